@@ -23,6 +23,10 @@
 #   [ TAG <JSON data> ]
 #   [ ARGUMENTS <arg1> ... ]
 #   [ ENVIRONMENT <varName1> <varValue1> ... ]
+#   [ MAX_JOBS_PER_PROCESS <count> ]
+#   [ IDLE_TIMEOUT <milliseconds> ]
+#   [ MIN_IDLE_WORKERS <count> ]
+#   [ RESOURCE_LIMITS <JSON object> ]
 #   )
 #
 #
@@ -75,6 +79,41 @@
 # file generated by the above provides access to a dictionary rather than
 # a string. This is convenient for the FactoryFileParser and its subclasses.
 #
+#Workers that are slow to start can be registered as resident workers,
+#whose processes handle many jobs before exiting. MAX_JOBS_PER_PROCESS is
+#the number of jobs a process handles, where 0 handles jobs until the
+#process is terminated, and IDLE_TIMEOUT is how many milliseconds a process
+#waits for a job before exiting. The worker factory passes both to the
+#process, which reads them with remus::worker::ResidentLimits:
+#
+#   remus_register_worker(cubit_worker
+#     INPUT_TYPE           "Model"
+#     OUTPUT_TYPE          "Mesh3D"
+#     MAX_JOBS_PER_PROCESS 50
+#     IDLE_TIMEOUT         60000
+#   )
+#
+#MIN_IDLE_WORKERS is the number of workers the worker factory keeps launched
+#ahead of demand, so that jobs don't wait for a worker to start. Workers
+#launched ahead of demand count against the max worker count of the factory.
+#
+#RESOURCE_LIMITS is a JSON object of the resources each worker process can
+#use, which is substituted into the worker file bare like TAG. MaxMemoryMB
+#and CpuQuota, in cpus, are applied with a cgroup v2 group made under
+#ControlGroup, or the cgroup of the server when ControlGroup isn't given.
+#The server's own cgroup can only hand its controllers down when no process
+#lives in it, so ControlGroup is normally a group delegated to the server.
+#CpuSet is a list of cpus such as "0-3,8" and MaxOpenFiles is the number of
+#files the process can have open. When cgroups can't be used the memory
+#limit is applied as an address space limit and the cpu quota isn't
+#applied. Jobs of a worker killed for going over its memory limit fail:
+#
+#   remus_register_worker(cubit_worker
+#     INPUT_TYPE      "Model"
+#     OUTPUT_TYPE     "Mesh3D"
+#     RESOURCE_LIMITS "{\"MaxMemoryMB\": 4096, \"CpuQuota\": 2}"
+#   )
+#
 #For the file example the remus_register_mesh_worker call will setup install rules
 #so that the rw file and the file referenced by the FILE_PATH are installed
 #in the bin directory. If you need to overwrite were the files are installed
@@ -103,7 +142,8 @@ function(remus_register_mesh_worker workerTarget )
   endif()
 
   set(options NO_INSTALL)
-  set(oneValueArgs INPUT_TYPE OUTPUT_TYPE EXECUTABLE_NAME WORKER_NAME INSTALL_PATH WORKER_FILE_EXT FILE_TYPE FILE_PATH TAG)
+  set(oneValueArgs INPUT_TYPE OUTPUT_TYPE EXECUTABLE_NAME WORKER_NAME INSTALL_PATH WORKER_FILE_EXT FILE_TYPE FILE_PATH TAG
+                   MAX_JOBS_PER_PROCESS IDLE_TIMEOUT MIN_IDLE_WORKERS RESOURCE_LIMITS)
   set(multiValueArgs ARGUMENTS ENVIRONMENT)
   cmake_parse_arguments(R "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN} )
 
@@ -160,6 +200,26 @@ function(remus_register_mesh_worker workerTarget )
     \"Tag\":  ${R_TAG},")
   endif()
 
+  if(NOT "${R_MAX_JOBS_PER_PROCESS}" STREQUAL "")
+    set(extra_json "${extra_json}
+    \"MaxJobsPerProcess\":  ${R_MAX_JOBS_PER_PROCESS},")
+  endif()
+
+  if(NOT "${R_IDLE_TIMEOUT}" STREQUAL "")
+    set(extra_json "${extra_json}
+    \"IdleTimeout\":  ${R_IDLE_TIMEOUT},")
+  endif()
+
+  if(NOT "${R_MIN_IDLE_WORKERS}" STREQUAL "")
+    set(extra_json "${extra_json}
+    \"MinIdleWorkers\":  ${R_MIN_IDLE_WORKERS},")
+  endif()
+
+  if(R_RESOURCE_LIMITS)
+    set(extra_json "${extra_json}
+    \"ResourceLimits\":  ${R_RESOURCE_LIMITS},")
+  endif()
+
   if(R_ARGUMENTS)
     # Since "@SELF@" should be replaced at run-time, not
     # configure-time, we set SELF here so that @SELF@ -> @SELF@:
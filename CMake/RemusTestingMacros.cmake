@@ -88,6 +88,10 @@ endfunction()
 #   [ TAG <JSON data> ]
 #   [ ARGUMENTS <arg1> ... ]
 #   [ ENVIRONMENT <varName1> <varValue1> ... ]
+#   [ MAX_JOBS_PER_PROCESS <count> ]
+#   [ IDLE_TIMEOUT <milliseconds> ]
+#   [ MIN_IDLE_WORKERS <count> ]
+#   [ RESOURCE_LIMITS <JSON object> ]
 #   )
 #
 # IS_FILE_BASED will set the requirements to be file based, and specify
@@ -106,7 +110,8 @@ function(remus_register_unit_test_worker)
   endif()
 
   set(options IS_FILE_BASED)
-  set(oneValueArgs EXEC_NAME INPUT_TYPE OUTPUT_TYPE CONFIG_DIR FILE_EXT TAG WORKER_NAME)
+  set(oneValueArgs EXEC_NAME INPUT_TYPE OUTPUT_TYPE CONFIG_DIR FILE_EXT TAG WORKER_NAME
+                   MAX_JOBS_PER_PROCESS IDLE_TIMEOUT MIN_IDLE_WORKERS RESOURCE_LIMITS)
   set(multiValueArgs ARGUMENTS ENVIRONMENT)
   cmake_parse_arguments(R
     "${options}" "${oneValueArgs}" "${multiValueArgs}"
@@ -125,6 +130,26 @@ function(remus_register_unit_test_worker)
     \"Tag\":  ${R_TAG},")
   endif()
 
+  if(NOT "${R_MAX_JOBS_PER_PROCESS}" STREQUAL "")
+    set(extra_json "${extra_json}
+    \"MaxJobsPerProcess\":  ${R_MAX_JOBS_PER_PROCESS},")
+  endif()
+
+  if(NOT "${R_IDLE_TIMEOUT}" STREQUAL "")
+    set(extra_json "${extra_json}
+    \"IdleTimeout\":  ${R_IDLE_TIMEOUT},")
+  endif()
+
+  if(NOT "${R_MIN_IDLE_WORKERS}" STREQUAL "")
+    set(extra_json "${extra_json}
+    \"MinIdleWorkers\":  ${R_MIN_IDLE_WORKERS},")
+  endif()
+
+  if(R_RESOURCE_LIMITS)
+    set(extra_json "${extra_json}
+    \"ResourceLimits\":  ${R_RESOURCE_LIMITS},")
+  endif()
+
   if(R_ARGUMENTS)
     # Since "@SELF@" should be replaced at run-time, not
     # configure-time, we set SELF here so that @SELF@ -> @SELF@:
@@ -38,6 +38,9 @@ worker::worker( remus::worker::ServerConnection const& conn )
       conn),
    Process(NULL)
 {
+  //every line of output is sent as progress, so only send the latest
+  //line every quarter second
+  this->statusInterval(250);
 }
 
 worker::~worker()
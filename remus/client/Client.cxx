@@ -12,26 +12,446 @@
 
 #include <remus/client/Client.h>
 
+#include <remus/proto/Batch.h>
 #include <remus/proto/Message.h>
 #include <remus/proto/Response.h>
+#include <remus/proto/Transfer.h>
 
 #include <remus/proto/zmqHelper.h>
+
+//suppress warnings inside boost headers for gcc and clang
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/make_shared.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/uuid/random_generator.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iterator>
 #include <sstream>
 
 namespace remus{
 namespace client{
 
+namespace detail{
+//------------------------------------------------------------------------------
+//decode the reply to a query into the type the query returns
+remus::proto::Job decode_Job(const remus::proto::Response& response)
+{
+  const std::string job(response.data(), response.dataSize());
+  return remus::proto::to_Job(job);
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus decode_JobStatus(const remus::proto::Response& response)
+{
+  return remus::proto::to_JobStatus(response.data(), response.dataSize());
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobResult decode_JobResult(const remus::proto::Response& response)
+{
+  //the result shares the response's storage so it is never copied
+  return remus::proto::to_JobResult(response.data(), response.dataSize(),
+                                    response.storage());
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::Job> decode_JobVector(
+                                    const remus::proto::Response& response)
+{
+  return remus::proto::to_JobVector(response.data(), response.dataSize());
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::JobStatus> decode_JobStatusVector(
+                                    const remus::proto::Response& response)
+{
+  return remus::proto::to_JobStatusVector(response.data(), response.dataSize());
+}
+
+//------------------------------------------------------------------------------
+//wait for every future, returning their values in order
+template<typename T>
+std::vector<T> get_all(const std::vector< boost::shared_future<T> >& futures)
+{
+  std::vector<T> values;
+  values.reserve(futures.size());
+  for(std::size_t i=0; i < futures.size(); ++i)
+    {
+    values.push_back( futures[i].get() );
+    }
+  return values;
+}
+
+//------------------------------------------------------------------------------
+//an asynchronous query that is waiting for the server to reply
+class PendingResponse
+{
+public:
+  virtual ~PendingResponse() {}
+  virtual void respond(const remus::proto::Response& response) = 0;
+};
+
+//------------------------------------------------------------------------------
+template<typename T>
+class PendingValue : public PendingResponse
+{
+public:
+  typedef T (*DecodeFunction)(const remus::proto::Response&);
+
+  explicit PendingValue(DecodeFunction decode):
+    Promise(),
+    Decode(decode)
+  {}
+
+  boost::promise<T>& promise() { return this->Promise; }
+
+  void respond(const remus::proto::Response& response)
+  {
+    this->Promise.set_value( this->Decode(response) );
+  }
+
+private:
+  boost::promise<T> Promise;
+  DecodeFunction Decode;
+};
+
 //lightweight struct to hide zmq from leaking into libraries that link
 //to remus client
-namespace detail{
 struct ZmqManagement
 {
+  typedef boost::unordered_map< std::string,
+                        boost::shared_ptr<PendingResponse> > PendingMap;
+
+  //we use a dealer so that we can send a query before the reply to the
+  //last one has arrived. Every query is tagged with a request id, which
+  //the server sends back with the reply to it
   zmq::socket_t Server;
 
+  //the wire format we asked for, and the one the server agreed to use
+  remus::proto::WireFormat::Type Requested;
+  remus::proto::WireFormat::Type Format;
+  bool Negotiated;
+
+  //the ids of the queries that haven't been replied to, in the order they
+  //were sent, and the futures of the ones that are asynchronous
+  boost::uint64_t NextRequestId;
+  std::deque<std::string> InFlight;
+  PendingMap Pending;
+
   ZmqManagement(const remus::client::ServerConnection &conn):
-    Server(*(conn.context()), ZMQ_REQ)
+    Server(*(conn.context()), ZMQ_DEALER),
+    Requested(conn.wireFormat()),
+    Format(remus::proto::WireFormat::Text),
+    Negotiated(false),
+    NextRequestId(0),
+    InFlight(),
+    Pending()
   {}
+
+  //ask the server to use our wire format the first time we send it a
+  //proto object. Servers that don't know about wire formats reply with
+  //an invalid service, in which case we keep using text
+  remus::proto::WireFormat::Type wireFormat()
+  {
+    if(!this->Negotiated)
+      {
+      this->Negotiated = true;
+      if(this->Requested != remus::proto::WireFormat::Text)
+        {
+        remus::proto::Response response =
+            this->request(remus::common::MeshIOType(),
+                          remus::WIRE_FORMAT,
+                          remus::proto::to_string(this->Requested));
+        if(response.serviceType() == remus::WIRE_FORMAT)
+          {
+          this->Format = remus::proto::to_WireFormat(response.data(),
+                                                     response.dataSize());
+          }
+        }
+      }
+    return this->Format;
+  }
+
+  //send a query tagged with a new request id, which is returned
+  std::string send(const remus::common::MeshIOType& mtype,
+                   remus::SERVICE_TYPE service,
+                   const std::string& data = std::string(),
+                   const std::string& payload = std::string())
+  {
+    std::string id(sizeof(this->NextRequestId), 0);
+    std::memcpy(&id[0], &this->NextRequestId, sizeof(this->NextRequestId));
+    ++this->NextRequestId;
+
+    remus::proto::send_Message(mtype, service, data, payload,
+                               &this->Server, id);
+    this->InFlight.push_back(id);
+    return id;
+  }
+
+  //send a query and wait for the reply to it. The replies to asynchronous
+  //queries that arrive first are handed to their futures
+  remus::proto::Response request(const remus::common::MeshIOType& mtype,
+                                 remus::SERVICE_TYPE service,
+                                 const std::string& data = std::string(),
+                                 const std::string& payload = std::string())
+  {
+    const std::string id = this->send(mtype, service, data, payload);
+    while(true)
+      {
+      remus::proto::Response response =
+          remus::proto::receive_Response(&this->Server);
+      const std::string repliedTo = this->repliedTo(response);
+      if(repliedTo == id)
+        {
+        return response;
+        }
+      this->deliver(repliedTo, response);
+      }
+  }
+
+  //make a future for the reply to the query with the given id. Waiting
+  //on the future receives replies until the one it is waiting for arrives
+  template<typename T>
+  boost::shared_future<T> expect(const std::string& id,
+                                 typename PendingValue<T>::DecodeFunction decode)
+  {
+    boost::shared_ptr< PendingValue<T> > pending =
+        boost::make_shared< PendingValue<T> >(decode);
+    pending->promise().set_wait_callback( WaitForResponse(this, id) );
+    this->Pending[id] = pending;
+    return boost::shared_future<T>( pending->promise().get_future() );
+  }
+
+  //receive replies until the asynchronous query with the given id has
+  //been replied to
+  void waitFor(const std::string& id)
+  {
+    while(this->Pending.find(id) != this->Pending.end())
+      {
+      remus::proto::Response response =
+          remus::proto::receive_Response(&this->Server);
+      this->deliver(this->repliedTo(response), response);
+      }
+  }
+
+  //receive the replies that have arrived, waiting up to timeout for
+  //the first one
+  std::size_t poll(boost::int64_t timeout)
+  {
+    std::size_t delivered = 0;
+    zmq::pollitem_t item = { this->Server, 0, ZMQ_POLLIN, 0 };
+    while(!this->InFlight.empty())
+      {
+      if(timeout > 0)
+        {
+        zmq::poll_safely(&item, 1, timeout);
+        }
+      else
+        {
+        zmq::poll(&item, 1, 0);
+        }
+      if((item.revents & ZMQ_POLLIN) == 0)
+        {
+        break;
+        }
+
+      remus::proto::Response response =
+          remus::proto::receive_Response(&this->Server);
+      if(this->deliver(this->repliedTo(response), response))
+        {
+        ++delivered;
+        }
+      timeout = 0;
+      }
+    return delivered;
+  }
+
+  //returns the id of the query a reply answers. Servers that don't send
+  //request ids back reply to queries in the order they were sent, as do
+  //replies that we couldn't read
+  std::string repliedTo(const remus::proto::Response& response)
+  {
+    std::deque<std::string>::iterator i =
+        std::find(this->InFlight.begin(), this->InFlight.end(),
+                  response.requestId());
+    if(i == this->InFlight.end())
+      {
+      if(!response.requestId().empty() || this->InFlight.empty())
+        {
+        return std::string();
+        }
+      i = this->InFlight.begin();
+      }
+    const std::string id = *i;
+    this->InFlight.erase(i);
+    return id;
+  }
+
+  //hand a reply to the future of the asynchronous query it answers.
+  //Returns false if the query wasn't asynchronous
+  bool deliver(const std::string& id, const remus::proto::Response& response)
+  {
+    PendingMap::iterator i = this->Pending.find(id);
+    if(i == this->Pending.end())
+      {
+      return false;
+      }
+    boost::shared_ptr<PendingResponse> pending = i->second;
+    this->Pending.erase(i);
+    pending->respond(response);
+    return true;
+  }
+
+  //waits on a future by receiving replies. The future can only be waited
+  //on while its promise is held in Pending, so we never outlive the client
+  struct WaitForResponse
+  {
+    typedef void result_type;
+
+    WaitForResponse(ZmqManagement* zmq, const std::string& id):
+      Zmq(zmq),
+      Id(id)
+    {}
+
+    template<typename T>
+    void operator()(boost::promise<T>&) const
+    {
+      this->Zmq->waitFor(this->Id);
+    }
+
+    ZmqManagement* Zmq;
+    std::string Id;
+  };
+
+  //send one message of a chunked transfer, and return the reply of the
+  //server which is invalid when the server rejected the message
+  remus::proto::Transfer transfer(const remus::common::MeshIOType& mtype,
+                                  remus::SERVICE_TYPE service,
+                                  const remus::proto::Transfer& t,
+                                  const std::string& chunk)
+  {
+    remus::proto::Response response =
+        this->request(mtype, service, remus::proto::to_binary(t), chunk);
+    if(response.serviceType() != service)
+      {
+      return remus::proto::Transfer();
+      }
+    return remus::proto::to_Transfer(response.data(), response.dataSize());
+  }
+};
+
+//------------------------------------------------------------------------------
+//The binary encoding of a submission whose content under one key is read
+//from a stream. Any range of the encoding can be read, so that we can
+//resume from wherever the server tells us its data ends, without ever
+//holding the whole streamed content in memory.
+class StreamedSubmission
+{
+public:
+  StreamedSubmission(const remus::proto::JobSubmission& submission,
+                     const std::string& key,
+                     std::istream& content,
+                     boost::uint64_t contentSize):
+    Prefix(),
+    Suffix(),
+    Content(content),
+    Start(content.tellg()),
+    Position(0),
+    ContentSize(contentSize)
+  {
+    remus::proto::to_binaryParts(submission, key,
+                                 static_cast<std::size_t>(contentSize),
+                                 this->Prefix, this->Suffix);
+  }
+
+  boost::uint64_t size() const
+    { return this->Prefix.size() + this->ContentSize + this->Suffix.size(); }
+
+  //fill chunk with up to maxSize bytes of the encoding, starting at offset.
+  //Returns false if the stream couldn't be read
+  bool read(boost::uint64_t offset, std::size_t maxSize, std::string& chunk)
+  {
+    chunk.clear();
+    const boost::uint64_t end = std::min(this->size(), offset + maxSize);
+    const boost::uint64_t contentEnd = this->Prefix.size() + this->ContentSize;
+    boost::uint64_t pos = offset;
+
+    if(pos < this->Prefix.size())
+      {
+      const std::size_t n = static_cast<std::size_t>(
+                    std::min<boost::uint64_t>(end, this->Prefix.size()) - pos);
+      chunk.append(this->Prefix, static_cast<std::size_t>(pos), n);
+      pos += n;
+      }
+
+    if(pos < end && pos < contentEnd)
+      {
+      const boost::uint64_t contentPos = pos - this->Prefix.size();
+      const std::size_t n = static_cast<std::size_t>(
+                                  std::min(end, contentEnd) - pos);
+      //only seek when we aren't reading from where we stopped last time
+      if(contentPos != this->Position)
+        {
+        this->Content.clear();
+        this->Content.seekg(this->Start +
+                            static_cast<std::streamoff>(contentPos));
+        }
+      const std::size_t old = chunk.size();
+      chunk.resize(old + n);
+      this->Content.read(&chunk[old], static_cast<std::streamsize>(n));
+      if(static_cast<std::size_t>(this->Content.gcount()) != n)
+        {
+        this->Position = this->ContentSize + 1;
+        return false;
+        }
+      this->Position = contentPos + n;
+      pos += n;
+      }
+
+    if(pos < end)
+      {
+      const std::size_t n = static_cast<std::size_t>(end - pos);
+      chunk.append(this->Suffix, static_cast<std::size_t>(pos - contentEnd), n);
+      }
+    return true;
+  }
+
+private:
+  std::string Prefix;
+  std::string Suffix;
+  std::istream& Content;
+  std::streampos Start;
+  boost::uint64_t Position;
+  boost::uint64_t ContentSize;
 };
+
+//------------------------------------------------------------------------------
+//returns the number of bytes left in the stream, or false if the stream
+//can't tell us, which is the case for pipes and sockets
+bool remaining_size(std::istream& content, boost::uint64_t& size)
+{
+  const std::streampos start = content.tellg();
+  if(start == std::streampos(-1) || !content.seekg(0, std::ios::end))
+    {
+    content.clear();
+    return false;
+    }
+  const std::streampos end = content.tellg();
+  content.seekg(start);
+  if(end == std::streampos(-1) || !content.good())
+    {
+    content.clear();
+    return false;
+    }
+  size = static_cast<boost::uint64_t>(end - start);
+  return true;
+}
+
 }
 
 //------------------------------------------------------------------------------
@@ -56,12 +476,9 @@ const remus::client::ServerConnection& Client::connection() const
 //------------------------------------------------------------------------------
 remus::common::MeshIOTypeSet Client::supportedIOTypes()
 {
-  remus::proto::send_Message(remus::common::MeshIOType(),
-                             remus::SUPPORTED_IO_TYPES,
-                             &this->Zmq->Server);
-
   remus::proto::Response response =
-      remus::proto::receive_Response(&this->Zmq->Server);
+      this->Zmq->request(remus::common::MeshIOType(),
+                         remus::SUPPORTED_IO_TYPES);
   std::istringstream buffer(response.data());
 
   remus::common::MeshIOTypeSet supportedTypes;
@@ -72,12 +489,8 @@ remus::common::MeshIOTypeSet Client::supportedIOTypes()
 //------------------------------------------------------------------------------
 bool Client::canMesh(const remus::common::MeshIOType& meshtypes)
 {
-  remus::proto::send_Message(meshtypes,
-                             remus::CAN_MESH_IO_TYPE,
-                             &this->Zmq->Server);
-
   remus::proto::Response response =
-      remus::proto::receive_Response(&this->Zmq->Server);
+      this->Zmq->request(meshtypes, remus::CAN_MESH_IO_TYPE);
   std::istringstream buffer(response.data());
 
   bool serverCanMesh;
@@ -88,15 +501,11 @@ bool Client::canMesh(const remus::common::MeshIOType& meshtypes)
 //------------------------------------------------------------------------------
 bool Client::canMesh(const remus::proto::JobRequirements& reqs)
 {
-  std::ostringstream input_buffer;
-  input_buffer << reqs;
-  remus::proto::send_Message(reqs.meshTypes(),
-                             remus::CAN_MESH_REQUIREMENTS,
-                             input_buffer.str(),
-                             &this->Zmq->Server);
-
+  const remus::proto::WireFormat::Type format = this->Zmq->wireFormat();
   remus::proto::Response response =
-      remus::proto::receive_Response(&this->Zmq->Server);
+      this->Zmq->request(reqs.meshTypes(),
+                         remus::CAN_MESH_REQUIREMENTS,
+                         remus::proto::to_string(reqs,format));
   std::istringstream output_buffer(response.data());
 
   bool serverCanMesh;
@@ -108,12 +517,8 @@ bool Client::canMesh(const remus::proto::JobRequirements& reqs)
 remus::proto::JobRequirementsSet
 Client::retrieveRequirements( const remus::common::MeshIOType& meshtypes)
 {
-  remus::proto::send_Message(meshtypes,
-                             remus::MESH_REQUIREMENTS_FOR_IO_TYPE,
-                             &this->Zmq->Server);
-
   remus::proto::Response response =
-      remus::proto::receive_Response(&this->Zmq->Server);
+      this->Zmq->request(meshtypes, remus::MESH_REQUIREMENTS_FOR_IO_TYPE);
   std::istringstream buffer(response.data());
 
   remus::proto::JobRequirementsSet set;
@@ -125,59 +530,269 @@ Client::retrieveRequirements( const remus::common::MeshIOType& meshtypes)
 remus::proto::Job
 Client::submitJob(const remus::proto::JobSubmission& submission)
 {
-  std::ostringstream buffer;
-  buffer << submission;
+  return this->submitJobAsync(submission).get();
+}
 
-  remus::proto::send_Message(submission.type(),
-                             remus::MAKE_MESH,
-                            buffer.str(),
-                            &this->Zmq->Server);
+//------------------------------------------------------------------------------
+remus::proto::Job
+Client::submitJob(const remus::proto::JobSubmission& submission,
+                  const std::string& key,
+                  std::istream& content)
+{
+  return this->submitJob(submission, key, content,
+                         boost::uuids::random_generator()());
+}
 
-  remus::proto::Response response =
-      remus::proto::receive_Response(&this->Zmq->Server);
-  const std::string job(response.data(), response.dataSize());
-  return remus::proto::to_Job(job);
+//------------------------------------------------------------------------------
+remus::proto::Job
+Client::submitJob(const remus::proto::JobSubmission& submission,
+                  const std::string& key,
+                  std::istream& content,
+                  const boost::uuids::uuid& transferId)
+{
+  //the streamed content keeps the format and tag of the content under key
+  remus::proto::JobSubmission sub(submission);
+  const remus::proto::JobContent& info = sub[key];
+  remus::proto::JobContent placeholder(info.formatType(), std::string());
+  placeholder.tag(info.tag());
+  sub[key] = placeholder;
+
+  //we can only stream binary submissions whose size we know. Anything
+  //else is read into memory and submitted as usual
+  boost::uint64_t contentSize = 0;
+  const bool canStream =
+          this->Zmq->wireFormat() == remus::proto::WireFormat::Binary &&
+          detail::remaining_size(content, contentSize);
+  if(!canStream)
+    {
+    const std::string data( (std::istreambuf_iterator<char>(content)),
+                            std::istreambuf_iterator<char>() );
+    remus::proto::JobContent full(placeholder.formatType(), data);
+    full.tag(placeholder.tag());
+    sub[key] = full;
+    return this->submitJob(sub);
+    }
+
+  detail::StreamedSubmission encoded(sub, key, content, contentSize);
+  const remus::common::MeshIOType& mtype = sub.type();
+  const std::size_t chunkSize = this->ConnectionInfo.chunkSize();
+
+  //we only keep a single chunk in flight, so the credits the server
+  //gives us don't matter. We always send the chunk that starts
+  //where the server says its data ends, which resumes the transfer after
+  //any chunk that the server didn't keep, and resumes a transfer that
+  //was begun before
+  const boost::uuids::uuid& id = transferId;
+  remus::proto::Transfer reply = this->Zmq->transfer(mtype,
+                  remus::TRANSFER_BEGIN,
+                  remus::proto::Transfer(id, 0, encoded.size()),
+                  std::string());
+
+  std::string chunk;
+  while(reply.valid() && reply.offset() < encoded.size())
+    {
+    if(!encoded.read(reply.offset(), chunkSize, chunk))
+      {
+      return remus::proto::make_invalidJob();
+      }
+    reply = this->Zmq->transfer(mtype, remus::TRANSFER_CHUNK,
+                      remus::proto::Transfer(id, reply.offset()), chunk);
+    }
+  if(!reply.valid())
+    {
+    return remus::proto::make_invalidJob();
+    }
+
+  return detail::decode_Job( this->Zmq->request(mtype,
+                      remus::TRANSFER_COMMIT,
+                      remus::proto::to_binary(
+                          remus::proto::Transfer(id, encoded.size()))) );
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Job
+Client::submitJobFromFile(const remus::proto::JobSubmission& submission,
+                          const std::string& key,
+                          const std::string& path)
+{
+  std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+  if(!file)
+    {
+    return remus::proto::make_invalidJob();
+    }
+  return this->submitJob(submission, key, file);
 }
 
 //------------------------------------------------------------------------------
 remus::proto::JobStatus Client::jobStatus(const remus::proto::Job& job)
 {
-  remus::proto::send_Message(job.type(),
-                             remus::MESH_STATUS,
-                             remus::proto::to_string(job),&this->Zmq->Server);
+  return this->jobStatusAsync(job).get();
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobResult Client::retrieveResults(const remus::proto::Job& job)
+{
+  return this->retrieveResultsAsync(job).get();
+}
+
+//------------------------------------------------------------------------------
+boost::shared_future<remus::proto::Job>
+Client::submitJobAsync(const remus::proto::JobSubmission& submission)
+{
+  const remus::proto::WireFormat::Type format = this->Zmq->wireFormat();
+  std::string id;
+  if(format == remus::proto::WireFormat::Binary)
+    {
+    //the server only needs the requirements to schedule the job, so we
+    //send them as a small header and the submission as a payload that
+    //the server forwards to the worker without decoding
+    id = this->Zmq->send(submission.type(),
+                         remus::MAKE_MESH,
+                         remus::proto::to_binary(submission.requirements()),
+                         remus::proto::to_binary(submission));
+    }
+  else
+    {
+    id = this->Zmq->send(submission.type(),
+                         remus::MAKE_MESH,
+                         remus::proto::to_string(submission,format));
+    }
+  return this->Zmq->expect<remus::proto::Job>(id, &detail::decode_Job);
+}
+
+//------------------------------------------------------------------------------
+boost::shared_future<remus::proto::JobStatus>
+Client::jobStatusAsync(const remus::proto::Job& job)
+{
+  //negotiate first so the status is sent back in our wire format
+  this->Zmq->wireFormat();
+  const std::string id = this->Zmq->send(job.type(),
+                                         remus::MESH_STATUS,
+                                         remus::proto::to_string(job));
+  return this->Zmq->expect<remus::proto::JobStatus>(id,
+                                                    &detail::decode_JobStatus);
+}
+
+//------------------------------------------------------------------------------
+boost::shared_future<remus::proto::JobResult>
+Client::retrieveResultsAsync(const remus::proto::Job& job)
+{
+  //negotiate first so the result is sent back in our wire format
+  this->Zmq->wireFormat();
+  const std::string id = this->Zmq->send(job.type(),
+                                         remus::RETRIEVE_RESULT,
+                                         remus::proto::to_string(job));
+  return this->Zmq->expect<remus::proto::JobResult>(id,
+                                                    &detail::decode_JobResult);
+}
 
+//------------------------------------------------------------------------------
+std::vector<remus::proto::Job>
+Client::submitJobs(const std::vector<remus::proto::JobSubmission>& submissions)
+{
+  if(submissions.empty())
+    {
+    return std::vector<remus::proto::Job>();
+    }
+
+  const remus::proto::WireFormat::Type format = this->Zmq->wireFormat();
   remus::proto::Response response =
-      remus::proto::receive_Response(&this->Zmq->Server);
-  const std::string status(response.data(), response.dataSize());
-  return remus::proto::to_JobStatus(status);
+      this->Zmq->request(remus::common::MeshIOType(),
+                         remus::MAKE_MESH_BATCH,
+                         remus::proto::to_batch(submissions,format));
+  if(response.serviceType() == remus::MAKE_MESH_BATCH)
+    {
+    return detail::decode_JobVector(response);
+    }
+
+  std::vector< boost::shared_future<remus::proto::Job> > jobs;
+  for(std::size_t i=0; i < submissions.size(); ++i)
+    {
+    jobs.push_back( this->submitJobAsync(submissions[i]) );
+    }
+  return detail::get_all(jobs);
 }
 
 //------------------------------------------------------------------------------
-remus::proto::JobResult Client::retrieveResults(const remus::proto::Job& job)
+std::vector<remus::proto::JobStatus>
+Client::jobStatus(const std::vector<remus::proto::Job>& jobs)
 {
-  remus::proto::send_Message(job.type(),
-                             remus::RETRIEVE_RESULT,
-                             remus::proto::to_string(job),
-                             &this->Zmq->Server);
+  if(jobs.empty())
+    {
+    return std::vector<remus::proto::JobStatus>();
+    }
 
+  //negotiate first so the statuses are sent back in our wire format
+  this->Zmq->wireFormat();
   remus::proto::Response response =
-      remus::proto::receive_Response(&this->Zmq->Server);
-  const std::string result(response.data(), response.dataSize());
-  return remus::proto::to_JobResult(result);
+      this->Zmq->request(remus::common::MeshIOType(),
+                         remus::MESH_STATUS_BATCH,
+                         remus::proto::to_batch(jobs));
+  if(response.serviceType() == remus::MESH_STATUS_BATCH)
+    {
+    return detail::decode_JobStatusVector(response);
+    }
+
+  std::vector< boost::shared_future<remus::proto::JobStatus> > statuses;
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    statuses.push_back( this->jobStatusAsync(jobs[i]) );
+    }
+  return detail::get_all(statuses);
 }
 
 //------------------------------------------------------------------------------
-remus::proto::JobStatus Client::terminate(const remus::proto::Job& job)
+std::vector<remus::proto::JobStatus>
+Client::terminate(const std::vector<remus::proto::Job>& jobs)
 {
-  remus::proto::send_Message(job.type(),
-                             remus::TERMINATE_JOB,
-                             remus::proto::to_string(job),
-                             &this->Zmq->Server);
+  if(jobs.empty())
+    {
+    return std::vector<remus::proto::JobStatus>();
+    }
 
+  //negotiate first so the statuses are sent back in our wire format
+  this->Zmq->wireFormat();
   remus::proto::Response response =
-      remus::proto::receive_Response(&this->Zmq->Server);
-  const std::string status(response.data(), response.dataSize());
-  return remus::proto::to_JobStatus(status);
+      this->Zmq->request(remus::common::MeshIOType(),
+                         remus::TERMINATE_JOB_BATCH,
+                         remus::proto::to_batch(jobs));
+  if(response.serviceType() == remus::TERMINATE_JOB_BATCH)
+    {
+    return detail::decode_JobStatusVector(response);
+    }
+
+  std::vector< boost::shared_future<remus::proto::JobStatus> > statuses;
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    const std::string id = this->Zmq->send(jobs[i].type(),
+                                           remus::TERMINATE_JOB,
+                                           remus::proto::to_string(jobs[i]));
+    statuses.push_back( this->Zmq->expect<remus::proto::JobStatus>(id,
+                                           &detail::decode_JobStatus) );
+    }
+  return detail::get_all(statuses);
+}
+
+//------------------------------------------------------------------------------
+std::size_t Client::pollResponses(boost::int64_t timeoutMillisec)
+{
+  return this->Zmq->poll(timeoutMillisec);
+}
+
+//------------------------------------------------------------------------------
+std::size_t Client::pendingResponses() const
+{
+  return this->Zmq->Pending.size();
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus Client::terminate(const remus::proto::Job& job)
+{
+  //negotiate first so the status is sent back in our wire format
+  this->Zmq->wireFormat();
+  return detail::decode_JobStatus( this->Zmq->request(job.type(),
+                                                remus::TERMINATE_JOB,
+                                                remus::proto::to_string(job)) );
 }
 
 }
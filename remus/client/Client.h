@@ -15,6 +15,12 @@
 
 #include <boost/scoped_ptr.hpp>
 
+//suppress warnings inside boost headers for gcc and clang
+#include <remus/common/CompilerInformation.h>
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/thread/future.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
 #include <remus/client/ServerConnection.h>
 
 #include <remus/common/MeshIOType.h>
@@ -30,9 +36,21 @@
 //included for export symbols
 #include <remus/client/ClientExports.h>
 
+#include <iosfwd>
+#include <vector>
+
 //The client class is used to submit meshing jobs to a remus server.
 //The class also allows you to query on the state of a given job and
 //to retrieve the results of the job when it is finished.
+//
+//Every query can also be made without waiting for the server to reply,
+//so that many queries are in flight at once on the connection to the server.
+//The asynchronous queries return futures that become ready once the reply
+//to them has been received. Replies are only received by the thread that
+//uses the client: when it waits on a future, calls pollResponses, or makes
+//any other query. So a future must be waited on from the thread that uses
+//the client, and is broken if the client is destroyed before the reply
+//to it has been received.
 namespace remus{
 namespace client{
 
@@ -74,18 +92,84 @@ public:
   //a JobRequirements component
   remus::proto::Job submitJob(const remus::proto::JobSubmission& submission);
 
+  //Submit a job to the server, whose content under key is read from the
+  //given stream instead of being held in memory. The content under key in
+  //the submission states the format and tag of the streamed content, and
+  //its data is ignored. When the server supports it the content is sent in
+  //chunks of the connection's chunkSize, otherwise the stream is read fully
+  //and sent like any other submission.
+  remus::proto::Job submitJob(const remus::proto::JobSubmission& submission,
+                              const std::string& key,
+                              std::istream& content);
+
+  //Submit a job whose content under key is read from the given stream,
+  //sending the content as the transfer with the given id. Submitting again
+  //with the same transfer id, from this or another client, resumes the
+  //transfer from where the data the server has ends, such as after the
+  //client that began it went away. The stream has to hold the same content
+  //each time, and the server drops transfers that have been idle for five
+  //minutes.
+  remus::proto::Job submitJob(const remus::proto::JobSubmission& submission,
+                              const std::string& key,
+                              std::istream& content,
+                              const boost::uuids::uuid& transferId);
+
+  //Submit a job to the server, whose content under key is streamed from
+  //the given file. Returns an invalid job if the file can't be read
+  remus::proto::Job submitJobFromFile(
+                              const remus::proto::JobSubmission& submission,
+                              const std::string& key,
+                              const std::string& path);
+
   //Given a remus Job object returns the status of the job
   remus::proto::JobStatus jobStatus(const remus::proto::Job& job);
 
   //Return job result of of a give job
   remus::proto::JobResult retrieveResults(const remus::proto::Job& job);
 
+  //Submit a job to the server, without waiting for the server to reply
+  boost::shared_future<remus::proto::Job>
+  submitJobAsync(const remus::proto::JobSubmission& submission);
+
+  //Ask for the status of a job, without waiting for the server to reply
+  boost::shared_future<remus::proto::JobStatus>
+  jobStatusAsync(const remus::proto::Job& job);
+
+  //Ask for the result of a job, without waiting for the server to reply
+  boost::shared_future<remus::proto::JobResult>
+  retrieveResultsAsync(const remus::proto::Job& job);
+
+  //Receive the replies to asynchronous queries that have arrived, making
+  //their futures ready. Waits up to timeoutMillisec for the first reply
+  //when none have arrived. Returns the number of futures made ready
+  std::size_t pollResponses(boost::int64_t timeoutMillisec = 0);
+
+  //the number of asynchronous queries that haven't been replied to
+  std::size_t pendingResponses() const;
+
   //attempts to terminate a given job, will kill the job if the job hasn't
   //started. If the job has been finished and the results
   //are on the server the results will be deleted. If the job is in process
   //this will be unable to kill the job.
   remus::proto::JobStatus terminate(const remus::proto::Job& job);
 
+  //Submit many jobs to the server with a single query, returning the jobs
+  //in the same order as their submissions. Servers that don't support
+  //batches are sent a query per job instead, which are all in flight
+  //at once
+  std::vector<remus::proto::Job>
+  submitJobs(const std::vector<remus::proto::JobSubmission>& submissions);
+
+  //Given many remus Job objects returns the status of each of them, in the
+  //same order, with a single query
+  std::vector<remus::proto::JobStatus>
+  jobStatus(const std::vector<remus::proto::Job>& jobs);
+
+  //attempts to terminate many jobs like terminate does with a single query,
+  //returning the status of each of them in the same order
+  std::vector<remus::proto::JobStatus>
+  terminate(const std::vector<remus::proto::Job>& jobs);
+
 protected:
   remus::client::ServerConnection ConnectionInfo;
 private:
@@ -0,0 +1,474 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <remus/client/JobNotifier.h>
+
+#include <remus/common/Timer.h>
+#include <remus/proto/EventTypes.h>
+
+#include <remus/proto/zmqHelper.h>
+
+//suppress warnings inside boost headers for gcc and clang
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/unordered_map.hpp>
+#include <boost/uuid/nil_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include "cJSON.h"
+
+#include <algorithm>
+#include <list>
+#include <sstream>
+
+namespace remus{
+namespace client{
+
+namespace detail{
+
+//------------------------------------------------------------------------------
+//the job events that can tell us a job has completed
+static const remus::proto::jobevents::EVENT_TYPE completion_events[] = {
+  remus::proto::jobevents::COMPLETED,
+  remus::proto::jobevents::EXPIRED,
+  remus::proto::jobevents::TERMINATED,
+  remus::proto::jobevents::JOB_STATUS };
+static const std::size_t num_completion_events =
+              sizeof(completion_events) / sizeof(completion_events[0]);
+
+//------------------------------------------------------------------------------
+//the key the server publishes an event about a job under
+std::string make_JobEventKey(remus::proto::jobevents::EVENT_TYPE event,
+                             const boost::uuids::uuid& id)
+{
+  return "job:" + remus::proto::jobevents::to_string(event) + ":" +
+         boost::uuids::to_string(id);
+}
+
+//------------------------------------------------------------------------------
+//the status a job completed with, given an event of the job. The status is
+//good when the event doesn't mean the job has completed
+remus::STATUS_TYPE to_CompletedStatus(const std::string& event,
+                                      const zmq::message_t& data)
+{
+  namespace ev = remus::proto::jobevents;
+  if(event == ev::to_string(ev::COMPLETED))
+    {
+    return remus::FINISHED;
+    }
+  else if(event == ev::to_string(ev::EXPIRED))
+    {
+    return remus::EXPIRED;
+    }
+  else if(event == ev::to_string(ev::TERMINATED))
+    {
+    return remus::FAILED;
+    }
+  else if(event == ev::to_string(ev::JOB_STATUS))
+    {
+    //workers that fail a job only tell us with a status update
+    remus::STATUS_TYPE status = remus::IN_PROGRESS;
+    const std::string json(static_cast<const char*>(data.data()), data.size());
+    cJSON *root = cJSON_Parse(json.c_str());
+    cJSON *type = root ? cJSON_GetObjectItem(root, "status_type") : NULL;
+    if(type && type->valuestring)
+      {
+      status = remus::to_statusType(type->valuestring);
+      }
+    cJSON_Delete(root);
+    return (status == remus::INVALID_STATUS) ? remus::IN_PROGRESS : status;
+    }
+  return remus::IN_PROGRESS;
+}
+
+//------------------------------------------------------------------------------
+//a callback waiting for any of a collection of jobs to complete
+struct Waiter
+{
+  Waiter(const std::vector<remus::proto::Job>& jobs,
+         const JobNotifier::Callback& callback,
+         boost::int64_t nextCheck):
+    Jobs(jobs),
+    Callback(callback),
+    NextCheck(nextCheck),
+    Status(boost::uuids::nil_uuid(), remus::INVALID_STATUS)
+  {}
+
+  std::vector<remus::proto::Job> Jobs;
+  JobNotifier::Callback Callback;
+  //when we next ask the server for the status of the jobs
+  boost::int64_t NextCheck;
+  remus::proto::JobStatus Status;
+};
+
+//------------------------------------------------------------------------------
+struct JobSubscriber
+{
+  typedef boost::unordered_map<boost::uuids::uuid, std::size_t> WatchMap;
+  typedef boost::unordered_map<boost::uuids::uuid,
+                               remus::proto::JobStatus> StatusMap;
+
+  remus::client::Client& Client;
+  //holds the context the socket was made from
+  remus::client::ServerConnection Connection;
+  zmq::socket_t Socket;
+
+  remus::common::Timer Clock;
+  boost::int64_t FallbackInterval;
+
+  //the number of waits on each job we are subscribed to, and the status
+  //of the ones we know have completed
+  WatchMap Watched;
+  StatusMap Completed;
+  std::list<Waiter> Callbacks;
+
+  JobSubscriber(remus::client::Client& client,
+                const remus::client::ServerConnection& status):
+    Client(client),
+    Connection(status),
+    Socket(*(status.context()), ZMQ_SUB),
+    Clock(),
+    FallbackInterval(5000),
+    Watched(),
+    Completed(),
+    Callbacks()
+  {
+    zmq::connectToAddress(this->Socket, status.endpoint());
+  }
+
+  //subscribe to the events of the jobs we weren't already subscribed to
+  void watch(const std::vector<remus::proto::Job>& jobs)
+  {
+    typedef std::vector<remus::proto::Job>::const_iterator it;
+    for(it i = jobs.begin(); i != jobs.end(); ++i)
+      {
+      if(++this->Watched[i->id()] == 1)
+        {
+        this->subscribe(i->id(), ZMQ_SUBSCRIBE);
+        }
+      }
+  }
+
+  //unsubscribe from the events of the jobs nobody is waiting on anymore
+  void unwatch(const std::vector<remus::proto::Job>& jobs)
+  {
+    typedef std::vector<remus::proto::Job>::const_iterator it;
+    for(it i = jobs.begin(); i != jobs.end(); ++i)
+      {
+      WatchMap::iterator w = this->Watched.find(i->id());
+      if(w != this->Watched.end() && --w->second == 0)
+        {
+        this->Watched.erase(w);
+        this->Completed.erase(i->id());
+        this->subscribe(i->id(), ZMQ_UNSUBSCRIBE);
+        }
+      }
+  }
+
+  void subscribe(const boost::uuids::uuid& id, int option)
+  {
+    for(std::size_t i=0; i < num_completion_events; ++i)
+      {
+      const std::string key = make_JobEventKey(completion_events[i], id);
+      this->Socket.setsockopt(option, key.data(), key.size());
+      }
+  }
+
+  //receive the events that have arrived, waiting up to timeout for the
+  //first one. Returns the number of events received
+  std::size_t receive(boost::int64_t timeout)
+  {
+    std::size_t received = 0;
+    zmq::pollitem_t item = { this->Socket, 0, ZMQ_POLLIN, 0 };
+    if(timeout > 0)
+      {
+      zmq::poll_safely(&item, 1, timeout);
+      }
+    else
+      {
+      zmq::poll(&item, 1, 0);
+      }
+    while((item.revents & ZMQ_POLLIN) != 0)
+      {
+      zmq::message_t key;
+      zmq::message_t data;
+      if(zmq::recv_harder(this->Socket, &key) &&
+         zmq::recv_harder(this->Socket, &data))
+        {
+        this->handle(std::string(static_cast<const char*>(key.data()),
+                                 key.size()), data);
+        ++received;
+        }
+      zmq::poll(&item, 1, 0);
+      }
+    return received;
+  }
+
+  //events are published under job:<event>:<jobId>
+  void handle(const std::string& key, const zmq::message_t& data)
+  {
+    const std::string::size_type eventStart = key.find(':');
+    const std::string::size_type idStart = key.rfind(':');
+    if(eventStart == std::string::npos || idStart <= eventStart)
+      {
+      return;
+      }
+
+    boost::uuids::uuid id;
+    std::istringstream buffer(key.substr(idStart+1));
+    buffer >> id;
+    if(buffer.fail() || this->Watched.find(id) == this->Watched.end())
+      { //we have stopped waiting on the job since the event was sent
+      return;
+      }
+
+    const std::string event = key.substr(eventStart+1, idStart-eventStart-1);
+    const remus::proto::JobStatus status(id, to_CompletedStatus(event, data));
+    if(!status.good())
+      {
+      this->Completed.insert( StatusMap::value_type(id, status) );
+      }
+  }
+
+  //ask the server for the status of the jobs with a single query, which
+  //catches the jobs whose completion we haven't heard of. Returns the
+  //status of the first job
+  remus::proto::JobStatus check(const std::vector<remus::proto::Job>& jobs)
+  {
+    const std::vector<remus::proto::JobStatus> statuses =
+                                              this->Client.jobStatus(jobs);
+    for(std::size_t i=0; i < statuses.size(); ++i)
+      {
+      if(!statuses[i].good())
+        {
+        this->Completed.insert( StatusMap::value_type(jobs[i].id(),
+                                                      statuses[i]) );
+        }
+      }
+    return statuses.empty() ?
+      remus::proto::JobStatus(boost::uuids::nil_uuid(),remus::INVALID_STATUS) :
+      statuses.front();
+  }
+
+  //find the first of the jobs we know has completed
+  bool completed(const std::vector<remus::proto::Job>& jobs,
+                 remus::proto::JobStatus& status) const
+  {
+    typedef std::vector<remus::proto::Job>::const_iterator it;
+    for(it i = jobs.begin(); i != jobs.end(); ++i)
+      {
+      StatusMap::const_iterator c = this->Completed.find(i->id());
+      if(c != this->Completed.end())
+        {
+        status = c->second;
+        return true;
+        }
+      }
+    return false;
+  }
+
+  //when the next callback is due a check
+  boost::int64_t nextCheck() const
+  {
+    boost::int64_t next = this->Clock.elapsed() + this->FallbackInterval;
+    typedef std::list<Waiter>::const_iterator it;
+    for(it i = this->Callbacks.begin(); i != this->Callbacks.end(); ++i)
+      {
+      next = std::min(next, i->NextCheck);
+      }
+    return next;
+  }
+
+  //invoke the callbacks whose jobs have completed, after asking for the
+  //status of the jobs that are due a check with a single query
+  std::size_t dispatch()
+  {
+    typedef std::list<Waiter>::iterator it;
+    const boost::int64_t now = this->Clock.elapsed();
+
+    std::vector<remus::proto::Job> due;
+    for(it i = this->Callbacks.begin(); i != this->Callbacks.end(); ++i)
+      {
+      if(i->NextCheck <= now && !this->completed(i->Jobs, i->Status))
+        {
+        due.insert(due.end(), i->Jobs.begin(), i->Jobs.end());
+        i->NextCheck = now + this->FallbackInterval;
+        }
+      }
+    if(!due.empty())
+      {
+      this->check(due);
+      }
+
+    //take the completed callbacks out of the list before invoking them, as
+    //they are free to wait on more jobs
+    std::list<Waiter> ready;
+    for(it i = this->Callbacks.begin(); i != this->Callbacks.end();)
+      {
+      if(this->completed(i->Jobs, i->Status))
+        {
+        ready.splice(ready.end(), this->Callbacks, i++);
+        }
+      else
+        {
+        ++i;
+        }
+      }
+
+    for(it i = ready.begin(); i != ready.end(); ++i)
+      {
+      this->unwatch(i->Jobs);
+      i->Callback(i->Status);
+      }
+    return ready.size();
+  }
+};
+
+}
+
+//------------------------------------------------------------------------------
+JobNotifier::JobNotifier(remus::client::Client& client,
+                         const remus::client::ServerConnection& status):
+  Subscriber( new detail::JobSubscriber(client,status) )
+{
+}
+
+//------------------------------------------------------------------------------
+JobNotifier::~JobNotifier()
+{
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus
+JobNotifier::waitForCompletion(const remus::proto::Job& job,
+                               boost::int64_t timeoutMillisec)
+{
+  return this->waitForAny(std::vector<remus::proto::Job>(1,job),
+                          timeoutMillisec);
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus
+JobNotifier::waitForAny(const std::vector<remus::proto::Job>& jobs,
+                        boost::int64_t timeoutMillisec)
+{
+  if(jobs.empty())
+    {
+    return remus::proto::JobStatus(boost::uuids::nil_uuid(),
+                                   remus::INVALID_STATUS);
+    }
+
+  detail::JobSubscriber& sub = *this->Subscriber;
+  const boost::int64_t start = sub.Clock.elapsed();
+  const boost::int64_t deadline = start + timeoutMillisec;
+  boost::int64_t nextCheck = start + sub.FallbackInterval;
+
+  //subscribe before asking for the status, so that a job that completes
+  //in between isn't missed
+  sub.watch(jobs);
+  remus::proto::JobStatus status = sub.check(jobs);
+  bool done = sub.completed(jobs, status);
+  while(!done)
+    {
+    const boost::int64_t now = sub.Clock.elapsed();
+    if(timeoutMillisec >= 0 && now >= deadline)
+      { //ask once more in case we missed the event, then give up
+      if(timeoutMillisec > 0)
+        {
+        status = sub.check(jobs);
+        }
+      break;
+      }
+    else if(now >= nextCheck)
+      {
+      status = sub.check(jobs);
+      nextCheck = now + sub.FallbackInterval;
+      }
+    else
+      {
+      boost::int64_t wait = nextCheck - now;
+      if(timeoutMillisec >= 0)
+        {
+        wait = std::min(wait, deadline - now);
+        }
+      sub.receive(wait);
+      }
+    done = sub.completed(jobs, status);
+    }
+  sub.unwatch(jobs);
+
+  //the callbacks of other jobs that completed while we waited
+  sub.dispatch();
+  return status;
+}
+
+//------------------------------------------------------------------------------
+void JobNotifier::waitForCompletion(const remus::proto::Job& job,
+                                    const Callback& callback)
+{
+  this->waitForAny(std::vector<remus::proto::Job>(1,job), callback);
+}
+
+//------------------------------------------------------------------------------
+void JobNotifier::waitForAny(const std::vector<remus::proto::Job>& jobs,
+                             const Callback& callback)
+{
+  if(jobs.empty())
+    {
+    return;
+    }
+
+  //the status of the jobs is asked for the next time we dispatch, with the
+  //status of every other callback added since then
+  detail::JobSubscriber& sub = *this->Subscriber;
+  sub.watch(jobs);
+  sub.Callbacks.push_back( detail::Waiter(jobs, callback,
+                                          sub.Clock.elapsed()) );
+}
+
+//------------------------------------------------------------------------------
+std::size_t JobNotifier::poll(boost::int64_t timeoutMillisec)
+{
+  detail::JobSubscriber& sub = *this->Subscriber;
+  sub.receive(0);
+  std::size_t invoked = sub.dispatch();
+  if(invoked == 0 && timeoutMillisec > 0 && !sub.Callbacks.empty())
+    {
+    //don't wait past when the next callback is due a check
+    const boost::int64_t untilCheck = sub.nextCheck() - sub.Clock.elapsed();
+    sub.receive( std::min(timeoutMillisec, untilCheck) );
+    invoked = sub.dispatch();
+    }
+  return invoked;
+}
+
+//------------------------------------------------------------------------------
+std::size_t JobNotifier::pendingCallbacks() const
+{
+  return this->Subscriber->Callbacks.size();
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t JobNotifier::fallbackInterval() const
+{
+  return this->Subscriber->FallbackInterval;
+}
+
+//------------------------------------------------------------------------------
+void JobNotifier::fallbackInterval(boost::int64_t millisec)
+{
+  this->Subscriber->FallbackInterval = (millisec > 0) ? millisec : 1;
+}
+
+}
+}
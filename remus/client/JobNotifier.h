@@ -0,0 +1,106 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#ifndef remus_client_JobNotifier_h
+#define remus_client_JobNotifier_h
+
+#include <remus/client/Client.h>
+
+//suppress warnings inside boost headers for gcc and clang
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+//included for export symbols
+#include <remus/client/ClientExports.h>
+
+#include <vector>
+
+//The job notifier is used to wait for jobs submitted by a client to
+//complete, which is when they have finished, failed, expired or been
+//terminated. Instead of asking the server for the status of the jobs over
+//and over, it listens to the job events that the server publishes on its
+//status port. Since a subscriber can miss events, for example ones published
+//before the subscription reached the server, the notifier asks the server for
+//the status of the jobs once when it starts waiting on them, and once more
+//each fallbackInterval they go without an event.
+//
+//Like the futures of the client, callbacks are only invoked from the thread
+//that uses the notifier: when it waits on jobs or calls poll.
+namespace remus{
+namespace client{
+
+namespace detail { struct JobSubscriber; }
+
+class REMUSCLIENT_EXPORT JobNotifier
+{
+public:
+  typedef boost::function<void (const remus::proto::JobStatus&)> Callback;
+
+  //listen to the job events the server publishes on the given status
+  //connection, and use the client to ask for the status of jobs. The client
+  //must outlive the notifier
+  JobNotifier(remus::client::Client& client,
+              const remus::client::ServerConnection& status);
+
+  //explicit destructor since we use the pimpl idiom
+  ~JobNotifier();
+
+  //Wait up to timeoutMillisec for the job to complete, returning its status.
+  //Waits until the job completes when the timeout is negative. When the wait
+  //times out the job's last known status is returned, which is still good()
+  remus::proto::JobStatus waitForCompletion(const remus::proto::Job& job,
+                                            boost::int64_t timeoutMillisec = -1);
+
+  //Wait up to timeoutMillisec for the first of the jobs to complete,
+  //returning its status. When the wait times out the last known status of
+  //the first job is returned, which is still good()
+  remus::proto::JobStatus waitForAny(const std::vector<remus::proto::Job>& jobs,
+                                     boost::int64_t timeoutMillisec = -1);
+
+  //Invoke the callback with the status of the job once it completes.
+  //The callback is invoked the next time the notifier waits or polls
+  void waitForCompletion(const remus::proto::Job& job,
+                         const Callback& callback);
+
+  //Invoke the callback with the status of the first of the jobs to
+  //complete. The callback is invoked only once
+  void waitForAny(const std::vector<remus::proto::Job>& jobs,
+                  const Callback& callback);
+
+  //Receive the job events that have arrived, invoking the callbacks of the
+  //jobs that have completed. Waits up to timeoutMillisec for the first event
+  //when none have arrived. Returns the number of callbacks invoked
+  std::size_t poll(boost::int64_t timeoutMillisec = 0);
+
+  //the number of callbacks that haven't been invoked
+  std::size_t pendingCallbacks() const;
+
+  //how long jobs go without an event before we ask the server for their
+  //status, in case their event was missed. Defaults to 5 seconds
+  boost::int64_t fallbackInterval() const;
+  void fallbackInterval(boost::int64_t millisec);
+
+private:
+  //explicitly state the notifier doesn't support copy or move semantics
+  JobNotifier(const JobNotifier&);
+  void operator=(const JobNotifier&);
+
+  boost::scoped_ptr<detail::JobSubscriber> Subscriber;
+};
+
+}
+}
+
+#endif
@@ -22,6 +22,8 @@ REMUS_THIRDPARTY_PRE_INCLUDE
 #include <remus/proto/zmqSocketInfo.h>
 REMUS_THIRDPARTY_POST_INCLUDE
 
+#include <remus/proto/WireFormat.h>
+
 
 //forward declare the context
 namespace zmq { class context_t; }
@@ -57,10 +59,23 @@ public:
   //and most likely will crash the program
   void context(boost::shared_ptr<zmq::context_t> c) { this->Context = c; }
 
+  //the wire format that we ask the server to use when sending proto objects
+  //over this connection. The server and client fall back to the Text format
+  //when the server doesn't support the requested format. Defaults to Binary
+  remus::proto::WireFormat::Type wireFormat() const { return this->Format; }
+  void wireFormat(remus::proto::WireFormat::Type f) { this->Format = f; }
+
+  //the largest chunk that streamed submissions are sent to the server in.
+  //Streaming needs the Binary wire format, and defaults to 1MB chunks
+  std::size_t chunkSize() const { return this->ChunkSize; }
+  void chunkSize(std::size_t size) { this->ChunkSize = (size > 0) ? size : 1; }
+
 private:
   boost::shared_ptr<zmq::context_t> Context;
   std::string Endpoint;
   bool IsLocalEndpoint;
+  remus::proto::WireFormat::Type Format;
+  std::size_t ChunkSize;
 };
 
 //convert a string in the form of proto://hostname:port where :port
@@ -79,7 +94,9 @@ template<typename T>
 ServerConnection::ServerConnection(zmq::socketInfo<T> const& socket):
   Context( remus::client::make_ServerContext() ),
   Endpoint(socket.endpoint()),
-  IsLocalEndpoint( zmq::isLocalEndpoint(socket) )
+  IsLocalEndpoint( zmq::isLocalEndpoint(socket) ),
+  Format( remus::proto::WireFormat::Binary ),
+  ChunkSize(1024*1024)
 {
 }
 
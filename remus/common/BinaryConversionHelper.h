@@ -0,0 +1,295 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_common_BinaryConversionHelper_h
+#define remus_common_BinaryConversionHelper_h
+
+#include <remus/common/CompilerInformation.h>
+#include <remus/common/ConditionalStorage.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/cstdint.hpp>
+#include <boost/shared_array.hpp>
+#include <boost/shared_ptr.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <cstddef>
+#include <string>
+
+//The binary wire encoding of the proto objects. Every encoded object starts
+//with a four byte header of a null byte, the character 'R', the version of
+//the encoding and a tag that states what object follows. Text encoded
+//objects never start with a null byte, which is what allows decoders to
+//accept both encodings.
+//
+//All integers are written as fixed width little endian values, and
+//strings and blobs are written as a 64bit length followed by the raw bytes.
+namespace remus {
+namespace internal
+{
+
+//the version of the binary encoding that we write
+static const boost::uint8_t BinaryEncodingVersion = 1;
+
+//the object that follows the header of a binary encoded message
+struct BinaryTag
+{
+  enum Type { JobContent = 1,
+              JobRequirements = 2,
+              JobSubmission = 3,
+              JobResult = 4,
+              JobStatus = 5,
+              WorkerJob = 6,
+              Transfer = 7,
+              Batch = 8 };
+};
+
+//------------------------------------------------------------------------------
+//returns true if the data starts with a binary header
+inline bool isBinaryEncoded(const char* data, std::size_t size)
+{
+  return size >= 4 && data != NULL && data[0] == '\0' && data[1] == 'R';
+}
+
+//------------------------------------------------------------------------------
+//appends binary encoded values to a string. The string is the only
+//copy made of the data passed in, so callers should reserve the string
+//when they know how large the encoded object is.
+class BinaryWriter
+{
+public:
+  explicit BinaryWriter(std::string& buffer):
+    Buffer(buffer)
+  {
+  }
+
+  void writeHeader(BinaryTag::Type tag)
+  {
+    this->Buffer.push_back('\0');
+    this->Buffer.push_back('R');
+    this->writeUInt8(BinaryEncodingVersion);
+    this->writeUInt8(static_cast<boost::uint8_t>(tag));
+  }
+
+  void writeUInt8(boost::uint8_t value)
+  {
+    this->Buffer.push_back(static_cast<char>(value));
+  }
+
+  void writeUInt32(boost::uint32_t value)
+  {
+    char bytes[4];
+    for(int i=0; i < 4; ++i)
+      {
+      bytes[i] = static_cast<char>( (value >> (8*i)) & 0xFF );
+      }
+    this->Buffer.append(bytes, 4);
+  }
+
+  void writeUInt64(boost::uint64_t value)
+  {
+    char bytes[8];
+    for(int i=0; i < 8; ++i)
+      {
+      bytes[i] = static_cast<char>( (value >> (8*i)) & 0xFF );
+      }
+    this->Buffer.append(bytes, 8);
+  }
+
+  //write raw bytes with no length prefix, used for fixed width values
+  //such as uuids
+  void writeBytes(const char* data, std::size_t size)
+  {
+    if(size > 0)
+      {
+      this->Buffer.append(data, size);
+      }
+  }
+
+  //write a length prefixed blob
+  void writeBlob(const char* data, std::size_t size)
+  {
+    this->writeUInt64(static_cast<boost::uint64_t>(size));
+    this->writeBytes(data, size);
+  }
+
+  void writeString(const std::string& str)
+  {
+    this->writeBlob(str.data(), str.size());
+  }
+
+  //the number of bytes a blob of the given size is encoded in
+  static std::size_t blobSize(std::size_t size) { return 8 + size; }
+
+private:
+  std::string& Buffer;
+};
+
+//------------------------------------------------------------------------------
+//reads binary encoded values out of a buffer. Reading past the end of the
+//buffer marks the reader as bad, and all reads from a bad reader return
+//zero or empty values. Decoders only need to check good() once they are done.
+//
+//When the reader is given the owner of the buffer, blobs read with
+//readSharedBlob point into the buffer and keep the owner alive, instead of
+//being copied.
+class BinaryReader
+{
+public:
+  BinaryReader(const char* data, std::size_t size):
+    Data(data),
+    Size(size),
+    Position(0),
+    Good(data != NULL || size == 0),
+    Owner()
+  {
+  }
+
+  BinaryReader(const char* data, std::size_t size,
+               const boost::shared_ptr<const void>& owner):
+    Data(data),
+    Size(size),
+    Position(0),
+    Good(data != NULL || size == 0),
+    Owner(owner)
+  {
+  }
+
+  bool good() const { return this->Good; }
+
+  //the bytes that haven't been read yet
+  std::size_t remaining() const { return this->Size - this->Position; }
+
+  //the location in the buffer of the next byte to be read
+  const char* current() const { return this->Data + this->Position; }
+
+  //returns false and marks the reader as bad if the header is not for
+  //the given tag, or is from a newer version of the encoding than we
+  //understand
+  bool readHeader(BinaryTag::Type tag)
+  {
+    if(!isBinaryEncoded(this->current(), this->remaining()))
+      {
+      this->Good = false;
+      return false;
+      }
+    this->Position += 2;
+    const boost::uint8_t version = this->readUInt8();
+    const boost::uint8_t t = this->readUInt8();
+    if(version == 0 || version > BinaryEncodingVersion ||
+       t != static_cast<boost::uint8_t>(tag))
+      {
+      this->Good = false;
+      }
+    return this->Good;
+  }
+
+  boost::uint8_t readUInt8()
+  {
+    const char* bytes = this->readBytes(1);
+    return bytes ? static_cast<boost::uint8_t>(bytes[0]) : 0;
+  }
+
+  boost::uint32_t readUInt32()
+  {
+    boost::uint32_t value = 0;
+    const char* bytes = this->readBytes(4);
+    for(int i=0; bytes && i < 4; ++i)
+      {
+      value |= static_cast<boost::uint32_t>(
+                  static_cast<unsigned char>(bytes[i])) << (8*i);
+      }
+    return value;
+  }
+
+  boost::uint64_t readUInt64()
+  {
+    boost::uint64_t value = 0;
+    const char* bytes = this->readBytes(8);
+    for(int i=0; bytes && i < 8; ++i)
+      {
+      value |= static_cast<boost::uint64_t>(
+                  static_cast<unsigned char>(bytes[i])) << (8*i);
+      }
+    return value;
+  }
+
+  //returns a pointer into the buffer for the next size bytes, or NULL
+  //if the buffer doesn't have that many bytes left
+  const char* readBytes(std::size_t size)
+  {
+    if(!this->Good || size > this->remaining())
+      {
+      this->Good = false;
+      return NULL;
+      }
+    const char* bytes = this->current();
+    this->Position += size;
+    return bytes;
+  }
+
+  //returns a pointer into the buffer for a length prefixed blob. No copy
+  //of the blob is made
+  const char* readBlob(std::size_t& size)
+  {
+    const boost::uint64_t len = this->readUInt64();
+    if(!this->Good || len > this->remaining())
+      {
+      this->Good = false;
+      size = 0;
+      return NULL;
+      }
+    size = static_cast<std::size_t>(len);
+    return this->readBytes(size);
+  }
+
+  //returns a length prefixed blob that shares ownership of the buffer
+  //when we know the owner of the buffer, otherwise the blob is copied.
+  //Empty blobs are returned as a NULL array
+  boost::shared_array<char> readSharedBlob(std::size_t& size)
+  {
+    const char* bytes = this->readBlob(size);
+    if(bytes == NULL || size == 0)
+      {
+      size = 0;
+      return boost::shared_array<char>();
+      }
+
+    if(this->Owner)
+      {
+      return remus::common::make_SharedView(this->Owner, bytes);
+      }
+
+    boost::shared_array<char> storage( new char[size] );
+    std::memcpy(storage.get(), bytes, size);
+    return storage;
+  }
+
+  std::string readString()
+  {
+    std::size_t size = 0;
+    const char* bytes = this->readBlob(size);
+    return (bytes && size > 0) ? std::string(bytes, size) : std::string();
+  }
+
+private:
+  const char* Data;
+  std::size_t Size;
+  std::size_t Position;
+  bool Good;
+  boost::shared_ptr<const void> Owner;
+};
+
+}
+}
+
+#endif
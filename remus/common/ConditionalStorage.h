@@ -15,6 +15,7 @@
 
 #include <cstring> //for memcpy
 #include <boost/shared_array.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
 #include <vector>
 
@@ -22,6 +23,32 @@
 namespace remus {
 namespace common {
 
+//a shared_array deleter that never frees the memory it is given. Instead it
+//holds a reference to the object that owns the memory, which allows a
+//shared_array to point into a buffer that something else owns, such as
+//a received zmq message, while keeping that buffer alive.
+struct KeepOwnerAlive
+{
+  explicit KeepOwnerAlive(const boost::shared_ptr<const void>& owner):
+    Owner(owner)
+  {
+  }
+
+  void operator()(char*) const {}
+
+  boost::shared_ptr<const void> Owner;
+};
+
+//construct a shared_array that points into memory held by owner, no copy
+//of the memory is made
+inline boost::shared_array<char> make_SharedView(
+                                const boost::shared_ptr<const void>& owner,
+                                const char* data)
+{
+  return boost::shared_array<char>(const_cast<char*>(data),
+                                   KeepOwnerAlive(owner));
+}
+
 //a special struct that will copy the data passed in, only if the item
 //coming in has a size greater than zero.
 struct ConditionalStorage
@@ -12,12 +12,549 @@
 
 #include <remus/common/ExecuteProcess.h>
 
-#include <RemusSysTools/Process.h>
+#ifdef REMUS_HAVE_POSIX_SPAWN
+# include <errno.h>
+# include <fcntl.h>
+# include <poll.h>
+# include <sched.h>
+# include <signal.h>
+# include <spawn.h>
+# include <sys/resource.h>
+# include <sys/stat.h>
+# include <sys/types.h>
+# include <sys/wait.h>
+# include <unistd.h>
+# include <cstring>
+# include <fstream>
+# include <sstream>
+extern char **environ;
+#else
+# include <RemusSysTools/Process.h>
+# include <remus/common/CompilerInformation.h>
+REMUS_THIRDPARTY_PRE_INCLUDE
+# include <boost/thread/locks.hpp>
+# include <boost/thread/mutex.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+#endif
 
 #include <stdlib.h>
 
 namespace{
 
+typedef std::map<std::string,std::string> envmap_t;
+
+#ifdef REMUS_HAVE_POSIX_SPAWN
+
+//----------------------------------------------------------------------------
+//create a pipe whose ends aren't inherited by the processes we launch.
+//The ends that a process should have are handed to it by the spawn file
+//actions, which clear the close on exec flag of the descriptor they dup to.
+//Without this a worker launched by another thread at the same time would
+//hold on to the write end of our pipes, and we would never see them close
+bool make_pipe(int fds[2])
+  {
+#if defined(__linux__)
+  return pipe2(fds, O_CLOEXEC) == 0;
+#else
+  if(pipe(fds) != 0)
+    {
+    return false;
+    }
+  fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+  return true;
+#endif
+  }
+
+//----------------------------------------------------------------------------
+void close_fd(int& fd)
+  {
+  if(fd >= 0)
+    {
+    ::close(fd);
+    fd = -1;
+    }
+  }
+
+//----------------------------------------------------------------------------
+//build the environment of the launched process, which is the environment
+//of this process with the requested variables added or replaced. The
+//environment of this process is never modified, so processes can be
+//launched from many threads at once
+std::vector<std::string> make_environment(const envmap_t& env)
+  {
+  std::vector<std::string> result;
+  for(char** var = environ; var && *var; ++var)
+    {
+    const char* eq = std::strchr(*var,'=');
+    const std::string name = eq ? std::string(*var, eq - *var) :
+                                  std::string(*var);
+    if(env.find(name) == env.end())
+      {
+      result.push_back(*var);
+      }
+    }
+  for(envmap_t::const_iterator it = env.begin(); it != env.end(); ++it)
+    {
+    result.push_back(it->first + "=" + it->second);
+    }
+  return result;
+  }
+
+//----------------------------------------------------------------------------
+//a null terminated array of pointers into strings, which has to outlive
+//the array
+std::vector<char*> make_argv(const std::vector<std::string>& strings)
+  {
+  std::vector<char*> result;
+  result.reserve(strings.size() + 1);
+  for(std::size_t i=0; i < strings.size(); ++i)
+    {
+    result.push_back(const_cast<char*>(strings[i].c_str()));
+    }
+  result.push_back(NULL);
+  return result;
+  }
+
+//----------------------------------------------------------------------------
+//what a stream of a launched process is connected to, either a copy of one
+//of our descriptors or a file that is opened by the process
+struct FileAction
+  {
+  FileAction(int fd, int source):
+    Fd(fd), Source(source), Path(), Flags(0) {}
+  FileAction(int fd, const std::string& path, int flags):
+    Fd(fd), Source(-1), Path(path), Flags(flags) {}
+
+  int Fd;
+  int Source;
+  std::string Path;
+  int Flags;
+  };
+typedef std::vector<FileAction> FileActions;
+
+//----------------------------------------------------------------------------
+//the limits a process applies to itself between fork and exec, so that
+//they are in place before it runs. Everything the process needs is worked
+//out before the fork, since the process can only make system calls
+struct ChildLimits
+  {
+  ChildLimits():
+    ProcsFile(),
+    HaveOpenFiles(false),
+    HaveAddressSpace(false),
+    HaveAffinity(false)
+    {
+    }
+
+  //the cgroup.procs file of the cgroup the process joins
+  std::string ProcsFile;
+
+  bool HaveOpenFiles;
+  struct rlimit OpenFiles;
+
+  bool HaveAddressSpace;
+  struct rlimit AddressSpace;
+
+  bool HaveAffinity;
+#if defined(__linux__)
+  cpu_set_t Affinity;
+#endif
+  };
+
+//----------------------------------------------------------------------------
+bool write_value(const std::string& path, const std::string& value)
+  {
+  const int fd = ::open(path.c_str(), O_WRONLY|O_CLOEXEC);
+  if(fd < 0)
+    {
+    return false;
+    }
+  const ssize_t written = ::write(fd, value.c_str(), value.size());
+  const bool closed = (::close(fd) == 0);
+  return closed && written == static_cast<ssize_t>(value.size());
+  }
+
+#if defined(__linux__)
+
+//----------------------------------------------------------------------------
+//the directory of the cgroup v2 group this process is in, or an empty
+//string when the cgroup v2 hierarchy isn't mounted
+std::string own_control_group()
+  {
+  std::string mount;
+  std::string line;
+  std::ifstream mounts("/proc/self/mountinfo");
+  while(mount.empty() && std::getline(mounts,line))
+    {
+    //the file system type comes after the separator, and the mount point
+    //is the fifth field
+    const std::string::size_type sep = line.find(" - ");
+    if(sep != std::string::npos && line.compare(sep + 3, 8, "cgroup2 ") == 0)
+      {
+      std::istringstream fields(line);
+      for(int i=0; i < 5; ++i)
+        {
+        fields >> mount;
+        }
+      }
+    }
+  if(mount.empty())
+    {
+    return std::string();
+    }
+
+  std::ifstream groups("/proc/self/cgroup");
+  while(std::getline(groups,line))
+    {
+    if(line.compare(0, 3, "0::") == 0)
+      {
+      return mount + line.substr(3);
+      }
+    }
+  return std::string();
+  }
+
+//----------------------------------------------------------------------------
+//parse a list of cpus such as "0-3,6"
+bool parse_cpu_set(const std::string& text, cpu_set_t& cpus)
+  {
+  CPU_ZERO(&cpus);
+  bool haveCpu = false;
+  std::istringstream ranges(text);
+  std::string range;
+  while(std::getline(ranges, range, ','))
+    {
+    std::istringstream buffer(range);
+    int first = 0;
+    if(!(buffer >> first) || first < 0)
+      {
+      return false;
+      }
+    int last = first;
+    char dash = 0;
+    if(buffer >> dash && (dash != '-' || !(buffer >> last)))
+      {
+      return false;
+      }
+    for(int cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+      {
+      CPU_SET(cpu, &cpus);
+      haveCpu = true;
+      }
+    }
+  return haveCpu;
+  }
+
+//----------------------------------------------------------------------------
+//make a cgroup with the limits that cgroups apply, returning its directory,
+//or an empty string when we can't make one that applies all of them
+std::string make_control_group(const remus::common::ProcessLimits& limits,
+                               const std::string& name)
+  {
+  const bool limitMemory = limits.MaxMemoryBytes >= 0;
+  const bool limitCpu = limits.CpuQuota > 0;
+  const bool limitCpuSet = !limits.CpuSet.empty();
+  if(!limitMemory && !limitCpu && !limitCpuSet)
+    {
+    return std::string();
+    }
+
+  const std::string parent = limits.ControlGroupParent.empty() ?
+                             own_control_group() : limits.ControlGroupParent;
+  if(parent.empty())
+    {
+    return std::string();
+    }
+
+  //hand the controllers down to the groups under the parent. This fails
+  //when they already are, or when the parent can't hand them down, which
+  //we find out when setting the limits
+  const std::string subtree = parent + "/cgroup.subtree_control";
+  if(limitMemory) { write_value(subtree, "+memory"); }
+  if(limitCpu) { write_value(subtree, "+cpu"); }
+  if(limitCpuSet) { write_value(subtree, "+cpuset"); }
+
+  const std::string group = parent + "/" + name;
+  if(::mkdir(group.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+    return std::string();
+    }
+
+  bool applied = true;
+  if(limitMemory)
+    {
+    std::ostringstream bytes;
+    bytes << limits.MaxMemoryBytes;
+    applied = write_value(group + "/memory.max", bytes.str()) && applied;
+
+    //the process shouldn't get around the limit by swapping, which can
+    //only be stopped when swap is accounted for
+    write_value(group + "/memory.swap.max", "0");
+    }
+  if(limitCpu)
+    {
+    const boost::int64_t period = 100000;
+    std::ostringstream quota;
+    quota << static_cast<boost::int64_t>(limits.CpuQuota * period) << " "
+          << period;
+    applied = write_value(group + "/cpu.max", quota.str()) && applied;
+    }
+  if(limitCpuSet)
+    {
+    applied = write_value(group + "/cpuset.cpus", limits.CpuSet) && applied;
+    }
+
+  if(!applied)
+    {
+    ::rmdir(group.c_str());
+    return std::string();
+    }
+  return group;
+  }
+
+//----------------------------------------------------------------------------
+//has the memory controller of the group killed a process for going over
+//the memory limit of the group
+bool oom_killed(const std::string& group)
+  {
+  std::ifstream events( (group + "/memory.events").c_str() );
+  std::string key;
+  boost::int64_t count = 0;
+  while(events >> key >> count)
+    {
+    if(key == "oom_kill" && count > 0)
+      {
+      return true;
+      }
+    }
+  return false;
+  }
+
+#endif
+
+//----------------------------------------------------------------------------
+//work out how the limits are applied. Limits that a cgroup can apply are
+//applied by a cgroup made for the process, whose directory is returned
+//in group, and the rest by the process itself
+ChildLimits make_child_limits(const remus::common::ProcessLimits& limits,
+                              const std::string& name,
+                              std::string& group)
+  {
+  ChildLimits child;
+  group.clear();
+#if defined(__linux__)
+  group = make_control_group(limits, name);
+  if(!group.empty())
+    {
+    child.ProcsFile = group + "/cgroup.procs";
+    }
+  else if(!limits.CpuSet.empty())
+    {
+    child.HaveAffinity = parse_cpu_set(limits.CpuSet, child.Affinity);
+    }
+#else
+  (void)name;
+#endif
+
+  if(group.empty() && limits.MaxMemoryBytes >= 0)
+    {
+    child.HaveAddressSpace = true;
+    child.AddressSpace.rlim_cur = static_cast<rlim_t>(limits.MaxMemoryBytes);
+    child.AddressSpace.rlim_max = static_cast<rlim_t>(limits.MaxMemoryBytes);
+    }
+  if(limits.MaxOpenFiles >= 0)
+    {
+    child.HaveOpenFiles = true;
+    child.OpenFiles.rlim_cur = static_cast<rlim_t>(limits.MaxOpenFiles);
+    child.OpenFiles.rlim_max = static_cast<rlim_t>(limits.MaxOpenFiles);
+    }
+  return child;
+  }
+
+//----------------------------------------------------------------------------
+//find the executable the way posix_spawnp does, by searching the PATH
+//when the command isn't a path
+std::string find_executable(const std::string& command)
+  {
+  if(command.find('/') != std::string::npos)
+    {
+    return command;
+    }
+  const char* path = getenv("PATH");
+  std::istringstream dirs(path ? path : "/usr/bin:/bin");
+  std::string dir;
+  while(std::getline(dirs, dir, ':'))
+    {
+    const std::string candidate = (dir.empty() ? "." : dir) + "/" + command;
+    if(::access(candidate.c_str(), X_OK) == 0)
+      {
+      return candidate;
+      }
+    }
+  return command;
+  }
+
+//----------------------------------------------------------------------------
+//launch a process with posix_spawn, returning 0 or the error that stopped
+//the process from being launched
+int spawn_process(pid_t* pid, char* const* argv, char* const* envp,
+                  const FileActions& fileActions,
+                  const posix_spawnattr_t* attributes)
+  {
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  for(FileActions::const_iterator i=fileActions.begin();
+      i != fileActions.end(); ++i)
+    {
+    if(i->Source >= 0)
+      {
+      posix_spawn_file_actions_adddup2(&actions, i->Source, i->Fd);
+      }
+    else
+      {
+      posix_spawn_file_actions_addopen(&actions, i->Fd, i->Path.c_str(),
+                                       i->Flags, 0666);
+      }
+    }
+  const int error = posix_spawnp(pid, argv[0], &actions, attributes,
+                                 argv, envp);
+  posix_spawn_file_actions_destroy(&actions);
+  return error;
+  }
+
+//----------------------------------------------------------------------------
+//tell the parent why a forked child couldn't execute, and exit. Only
+//async signal safe calls are made
+void child_failed(int statusFd, int error)
+  {
+  ssize_t ignored = ::write(statusFd, &error, sizeof(error));
+  (void)ignored;
+  _exit(127);
+  }
+
+//----------------------------------------------------------------------------
+//launch a process with fork and exec, so that the process can apply its
+//limits before it runs. Returns 0 or the error that stopped the process
+//from being launched, which the process tells us through a pipe that is
+//closed when exec succeeds
+int fork_process(pid_t* pid, const std::string& path,
+                 char* const* argv, char* const* envp,
+                 const FileActions& fileActions, const ChildLimits& limits)
+  {
+  int status[2];
+  if(!make_pipe(status))
+    {
+    return errno;
+    }
+
+  *pid = fork();
+  if(*pid == 0)
+    {
+    //only async signal safe calls from here on
+    if(!limits.ProcsFile.empty())
+      {
+      //the memory limit is only applied by the group, so a process that
+      //can't join it must not run
+      const int procs = ::open(limits.ProcsFile.c_str(), O_WRONLY|O_CLOEXEC);
+      if(procs < 0)
+        {
+        child_failed(status[1], errno);
+        }
+      //writing 0 moves the process that writes it
+      if(::write(procs, "0", 1) != 1)
+        {
+        child_failed(status[1], errno != 0 ? errno : EIO);
+        }
+      ::close(procs);
+      }
+    if(limits.HaveOpenFiles)
+      {
+      setrlimit(RLIMIT_NOFILE, &limits.OpenFiles);
+      }
+    if(limits.HaveAddressSpace)
+      {
+      setrlimit(RLIMIT_AS, &limits.AddressSpace);
+      }
+#if defined(__linux__)
+    if(limits.HaveAffinity)
+      {
+      sched_setaffinity(0, sizeof(limits.Affinity), &limits.Affinity);
+      }
+#endif
+
+    //start with no blocked signals, and the default behavior for SIGPIPE
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigprocmask(SIG_SETMASK, &signals, NULL);
+    signal(SIGPIPE, SIG_DFL);
+
+    for(FileActions::const_iterator i=fileActions.begin();
+        i != fileActions.end(); ++i)
+      {
+      int source = i->Source;
+      if(source < 0)
+        {
+        source = ::open(i->Path.c_str(), i->Flags, 0666);
+        }
+      if(source == i->Fd)
+        {
+        fcntl(source, F_SETFD, 0);
+        }
+      else if(source >= 0)
+        {
+        dup2(source, i->Fd);
+        if(i->Source < 0)
+          {
+          ::close(source);
+          }
+        }
+      }
+
+    execve(path.c_str(), argv, envp);
+    child_failed(status[1], errno);
+    }
+
+  ::close(status[1]);
+  if(*pid < 0)
+    {
+    const int error = errno;
+    ::close(status[0]);
+    return error;
+    }
+
+  int error = 0;
+  ssize_t length = 0;
+  do
+    {
+    length = ::read(status[0], &error, sizeof(error));
+    }
+  while(length < 0 && errno == EINTR);
+  ::close(status[0]);
+
+  if(length == static_cast<ssize_t>(sizeof(error)))
+    {
+    //exec failed, so the process has already exited
+    waitpid(*pid, NULL, 0);
+    return error;
+    }
+  return 0;
+  }
+
+#else
+
+//----------------------------------------------------------------------------
+//RemusSysTools launches processes with the environment of this process, so
+//the requested variables have to be set on it while the process is
+//launched. Only a single process is launched at a time, so that processes
+//launched from different threads don't see each others environment
+boost::mutex& environment_mutex()
+  {
+  static boost::mutex mutex;
+  return mutex;
+  }
+
+//----------------------------------------------------------------------------
 remus::common::ProcessPipe::PipeType toProcessPipeType(int type)
   {
   typedef remus::common::ProcessPipe PPipe;
@@ -48,10 +585,10 @@ remus::common::ProcessPipe::PipeType toProcessPipeType(int type)
   return pipeType;
   }
 
+//----------------------------------------------------------------------------
 int fromProcessPipeType(remus::common::ProcessPipe::PipeType type)
   {
   typedef remus::common::ProcessPipe PPipe;
-  typedef remus::common::ProcessPipe::PipeType PipeType;
 
   RemusSysToolsProcess_Pipes_e pipeType;
   switch(type)
@@ -75,31 +612,629 @@ int fromProcessPipeType(remus::common::ProcessPipe::PipeType type)
     }
   return pipeType;
   }
+#endif
 }
 
 namespace remus{
 namespace common{
 
+#ifdef REMUS_HAVE_POSIX_SPAWN
+
+//----------------------------------------------------------------------------
+//Launches the processes with posix_spawn, which doesn't copy the address
+//space of the server the way fork does, and hands each process its own
+//environment instead of modifying the one of the server.
+struct ExecuteProcess::Process
+{
+  enum State
+    {
+    Starting,
+    Executing,
+    Exited,
+    Killed,
+    Exception,
+    Error
+    };
+
+  State ProcState;
+  std::vector<pid_t> Pids;
+  std::vector<int> Statuses;
+
+  //the cgroup that applies the limits of the processes, and whether the
+  //processes went over the memory limit of the group
+  std::string ControlGroup;
+  bool MemoryExceeded;
+
+  //the exit code of the last process, which is only valid once it has
+  //exited by itself
+  int ExitCode;
+
+  //indexed by ProcessPipe::PipeType
+  bool Shared[4];
+  std::string Files[4];
+  int Output[4];
+
+  char Buffer[4096];
+
+  //--------------------------------------------------------------------------
+  Process():
+    ProcState(Starting),
+    Pids(),
+    Statuses(),
+    ControlGroup(),
+    MemoryExceeded(false),
+    ExitCode(-1)
+    {
+    for(int i=0; i < 4; ++i)
+      {
+      this->Shared[i] = false;
+      this->Output[i] = -1;
+      }
+    this->Shared[ProcessPipe::STDIN] = true;
+    }
+
+  //--------------------------------------------------------------------------
+  //running processes are left running, the same as RemusSysTools does
+  ~Process()
+    {
+    for(int i=0; i < 4; ++i)
+      {
+      close_fd(this->Output[i]);
+      }
+    this->update(WNOHANG);
+    }
+
+  //--------------------------------------------------------------------------
+  bool created() const { return this->ProcState != Starting; }
+
+  //--------------------------------------------------------------------------
+  void setShared(ProcessPipe::PipeType pipe, bool choice)
+    {
+    if(pipe >= ProcessPipe::STDIN && pipe <= ProcessPipe::STDERR)
+      {
+      this->Shared[pipe] = choice;
+      }
+    }
+
+  //--------------------------------------------------------------------------
+  void setFile(ProcessPipe::PipeType pipe, const std::string& filename)
+    {
+    if(pipe >= ProcessPipe::STDIN && pipe <= ProcessPipe::STDERR)
+      {
+      this->Files[pipe] = filename;
+      }
+    }
+
+  //--------------------------------------------------------------------------
+  //state what the given stream of a process is connected to. Streams that
+  //aren't shared, redirected to a file, or captured by us read from or
+  //write to /dev/null
+  void redirect(FileActions& actions,
+                ProcessPipe::PipeType pipe, int captured) const
+    {
+    const int fd = static_cast<int>(pipe) - 1;
+    const int flags = (pipe == ProcessPipe::STDIN) ? O_RDONLY :
+                                                     O_WRONLY|O_CREAT|O_TRUNC;
+    if(!this->Files[pipe].empty())
+      {
+      actions.push_back( FileAction(fd, this->Files[pipe], flags) );
+      }
+    else if(captured >= 0)
+      {
+      actions.push_back( FileAction(fd, captured) );
+      }
+    else if(!this->Shared[pipe])
+      {
+      actions.push_back( FileAction(fd, "/dev/null", flags) );
+      }
+    }
+
+  //--------------------------------------------------------------------------
+  //launches every command, with the output of each piped to the input of
+  //the next. Processes with limits are launched with fork and exec, so
+  //that they apply their limits before they run
+  void execute(const std::vector<ExecuteProcess::Command>& commands,
+               const envmap_t& env,
+               const ProcessLimits& limits)
+    {
+    this->ProcState = Error;
+
+    //the pipes we capture the output of the processes with, the error
+    //pipe is shared by every process
+    int outPipe[2] = {-1, -1};
+    int errPipe[2] = {-1, -1};
+    const bool captureOut = !this->Shared[ProcessPipe::STDOUT] &&
+                            this->Files[ProcessPipe::STDOUT].empty();
+    const bool captureErr = !this->Shared[ProcessPipe::STDERR] &&
+                            this->Files[ProcessPipe::STDERR].empty();
+    if( (captureOut && !make_pipe(outPipe)) ||
+        (captureErr && !make_pipe(errPipe)) )
+      {
+      close_fd(outPipe[0]); close_fd(outPipe[1]);
+      return;
+      }
+
+    const std::vector<std::string> environment = make_environment(env);
+    std::vector<char*> envp = make_argv(environment);
+
+    //every process starts with no blocked signals, and with the default
+    //behavior for SIGPIPE even if the server ignores it
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attributes, &signals);
+    sigaddset(&signals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attributes, &signals);
+    posix_spawnattr_setflags(&attributes,
+                             POSIX_SPAWN_SETSIGMASK|POSIX_SPAWN_SETSIGDEF);
+
+    const bool limited = limits.limited();
+    ChildLimits childLimits;
+    if(limited)
+      {
+      std::ostringstream name;
+      name << "remus-" << getpid() << "-" << static_cast<const void*>(this);
+      childLimits = make_child_limits(limits, name.str(), this->ControlGroup);
+      }
+
+    bool launchedAll = true;
+    int previousOut = -1;
+    for(std::size_t i=0; i < commands.size() && launchedAll; ++i)
+      {
+      const bool first = (i == 0);
+      const bool last = (i + 1 == commands.size());
+
+      int link[2] = {-1, -1};
+      if(!last && !make_pipe(link))
+        {
+        launchedAll = false;
+        break;
+        }
+
+      FileActions actions;
+      if(first)
+        {
+        this->redirect(actions, ProcessPipe::STDIN, -1);
+        }
+      else
+        {
+        actions.push_back( FileAction(0, previousOut) );
+        }
+
+      if(last)
+        {
+        this->redirect(actions, ProcessPipe::STDOUT, outPipe[1]);
+        }
+      else
+        {
+        actions.push_back( FileAction(1, link[1]) );
+        }
+      this->redirect(actions, ProcessPipe::STDERR, errPipe[1]);
+
+      std::vector<std::string> arguments(1, commands[i].Cmd);
+      arguments.insert(arguments.end(),
+                       commands[i].Args.begin(), commands[i].Args.end());
+      std::vector<char*> argv = make_argv(arguments);
+
+      pid_t pid = 0;
+      int error = 0;
+      if(limited)
+        {
+        error = fork_process(&pid, find_executable(commands[i].Cmd),
+                             &argv[0], &envp[0], actions, childLimits);
+        }
+      else
+        {
+        error = spawn_process(&pid, &argv[0], &envp[0], actions, &attributes);
+        }
+
+      close_fd(previousOut);
+      close_fd(link[1]);
+      previousOut = link[0];
+
+      if(error == 0)
+        {
+        this->Pids.push_back(pid);
+        this->Statuses.push_back(0);
+        }
+      else
+        {
+        launchedAll = false;
+        }
+      }
+    close_fd(previousOut);
+    posix_spawnattr_destroy(&attributes);
+
+    //we only keep the read ends of the pipes we capture output with
+    close_fd(outPipe[1]);
+    close_fd(errPipe[1]);
+    this->Output[ProcessPipe::STDOUT] = outPipe[0];
+    this->Output[ProcessPipe::STDERR] = errPipe[0];
+
+    if(launchedAll)
+      {
+      this->ProcState = Executing;
+      }
+    else
+      {
+      //the pipeline is broken, so take down any part of it that started
+      this->ProcState = Executing;
+      this->kill();
+      this->ProcState = Error;
+      }
+    }
+
+  //--------------------------------------------------------------------------
+  //reap the processes that have exited. The state of the processes is
+  //the one of the last process, once every process has exited
+  void update(int options)
+    {
+    if(this->ProcState != Executing)
+      {
+      return;
+      }
+
+    bool allExited = true;
+    for(std::size_t i=0; i < this->Pids.size(); ++i)
+      {
+      if(this->Pids[i] <= 0)
+        {
+        continue;
+        }
+      int status = 0;
+      pid_t result = 0;
+      do
+        {
+        result = waitpid(this->Pids[i], &status, options);
+        }
+      while(result < 0 && errno == EINTR);
+
+      if(result == this->Pids[i] || result < 0)
+        {
+        this->Statuses[i] = status;
+        this->Pids[i] = 0;
+        }
+      else
+        {
+        allExited = false;
+        }
+      }
+
+    if(allExited)
+      {
+#if defined(__linux__)
+      //the group can only be removed once it is empty
+      if(!this->ControlGroup.empty())
+        {
+        this->MemoryExceeded = oom_killed(this->ControlGroup);
+        ::rmdir(this->ControlGroup.c_str());
+        this->ControlGroup.clear();
+        }
+#endif
+      const int status = this->Statuses.empty() ? 0 : this->Statuses.back();
+      if(WIFSIGNALED(status))
+        {
+        this->ProcState =
+          (WTERMSIG(status) == SIGKILL) ? Killed : Exception;
+        }
+      else
+        {
+        this->ProcState = Exited;
+        this->ExitCode = WEXITSTATUS(status);
+        }
+      }
+    }
+
+  //--------------------------------------------------------------------------
+  bool kill()
+    {
+    this->update(WNOHANG);
+    if(this->ProcState != Executing)
+      {
+      return false;
+      }
+    for(std::size_t i=0; i < this->Pids.size(); ++i)
+      {
+      if(this->Pids[i] > 0)
+        {
+        ::kill(this->Pids[i], SIGKILL);
+        }
+      }
+    this->update(0);
+    this->ProcState = Killed;
+    return true;
+    }
+
+  //--------------------------------------------------------------------------
+  bool isAlive()
+    {
+    this->update(WNOHANG);
+    return this->ProcState == Executing;
+    }
+
+  //--------------------------------------------------------------------------
+  bool exitedNormally()
+    {
+    this->update(WNOHANG);
+    return this->ProcState == Exited && this->ExitCode == 0;
+    }
+
+  //--------------------------------------------------------------------------
+  int exitCode()
+    {
+    this->update(WNOHANG);
+    return (this->ProcState == Exited) ? this->ExitCode : -1;
+    }
+
+  //--------------------------------------------------------------------------
+  bool exceededMemoryLimit()
+    {
+    this->update(WNOHANG);
+    return this->MemoryExceeded;
+    }
+
+  //--------------------------------------------------------------------------
+  //the timeout is in seconds, with a negative timeout blocking until
+  //there is output
+  ProcessPipe poll(double timeout)
+    {
+    const int timeoutMillisec = (timeout < 0) ? -1 :
+                                static_cast<int>(timeout * 1000);
+    while(true)
+      {
+      struct pollfd fds[2];
+      ProcessPipe::PipeType types[2];
+      nfds_t count = 0;
+      for(int i=ProcessPipe::STDOUT; i <= ProcessPipe::STDERR; ++i)
+        {
+        if(this->Output[i] >= 0)
+          {
+          fds[count].fd = this->Output[i];
+          fds[count].events = POLLIN;
+          fds[count].revents = 0;
+          types[count] = static_cast<ProcessPipe::PipeType>(i);
+          ++count;
+          }
+        }
+      if(count == 0)
+        {
+        this->update(WNOHANG);
+        return ProcessPipe(ProcessPipe::None);
+        }
+
+      const int ready = ::poll(fds, count, timeoutMillisec);
+      if(ready < 0 && errno == EINTR)
+        {
+        continue;
+        }
+      if(ready <= 0)
+        {
+        return ProcessPipe(ProcessPipe::Timeout);
+        }
+
+      for(nfds_t i=0; i < count; ++i)
+        {
+        if(fds[i].revents == 0)
+          {
+          continue;
+          }
+        const ssize_t length = ::read(fds[i].fd, this->Buffer,
+                                      sizeof(this->Buffer));
+        if(length > 0)
+          {
+          ProcessPipe result(types[i]);
+          result.text = std::string(this->Buffer, length);
+          return result;
+          }
+        if(length == 0 || errno != EINTR)
+          {
+          //the process closed the pipe
+          close_fd(this->Output[types[i]]);
+          }
+        }
+      }
+    }
+};
+
+#else
+
 //----------------------------------------------------------------------------
 struct ExecuteProcess::Process
 {
-public:
   RemusSysToolsProcess *Proc;
   bool Created;
+
+  //--------------------------------------------------------------------------
   Process():Created(false)
     {
     this->Proc = RemusSysToolsProcess_New();
     }
+
+  //--------------------------------------------------------------------------
   ~Process()
     {
-    if(this->Created)
+    RemusSysToolsProcess_Delete(this->Proc);
+    }
+
+  //--------------------------------------------------------------------------
+  bool created() const { return this->Created; }
+
+  //--------------------------------------------------------------------------
+  void setShared(ProcessPipe::PipeType pipe, bool choice)
+    {
+    RemusSysToolsProcess_SetPipeShared(this->Proc,
+                                       fromProcessPipeType(pipe),
+                                       choice);
+    }
+
+  //--------------------------------------------------------------------------
+  void setFile(ProcessPipe::PipeType pipe, const std::string& filename)
+    {
+    RemusSysToolsProcess_SetPipeFile(this->Proc,
+                                     fromProcessPipeType(pipe),
+                                     filename.c_str());
+    }
+
+  //--------------------------------------------------------------------------
+  //RemusSysTools has no way to limit the resources of a process, so the
+  //limits aren't applied
+  void execute(const std::vector<ExecuteProcess::Command>& commands,
+               const envmap_t& env,
+               const ProcessLimits&)
+    {
+    for (std::size_t cmdId=0;cmdId<commands.size();cmdId++)
+      {
+      //allocate array large enough for command str, args, and null entry
+      const std::size_t size(commands[cmdId].Args.size() + 2);
+      const char **cmds = new const char * [size];
+      cmds[0] = commands[cmdId].Cmd.c_str();
+      for(std::size_t i=0; i < commands[cmdId].Args.size();++i)
+        {
+        cmds[1 + i] = commands[cmdId].Args[i].c_str();
+        }
+      cmds[size-1]=NULL;
+
+      if (cmdId == 0)
+        {
+        RemusSysToolsProcess_SetCommand(this->Proc,cmds);
+        }
+      else
+        {
+        RemusSysToolsProcess_AddCommand(this->Proc,cmds);
+        }
+      delete[] cmds;
+      }
+
+    boost::lock_guard<boost::mutex> lock(environment_mutex());
+
+    // For each requested environment variable, save
+    // the old value before setting the new one.
+    envmap_t TmpEnv;
+    std::vector<std::string> UnsetEnv;
+    for (envmap_t::const_iterator it = env.begin(); it != env.end(); ++it)
+      {
+      char* buf;
+#if !defined(_WIN32) || defined(__CYGWIN__)
+      buf = getenv(it->first.c_str());
+      if (buf && buf[0])
+        TmpEnv[it->first] = buf;
+      else
+        UnsetEnv.push_back(it->first);
+      setenv(it->first.c_str(), it->second.c_str(), 1);
+#else
+      const bool valid = (_dupenv_s(&buf, NULL, it->first.c_str()) == 0) &&
+                         (buf != NULL);
+      if (valid)
+        TmpEnv[it->first] = buf;
+      else
+        UnsetEnv.push_back(it->first);
+      _putenv_s(it->first.c_str(), it->second.c_str());
+#endif
+      }
+
+    RemusSysToolsProcess_SetOption(this->Proc,
+                              RemusSysToolsProcess_Option_HideWindow, true);
+
+    RemusSysToolsProcess_Execute(this->Proc);
+
+    // Now that the process has been created, reset the environment.
+    for (envmap_t::const_iterator it = TmpEnv.begin(); it != TmpEnv.end(); ++it)
       {
-      RemusSysToolsProcess_Delete(this->Proc);
+#if !defined(_WIN32) || defined(__CYGWIN__)
+      setenv(it->first.c_str(), it->second.c_str(), 1);
+#else
+      _putenv_s(it->first.c_str(), it->second.c_str());
+#endif
+      }
+    for (std::size_t i=0; i < UnsetEnv.size(); ++i)
+      {
+#if !defined(_WIN32) || defined(__CYGWIN__)
+      unsetenv(UnsetEnv[i].c_str());
+#else
+      _putenv_s(UnsetEnv[i].c_str(), "");
+#endif
       }
 
+    this->Created = true;
+    }
+
+  //--------------------------------------------------------------------------
+  bool kill()
+    {
+    if(RemusSysToolsProcess_GetState(this->Proc) ==
+       RemusSysToolsProcess_State_Executing)
+      {
+      RemusSysToolsProcess_Kill( this->Proc );
+      RemusSysToolsProcess_WaitForExit(this->Proc, 0);
+      return true;
+      }
+    return false;
+    }
+
+  //--------------------------------------------------------------------------
+  int state()
+    {
+    //poll just to see if the state has changed
+    double timeout = -1; //set to a negative number to poll
+    RemusSysToolsProcess_WaitForExit(this->Proc, &timeout);
+    return RemusSysToolsProcess_GetState(this->Proc);
+    }
+
+  //--------------------------------------------------------------------------
+  bool isAlive()
+    {
+    return this->state() == RemusSysToolsProcess_State_Executing;
+    }
+
+  //--------------------------------------------------------------------------
+  bool exitedNormally()
+    {
+    return this->exitCode() == 0;
+    }
+
+  //--------------------------------------------------------------------------
+  int exitCode()
+    {
+    return (this->state() == RemusSysToolsProcess_State_Exited) ?
+           RemusSysToolsProcess_GetExitValue(this->Proc) : -1;
+    }
+
+  //--------------------------------------------------------------------------
+  bool exceededMemoryLimit()
+    {
+    return false;
+    }
+
+  //--------------------------------------------------------------------------
+  ProcessPipe poll(double timeout)
+    {
+    //convert our syntax for timout to the RemusSysTools version
+    //our negative values mean zero for sysToolProcess
+    //our zero value means a negative value
+    //other wise we are the same
+
+    //RemusSysTools currently doesn't have a block for inifinte time that acutally works
+    const double fakeInfiniteWait = 100000000;
+    double realTimeOut = (timeout == 0 ) ? -1 : ( timeout < 0) ? fakeInfiniteWait : timeout;
+
+    //poll sys tool for data
+    int length;
+    char* data;
+    int pipe = RemusSysToolsProcess_WaitForData(this->Proc,
+                                                &data,&length,&realTimeOut);
+
+    ProcessPipe result(toProcessPipeType(pipe));
+    if(result.valid())
+      {
+      result.text = std::string(data,length);
+      }
+    return result;
     }
 };
 
+#endif
+
 //-----------------------------------------------------------------------------
 ExecuteProcess::ExecuteProcess(
   const std::string& command,
@@ -148,170 +1283,84 @@ void ExecuteProcess::appendProcess(const std::string& command)
 //-----------------------------------------------------------------------------
 void ExecuteProcess::execute()
 {
-  for (std::size_t cmdId=0;cmdId<this->CommandQueue.size();cmdId++)
-  {
-    //allocate array large enough for command str, args, and null entry
-    const std::size_t size(this->CommandQueue[cmdId].Args.size() + 2);
-    const char **cmds = new const char * [size];
-    cmds[0] = this->CommandQueue[cmdId].Cmd.c_str();
-    for(std::size_t i=0; i < this->CommandQueue[cmdId].Args.size();++i)
-    {
-      cmds[1 + i] = this->CommandQueue[cmdId].Args[i].c_str();
-    }
-    cmds[size-1]=NULL;
-
-    if (cmdId == 0)
-    {
-      RemusSysToolsProcess_SetCommand(this->ExternalProcess->Proc,cmds);
-    }
-    else
-    {
-      RemusSysToolsProcess_AddCommand(this->ExternalProcess->Proc,cmds);
-    }
-    delete[] cmds;
-  }
-
-  // For each requested environment variable, save
-  // the old value before setting the new one.
-  typedef std::map<std::string,std::string> envmap_t;
-  envmap_t TmpEnv;
-  for (envmap_t::const_iterator it = this->Env.begin(); it != this->Env.end(); ++it)
-    {
-    char* buf;
-#if !defined(_WIN32) || defined(__CYGWIN__)
-    buf = getenv(it->first.c_str());
-    if (buf && buf[0])
-      TmpEnv[it->first] = buf;
-    setenv(it->first.c_str(), it->second.c_str(), 1);
-#else
-    const bool valid = (_dupenv_s(&buf, NULL, it->first.c_str()) == 0) &&
-                       (buf != NULL);
-    if (valid)
-      TmpEnv[it->first] = buf;
-    _putenv_s(it->first.c_str(), it->second.c_str());
-#endif
-    }
-
-  RemusSysToolsProcess_SetOption(this->ExternalProcess->Proc,
-                            RemusSysToolsProcess_Option_HideWindow, true);
-
-  RemusSysToolsProcess_Execute(this->ExternalProcess->Proc);
-
-  // Now that the process has been created, reset the environment.
-  for (envmap_t::const_iterator it = TmpEnv.begin(); it != TmpEnv.end(); ++it)
-    {
-#if !defined(_WIN32) || defined(__CYGWIN__)
-    setenv(it->first.c_str(), it->second.c_str(), 1);
-#else
-    _putenv_s(it->first.c_str(), it->second.c_str());
-#endif
-    }
-
-  this->ExternalProcess->Created = true;
+  this->ExternalProcess->execute(this->CommandQueue, this->Env, this->Limits);
 }
 
-
 //-----------------------------------------------------------------------------
 bool ExecuteProcess::kill()
 {
-  if(this->ExternalProcess->Created &&
-     RemusSysToolsProcess_GetState(this->ExternalProcess->Proc) ==
-     RemusSysToolsProcess_State_Executing)
+  if(!this->ExternalProcess->created())
     {
-    RemusSysToolsProcess_Kill( this->ExternalProcess->Proc );
-    RemusSysToolsProcess_WaitForExit(this->ExternalProcess->Proc, 0);
-    return true;
+    return false;
     }
-  return false;
+  return this->ExternalProcess->kill();
 }
 
 //-----------------------------------------------------------------------------
 void ExecuteProcess::sharePipeWithParent(ProcessPipe::PipeType pipe,bool choice)
 {
-  RemusSysToolsProcess_SetPipeShared(this->ExternalProcess->Proc,
-                                     fromProcessPipeType(pipe),
-                                     choice);
+  this->ExternalProcess->setShared(pipe, choice);
 }
 
 //-----------------------------------------------------------------------------
 void ExecuteProcess::pipeToFile(ProcessPipe::PipeType pipe,
                                 const std::string& filename)
 {
-  RemusSysToolsProcess_SetPipeFile(this->ExternalProcess->Proc,
-                                   fromProcessPipeType(pipe),
-                                   filename.c_str());
+  this->ExternalProcess->setFile(pipe, filename);
 }
 
 //-----------------------------------------------------------------------------
 bool ExecuteProcess::isAlive()
 {
-  if(!this->ExternalProcess->Created)
+  if(!this->ExternalProcess->created())
     {
     //never was created can't be  alive
     return false;
     }
-  //poll just to see if the state has changed
-  double timeout = -1; //set to a negative number to poll
-  RemusSysToolsProcess_WaitForExit(this->ExternalProcess->Proc, &timeout);
-
-  int state = RemusSysToolsProcess_GetState(this->ExternalProcess->Proc);
-  return state == RemusSysToolsProcess_State_Executing;
+  return this->ExternalProcess->isAlive();
 }
 
 //-----------------------------------------------------------------------------
 bool ExecuteProcess::exitedNormally()
 {
-  if(!this->ExternalProcess->Created)
+  if(!this->ExternalProcess->created())
     {
     //never was created can't be  alive
     return false;
     }
-  //poll just to see if the state has changed
-  double timeout = -1; //set to a negative number to poll
-  RemusSysToolsProcess_WaitForExit(this->ExternalProcess->Proc, &timeout);
-
-  int state = RemusSysToolsProcess_GetState(this->ExternalProcess->Proc);
-  return (state == RemusSysToolsProcess_State_Exited);
+  return this->ExternalProcess->exitedNormally();
 }
 
-
-
 //-----------------------------------------------------------------------------
-remus::common::ProcessPipe ExecuteProcess::poll(double timeout)
+int ExecuteProcess::exitCode()
 {
-  //The timeout's unit of time is SECONDS.
-
-  typedef remus::common::ProcessPipe PPipe;
-
-  if(!this->ExternalProcess->Created)
+  if(!this->ExternalProcess->created())
     {
-    return PPipe(PPipe::None);
+    return -1;
     }
+  return this->ExternalProcess->exitCode();
+}
 
-  //convert our syntax for timout to the RemusSysTools version
-  //our negative values mean zero for sysToolProcess
-  //our zero value means a negative value
-  //other wise we are the same
-
-  //RemusSysTools currently doesn't have a block for inifinte time that acutally works
-  const double fakeInfiniteWait = 100000000;
-  double realTimeOut = (timeout == 0 ) ? -1 : ( timeout < 0) ? fakeInfiniteWait : timeout;
-
-  //poll sys tool for data
-  int length;
-  char* data;
-  int pipe = RemusSysToolsProcess_WaitForData(this->ExternalProcess->Proc,
-                                          &data,&length,&realTimeOut);
-  PPipe::PipeType type = toProcessPipeType(pipe);
-
-  PPipe result(type);
-  if(result.valid())
+//-----------------------------------------------------------------------------
+bool ExecuteProcess::exceededMemoryLimit()
+{
+  if(!this->ExternalProcess->created())
     {
-    result.text = std::string(data,length);
+    return false;
     }
-  return result;
+  return this->ExternalProcess->exceededMemoryLimit();
 }
 
+//-----------------------------------------------------------------------------
+remus::common::ProcessPipe ExecuteProcess::poll(double timeout)
+{
+  //The timeout's unit of time is SECONDS.
+  if(!this->ExternalProcess->created())
+    {
+    return ProcessPipe(ProcessPipe::None);
+    }
+  return this->ExternalProcess->poll(timeout);
+}
 
 }
 }
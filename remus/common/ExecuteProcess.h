@@ -18,6 +18,12 @@
 #include <vector>
 
 #include <remus/common/CommonExports.h>
+#include <remus/common/CompilerInformation.h>
+
+//suppress warnings inside boost headers for gcc and clang
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/cstdint.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
 
 //forward declare the systools
 
@@ -45,6 +51,49 @@ struct REMUSCOMMON_EXPORT ProcessPipe
   std::string text;
 };
 
+//The resources a process can use. On Linux the memory, cpu quota and cpu
+//set limits are applied through a cgroup v2 group made for the process
+//when the cgroup hierarchy allows it, which is the cgroup of this process
+//unless ControlGroupParent names another one. Otherwise the memory limit
+//becomes a limit on the address space of the process, and the cpu set
+//limits the cpus the process can be scheduled on, while the cpu quota
+//can't be applied. The limits aren't applied on other platforms.
+struct REMUSCOMMON_EXPORT ProcessLimits
+{
+  ProcessLimits():
+    MaxMemoryBytes(-1),
+    CpuQuota(0),
+    CpuSet(),
+    MaxOpenFiles(-1),
+    ControlGroupParent()
+  {
+  }
+
+  //does the process have any limit
+  bool limited() const
+  {
+    return this->MaxMemoryBytes >= 0 || this->CpuQuota > 0 ||
+           !this->CpuSet.empty() || this->MaxOpenFiles >= 0;
+  }
+
+  //the most memory the process can use, negative means no limit
+  boost::int64_t MaxMemoryBytes;
+
+  //how many cpus worth of time the process can use, so 0.5 is half of a
+  //cpu. Zero or less means no limit
+  double CpuQuota;
+
+  //the cpus the process can run on, such as "0-3,6". Empty means any cpu
+  std::string CpuSet;
+
+  //the most files the process can have open, negative means no limit
+  boost::int64_t MaxOpenFiles;
+
+  //the directory of the cgroup under which the groups of processes are
+  //made, empty means the cgroup of this process
+  std::string ControlGroupParent;
+};
+
 
 class REMUSCOMMON_EXPORT ExecuteProcess
 {
@@ -66,7 +115,10 @@ public:
   //preceding process.
   void appendProcess(const std::string& command);
 
-  //execute the process.
+  //execute the process. The process is given the environment of this
+  //process along with the environment variables it was constructed with.
+  //Where posix_spawn is available the environment of this process is
+  //never modified, so processes can be executed from many threads at once
   virtual void execute();
 
   //kills the process if running
@@ -102,11 +154,27 @@ public:
   //returns if the process is still alive
   bool isAlive();
 
-  //returns if the process exited normally.
+  //returns if the process exited normally, which means by itself with an
+  //exit code of zero.
   //If the process is still running, killed, disowned, not yet running
-  //this will return false
+  //or exited with a nonzero code this will return false
   bool exitedNormally();
 
+  //returns the exit code of a process that exited by itself.
+  //If the process is still running, killed, disowned, not yet running
+  //this will return -1
+  int exitCode();
+
+  //set the resources the process can use, which has to be done before
+  //the process is executed
+  void setLimits(const ProcessLimits& limits) { this->Limits = limits; }
+  const ProcessLimits& limits() const { return this->Limits; }
+
+  //returns if the process has been killed for going over its memory
+  //limit. This can only be told when the limit was applied with a cgroup,
+  //otherwise this returns false
+  bool exceededMemoryLimit();
+
   //Will poll for a given timeout value looking any output on the STDIN,STDOUT,and
   //STDERR streams.
   //The timeout's unit of time is SECONDS.
@@ -138,6 +206,7 @@ private:
 
   std::vector<Command> CommandQueue;
   std::map<std::string,std::string> Env;
+  ProcessLimits Limits;
 
   struct Process;
   Process* ExternalProcess;
@@ -31,7 +31,14 @@ namespace remus {
      ServiceTypeMacro(RETRIEVE_RESULT, 7, "RETRIEVE RESULT"), \
      ServiceTypeMacro(HEARTBEAT, 8, "HEARTBEAT"), \
      ServiceTypeMacro(TERMINATE_JOB, 9, "TERMINATE JOB"), \
-     ServiceTypeMacro(TERMINATE_WORKER, 10, "TERMINATE WORKER")
+     ServiceTypeMacro(TERMINATE_WORKER, 10, "TERMINATE WORKER"), \
+     ServiceTypeMacro(WIRE_FORMAT, 11, "WIRE FORMAT"), \
+     ServiceTypeMacro(TRANSFER_BEGIN, 12, "TRANSFER BEGIN"), \
+     ServiceTypeMacro(TRANSFER_CHUNK, 13, "TRANSFER CHUNK"), \
+     ServiceTypeMacro(TRANSFER_COMMIT, 14, "TRANSFER COMMIT"), \
+     ServiceTypeMacro(MAKE_MESH_BATCH, 15, "MAKE MESH BATCH"), \
+     ServiceTypeMacro(MESH_STATUS_BATCH, 16, "MESH STATUS BATCH"), \
+     ServiceTypeMacro(TERMINATE_JOB_BATCH, 17, "TERMINATE JOB BATCH")
 
 
 //------------------------------------------------------------------------------
@@ -62,7 +69,7 @@ inline std::string to_string(remus::SERVICE_TYPE t)
 //------------------------------------------------------------------------------
 inline remus::SERVICE_TYPE to_serviceType(const std::string& t)
 {
-  for(int i=1; i<=10; i++)
+  for(int i=1; i<=17; i++)
     {
     remus::SERVICE_TYPE mt=static_cast<remus::SERVICE_TYPE>(i);
     if (remus::to_string(mt) == t)
@@ -14,6 +14,11 @@
 #include <remus/common/SleepFor.h>
 
 #include <stdlib.h>
+#include <vector>
+
+#if !defined(_WIN32) || defined(__CYGWIN__)
+# include <sys/resource.h>
+#endif
 
 //needed for comparison of std::string on windows.
 #include <string>
@@ -56,6 +61,10 @@ int main(int argc, char** argv)
       }
     else if( prog_type.find("CERR_OUTPUT") == 0)
       mode = 3;
+    else if( prog_type.find("OPEN_FILES_LIMIT") == 0)
+      mode = 4;
+    else if( prog_type.find("ALLOCATE_MEMORY") == 0)
+      mode = 5;
     }
 
   //determine our behavior
@@ -63,6 +72,26 @@ int main(int argc, char** argv)
     {
     remus::common::SleepForMillisec(500);
     }
+  else if(mode == 4)
+    { //state how many files we can open, and wait to be killed
+#if !defined(_WIN32) || defined(__CYGWIN__)
+    struct rlimit limit;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    std::cout << limit.rlim_cur << std::endl;
+#endif
+    while(true)
+      {
+      remus::common::SleepForMillisec(100);
+      }
+    }
+  else if(mode == 5)
+    { //use a gigabyte of memory, touching every page so that it is used
+    std::vector< std::vector<char> > blocks;
+    for(int i=0; i < 1024; ++i)
+      {
+      blocks.push_back( std::vector<char>(1024*1024, 'r') );
+      }
+    }
   else if(mode >= 1)
     { //no ouput while polling
     while(true)
@@ -17,6 +17,7 @@
 #include "PathToTestExecutable.h"
 
 #include <iostream>
+#include <stdlib.h>
 
 int UnitTestExecuteProcess(int, char *[])
 {
@@ -30,7 +31,9 @@ int UnitTestExecuteProcess(int, char *[])
   //for now that will be a terminal / shell
   {
   std::cout << eapp.name << std::endl;
-  remus::common::ExecuteProcess example(eapp.name);
+  std::vector< std::string > args;
+  args.push_back("NO_OUTPUT");
+  remus::common::ExecuteProcess example(eapp.name, args);
 
   //validate that isAlive and kill return the proper results before
   //we call execute
@@ -68,6 +71,7 @@ int UnitTestExecuteProcess(int, char *[])
   while(example.isAlive()){}
 
   REMUS_ASSERT(example.exitedNormally());
+  REMUS_ASSERT(example.exitCode() == 0);
   //make sure we can't kill a program that has stopped
   REMUS_ASSERT(!example.kill());
   }
@@ -89,6 +93,10 @@ int UnitTestExecuteProcess(int, char *[])
   example.execute();
   REMUS_ASSERT(example.isAlive());
 
+  //the environment of the process is its own, the environment of
+  //this process isn't changed to launch it
+  REMUS_ASSERT( (getenv("REMUS_TEST") == NULL) );
+
   //verify the polling results
   remus::common::ProcessPipe pollResult = example.poll(-1);
   REMUS_ASSERT(pollResult.valid());
@@ -168,5 +176,59 @@ int UnitTestExecuteProcess(int, char *[])
   REMUS_ASSERT(example.kill());
   }
 
+//==============================================================================
+//  Test Launching a program with limits on its resources
+//==============================================================================
+#if !defined(_WIN32) || defined(__CYGWIN__)
+  {
+  std::vector< std::string > args;
+  args.push_back("OPEN_FILES_LIMIT");
+  remus::common::ExecuteProcess example(eapp.name, args);
+
+  remus::common::ProcessLimits limits;
+  REMUS_ASSERT(!limits.limited());
+  limits.MaxOpenFiles = 64;
+  REMUS_ASSERT(limits.limited());
+  example.setLimits(limits);
+
+  //the program states the limit it was launched with
+  example.execute();
+  remus::common::ProcessPipe pollResult = example.poll(-1);
+  REMUS_ASSERT( (pollResult.type == remus::common::ProcessPipe::STDOUT) );
+  REMUS_ASSERT( (pollResult.text.find("64") == 0) );
+
+  REMUS_ASSERT(example.kill());
+  REMUS_ASSERT(!example.exceededMemoryLimit());
+  }
+
+  {
+  //a program that uses more memory than it is allowed to can't finish
+  std::vector< std::string > args;
+  args.push_back("ALLOCATE_MEMORY");
+  remus::common::ExecuteProcess example(eapp.name, args);
+
+  remus::common::ProcessLimits limits;
+  limits.MaxMemoryBytes = 128 * 1024 * 1024;
+  example.setLimits(limits);
+
+  example.execute();
+  while(example.isAlive()){ remus::common::SleepForMillisec(5); }
+  REMUS_ASSERT(!example.exitedNormally());
+  }
+#endif
+
+//==============================================================================
+//  Test Launching a program that doesn't exist
+//==============================================================================
+  {
+  remus::common::ExecuteProcess example(eapp.name + "_missing");
+  example.execute();
+
+  //the process never ran, so it can't be alive, polled, or killed
+  REMUS_ASSERT(!example.isAlive());
+  REMUS_ASSERT(!example.poll(0.1).valid());
+  REMUS_ASSERT(!example.kill());
+  }
+
   return 0;
 }
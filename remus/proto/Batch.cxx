@@ -0,0 +1,186 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <remus/proto/Batch.h>
+
+#include <remus/common/BinaryConversionHelper.h>
+
+namespace remus{
+namespace proto{
+
+namespace
+{
+//------------------------------------------------------------------------------
+template<typename T, typename Encoder>
+std::string encode_batch(const std::vector<T>& values, Encoder encode)
+{
+  std::vector<std::string> items;
+  items.reserve(values.size());
+  for(std::size_t i=0; i < values.size(); ++i)
+    {
+    items.push_back( encode(values[i]) );
+    }
+  return remus::proto::to_batch(items);
+}
+
+//------------------------------------------------------------------------------
+std::string encode_job(const remus::proto::Job& job)
+{
+  return remus::proto::to_string(job);
+}
+
+//------------------------------------------------------------------------------
+struct EncodeWithFormat
+{
+  explicit EncodeWithFormat(remus::proto::WireFormat::Type format):
+    Format(format)
+  {}
+
+  template<typename T>
+  std::string operator()(const T& t) const
+  {
+    return remus::proto::to_string(t, this->Format);
+  }
+
+  remus::proto::WireFormat::Type Format;
+};
+}
+
+//------------------------------------------------------------------------------
+std::string to_batch(const std::vector<std::string>& items)
+{
+  std::size_t size = 4 + 8;
+  for(std::size_t i=0; i < items.size(); ++i)
+    {
+    size += remus::internal::BinaryWriter::blobSize(items[i].size());
+    }
+
+  std::string encoded;
+  encoded.reserve(size);
+
+  remus::internal::BinaryWriter buffer(encoded);
+  buffer.writeHeader(remus::internal::BinaryTag::Batch);
+  buffer.writeUInt64(static_cast<boost::uint64_t>(items.size()));
+  for(std::size_t i=0; i < items.size(); ++i)
+    {
+    buffer.writeString(items[i]);
+    }
+  return encoded;
+}
+
+//------------------------------------------------------------------------------
+std::string to_batch(const std::vector<remus::proto::Job>& jobs)
+{
+  return encode_batch(jobs, &encode_job);
+}
+
+//------------------------------------------------------------------------------
+std::string to_batch(const std::vector<remus::proto::JobStatus>& statuses,
+                     remus::proto::WireFormat::Type format)
+{
+  return encode_batch(statuses, EncodeWithFormat(format));
+}
+
+//------------------------------------------------------------------------------
+std::string to_batch(const std::vector<remus::proto::JobSubmission>& subs,
+                     remus::proto::WireFormat::Type format)
+{
+  return encode_batch(subs, EncodeWithFormat(format));
+}
+
+//------------------------------------------------------------------------------
+bool to_BatchItems(const char* data, std::size_t size,
+                   std::vector<remus::proto::BatchItem>& items)
+{
+  items.clear();
+  remus::internal::BinaryReader buffer(data,size);
+  if(!buffer.readHeader(remus::internal::BinaryTag::Batch))
+    {
+    return false;
+    }
+
+  //every item takes at least the 8 bytes of its length, which keeps a
+  //corrupt count from making us reserve a huge vector
+  const boost::uint64_t count = buffer.readUInt64();
+  if(!buffer.good() || count > buffer.remaining() / 8)
+    {
+    return false;
+    }
+
+  items.reserve(static_cast<std::size_t>(count));
+  for(boost::uint64_t i=0; i < count; ++i)
+    {
+    std::size_t itemSize = 0;
+    const char* item = buffer.readBlob(itemSize);
+    items.push_back( remus::proto::BatchItem(item, itemSize) );
+    }
+  if(!buffer.good())
+    {
+    items.clear();
+    }
+  return buffer.good();
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::Job> to_JobVector(const char* data, std::size_t size)
+{
+  std::vector<remus::proto::BatchItem> items;
+  to_BatchItems(data, size, items);
+
+  std::vector<remus::proto::Job> jobs;
+  jobs.reserve(items.size());
+  for(std::size_t i=0; i < items.size(); ++i)
+    {
+    jobs.push_back( remus::proto::to_Job(items[i].first, items[i].second) );
+    }
+  return jobs;
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::JobStatus> to_JobStatusVector(const char* data,
+                                                        std::size_t size)
+{
+  std::vector<remus::proto::BatchItem> items;
+  to_BatchItems(data, size, items);
+
+  std::vector<remus::proto::JobStatus> statuses;
+  statuses.reserve(items.size());
+  for(std::size_t i=0; i < items.size(); ++i)
+    {
+    statuses.push_back( remus::proto::to_JobStatus(items[i].first,
+                                                   items[i].second) );
+    }
+  return statuses;
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::JobSubmission> to_JobSubmissionVector(
+                              const char* data, std::size_t size,
+                              const boost::shared_ptr<const void>& owner)
+{
+  std::vector<remus::proto::BatchItem> items;
+  to_BatchItems(data, size, items);
+
+  std::vector<remus::proto::JobSubmission> subs;
+  subs.reserve(items.size());
+  for(std::size_t i=0; i < items.size(); ++i)
+    {
+    subs.push_back( remus::proto::to_JobSubmission(items[i].first,
+                                                   items[i].second,
+                                                   owner) );
+    }
+  return subs;
+}
+
+}
+}
@@ -0,0 +1,92 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#ifndef remus_proto_Batch_h
+#define remus_proto_Batch_h
+
+#include <remus/proto/Job.h>
+#include <remus/proto/JobStatus.h>
+#include <remus/proto/JobSubmission.h>
+#include <remus/proto/WireFormat.h>
+
+//included for export symbols
+#include <remus/proto/ProtoExports.h>
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace remus{
+namespace proto{
+
+//A batch holds many encoded proto objects in one message, which allows
+//clients to submit, query and terminate many jobs with a single round trip
+//to the server. The items of a batch are kept in the order they were given.
+//
+//Batches are only sent by peers that know about the batch service types,
+//so they are always framed with the binary encoding. The items of a batch
+//are encoded with the wire format of the connection, and are decoded like
+//any other proto object.
+
+//a pointer to an encoded item of a batch, and its size
+typedef std::pair<const char*, std::size_t> BatchItem;
+
+//------------------------------------------------------------------------------
+//frame already encoded proto objects as a batch
+REMUSPROTO_EXPORT
+std::string to_batch(const std::vector<std::string>& items);
+
+//------------------------------------------------------------------------------
+REMUSPROTO_EXPORT
+std::string to_batch(const std::vector<remus::proto::Job>& jobs);
+
+//------------------------------------------------------------------------------
+REMUSPROTO_EXPORT
+std::string to_batch(const std::vector<remus::proto::JobStatus>& statuses,
+                     remus::proto::WireFormat::Type format);
+
+//------------------------------------------------------------------------------
+REMUSPROTO_EXPORT
+std::string to_batch(const std::vector<remus::proto::JobSubmission>& subs,
+                     remus::proto::WireFormat::Type format);
+
+//------------------------------------------------------------------------------
+//find the items of a batch without copying them, the items point into data.
+//Returns false when the data isn't a batch
+REMUSPROTO_EXPORT
+bool to_BatchItems(const char* data, std::size_t size,
+                   std::vector<remus::proto::BatchItem>& items);
+
+//------------------------------------------------------------------------------
+//decode a batch, returns an empty vector when the data isn't a batch
+REMUSPROTO_EXPORT
+std::vector<remus::proto::Job> to_JobVector(const char* data, std::size_t size);
+
+//------------------------------------------------------------------------------
+REMUSPROTO_EXPORT
+std::vector<remus::proto::JobStatus> to_JobStatusVector(const char* data,
+                                                        std::size_t size);
+
+//------------------------------------------------------------------------------
+//the submissions share ownership of the data when the owner is given,
+//instead of copying their contents
+REMUSPROTO_EXPORT
+std::vector<remus::proto::JobSubmission> to_JobSubmissionVector(
+                              const char* data, std::size_t size,
+                              const boost::shared_ptr<const void>& owner);
+
+}
+}
+
+#endif
@@ -12,6 +12,7 @@
 
 #include <remus/proto/JobContent.h>
 
+#include <remus/common/BinaryConversionHelper.h>
 #include <remus/common/ConditionalStorage.h>
 #include <remus/common/MD5Hash.h>
 #include <remus/common/ConversionHelper.h>
@@ -20,6 +21,7 @@
 
 #include <sstream>
 #include <algorithm>
+#include <cstring>
 
 namespace remus{
 namespace proto{
@@ -272,6 +274,45 @@ JobContent::JobContent(std::istream& buffer)
     }
 }
 
+//------------------------------------------------------------------------------
+void JobContent::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.writeUInt8(static_cast<boost::uint8_t>(this->sourceType()));
+  buffer.writeUInt8(static_cast<boost::uint8_t>(this->formatType()));
+  buffer.writeString(this->tag());
+  buffer.writeBlob(this->Implementation->data(),
+                   this->Implementation->size());
+}
+
+//------------------------------------------------------------------------------
+JobContent::JobContent(remus::internal::BinaryReader& buffer):
+  SourceType(),
+  FormatType(),
+  Tag(),
+  Implementation()
+{
+  const int stype = buffer.readUInt8();
+  const int ftype = buffer.readUInt8();
+  this->SourceType = static_cast<remus::common::ContentSource::Type>(stype);
+  this->FormatType = static_cast<remus::common::ContentFormat::Type>(ftype);
+  this->Tag = buffer.readString();
+
+  //when the reader knows who owns the buffer the contents point
+  //straight into it, otherwise they are copied once
+  std::size_t contentsSize = 0;
+  boost::shared_array<char> contents = buffer.readSharedBlob(contentsSize);
+  if( contentsSize == 0)
+    { //make_shared is significantly faster than using manual new
+    this->Implementation = boost::make_shared<InternalImpl>(
+                                    static_cast<char*>(NULL),std::size_t(0));
+    }
+  else
+    {
+    this->Implementation = boost::make_shared<InternalImpl>(
+                                                contents, contentsSize);
+    }
+}
+
 //------------------------------------------------------------------------------
 std::string to_string(const remus::proto::JobContent& content)
 {
@@ -280,9 +321,29 @@ std::string to_string(const remus::proto::JobContent& content)
   return buffer.str();
 }
 
+//------------------------------------------------------------------------------
+std::string to_binary(const remus::proto::JobContent& content)
+{
+  std::string result;
+  result.reserve(64 + content.tag().size() + content.dataSize());
+
+  remus::internal::BinaryWriter buffer(result);
+  buffer.writeHeader(remus::internal::BinaryTag::JobContent);
+  content.serialize(buffer);
+  return result;
+}
+
 //------------------------------------------------------------------------------
 remus::proto::JobContent to_JobContent(const char* data, std::size_t size)
 {
+  if(remus::internal::isBinaryEncoded(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    buffer.readHeader(remus::internal::BinaryTag::JobContent);
+    remus::proto::JobContent content(buffer);
+    return buffer.good() ? content : remus::proto::JobContent();
+    }
+
   std::stringstream buffer;
   remus::internal::writeString(buffer, data, size);
   remus::proto::JobContent content;
@@ -23,6 +23,10 @@
 //included for export symbols
 #include <remus/proto/ProtoExports.h>
 
+//forward declare the binary encoding helpers
+namespace remus { namespace internal {
+  class BinaryReader; class BinaryWriter; } }
+
 namespace remus{
 namespace proto{
 
@@ -80,12 +84,23 @@ public:
     { content = JobContent(is); return is; }
 
 private:
+  friend class JobSubmission;
+  friend REMUSPROTO_EXPORT std::string to_binary(const JobContent& content);
+  friend REMUSPROTO_EXPORT JobContent to_JobContent(const char* data,
+                                                    std::size_t size);
+
   //serialize function
   void serialize(std::ostream& buffer) const;
 
   //deserialize constructor function
   explicit JobContent(std::istream& buffer);
 
+  //binary serialize function
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+
+  //binary deserialize constructor function
+  explicit JobContent(remus::internal::BinaryReader& buffer);
+
 
   remus::common::ContentSource::Type SourceType;
   remus::common::ContentFormat::Type FormatType;
@@ -121,6 +136,12 @@ std::string to_string(const remus::proto::JobContent& content);
 // }
 
 //------------------------------------------------------------------------------
+//encode the content using the binary wire format
+REMUSPROTO_EXPORT
+std::string to_binary(const remus::proto::JobContent& content);
+
+//------------------------------------------------------------------------------
+//decode content that was encoded with either wire format
 REMUSPROTO_EXPORT
 remus::proto::JobContent to_JobContent(const char* data, std::size_t size);
 
@@ -14,6 +14,7 @@
 #include <algorithm>
 #include <sstream>
 
+#include <remus/common/BinaryConversionHelper.h>
 #include <remus/common/ConversionHelper.h>
 
 namespace remus {
@@ -81,5 +82,19 @@ JobProgress::JobProgress(std::istream& buffer)
   this->Message = remus::internal::extractString(buffer,progressMessageLen);
 }
 
+//------------------------------------------------------------------------------
+void JobProgress::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.writeUInt32(static_cast<boost::uint32_t>(this->value()));
+  buffer.writeString(this->message());
+}
+
+//------------------------------------------------------------------------------
+JobProgress::JobProgress(remus::internal::BinaryReader& buffer):
+  Value(static_cast<boost::int32_t>(buffer.readUInt32())),
+  Message(buffer.readString())
+{
+}
+
 }
 }
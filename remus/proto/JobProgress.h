@@ -19,6 +19,10 @@
 //included for export symbols
 #include <remus/proto/ProtoExports.h>
 
+//forward declare the binary encoding helpers
+namespace remus { namespace internal {
+  class BinaryReader; class BinaryWriter; } }
+
 namespace remus {
 namespace proto {
 
@@ -63,12 +67,20 @@ public:
     { prog = JobProgress(is); return is; }
 
 private:
+  friend class JobStatus;
+
   //serialize function
   void serialize(std::ostream& buffer) const;
 
   //deserialize constructor function
   explicit JobProgress(std::istream& buffer);
 
+  //binary serialize function
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+
+  //binary deserialize constructor function
+  explicit JobProgress(remus::internal::BinaryReader& buffer);
+
   int Value;
   std::string Message;
 };
@@ -12,13 +12,16 @@
 
 #include <remus/proto/JobRequirements.h>
 
+#include <remus/common/BinaryConversionHelper.h>
 #include <remus/common/ConditionalStorage.h>
 #include <remus/common/ConversionHelper.h>
 
 REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/functional/hash.hpp>
 #include <boost/make_shared.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
+#include <cstring>
 #include <sstream>
 
 namespace remus{
@@ -191,6 +194,19 @@ bool JobRequirements::operator!=(const JobRequirements& other) const
   return !(*this == other);
 }
 
+//------------------------------------------------------------------------------
+std::size_t hash_value(const JobRequirements& reqs)
+{
+  std::size_t seed = 0;
+  boost::hash_combine(seed, reqs.meshTypes().inputType());
+  boost::hash_combine(seed, reqs.meshTypes().outputType());
+  boost::hash_combine(seed, static_cast<int>(reqs.sourceType()));
+  boost::hash_combine(seed, static_cast<int>(reqs.formatType()));
+  boost::hash_combine(seed, reqs.workerName());
+  boost::hash_combine(seed, reqs.tag());
+  return seed;
+}
+
 //------------------------------------------------------------------------------
 void JobRequirements::serialize(std::ostream& buffer) const
 {
@@ -261,9 +277,81 @@ std::string to_string(const remus::proto::JobRequirements& reqs)
   return buffer.str();
 }
 
+//------------------------------------------------------------------------------
+void JobRequirements::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.writeUInt8(static_cast<boost::uint8_t>(this->sourceType()));
+  buffer.writeUInt8(static_cast<boost::uint8_t>(this->formatType()));
+  buffer.writeString(this->meshTypes().inputType());
+  buffer.writeString(this->meshTypes().outputType());
+  buffer.writeString(this->workerName());
+  buffer.writeString(this->tag());
+  buffer.writeBlob(this->requirements(), this->requirementsSize());
+}
+
+//------------------------------------------------------------------------------
+JobRequirements::JobRequirements(remus::internal::BinaryReader& buffer):
+  SourceType(),
+  FormatType(),
+  MeshType(),
+  WorkerName(),
+  Tag(),
+  Implementation()
+{
+  const int stype = buffer.readUInt8();
+  const int ftype = buffer.readUInt8();
+  this->SourceType = static_cast<remus::common::ContentSource::Type>(stype);
+  this->FormatType = static_cast<remus::common::ContentFormat::Type>(ftype);
+
+  const std::string inputType = buffer.readString();
+  const std::string outputType = buffer.readString();
+  this->MeshType = remus::common::MeshIOType(inputType,outputType);
+
+  this->WorkerName = buffer.readString();
+  this->Tag = buffer.readString();
+
+  //the contents are copied straight out of the buffer into the memory
+  //that the conditional storage will own
+  std::size_t contentsSize = 0;
+  const char* contents = buffer.readBlob(contentsSize);
+  if( contents == NULL || contentsSize == 0)
+    { //make_shared is significantly faster than using manual new
+    this->Implementation = boost::make_shared<InternalImpl>(
+                                    static_cast<char*>(NULL),std::size_t(0));
+    }
+  else
+    {
+    boost::shared_array<char> storage( new char[contentsSize] );
+    std::memcpy(storage.get(), contents, contentsSize);
+    this->Implementation = boost::make_shared<InternalImpl>(
+                                                storage, contentsSize);
+    }
+}
+
+//------------------------------------------------------------------------------
+std::string to_binary(const remus::proto::JobRequirements& reqs)
+{
+  std::string result;
+  result.reserve(128 + reqs.workerName().size() + reqs.tag().size() +
+                 reqs.requirementsSize());
+
+  remus::internal::BinaryWriter buffer(result);
+  buffer.writeHeader(remus::internal::BinaryTag::JobRequirements);
+  reqs.serialize(buffer);
+  return result;
+}
+
 //------------------------------------------------------------------------------
 remus::proto::JobRequirements to_JobRequirements(const char* data, std::size_t size)
 {
+  if(remus::internal::isBinaryEncoded(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    buffer.readHeader(remus::internal::BinaryTag::JobRequirements);
+    remus::proto::JobRequirements reqs(buffer);
+    return buffer.good() ? reqs : remus::proto::JobRequirements();
+    }
+
   std::stringstream buffer;
   remus::internal::writeString(buffer, data, size);
   remus::proto::JobRequirements reqs;
@@ -32,6 +32,10 @@ REMUS_THIRDPARTY_POST_INCLUDE
 
 namespace  remus { namespace worker { class Worker; } }
 
+//forward declare the binary encoding helpers
+namespace remus { namespace internal {
+  class BinaryReader; class BinaryWriter; } }
+
 namespace remus{
 namespace proto{
 
@@ -121,6 +125,10 @@ private:
   //of the full requirements to the server. This is the easiest way to do so.
   friend class remus::worker::Worker;
 
+  friend class JobSubmission;
+  friend REMUSPROTO_EXPORT std::string to_binary(const JobRequirements& reqs);
+  friend REMUSPROTO_EXPORT JobRequirements to_JobRequirements(const char* data,
+                                                              std::size_t size);
 
   //serialize function
   void serialize(std::ostream& buffer) const;
@@ -128,6 +136,12 @@ private:
   //deserialize constructor function
   explicit JobRequirements(std::istream& buffer);
 
+  //binary serialize function
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+
+  //binary deserialize constructor function
+  explicit JobRequirements(remus::internal::BinaryReader& buffer);
+
   remus::common::ContentSource::Type SourceType;
   remus::common::ContentFormat::Type FormatType;
   remus::common::MeshIOType MeshType;
@@ -138,6 +152,10 @@ private:
   boost::shared_ptr<InternalImpl> Implementation;
 };
 
+//hash function for JobRequirements so that it can be used as the key of
+//a boost::unordered_map. Only the members used by operator== are hashed.
+REMUSPROTO_EXPORT std::size_t hash_value(const JobRequirements& reqs);
+
 //a simple container so we can send a collection of requirements
 //to and from the client easily.
 struct REMUSPROTO_EXPORT JobRequirementsSet
@@ -220,6 +238,12 @@ REMUSPROTO_EXPORT
 std::string to_string(const remus::proto::JobRequirements& reqs);
 
 //------------------------------------------------------------------------------
+//encode the requirements using the binary wire format
+REMUSPROTO_EXPORT
+std::string to_binary(const remus::proto::JobRequirements& reqs);
+
+//------------------------------------------------------------------------------
+//decode requirements that were encoded with either wire format
 REMUSPROTO_EXPORT
 remus::proto::JobRequirements to_JobRequirements(const char* data, std::size_t size);
 
@@ -12,6 +12,7 @@
 
 #include <remus/proto/JobResult.h>
 
+#include <remus/common/BinaryConversionHelper.h>
 #include <remus/common/CompilerInformation.h>
 #include <remus/common/ConditionalStorage.h>
 #include <remus/common/MD5Hash.h>
@@ -24,6 +25,7 @@ REMUS_THIRDPARTY_PRE_INCLUDE
 REMUS_THIRDPARTY_POST_INCLUDE
 
 #include <algorithm>
+#include <cstring>
 #include <sstream>
 
 namespace remus {
@@ -199,6 +201,51 @@ JobResult::JobResult(std::istream& buffer)
     }
 }
 
+//------------------------------------------------------------------------------
+void JobResult::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.writeBytes(reinterpret_cast<const char*>(this->JobId.data),
+                    this->JobId.size());
+  buffer.writeUInt8(static_cast<boost::uint8_t>(this->formatType()));
+  buffer.writeBlob(this->Implementation->data(),
+                   this->Implementation->size());
+}
+
+//------------------------------------------------------------------------------
+JobResult::JobResult(remus::internal::BinaryReader& buffer):
+  JobId(),
+  FormatType(),
+  Implementation()
+{
+  const char* id = buffer.readBytes(this->JobId.size());
+  if(id)
+    {
+    std::copy(id, id + this->JobId.size(), this->JobId.data);
+    }
+  else
+    {
+    std::fill(this->JobId.begin(), this->JobId.end(), 0);
+    }
+
+  const int ftype = buffer.readUInt8();
+  this->FormatType = static_cast<remus::common::ContentFormat::Type>(ftype);
+
+  //when the reader knows who owns the buffer the contents point
+  //straight into it, otherwise they are copied once
+  std::size_t contentsSize = 0;
+  boost::shared_array<char> contents = buffer.readSharedBlob(contentsSize);
+  if( contentsSize == 0)
+    { //make_shared is significantly faster than using manual new
+    this->Implementation = boost::make_shared<InternalImpl>(
+                                    static_cast<char*>(NULL),std::size_t(0));
+    }
+  else
+    {
+    this->Implementation = boost::make_shared<InternalImpl>(
+                                                contents, contentsSize);
+    }
+}
+
 //------------------------------------------------------------------------------
 std::string to_string(const remus::proto::JobResult& result)
 {
@@ -208,8 +255,50 @@ std::string to_string(const remus::proto::JobResult& result)
 }
 
 //------------------------------------------------------------------------------
-remus::proto::JobResult to_JobResult(const char* data, std::size_t size)
+std::string to_binary(const remus::proto::JobResult& result)
 {
+  std::string encoded;
+  encoded.reserve(64 + result.dataSize());
+
+  remus::internal::BinaryWriter buffer(encoded);
+  buffer.writeHeader(remus::internal::BinaryTag::JobResult);
+  result.serialize(buffer);
+  return encoded;
+}
+
+//------------------------------------------------------------------------------
+std::string to_binaryPrefix(const remus::proto::JobResult& result,
+                            std::size_t dataSize)
+{
+  std::string encoded;
+  encoded.reserve(32);
+
+  //this must match the layout that JobResult::serialize writes
+  remus::internal::BinaryWriter buffer(encoded);
+  buffer.writeHeader(remus::internal::BinaryTag::JobResult);
+  buffer.writeBytes(reinterpret_cast<const char*>(result.id().data),
+                    result.id().size());
+  buffer.writeUInt8(static_cast<boost::uint8_t>(result.formatType()));
+  buffer.writeUInt64(static_cast<boost::uint64_t>(dataSize));
+  return encoded;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobResult to_JobResult(const char* data, std::size_t size,
+                                     const boost::shared_ptr<const void>& owner)
+{
+  if(remus::internal::isBinaryEncoded(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size,owner);
+    buffer.readHeader(remus::internal::BinaryTag::JobResult);
+    remus::proto::JobResult res(buffer);
+    if(!buffer.good())
+      {
+      return remus::proto::JobResult(res.id());
+      }
+    return res;
+    }
+
   std::stringstream buffer;
   remus::internal::writeString(buffer, data, size);
   remus::proto::JobResult res(buffer);
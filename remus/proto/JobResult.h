@@ -26,6 +26,10 @@
 //included for export symbols
 #include <remus/proto/ProtoExports.h>
 
+//forward declare the binary encoding helpers
+namespace remus { namespace internal {
+  class BinaryReader; class BinaryWriter; } }
+
 //Job result holds the result that the worker generated for a given job.
 //The Data string will hold the actual job result, be it a file path or a custom
 //serialized data structure.
@@ -88,13 +92,21 @@ public:
     { submission = JobResult(is); return is; }
 
 private:
-  friend REMUSPROTO_EXPORT remus::proto::JobResult to_JobResult(const char* data, std::size_t size);
+  friend REMUSPROTO_EXPORT remus::proto::JobResult to_JobResult(const char* data, std::size_t size,
+                                      const boost::shared_ptr<const void>& owner);
+  friend REMUSPROTO_EXPORT std::string to_binary(const JobResult& result);
   //serialize function
   void serialize(std::ostream& buffer) const;
 
   //deserialize constructor function
   explicit JobResult(std::istream& buffer);
 
+  //binary serialize function
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+
+  //binary deserialize constructor function
+  explicit JobResult(remus::internal::BinaryReader& buffer);
+
   boost::uuids::uuid JobId;
   remus::common::ContentFormat::Type FormatType;
 
@@ -123,8 +135,33 @@ REMUSPROTO_EXPORT
 std::string to_string(const remus::proto::JobResult& result);
 
 //------------------------------------------------------------------------------
+//encode the result using the binary wire format
 REMUSPROTO_EXPORT
-remus::proto::JobResult to_JobResult(const char* data, std::size_t size);
+std::string to_binary(const remus::proto::JobResult& result);
+
+//------------------------------------------------------------------------------
+//encode everything but the data of the result using the binary wire format.
+//The encoding is completed by appending dataSize bytes of data to it, which
+//allows a result to be streamed into a buffer and then decoded in place.
+//The prefix is always the same size for every result.
+REMUSPROTO_EXPORT
+std::string to_binaryPrefix(const remus::proto::JobResult& result,
+                            std::size_t dataSize);
+
+//------------------------------------------------------------------------------
+//decode a result that was encoded with either wire format. When the result
+//is binary encoded and the owner of data is given, the contents of the
+//result point into data and keep the owner alive instead of being copied.
+REMUSPROTO_EXPORT
+remus::proto::JobResult to_JobResult(const char* data, std::size_t size,
+                                     const boost::shared_ptr<const void>& owner);
+
+//------------------------------------------------------------------------------
+//decode a result that was encoded with either wire format
+inline remus::proto::JobResult to_JobResult(const char* data, std::size_t size)
+{
+  return to_JobResult(data, size, boost::shared_ptr<const void>());
+}
 
 //------------------------------------------------------------------------------
 inline remus::proto::JobResult to_JobResult(const std::string& msg)
@@ -12,8 +12,10 @@
 
 #include <remus/proto/JobStatus.h>
 
+#include <remus/common/BinaryConversionHelper.h>
 #include <remus/common/ConversionHelper.h>
 
+#include <algorithm>
 #include <sstream>
 
 namespace remus {
@@ -73,9 +75,62 @@ std::string to_string(const remus::proto::JobStatus& status)
 }
 
 //------------------------------------------------------------------------------
-remus::proto::JobStatus to_JobStatus(const std::string& msg)
+void JobStatus::serialize(remus::internal::BinaryWriter& buffer) const
 {
-  std::istringstream buffer(msg);
+  buffer.writeBytes(reinterpret_cast<const char*>(this->JobId.data),
+                    this->JobId.size());
+  buffer.writeUInt8(static_cast<boost::uint8_t>(this->status()));
+  this->Progress.serialize(buffer);
+}
+
+//------------------------------------------------------------------------------
+JobStatus::JobStatus(remus::internal::BinaryReader& buffer):
+  JobId(),
+  Status(remus::INVALID_STATUS),
+  Progress()
+{
+  const char* id = buffer.readBytes(this->JobId.size());
+  if(id)
+    {
+    std::copy(id, id + this->JobId.size(), this->JobId.data);
+    }
+  else
+    {
+    std::fill(this->JobId.begin(), this->JobId.end(), 0);
+    }
+  this->Status = static_cast<remus::STATUS_TYPE>(buffer.readUInt8());
+  this->Progress = remus::proto::JobProgress(buffer);
+}
+
+//------------------------------------------------------------------------------
+std::string to_binary(const remus::proto::JobStatus& status)
+{
+  std::string encoded;
+  encoded.reserve(64 + status.progress().message().size());
+
+  remus::internal::BinaryWriter buffer(encoded);
+  buffer.writeHeader(remus::internal::BinaryTag::JobStatus);
+  status.serialize(buffer);
+  return encoded;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus to_JobStatus(const char* data, std::size_t size)
+{
+  if(remus::internal::isBinaryEncoded(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    buffer.readHeader(remus::internal::BinaryTag::JobStatus);
+    remus::proto::JobStatus status(buffer);
+    if(!buffer.good())
+      {
+      return remus::proto::JobStatus(status.id(),remus::INVALID_STATUS);
+      }
+    return status;
+    }
+
+  //the text encoding needs a stream to parse from
+  std::istringstream buffer(std::string(data,size));
   return remus::proto::JobStatus(buffer);
 }
 
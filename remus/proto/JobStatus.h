@@ -116,7 +116,9 @@ public:
     { status = JobStatus(is); return is; }
 
 private:
-  friend REMUSPROTO_EXPORT remus::proto::JobStatus to_JobStatus(const std::string& msg);
+  friend REMUSPROTO_EXPORT remus::proto::JobStatus to_JobStatus(const char* data,
+                                                                std::size_t size);
+  friend REMUSPROTO_EXPORT std::string to_binary(const JobStatus& status);
 
   //serialize function
   void serialize(std::ostream& buffer) const;
@@ -124,6 +126,12 @@ private:
   //deserialize constructor function
   explicit JobStatus(std::istream& buffer);
 
+  //binary serialize function
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+
+  //binary deserialize constructor function
+  explicit JobStatus(remus::internal::BinaryReader& buffer);
+
   boost::uuids::uuid JobId;
   remus::STATUS_TYPE Status;
   remus::proto::JobProgress Progress;
@@ -163,14 +171,19 @@ inline remus::proto::JobStatus make_FailedJobStatus(
 }
 
 //------------------------------------------------------------------------------
+//encode the status using the binary wire format
+REMUSPROTO_EXPORT
+std::string to_binary(const remus::proto::JobStatus& status);
+
+//------------------------------------------------------------------------------
+//decode a status that was encoded with either wire format
 REMUSPROTO_EXPORT
-remus::proto::JobStatus to_JobStatus(const std::string& msg);
+remus::proto::JobStatus to_JobStatus(const char* data, std::size_t size);
 
 //------------------------------------------------------------------------------
-inline remus::proto::JobStatus to_JobStatus(const char* data, std::size_t size)
+inline remus::proto::JobStatus to_JobStatus(const std::string& msg)
 {
-  const std::string temp(data,size);
-  return to_JobStatus( temp );
+  return to_JobStatus(msg.c_str(), msg.size());
 }
 
 
@@ -12,6 +12,7 @@
 
 #include <remus/proto/JobSubmission.h>
 
+#include <remus/common/BinaryConversionHelper.h>
 #include <remus/common/ConversionHelper.h>
 
 #include <algorithm>
@@ -120,6 +121,88 @@ JobSubmission::JobSubmission(std::istream& buffer)
     }
 }
 
+//------------------------------------------------------------------------------
+void JobSubmission::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  //the mesh type of a submission is always the mesh type of the
+  //requirements, so we don't write it twice
+  this->Requirements.serialize(buffer);
+  buffer.writeUInt64(static_cast<boost::uint64_t>(this->Content.size()));
+  for(JobSubmission::const_iterator i = this->begin();
+      i != this->end();
+      ++i)
+    {
+    buffer.writeString(i->first);
+    i->second.serialize(buffer);
+    }
+}
+
+//------------------------------------------------------------------------------
+void JobSubmission::serialize(remus::internal::BinaryWriter& prefix,
+                              remus::internal::BinaryWriter& suffix,
+                              const std::string& key,
+                              std::size_t contentSize) const
+{
+  this->Requirements.serialize(prefix);
+  prefix.writeUInt64(static_cast<boost::uint64_t>(this->Content.size()));
+
+  remus::internal::BinaryWriter* buffer = &prefix;
+  for(JobSubmission::const_iterator i = this->begin();
+      i != this->end();
+      ++i)
+    {
+    buffer->writeString(i->first);
+    if(i->first == key)
+      {
+      //this must match the layout that JobContent::serialize writes, up
+      //to the length of the data, which the caller streams
+      buffer->writeUInt8(static_cast<boost::uint8_t>(i->second.sourceType()));
+      buffer->writeUInt8(static_cast<boost::uint8_t>(i->second.formatType()));
+      buffer->writeString(i->second.tag());
+      buffer->writeUInt64(static_cast<boost::uint64_t>(contentSize));
+      buffer = &suffix;
+      }
+    else
+      {
+      i->second.serialize(*buffer);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+JobSubmission::JobSubmission(remus::internal::BinaryReader& buffer):
+  MeshType(),
+  Requirements(buffer),
+  Content()
+{
+  this->MeshType = this->Requirements.meshTypes();
+
+  const boost::uint64_t contentSize = buffer.readUInt64();
+  for(boost::uint64_t i = 0; i < contentSize && buffer.good(); ++i)
+    {
+    const std::string key = buffer.readString();
+    this->Content[key] = JobContent(buffer);
+    }
+}
+
+//------------------------------------------------------------------------------
+std::size_t JobSubmission::binarySize() const
+{
+  typedef remus::internal::BinaryWriter Writer;
+  std::size_t size = 128 + Writer::blobSize(this->Requirements.workerName().size()) +
+                     Writer::blobSize(this->Requirements.tag().size()) +
+                     Writer::blobSize(this->Requirements.requirementsSize());
+  for(JobSubmission::const_iterator i = this->begin();
+      i != this->end();
+      ++i)
+    {
+    size += 2 + Writer::blobSize(i->first.size()) +
+            Writer::blobSize(i->second.tag().size()) +
+            Writer::blobSize(i->second.dataSize());
+    }
+  return size;
+}
+
 //------------------------------------------------------------------------------
 std::string to_string(const remus::proto::JobSubmission& sub)
 {
@@ -129,8 +212,52 @@ std::string to_string(const remus::proto::JobSubmission& sub)
 }
 
 //------------------------------------------------------------------------------
-remus::proto::JobSubmission to_JobSubmission(const char* data, std::size_t size)
+std::string to_binary(const remus::proto::JobSubmission& sub)
+{
+  //reserve the full size up front, so that the content is only copied once
+  std::string result;
+  result.reserve(sub.binarySize());
+
+  remus::internal::BinaryWriter buffer(result);
+  buffer.writeHeader(remus::internal::BinaryTag::JobSubmission);
+  sub.serialize(buffer);
+  return result;
+}
+
+//------------------------------------------------------------------------------
+bool to_binaryParts(const remus::proto::JobSubmission& sub,
+                    const std::string& key,
+                    std::size_t contentSize,
+                    std::string& prefix,
+                    std::string& suffix)
+{
+  prefix.clear();
+  suffix.clear();
+  if(sub.find(key) == sub.end())
+    {
+    return false;
+    }
+
+  prefix.reserve(sub.binarySize());
+  remus::internal::BinaryWriter prefixBuffer(prefix);
+  remus::internal::BinaryWriter suffixBuffer(suffix);
+  prefixBuffer.writeHeader(remus::internal::BinaryTag::JobSubmission);
+  sub.serialize(prefixBuffer, suffixBuffer, key, contentSize);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobSubmission to_JobSubmission(const char* data, std::size_t size,
+                                  const boost::shared_ptr<const void>& owner)
 {
+  if(remus::internal::isBinaryEncoded(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size,owner);
+    buffer.readHeader(remus::internal::BinaryTag::JobSubmission);
+    remus::proto::JobSubmission sub(buffer);
+    return buffer.good() ? sub : remus::proto::JobSubmission();
+    }
+
   std::stringstream buffer;
   remus::internal::writeString(buffer, data, size);
   remus::proto::JobSubmission sub;
@@ -138,7 +265,42 @@ remus::proto::JobSubmission to_JobSubmission(const char* data, std::size_t size)
   return sub;
 }
 
+//------------------------------------------------------------------------------
+std::string to_binary(const boost::uuids::uuid& jobId,
+                      const remus::proto::JobSubmission& sub)
+{
+  std::string result;
+  result.reserve(jobId.size() + sub.binarySize());
+
+  remus::internal::BinaryWriter buffer(result);
+  buffer.writeHeader(remus::internal::BinaryTag::WorkerJob);
+  buffer.writeBytes(reinterpret_cast<const char*>(jobId.data), jobId.size());
+  sub.serialize(buffer);
+  return result;
+}
 
+//------------------------------------------------------------------------------
+bool to_JobSubmission(const char* data, std::size_t size,
+                      const boost::shared_ptr<const void>& owner,
+                      boost::uuids::uuid& jobId,
+                      remus::proto::JobSubmission& sub)
+{
+  remus::internal::BinaryReader buffer(data,size,owner);
+  if(!buffer.readHeader(remus::internal::BinaryTag::WorkerJob))
+    {
+    return false;
+    }
+
+  const char* id = buffer.readBytes(jobId.size());
+  remus::proto::JobSubmission decoded(buffer);
+  if(!buffer.good())
+    {
+    return false;
+    }
+  std::copy(id, id + jobId.size(), jobId.data);
+  sub = decoded;
+  return true;
+}
 
 }
 }
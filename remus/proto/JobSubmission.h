@@ -21,6 +21,8 @@
 
 #include <remus/proto/ProtoExports.h>
 
+#include <boost/uuid/uuid.hpp>
+
 
 namespace remus{
 namespace proto{
@@ -101,12 +103,46 @@ public:
     { submission = JobSubmission(is); return is; }
 
 private:
+  friend REMUSPROTO_EXPORT std::string to_binary(const JobSubmission& sub);
+  friend REMUSPROTO_EXPORT std::string to_binary(const boost::uuids::uuid& jobId,
+                                                 const JobSubmission& sub);
+  friend REMUSPROTO_EXPORT bool to_binaryParts(const JobSubmission& sub,
+                                               const std::string& key,
+                                               std::size_t contentSize,
+                                               std::string& prefix,
+                                               std::string& suffix);
+  friend REMUSPROTO_EXPORT JobSubmission to_JobSubmission(const char* data,
+                                   std::size_t size,
+                                   const boost::shared_ptr<const void>& owner);
+  friend REMUSPROTO_EXPORT bool to_JobSubmission(const char* data,
+                                   std::size_t size,
+                                   const boost::shared_ptr<const void>& owner,
+                                   boost::uuids::uuid& jobId,
+                                   JobSubmission& sub);
+
   //serialize function
   void serialize(std::ostream& buffer) const;
 
   //deserialize constructor function
   explicit JobSubmission(std::istream& buffer);
 
+  //binary serialize function
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+
+  //binary serialize function that leaves out the data of the content
+  //under key, writing everything before it to prefix and everything
+  //after it to suffix
+  void serialize(remus::internal::BinaryWriter& prefix,
+                 remus::internal::BinaryWriter& suffix,
+                 const std::string& key,
+                 std::size_t contentSize) const;
+
+  //binary deserialize constructor function
+  explicit JobSubmission(remus::internal::BinaryReader& buffer);
+
+  //the number of bytes the binary encoding will need
+  std::size_t binarySize() const;
+
   remus::common::MeshIOType MeshType;
   remus::proto::JobRequirements Requirements;
   ContainerType Content;
@@ -119,8 +155,65 @@ REMUSPROTO_EXPORT
 std::string to_string(const remus::proto::JobSubmission& sub);
 
 //------------------------------------------------------------------------------
+//encode the submission using the binary wire format
+REMUSPROTO_EXPORT
+std::string to_binary(const remus::proto::JobSubmission& sub);
+
+//------------------------------------------------------------------------------
+//encode the submission using the binary wire format, without the data of
+//the content stored under key so that the data can be streamed instead of
+//held in memory. The full encoding is prefix, followed by contentSize bytes
+//of data, followed by suffix. Returns false if the submission has no
+//content under key.
+REMUSPROTO_EXPORT
+bool to_binaryParts(const remus::proto::JobSubmission& sub,
+                    const std::string& key,
+                    std::size_t contentSize,
+                    std::string& prefix,
+                    std::string& suffix);
+
+//------------------------------------------------------------------------------
+//decode a submission that was encoded with either wire format. When the
+//submission is binary encoded and the owner of data is given, the contents
+//of the submission point into data and keep the owner alive instead of
+//being copied.
+REMUSPROTO_EXPORT
+remus::proto::JobSubmission to_JobSubmission(const char* data, std::size_t size,
+                                  const boost::shared_ptr<const void>& owner);
+
+//------------------------------------------------------------------------------
+//decode a submission that was encoded with either wire format
+inline remus::proto::JobSubmission to_JobSubmission(const char* data,
+                                                    std::size_t size)
+{
+  return to_JobSubmission(data, size, boost::shared_ptr<const void>());
+}
+
+//------------------------------------------------------------------------------
+//encode a submission along with the id of the job it belongs to using the
+//binary wire format. This is how the server sends a remus::worker::Job
 REMUSPROTO_EXPORT
-remus::proto::JobSubmission to_JobSubmission(const char* data, std::size_t size);
+std::string to_binary(const boost::uuids::uuid& jobId,
+                      const remus::proto::JobSubmission& sub);
+
+//------------------------------------------------------------------------------
+//decode a binary encoded submission and job id. Returns false if the data
+//isn't a binary encoded job. When the owner of data is given the contents
+//of the submission point into data instead of being copied
+REMUSPROTO_EXPORT
+bool to_JobSubmission(const char* data, std::size_t size,
+                      const boost::shared_ptr<const void>& owner,
+                      boost::uuids::uuid& jobId,
+                      remus::proto::JobSubmission& sub);
+
+//------------------------------------------------------------------------------
+inline bool to_JobSubmission(const char* data, std::size_t size,
+                             boost::uuids::uuid& jobId,
+                             remus::proto::JobSubmission& sub)
+{
+  return to_JobSubmission(data, size, boost::shared_ptr<const void>(),
+                          jobId, sub);
+}
 
 //------------------------------------------------------------------------------
 inline remus::proto::JobSubmission to_JobSubmission(const std::string& msg)
@@ -47,6 +47,28 @@ Message send_Message(remus::common::MeshIOType mtype,
   return Message(mtype,stype,data,socket,Message::Blocking);
 }
 
+//----------------------------------------------------------------------------
+Message send_Message(remus::common::MeshIOType mtype,
+                     remus::SERVICE_TYPE stype,
+                     const std::string& data,
+                     const std::string& payload,
+                     zmq::socket_t* socket)
+{
+  return Message(mtype,stype,data,payload,std::string(),socket,
+                 Message::Blocking);
+}
+
+//----------------------------------------------------------------------------
+Message send_Message(remus::common::MeshIOType mtype,
+                     remus::SERVICE_TYPE stype,
+                     const std::string& data,
+                     const std::string& payload,
+                     zmq::socket_t* socket,
+                     const std::string& requestId)
+{
+  return Message(mtype,stype,data,payload,requestId,socket,Message::Blocking);
+}
+
 //----------------------------------------------------------------------------
 Message send_Message(remus::common::MeshIOType mtype,
                      remus::SERVICE_TYPE stype,
@@ -80,9 +102,34 @@ Message::Message(remus::common::MeshIOType mtype,
   MType(mtype),
   SType(stype),
   Valid(true), //need to be initially valid to be sent
-  Storage( boost::make_shared<zmq::message_t>(mdata.size()) )
+  Storage( boost::make_shared<zmq::message_t>(mdata.size()) ),
+  Payload()
+{
+  std::memcpy(Storage->data(),mdata.data(),mdata.size());
+
+  //send_impl wants us to be valid before we are sent, that way it knows
+  //that we are in a good state. This allows it to determine if it can forward
+  //itself to different sockets.
+  this->Valid = this->send_impl(socket, mode);
+}
+
+//----------------------------------------------------------------------------
+Message::Message(remus::common::MeshIOType mtype,
+                 remus::SERVICE_TYPE stype,
+                 const std::string& mdata,
+                 const std::string& mpayload,
+                 const std::string& requestId,
+                 zmq::socket_t* socket,
+                 Message::SendMode mode):
+  MType(mtype),
+  SType(stype),
+  Valid(true), //need to be initially valid to be sent
+  RequestId(requestId),
+  Storage( boost::make_shared<zmq::message_t>(mdata.size()) ),
+  Payload( boost::make_shared<zmq::message_t>(mpayload.size()) )
 {
   std::memcpy(Storage->data(),mdata.data(),mdata.size());
+  std::memcpy(Payload->data(),mpayload.data(),mpayload.size());
 
   //send_impl wants us to be valid before we are sent, that way it knows
   //that we are in a good state. This allows it to determine if it can forward
@@ -99,7 +146,8 @@ Message::Message(remus::common::MeshIOType mtype,
   MType(mtype),
   SType(stype),
   Valid(true), //need to be initially valid to be sent
-  Storage()
+  Storage(),
+  Payload()
 {
   //send_impl wants us to be valid before we are sent, that way it knows
   //that we are in a good state. This allows it to determine if it can forward
@@ -113,19 +161,23 @@ Message::Message(zmq::socket_t* socket):
   MType(),
   SType(),
   Valid(false),
-  Storage( boost::make_shared<zmq::message_t>() )
+  RequestId(),
+  Storage( boost::make_shared<zmq::message_t>() ),
+  Payload()
   {
   //we are receiving a multi part message
   //frame 0: REQ header / attachReqHeader does this
   //frame 1: Mesh Type
   //frame 2: Service Type
   //frame 3: Job Data //optional
+  //frame 4: Payload //optional, only sent when we have Job Data
   zmq::more_t more;
   size_t more_size = sizeof(more);
   socket->getsockopt(ZMQ_RCVMORE, &more, &more_size);
 
   //construct a job message from the socket
-  const bool removedHeader = zmq::removeReqHeader(*socket, ZMQ_DONTWAIT);
+  const bool removedHeader = zmq::removeReqHeader(*socket, this->RequestId,
+                                                  ZMQ_DONTWAIT);
   bool readMeshType = false;
   bool readServiceType = false;
   bool readStorageData = false;
@@ -168,6 +220,17 @@ Message::Message(zmq::socket_t* socket):
       readStorageData = zmq::recv_harder(*socket,
                                          this->Storage.get(),
                                          ZMQ_DONTWAIT);
+
+      //the payload is kept as its own zmq message so that it can be
+      //forwarded on without being copied
+      socket->getsockopt(ZMQ_RCVMORE, &more, &more_size);
+      if(readStorageData && more > 0)
+        {
+        this->Payload = boost::make_shared<zmq::message_t>();
+        readStorageData = zmq::recv_harder(*socket,
+                                           this->Payload.get(),
+                                           ZMQ_DONTWAIT);
+        }
       }
     }
 
@@ -202,6 +265,18 @@ std::size_t Message::dataSize() const
   return this->Storage ? this->Storage->size() : std::size_t(0);
 }
 
+//------------------------------------------------------------------------------
+const char* Message::payload() const
+{
+  return this->Payload ? static_cast<char*>(this->Payload->data()) : NULL;
+}
+
+//------------------------------------------------------------------------------
+std::size_t Message::payloadSize() const
+{
+  return this->Payload ? this->Payload->size() : std::size_t(0);
+}
+
 //------------------------------------------------------------------------------
 bool Message::send_impl(zmq::socket_t *socket, SendMode mode) const
 {
@@ -216,6 +291,7 @@ bool Message::send_impl(zmq::socket_t *socket, SendMode mode) const
   //frame 1: Mesh Type
   //frame 2: Service Type
   //frame 3: Job Data //optional
+  //frame 4: Payload //optional, only sent when we have Job Data
 
   //we have to be valid to be sent
   if(!this->isValid())
@@ -223,7 +299,8 @@ bool Message::send_impl(zmq::socket_t *socket, SendMode mode) const
     return false;
     }
 
-  const bool attached_header = zmq::attachReqHeader(*socket,flags);
+  const bool attached_header = zmq::attachReqHeader(*socket,this->RequestId,
+                                                    flags);
 
   bool valid = attached_header;
 
@@ -245,7 +322,20 @@ bool Message::send_impl(zmq::socket_t *socket, SendMode mode) const
     //send the service line not as the last line
     valid = zmq::send_harder(*socket,service,flags|ZMQ_SNDMORE);
 
-    valid = valid && zmq::send_harder(*socket, *this->Storage, flags);
+    if(this->payloadSize() > 0)
+      {
+      //zmq shares the payload between the copy and the original instead
+      //of copying the bytes, and the original stays valid after sending
+      zmq::message_t payload;
+      payload.copy(this->Payload.get());
+      valid = valid && zmq::send_harder(*socket, *this->Storage,
+                                        flags|ZMQ_SNDMORE);
+      valid = valid && zmq::send_harder(*socket, payload, flags);
+      }
+    else
+      {
+      valid = valid && zmq::send_harder(*socket, *this->Storage, flags);
+      }
     }
   else if(valid) //we are done
     {
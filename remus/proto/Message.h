@@ -43,6 +43,31 @@ Message send_Message(remus::common::MeshIOType mtype,
                      const std::string& data,
                      zmq::socket_t* socket);
 
+//----------------------------------------------------------------------------
+//pass in a std::string header and payload that we will copy and send.
+//The payload is sent as its own frame after the data, which allows the
+//receiver to parse the header without touching the payload.
+//The message returned will have a copy of the data given to it.
+REMUSPROTO_EXPORT
+Message send_Message(remus::common::MeshIOType mtype,
+                     remus::SERVICE_TYPE stype,
+                     const std::string& data,
+                     const std::string& payload,
+                     zmq::socket_t* socket);
+
+//----------------------------------------------------------------------------
+//send a message that is tagged with a request id, which the server sends
+//back in its response. This allows clients to have many messages in flight
+//on one socket, and match each response to the message it answers.
+//The data and payload frames are only sent when they aren't empty.
+REMUSPROTO_EXPORT
+Message send_Message(remus::common::MeshIOType mtype,
+                     remus::SERVICE_TYPE stype,
+                     const std::string& data,
+                     const std::string& payload,
+                     zmq::socket_t* socket,
+                     const std::string& requestId);
+
 //----------------------------------------------------------------------------
 //send a message that has no data.
 //The message returned will not have any data associated with it
@@ -96,6 +121,24 @@ public:
   const char* data() const;
   std::size_t dataSize() const;
 
+  //shared ownership of the zmq message that holds data(). Passing this
+  //to the decoders lets the decoded objects point into the message instead
+  //of copying it. Sending a message hands its data to zmq, so a message
+  //should not be forwarded once it has been decoded this way.
+  boost::shared_ptr<const void> storage() const { return this->Storage; }
+
+  //the optional payload frame that follows the data. Payloads are opaque
+  //to the server, which forwards them to workers without decoding them.
+  //payload() is NULL when the message has no payload
+  const char* payload() const;
+  std::size_t payloadSize() const;
+  const boost::shared_ptr<zmq::message_t>& payloadStorage() const
+    { return this->Payload; }
+
+  //the request id the message was tagged with, which is empty for
+  //messages that weren't tagged
+  const std::string& requestId() const { return RequestId; }
+
   //is true if all the message was sent, or all of the message was received.
   bool isValid() const { return Valid; }
 
@@ -105,6 +148,19 @@ private:
                               const std::string& data,
                               zmq::socket_t* socket);
 
+  friend Message send_Message(remus::common::MeshIOType mtype,
+                              remus::SERVICE_TYPE stype,
+                              const std::string& data,
+                              const std::string& payload,
+                              zmq::socket_t* socket);
+
+  friend Message send_Message(remus::common::MeshIOType mtype,
+                              remus::SERVICE_TYPE stype,
+                              const std::string& data,
+                              const std::string& payload,
+                              zmq::socket_t* socket,
+                              const std::string& requestId);
+
   friend Message send_Message(remus::common::MeshIOType mtype,
                               remus::SERVICE_TYPE stype,
                               zmq::socket_t* socket);
@@ -132,6 +188,17 @@ private:
           zmq::socket_t* socket,
           SendMode mode);
 
+  //----------------------------------------------------------------------------
+  //pass in a std::string data and payload that Message will copy and send,
+  //tagged with the given request id
+  Message(remus::common::MeshIOType mtype,
+          remus::SERVICE_TYPE stype,
+          const std::string& data,
+          const std::string& payload,
+          const std::string& requestId,
+          zmq::socket_t* socket,
+          SendMode mode);
+
   //----------------------------------------------------------------------------
   //creates a Message with no data
   Message(remus::common::MeshIOType mtype,
@@ -148,8 +215,10 @@ private:
   remus::common::MeshIOType MType;
   remus::SERVICE_TYPE SType;
   bool Valid; //tells if the message is valid
+  std::string RequestId;
 
   boost::shared_ptr<zmq::message_t> Storage;
+  boost::shared_ptr<zmq::message_t> Payload;
 };
 
 }
@@ -18,23 +18,68 @@
 namespace remus{
 namespace proto{
 
-
 //----------------------------------------------------------------------------
 Response send_Response(remus::SERVICE_TYPE stype,
                        const std::string& data,
                        zmq::socket_t* socket,
                        const zmq::SocketIdentity& client)
 {
-  return Response(stype,data,socket,client,Response::Blocking);
+  return Response(stype,data,socket,client,std::string(),Response::Blocking);
+}
+
+//----------------------------------------------------------------------------
+Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
+                                  const std::string& data,
+                                  zmq::socket_t* socket,
+                                  const zmq::SocketIdentity& client)
+{
+  return Response(stype,data,socket,client,std::string(),
+                  Response::NonBlocking);
 }
 
 //----------------------------------------------------------------------------
 Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
                                   const std::string& data,
+                                  const boost::shared_ptr<zmq::message_t>& payload,
                                   zmq::socket_t* socket,
                                   const zmq::SocketIdentity& client)
 {
-  return Response(stype,data,socket,client,Response::NonBlocking);
+  return Response(stype,data,payload,socket,client,Response::NonBlocking);
+}
+
+//----------------------------------------------------------------------------
+Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
+                                  const char* data,
+                                  std::size_t size,
+                                  const boost::shared_ptr<const void>& owner,
+                                  zmq::socket_t* socket,
+                                  const zmq::SocketIdentity& client)
+{
+  return Response(stype,data,size,owner,socket,client,std::string(),
+                  Response::NonBlocking);
+}
+
+//----------------------------------------------------------------------------
+Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
+                                  const std::string& data,
+                                  zmq::socket_t* socket,
+                                  const zmq::SocketIdentity& client,
+                                  const std::string& requestId)
+{
+  return Response(stype,data,socket,client,requestId,Response::NonBlocking);
+}
+
+//----------------------------------------------------------------------------
+Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
+                                  const char* data,
+                                  std::size_t size,
+                                  const boost::shared_ptr<const void>& owner,
+                                  zmq::socket_t* socket,
+                                  const zmq::SocketIdentity& client,
+                                  const std::string& requestId)
+{
+  return Response(stype,data,size,owner,socket,client,requestId,
+                  Response::NonBlocking);
 }
 
 //----------------------------------------------------------------------------
@@ -58,10 +103,13 @@ Response::Response(remus::SERVICE_TYPE stype,
                    const std::string& rdata,
                    zmq::socket_t* socket,
                    const zmq::SocketIdentity& client,
+                   const std::string& requestId,
                    Response::SendMode mode):
   SType(stype),
   Valid(true), //need to be initially valid to be sent
-  Storage( boost::make_shared<zmq::message_t>(rdata.size()) )
+  RequestId(requestId),
+  Storage( boost::make_shared<zmq::message_t>(rdata.size()) ),
+  Payload()
 {
   std::memcpy(this->Storage->data(),rdata.data(),rdata.size());
 
@@ -71,14 +119,57 @@ Response::Response(remus::SERVICE_TYPE stype,
   this->Valid = this->send_impl(socket, client, mode);
 }
 
+//----------------------------------------------------------------------------
+Response::Response(remus::SERVICE_TYPE stype,
+                   const std::string& rdata,
+                   const boost::shared_ptr<zmq::message_t>& payload,
+                   zmq::socket_t* socket,
+                   const zmq::SocketIdentity& client,
+                   Response::SendMode mode):
+  SType(stype),
+  Valid(true), //need to be initially valid to be sent
+  Storage( boost::make_shared<zmq::message_t>(rdata.size()) ),
+  Payload(payload)
+{
+  std::memcpy(this->Storage->data(),rdata.data(),rdata.size());
+
+  //send_impl wants us to be valid before we are sent, that way it knows
+  //that we are in a good state. This allows it to determine if it can forward
+  //itself to different sockets.
+  this->Valid = this->send_impl(socket, client, mode);
+}
+
+//----------------------------------------------------------------------------
+Response::Response(remus::SERVICE_TYPE stype,
+                   const char* rdata,
+                   std::size_t size,
+                   const boost::shared_ptr<const void>& owner,
+                   zmq::socket_t* socket,
+                   const zmq::SocketIdentity& client,
+                   const std::string& requestId,
+                   Response::SendMode mode):
+  SType(stype),
+  Valid(true), //need to be initially valid to be sent
+  RequestId(requestId),
+  Storage( zmq::make_shared_message(rdata,size,owner) ),
+  Payload()
+{
+  //send_impl wants us to be valid before we are sent, that way it knows
+  //that we are in a good state. This allows it to determine if it can forward
+  //itself to different sockets.
+  this->Valid = this->send_impl(socket, client, mode);
+}
+
 //----------------------------------------------------------------------------
 Response::Response(zmq::socket_t* socket):
   SType(remus::INVALID_SERVICE),
   Valid(false), //need to be initially valid to be sent
-  Storage( boost::make_shared<zmq::message_t>() )
+  RequestId(),
+  Storage( boost::make_shared<zmq::message_t>() ),
+  Payload()
 {
 
-  const bool removedHeader = zmq::removeReqHeader(*socket);
+  const bool removedHeader = zmq::removeReqHeader(*socket, this->RequestId);
   if(removedHeader)
     {
     zmq::message_t servType;
@@ -86,7 +177,18 @@ Response::Response(zmq::socket_t* socket):
     if(parsedServiceType)
       {
       this->SType = *(reinterpret_cast<SERVICE_TYPE*>(servType.data()));
-      const bool recvStorage = zmq::recv_harder(*socket,this->Storage.get());
+      bool recvStorage = zmq::recv_harder(*socket,this->Storage.get());
+
+      //the payload is kept as its own zmq message so that it can be
+      //forwarded on without being copied
+      zmq::more_t more = 0;
+      size_t more_size = sizeof(more);
+      socket->getsockopt(ZMQ_RCVMORE, &more, &more_size);
+      if(recvStorage && more > 0)
+        {
+        this->Payload = boost::make_shared<zmq::message_t>();
+        recvStorage = zmq::recv_harder(*socket,this->Payload.get());
+        }
 
       //if recvStorage is true than we received every chunk of data and we
       //are valid
@@ -107,6 +209,18 @@ std::size_t Response::dataSize() const
   return this->Storage ? this->Storage->size() : std::size_t(0);
 }
 
+//------------------------------------------------------------------------------
+const char* Response::payload() const
+{
+  return this->Payload ? static_cast<char*>(this->Payload->data()) : NULL;
+}
+
+//------------------------------------------------------------------------------
+std::size_t Response::payloadSize() const
+{
+  return this->Payload ? this->Payload->size() : std::size_t(0);
+}
+
 //------------------------------------------------------------------------------
 bool Response::send_impl(zmq::socket_t* socket,
                          const zmq::SocketIdentity& client,
@@ -120,9 +234,10 @@ bool Response::send_impl(zmq::socket_t* socket,
 
   //we are sending our selves as a multi part response
   //frame 0: client address we need to route too [Optional]
-  //frame 1: fake rep spacer
+  //frame 1: fake rep spacer, holding the request id when we have one
   //frame 2: Service Type we are responding too
   //frame 3: data
+  //frame 4: payload [Optional]
 
   bool responseSent = false;
 
@@ -136,7 +251,8 @@ bool Response::send_impl(zmq::socket_t* socket,
 
   if(clientSent)
     {
-    const bool sentFakeReq = zmq::attachReqHeader(*socket,flags);
+    const bool sentFakeReq = zmq::attachReqHeader(*socket,this->RequestId,
+                                                  flags);
     if(sentFakeReq)
       {
       zmq::message_t service(sizeof(this->SType));
@@ -146,7 +262,20 @@ bool Response::send_impl(zmq::socket_t* socket,
                                                  service, flags|ZMQ_SNDMORE );
       if(sentServiceType)
         {
-        responseSent = zmq::send_harder( *socket, *this->Storage, flags);
+        if(this->payloadSize() > 0)
+          {
+          //zmq shares the payload between the copy and the original
+          //instead of copying the bytes
+          zmq::message_t payload;
+          payload.copy(this->Payload.get());
+          responseSent = zmq::send_harder( *socket, *this->Storage,
+                                           flags|ZMQ_SNDMORE) &&
+                         zmq::send_harder( *socket, payload, flags);
+          }
+        else
+          {
+          responseSent = zmq::send_harder( *socket, *this->Storage, flags);
+          }
 
         }
       }
@@ -53,6 +53,53 @@ Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
                                   zmq::socket_t* socket,
                                   const zmq::SocketIdentity& client);
 
+//----------------------------------------------------------------------------
+//pass in a std::string that we will copy and send, followed by a payload
+//frame that we share with the message passed in instead of copying. This
+//is how the server forwards opaque job payloads to workers. No payload
+//frame is sent when the payload is empty.
+REMUSPROTO_EXPORT
+Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
+                                  const std::string& data,
+                                  const boost::shared_ptr<zmq::message_t>& payload,
+                                  zmq::socket_t* socket,
+                                  const zmq::SocketIdentity& client);
+
+//----------------------------------------------------------------------------
+//send data that is owned by someone else without copying it. zmq holds a
+//reference to the owner until it has finished sending the data, so the
+//data stays alive even if every other reference to the owner is dropped.
+REMUSPROTO_EXPORT
+Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
+                                  const char* data,
+                                  std::size_t size,
+                                  const boost::shared_ptr<const void>& owner,
+                                  zmq::socket_t* socket,
+                                  const zmq::SocketIdentity& client);
+
+//----------------------------------------------------------------------------
+//send a response to a message that was tagged with a request id, which we
+//send back so the client can match the response to the message it
+//answers. An empty request id sends the response like any other.
+REMUSPROTO_EXPORT
+Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
+                                  const std::string& data,
+                                  zmq::socket_t* socket,
+                                  const zmq::SocketIdentity& client,
+                                  const std::string& requestId);
+
+//----------------------------------------------------------------------------
+//send data that is owned by someone else without copying it, as a response
+//to a message that was tagged with a request id
+REMUSPROTO_EXPORT
+Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
+                                  const char* data,
+                                  std::size_t size,
+                                  const boost::shared_ptr<const void>& owner,
+                                  zmq::socket_t* socket,
+                                  const zmq::SocketIdentity& client,
+                                  const std::string& requestId);
+
 //----------------------------------------------------------------------------
 //parse a response from a socket
 //The response returned will have data associated with if it is valid
@@ -80,6 +127,23 @@ public:
   const char* data() const;
   std::size_t dataSize() const;
 
+  //shared ownership of the zmq message that holds data(). Passing this
+  //to the decoders lets the decoded objects point into the message instead
+  //of copying it. Sending a response hands its data to zmq, so a response
+  //should not be forwarded once it has been decoded this way.
+  boost::shared_ptr<const void> storage() const { return this->Storage; }
+
+  //the optional payload frame that follows the data. payload() is NULL
+  //when the response has no payload
+  const char* payload() const;
+  std::size_t payloadSize() const;
+  const boost::shared_ptr<zmq::message_t>& payloadStorage() const
+    { return this->Payload; }
+
+  //the request id of the message this response answers, which is empty
+  //when the message wasn't tagged with one
+  const std::string& requestId() const { return RequestId; }
+
   //is true if all the response was sent, or all of the response was received.
   bool isValid() const { return Valid; }
 private:
@@ -95,6 +159,33 @@ private:
                                            zmq::socket_t* socket,
                                            const zmq::SocketIdentity& client);
 
+  friend Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
+                          const std::string& data,
+                          const boost::shared_ptr<zmq::message_t>& payload,
+                          zmq::socket_t* socket,
+                          const zmq::SocketIdentity& client);
+
+  friend Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
+                          const char* data,
+                          std::size_t size,
+                          const boost::shared_ptr<const void>& owner,
+                          zmq::socket_t* socket,
+                          const zmq::SocketIdentity& client);
+
+  friend Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
+                                           const std::string& data,
+                                           zmq::socket_t* socket,
+                                           const zmq::SocketIdentity& client,
+                                           const std::string& requestId);
+
+  friend Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
+                          const char* data,
+                          std::size_t size,
+                          const boost::shared_ptr<const void>& owner,
+                          zmq::socket_t* socket,
+                          const zmq::SocketIdentity& client,
+                          const std::string& requestId);
+
   friend Response receive_Response( zmq::socket_t* socket );
 
   friend bool forward_Response(const remus::proto::Response& response,
@@ -107,6 +198,28 @@ private:
            const std::string& data,
            zmq::socket_t* socket,
            const zmq::SocketIdentity& client,
+           const std::string& requestId,
+           SendMode mode);
+
+  //----------------------------------------------------------------------------
+  //construct a response, the contents of the string will copied and sent
+  //and the payload will be shared and sent after it.
+  Response(remus::SERVICE_TYPE stype,
+           const std::string& data,
+           const boost::shared_ptr<zmq::message_t>& payload,
+           zmq::socket_t* socket,
+           const zmq::SocketIdentity& client,
+           SendMode mode);
+
+  //----------------------------------------------------------------------------
+  //construct a response that sends data held by owner without copying it
+  Response(remus::SERVICE_TYPE stype,
+           const char* data,
+           std::size_t size,
+           const boost::shared_ptr<const void>& owner,
+           zmq::socket_t* socket,
+           const zmq::SocketIdentity& client,
+           const std::string& requestId,
            SendMode mode);
 
   //----------------------------------------------------------------------------
@@ -117,8 +230,10 @@ private:
 
   remus::SERVICE_TYPE SType;
   bool Valid; //tells if the response is valid
+  std::string RequestId;
 
   boost::shared_ptr<zmq::message_t> Storage;
+  boost::shared_ptr<zmq::message_t> Payload;
 };
 
 }
@@ -0,0 +1,85 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <remus/proto/Transfer.h>
+
+#include <remus/common/BinaryConversionHelper.h>
+
+#include <algorithm>
+
+namespace remus{
+namespace proto{
+
+//------------------------------------------------------------------------------
+Transfer::Transfer():
+  Id(),
+  Offset(0),
+  Size(0),
+  Credits(0),
+  Valid(false)
+{
+  std::fill(this->Id.begin(), this->Id.end(), 0);
+}
+
+//------------------------------------------------------------------------------
+Transfer::Transfer(const boost::uuids::uuid& id,
+                   boost::uint64_t offset,
+                   boost::uint64_t size,
+                   boost::uint32_t credits):
+  Id(id),
+  Offset(offset),
+  Size(size),
+  Credits(credits),
+  Valid(true)
+{
+}
+
+//------------------------------------------------------------------------------
+std::string to_binary(const remus::proto::Transfer& t)
+{
+  std::string encoded;
+  encoded.reserve(4 + t.Id.size() + 8 + 8 + 4);
+
+  remus::internal::BinaryWriter buffer(encoded);
+  buffer.writeHeader(remus::internal::BinaryTag::Transfer);
+  buffer.writeBytes(reinterpret_cast<const char*>(t.Id.data), t.Id.size());
+  buffer.writeUInt64(t.Offset);
+  buffer.writeUInt64(t.Size);
+  buffer.writeUInt32(t.Credits);
+  return encoded;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Transfer to_Transfer(const char* data, std::size_t size)
+{
+  remus::internal::BinaryReader buffer(data,size);
+  if(!buffer.readHeader(remus::internal::BinaryTag::Transfer))
+    {
+    return remus::proto::Transfer();
+    }
+
+  remus::proto::Transfer t;
+  const char* id = buffer.readBytes(t.Id.size());
+  if(id)
+    {
+    std::copy(id, id + t.Id.size(), t.Id.data);
+    }
+  t.Offset = buffer.readUInt64();
+  t.Size = buffer.readUInt64();
+  t.Credits = buffer.readUInt32();
+  t.Valid = buffer.good();
+  return t;
+}
+
+}
+}
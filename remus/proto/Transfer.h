@@ -0,0 +1,104 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#ifndef remus_proto_Transfer_h
+#define remus_proto_Transfer_h
+
+#include <remus/common/CompilerInformation.h>
+
+//included for export symbols
+#include <remus/proto/ProtoExports.h>
+
+//suppress warnings inside boost headers for gcc, clang and MSVC
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/cstdint.hpp>
+#include <boost/uuid/uuid.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <cstddef>
+#include <string>
+
+namespace remus{
+namespace proto{
+
+//Describes one step of a chunked transfer. Large submissions and results
+//can be sent to the server as a TRANSFER_BEGIN message, a sequence of
+//TRANSFER_CHUNK messages and a TRANSFER_COMMIT message, instead of as
+//a single message that both peers need to hold in memory.
+//
+//The meaning of the offset, size and credits depends on the message:
+// - BEGIN: size is the total number of bytes that will be sent, or zero
+//   when the sender doesn't know it yet
+// - CHUNK: offset is where the chunk's bytes, which are sent as the
+//   message payload, start in the transfer
+// - the server replies to every message with the offset of the first byte
+//   it hasn't received, and the number of chunks the sender may have
+//   in flight before waiting for the next reply
+//
+//Transfers are named by an id the sender picks, so sending BEGIN again for
+//a transfer the server already knows about resumes it from the returned
+//offset. Transfers are only used by peers that negotiated the Binary
+//wire format, so they have no text encoding.
+class REMUSPROTO_EXPORT Transfer
+{
+public:
+  //construct an invalid transfer
+  Transfer();
+
+  Transfer(const boost::uuids::uuid& id,
+           boost::uint64_t offset,
+           boost::uint64_t size = 0,
+           boost::uint32_t credits = 0);
+
+  //returns the id the sender picked for the transfer
+  const boost::uuids::uuid& id() const { return this->Id; }
+
+  boost::uint64_t offset() const { return this->Offset; }
+  boost::uint64_t size() const { return this->Size; }
+  boost::uint32_t credits() const { return this->Credits; }
+
+  bool valid() const { return this->Valid; }
+
+private:
+  friend REMUSPROTO_EXPORT std::string to_binary(const Transfer& t);
+  friend REMUSPROTO_EXPORT Transfer to_Transfer(const char* data,
+                                                std::size_t size);
+
+  boost::uuids::uuid Id;
+  boost::uint64_t Offset;
+  boost::uint64_t Size;
+  boost::uint32_t Credits;
+  bool Valid;
+};
+
+//------------------------------------------------------------------------------
+//encode the transfer using the binary wire format
+REMUSPROTO_EXPORT
+std::string to_binary(const remus::proto::Transfer& t);
+
+//------------------------------------------------------------------------------
+//decode a binary encoded transfer, returns an invalid transfer when
+//the data isn't one
+REMUSPROTO_EXPORT
+remus::proto::Transfer to_Transfer(const char* data, std::size_t size);
+
+//------------------------------------------------------------------------------
+inline remus::proto::Transfer to_Transfer(const std::string& msg)
+{
+  return to_Transfer(msg.c_str(), msg.size());
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,46 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/proto/WireFormat.h>
+
+#include <remus/common/BinaryConversionHelper.h>
+
+namespace remus{
+namespace proto{
+
+//------------------------------------------------------------------------------
+remus::proto::WireFormat::Type detect_WireFormat(const char* data,
+                                                 std::size_t size)
+{
+  return remus::internal::isBinaryEncoded(data,size) ?
+                                    remus::proto::WireFormat::Binary :
+                                    remus::proto::WireFormat::Text;
+}
+
+//------------------------------------------------------------------------------
+std::string to_string(remus::proto::WireFormat::Type format)
+{
+  return (format == remus::proto::WireFormat::Binary) ? std::string("BINARY")
+                                                      : std::string("TEXT");
+}
+
+//------------------------------------------------------------------------------
+remus::proto::WireFormat::Type to_WireFormat(const char* data,
+                                             std::size_t size)
+{
+  const std::string format(data,size);
+  return (format == "BINARY") ? remus::proto::WireFormat::Binary
+                              : remus::proto::WireFormat::Text;
+}
+
+}
+}
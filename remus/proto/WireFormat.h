@@ -0,0 +1,65 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_proto_WireFormat_h
+#define remus_proto_WireFormat_h
+
+#include <cstddef>
+#include <string>
+
+//included for export symbols
+#include <remus/proto/ProtoExports.h>
+
+namespace remus{
+namespace proto{
+
+//The encodings that proto objects can be sent over a connection with.
+//Text is the original newline separated encoding and is understood by every
+//version of remus. Binary uses fixed width little endian headers and length
+//prefixed blobs, which allows large submissions and results to be decoded
+//without the copies that parsing the text encoding requires.
+//
+//Clients and workers ask the server for a wire format when they first talk
+//to it, and fall back to Text when the server doesn't understand the request.
+//Decoding always accepts both encodings.
+struct WireFormat{ enum Type{Text=0, Binary=1}; };
+
+//------------------------------------------------------------------------------
+//returns the wire format that the encoded data is in
+REMUSPROTO_EXPORT
+remus::proto::WireFormat::Type detect_WireFormat(const char* data,
+                                                 std::size_t size);
+
+//------------------------------------------------------------------------------
+//encode a wire format for sending while negotiating with the server
+REMUSPROTO_EXPORT
+std::string to_string(remus::proto::WireFormat::Type format);
+
+//------------------------------------------------------------------------------
+//decode a wire format, unknown formats are decoded as Text
+REMUSPROTO_EXPORT
+remus::proto::WireFormat::Type to_WireFormat(const char* data,
+                                             std::size_t size);
+
+//------------------------------------------------------------------------------
+//encode a proto object using the given wire format
+template<typename T>
+inline std::string to_string(const T& t, remus::proto::WireFormat::Type format)
+{
+  return (format == remus::proto::WireFormat::Binary) ? to_binary(t)
+                                                      : to_string(t);
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,119 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <remus/proto/Batch.h>
+#include <remus/testing/Testing.h>
+
+namespace
+{
+using namespace remus::proto;
+
+remus::common::MeshIOType make_type()
+{
+  return remus::common::make_MeshIOType(remus::meshtypes::Mesh2D(),
+                                        remus::meshtypes::Mesh3D());
+}
+
+void jobs_test()
+{
+  std::vector<Job> to_wire;
+  for(int i=0; i < 5; ++i)
+    {
+    to_wire.push_back( Job(remus::testing::UUIDGenerator(), make_type()) );
+    }
+
+  const std::string wire = to_batch(to_wire);
+  std::vector<Job> from_wire = to_JobVector(wire.c_str(), wire.size());
+  REMUS_ASSERT( (from_wire.size() == to_wire.size()) );
+  for(std::size_t i=0; i < to_wire.size(); ++i)
+    {
+    REMUS_ASSERT( (from_wire[i] == to_wire[i]) );
+    REMUS_ASSERT( (from_wire[i].type() == to_wire[i].type()) );
+    }
+
+  //an empty batch is still a batch
+  std::vector<BatchItem> items;
+  const std::string empty = to_batch(std::vector<Job>());
+  REMUS_ASSERT( to_BatchItems(empty.c_str(), empty.size(), items) );
+  REMUS_ASSERT( items.empty() );
+}
+
+void statuses_test(WireFormat::Type format)
+{
+  std::vector<JobStatus> to_wire;
+  to_wire.push_back( JobStatus(remus::testing::UUIDGenerator(), remus::QUEUED) );
+  to_wire.push_back( JobStatus(remus::testing::UUIDGenerator(),
+                               JobProgress(42, "halfway")) );
+  to_wire.push_back( JobStatus(remus::testing::UUIDGenerator(),
+                               remus::INVALID_STATUS) );
+
+  const std::string wire = to_batch(to_wire, format);
+  std::vector<JobStatus> from_wire = to_JobStatusVector(wire.c_str(), wire.size());
+  REMUS_ASSERT( (from_wire.size() == to_wire.size()) );
+  for(std::size_t i=0; i < to_wire.size(); ++i)
+    {
+    REMUS_ASSERT( (from_wire[i] == to_wire[i]) );
+    }
+}
+
+void submissions_test(WireFormat::Type format)
+{
+  const JobRequirements reqs =
+            make_JobRequirements(make_type(), "BatchWorker", "");
+  std::vector<JobSubmission> to_wire;
+  for(int i=0; i < 3; ++i)
+    {
+    JobSubmission sub(reqs);
+    sub["data"] = make_JobContent(remus::testing::BinaryDataGenerator(100*(i+1)));
+    to_wire.push_back(sub);
+    }
+
+  const std::string wire = to_batch(to_wire, format);
+  std::vector<JobSubmission> from_wire =
+    to_JobSubmissionVector(wire.c_str(), wire.size(),
+                           boost::shared_ptr<const void>());
+  REMUS_ASSERT( (from_wire.size() == to_wire.size()) );
+  for(std::size_t i=0; i < to_wire.size(); ++i)
+    {
+    REMUS_ASSERT( (from_wire[i] == to_wire[i]) );
+    }
+}
+
+void invalid_test()
+{
+  std::vector<BatchItem> items;
+
+  //single objects and truncated batches aren't batches
+  const Job job(remus::testing::UUIDGenerator(), make_type());
+  const std::string text = to_string(job);
+  REMUS_ASSERT( !to_BatchItems(text.c_str(), text.size(), items) );
+
+  std::vector<Job> jobs(3, job);
+  const std::string wire = to_batch(jobs);
+  REMUS_ASSERT( !to_BatchItems(wire.c_str(), wire.size()-1, items) );
+  REMUS_ASSERT( items.empty() );
+  REMUS_ASSERT( to_JobVector(wire.c_str(), wire.size()-1).empty() );
+}
+
+}
+
+int UnitTestBatch(int, char *[])
+{
+  jobs_test();
+  statuses_test(WireFormat::Text);
+  statuses_test(WireFormat::Binary);
+  submissions_test(WireFormat::Text);
+  submissions_test(WireFormat::Binary);
+  invalid_test();
+  return 0;
+}
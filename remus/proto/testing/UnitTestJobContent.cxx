@@ -11,6 +11,7 @@
 //=============================================================================
 
 #include <remus/proto/JobContent.h>
+#include <remus/proto/WireFormat.h>
 #include <remus/testing/Testing.h>
 
 #include <algorithm>
@@ -281,6 +282,32 @@ void verify_zero_copy_serilization(StringFactory factory)
   REMUS_ASSERT( (from_wire == input_content) );
 }
 
+template<typename StringFactory>
+void verify_binary_serilization(StringFactory factory)
+{
+  JobContent input_content = make_JobContent(factory(), ContentFormat::BSON);
+  input_content.tag("binary tag");
+
+  std::string wire_format = to_binary(input_content);
+  REMUS_ASSERT( (detect_WireFormat(wire_format.c_str(), wire_format.size()) ==
+                 WireFormat::Binary) );
+  JobContent from_wire = to_JobContent(wire_format);
+
+  REMUS_ASSERT( (from_wire.sourceType() == input_content.sourceType() ) );
+  REMUS_ASSERT( (from_wire.formatType() == input_content.formatType() ) );
+  REMUS_ASSERT( (from_wire.tag() == "binary tag" ) );
+  REMUS_ASSERT( (from_wire.dataSize() == input_content.dataSize()) );
+  REMUS_ASSERT( (from_wire == input_content) );
+
+  //a truncated message should not decode to the original content
+  if(input_content.dataSize() > 0)
+    {
+    JobContent truncated = to_JobContent(wire_format.c_str(),
+                                         wire_format.size() - 1);
+    REMUS_ASSERT( (truncated.dataSize() == 0) );
+    }
+}
+
 }
 
 int UnitTestJobContent(int, char *[])
@@ -327,6 +354,10 @@ int UnitTestJobContent(int, char *[])
   verify_zero_copy_serilization( (make_large_string()) );
   std::cout << "make_really_large_string" << std::endl;
   verify_zero_copy_serilization( (make_really_large_string()) );
+
+  verify_binary_serilization( (make_empty_string()) );
+  verify_binary_serilization( (make_small_binary_string()) );
+  verify_binary_serilization( (make_large_string()) );
   std::cout << std::endl;
 
   return 0;
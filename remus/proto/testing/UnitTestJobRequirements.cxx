@@ -265,6 +265,24 @@ void verify_serilization()
   REMUS_ASSERT( (reqs.requirementsSize() == reqs_serialized.requirementsSize()) );
 }
 
+void verify_binary_serilization()
+{
+  for(int i=0; i < 512; ++i)
+  {
+    JobRequirements reqs = make_random_MeshReqs();
+    const std::string wire = to_binary(reqs);
+    JobRequirements reqs_serialized =
+        to_JobRequirements( wire.c_str(), wire.size() );
+
+    REMUS_ASSERT( (reqs.sourceType() == reqs_serialized.sourceType()) );
+    REMUS_ASSERT( (reqs.formatType() == reqs_serialized.formatType()) );
+    REMUS_ASSERT( (reqs.meshTypes() == reqs_serialized.meshTypes()) );
+    REMUS_ASSERT( (reqs.workerName() == reqs_serialized.workerName()) );
+    REMUS_ASSERT( (reqs.tag() == reqs_serialized.tag()) );
+    REMUS_ASSERT( (reqs.hasRequirements() == reqs_serialized.hasRequirements()) );
+    REMUS_ASSERT( (reqs.requirementsSize() == reqs_serialized.requirementsSize()) );
+  }
+}
 
 void verify_req_set()
 {
@@ -299,6 +317,7 @@ int UnitTestJobRequirements(int, char *[])
   verify_less_than_op();
 
   verify_serilization();
+  verify_binary_serilization();
 
   verify_req_set();
   return 0;
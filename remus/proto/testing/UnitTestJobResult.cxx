@@ -10,6 +10,7 @@
 //
 //=============================================================================
 
+#include <boost/make_shared.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <remus/proto/JobResult.h>
 #include <remus/testing/Testing.h>
@@ -52,6 +53,58 @@ remus::common::ContentFormat::Type ftype = remus::common::ContentFormat::User)
   std::string data_from_buffer(from_buffer.data(),from_buffer.dataSize());
   REMUS_ASSERT( (data_from_string == data_s) );
 
+  const std::string binary = to_binary(s);
+  JobResult from_binary = to_JobResult(binary.c_str(), binary.size());
+
+  REMUS_ASSERT( (from_binary.id() == s.id()) );
+  REMUS_ASSERT( (from_binary.dataSize() == s.dataSize()) );
+  REMUS_ASSERT( (from_binary.valid() == s.valid()) );
+  REMUS_ASSERT( (from_binary.formatType() == ftype) );
+
+  std::string data_from_binary(from_binary.data(),from_binary.dataSize());
+  REMUS_ASSERT( (data_from_binary == data_s) );
+
+}
+
+void shared_storage_test()
+{
+  //decoding with the owner of the buffer should point the result into
+  //the buffer, and keep the buffer alive after everyone else drops it
+  JobResult input = make_JobResult( make_id(),
+                          remus::testing::BinaryDataGenerator(10240),
+                          remus::common::ContentFormat::BSON );
+
+  boost::shared_ptr<std::string> wire =
+                      boost::make_shared<std::string>(to_binary(input));
+  const char* begin = wire->data();
+  const char* end = wire->data() + wire->size();
+
+  JobResult from_wire = to_JobResult(wire->data(), wire->size(), wire);
+  wire.reset();
+
+  REMUS_ASSERT( (from_wire.data() >= begin && from_wire.data() < end) );
+  REMUS_ASSERT( (from_wire.dataSize() == input.dataSize()) );
+  std::string data_from_wire(from_wire.data(),from_wire.dataSize());
+  std::string data_input(input.data(),input.dataSize());
+  REMUS_ASSERT( (data_from_wire == data_input) );
+}
+
+void binary_prefix_test()
+{
+  //the prefix followed by the data should be the binary encoding of the
+  //full result, so results can be streamed into a buffer
+  JobResult input = make_JobResult( make_id(),
+                          remus::testing::BinaryDataGenerator(2048),
+                          remus::common::ContentFormat::XML );
+  const std::string data(input.data(),input.dataSize());
+
+  JobResult header(input.id(), remus::common::ContentFormat::XML,
+                   std::string());
+  const std::string prefix = to_binaryPrefix(header, data.size());
+  REMUS_ASSERT( (prefix + data == to_binary(input)) );
+
+  //the prefix is the same size no matter the result
+  REMUS_ASSERT( (prefix.size() == to_binaryPrefix(JobResult(make_id()),0).size()) );
 }
 
 void serialize_test()
@@ -104,5 +157,7 @@ void serialize_test()
 int UnitTestJobResult(int, char *[])
 {
   serialize_test();
+  shared_storage_test();
+  binary_prefix_test();
   return 0;
 }
\ No newline at end of file
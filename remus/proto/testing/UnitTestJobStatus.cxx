@@ -196,6 +196,16 @@ void validate_serialization(JobStatus s)
   REMUS_ASSERT( (from_string.inProgress() == s.inProgress() ) );
   REMUS_ASSERT( (from_string.finished() == s.finished() ) );
 
+  const std::string binary = to_binary(s);
+  JobStatus from_binary = to_JobStatus(binary.c_str(), binary.size());
+
+  REMUS_ASSERT( (from_binary.id() == s.id()) );
+  REMUS_ASSERT( (from_binary.status() == s.status()) );
+  REMUS_ASSERT( (from_binary.progress() == s.progress()) );
+
+  //truncated messages decode as an invalid status
+  JobStatus truncated = to_JobStatus(binary.c_str(), binary.size() - 1);
+  REMUS_ASSERT( (truncated.status() == remus::INVALID_STATUS) );
 }
 
 void serialize_test()
@@ -13,6 +13,8 @@
 #include <remus/proto/JobSubmission.h>
 #include <remus/testing/Testing.h>
 
+#include <boost/make_shared.hpp>
+
 namespace {
 using namespace remus::common;
 using namespace remus::proto;
@@ -270,6 +272,76 @@ void to_from_string_test()
   REMUS_ASSERT( (from_wire == to_wire) );
 }
 
+void to_from_binary_test()
+{
+  std::map< std::string, JobContent > content;
+  for(std::size_t i = 0;  i < size_t(10); ++i)
+    { content.insert(make_random_MapPairs()); }
+  JobSubmission to_wire(make_random_MeshReqs(),content);
+
+  const std::string wire = to_binary(to_wire);
+  JobSubmission from_wire = to_JobSubmission(wire.c_str(),wire.size());
+  REMUS_ASSERT( (from_wire == to_wire) );
+  REMUS_ASSERT( (from_wire.type() == to_wire.type()) );
+
+  //submissions sent to workers carry the job id with them
+  boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const std::string job_wire = to_binary(id,to_wire);
+  boost::uuids::uuid from_id;
+  JobSubmission from_job_wire;
+  REMUS_ASSERT( to_JobSubmission(job_wire.c_str(), job_wire.size(),
+                                 from_id, from_job_wire) );
+  REMUS_ASSERT( (from_id == id) );
+  REMUS_ASSERT( (from_job_wire == to_wire) );
+
+  //decoding with the owner of the buffer should point the contents into the
+  //buffer and keep it alive
+  boost::shared_ptr<std::string> shared_wire =
+                            boost::make_shared<std::string>(job_wire);
+  const char* begin = shared_wire->data();
+  const char* end = shared_wire->data() + shared_wire->size();
+  REMUS_ASSERT( to_JobSubmission(shared_wire->data(), shared_wire->size(),
+                                 shared_wire, from_id, from_job_wire) );
+  shared_wire.reset();
+  REMUS_ASSERT( (from_job_wire == to_wire) );
+  for(JobSubmission::const_iterator i = from_job_wire.begin();
+      i != from_job_wire.end(); ++i)
+    {
+    if(i->second.dataSize() > 0)
+      {
+      REMUS_ASSERT( (i->second.data() >= begin && i->second.data() < end) );
+      }
+    }
+
+  //a truncated job shouldn't decode
+  REMUS_ASSERT( !to_JobSubmission(job_wire.c_str(), job_wire.size()/2,
+                                  from_id, from_job_wire) );
+}
+
+void binary_parts_test()
+{
+  //the parts with the streamed data between them should be exactly the
+  //binary encoding of the full submission
+  const std::string data = remus::testing::BinaryDataGenerator(4096);
+  JobSubmission full(make_random_MeshReqs());
+  full["a"]= remus::proto::make_JobContent(remus::testing::AsciiStringGenerator(128));
+  full["b"]= remus::proto::make_JobContent(data);
+  full["c"]= remus::proto::make_JobContent(remus::testing::AsciiStringGenerator(128));
+
+  JobSubmission placeholder = full;
+  placeholder["b"] = remus::proto::make_JobContent(std::string());
+
+  std::string prefix, suffix;
+  REMUS_ASSERT( to_binaryParts(placeholder, "b", data.size(), prefix, suffix) );
+  REMUS_ASSERT( (prefix + data + suffix == to_binary(full)) );
+
+  //streaming the last content leaves nothing after it
+  REMUS_ASSERT( to_binaryParts(placeholder, "c", 0, prefix, suffix) );
+  REMUS_ASSERT( suffix.empty() );
+
+  REMUS_ASSERT( !to_binaryParts(placeholder, "missing", 0, prefix, suffix) );
+}
+
 void multiple_content_test()
 { //verify that a job submission with multiple key:values works properly
 
@@ -309,6 +381,8 @@ int UnitTestJobSubmission(int, char *[])
   insert_test();
   serialize_operator_test();
   to_from_string_test();
+  to_from_binary_test();
+  binary_parts_test();
 
   multiple_content_test();
 
@@ -17,6 +17,7 @@
 
 #include <boost/cstdint.hpp>
 
+#include <stdlib.h>
 #include <string>
 #include <set>
 
@@ -106,5 +107,35 @@ int UnitTestSocketIdentity(int, char *[])
   verify_uniqueness(randomIdentity);
   verify_uniqueness(nextIntegerIdentity);
 
+  //verify that a control lane maps back to the socket it belongs to, and
+  //that other sockets are left alone
+  zmq::SocketIdentity control = zmq::make_ControlIdentity(stringSocket);
+  REMUS_ASSERT( (zmq::is_ControlIdentity(control)) );
+  REMUS_ASSERT( (!zmq::is_ControlIdentity(stringSocket)) );
+  REMUS_ASSERT( (!zmq::is_ControlIdentity(intSocket)) );
+  REMUS_ASSERT( (!(control == stringSocket)) );
+  REMUS_ASSERT( (zmq::to_OwningIdentity(control) == stringSocket) );
+  REMUS_ASSERT( (zmq::to_OwningIdentity(stringSocket) == stringSocket) );
+  REMUS_ASSERT( (zmq::to_OwningIdentity(intSocket) == intSocket) );
+
+  //verify that the workers of a launched process can be told apart by the
+  //launch id of the process, including their control lanes
+  const std::string workerName = randomIdentity();
+  zmq::SocketIdentity plainWorker = zmq::make_WorkerIdentity(workerName);
+  REMUS_ASSERT( (plainWorker.name() == workerName) );
+
+#if !defined(_WIN32) || defined(__CYGWIN__)
+  setenv(zmq::launchIdVariable(), "launch-a", 1);
+  zmq::SocketIdentity launchedWorker = zmq::make_WorkerIdentity(workerName);
+  unsetenv(zmq::launchIdVariable());
+
+  REMUS_ASSERT( (zmq::is_LaunchedWorker(launchedWorker, "launch-a")) );
+  REMUS_ASSERT( (zmq::is_LaunchedWorker(
+                    zmq::make_ControlIdentity(launchedWorker), "launch-a")) );
+  REMUS_ASSERT( (!zmq::is_LaunchedWorker(launchedWorker, "launch")) );
+  REMUS_ASSERT( (!zmq::is_LaunchedWorker(launchedWorker, "")) );
+  REMUS_ASSERT( (!zmq::is_LaunchedWorker(plainWorker, "launch-a")) );
+#endif
+
   return 0;
 }
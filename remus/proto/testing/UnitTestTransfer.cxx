@@ -0,0 +1,60 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <remus/proto/Transfer.h>
+#include <remus/testing/Testing.h>
+
+namespace
+{
+using namespace remus::proto;
+
+void to_from_binary_test()
+{
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  Transfer to_wire(id, 1024, 65536, 4);
+  REMUS_ASSERT( to_wire.valid() );
+
+  const std::string wire = to_binary(to_wire);
+  Transfer from_wire = to_Transfer(wire);
+  REMUS_ASSERT( from_wire.valid() );
+  REMUS_ASSERT( (from_wire.id() == id) );
+  REMUS_ASSERT( (from_wire.offset() == 1024) );
+  REMUS_ASSERT( (from_wire.size() == 65536) );
+  REMUS_ASSERT( (from_wire.credits() == 4) );
+
+  //offsets larger than 4GB need to survive the trip
+  const boost::uint64_t large = (boost::uint64_t(1) << 40) + 7;
+  from_wire = to_Transfer(to_binary(Transfer(id, large, large)));
+  REMUS_ASSERT( (from_wire.offset() == large) );
+  REMUS_ASSERT( (from_wire.size() == large) );
+}
+
+void invalid_test()
+{
+  REMUS_ASSERT( !Transfer().valid() );
+
+  //text and truncated data aren't transfers
+  REMUS_ASSERT( !to_Transfer(std::string("TRANSFER")).valid() );
+  const std::string wire =
+            to_binary(Transfer(remus::testing::UUIDGenerator(), 1));
+  REMUS_ASSERT( !to_Transfer(wire.c_str(), wire.size()-1).valid() );
+}
+
+}
+
+int UnitTestTransfer(int, char *[])
+{
+  to_from_binary_test();
+  invalid_test();
+  return 0;
+}
@@ -18,6 +18,8 @@
 
 REMUS_THIRDPARTY_PRE_INCLUDE
 #include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
 //We now provide our own zmq.hpp since it has been removed from zmq 3, and
@@ -28,7 +30,9 @@ REMUS_THIRDPARTY_POST_INCLUDE
 
 #include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <sstream>
+#include <string>
 
 //inject some basic zero MQ helper functions into the namespace
 namespace zmq
@@ -51,6 +55,85 @@ inline zmq::SocketIdentity address_recv(zmq::socket_t& socket)
   return zmq::SocketIdentity((char*)message.data(),message.size());
 }
 
+//non blocking version of address_recv. Returns false when the socket
+//has no pending message, which allows callers to drain a socket without
+//needing to poll between each message
+inline bool address_recv_nonblocking(zmq::socket_t& socket,
+                                     zmq::SocketIdentity& address)
+{
+  zmq::message_t message;
+  if(!socket.recv(&message, ZMQ_DONTWAIT))
+    {
+    return false;
+    }
+  address = zmq::SocketIdentity((char*)message.data(),message.size());
+  return true;
+}
+
+//move a single multi part message from one socket to another without
+//blocking. The frames are handed over to the destination socket, not
+//copied. Returns false when the source socket has no pending message
+inline bool forward_nonblocking(zmq::socket_t& from, zmq::socket_t& to)
+{
+  zmq::message_t frame;
+  if(!from.recv(&frame, ZMQ_DONTWAIT))
+    {
+    return false;
+    }
+
+  zmq::more_t more;
+  std::size_t more_size = sizeof(more);
+  from.getsockopt(ZMQ_RCVMORE, &more, &more_size);
+  while(more > 0)
+    {
+    to.send(frame, ZMQ_SNDMORE|ZMQ_DONTWAIT);
+    //the remaining frames of a multi part message are delivered atomically
+    //so they are already available
+    from.recv(&frame);
+    from.getsockopt(ZMQ_RCVMORE, &more, &more_size);
+    }
+  to.send(frame, ZMQ_DONTWAIT);
+  return true;
+}
+
+//called by zmq once it has finished sending data that we didn't copy,
+//releases the reference we took to the owner of the data
+inline void release_shared_owner(void*, void* hint)
+{
+  delete static_cast< boost::shared_ptr<const void>* >(hint);
+}
+
+//make a zmq message that points at data without copying it, and keeps
+//owner alive for as long as zmq needs the data
+inline boost::shared_ptr<zmq::message_t> make_shared_message(const char* data,
+                                  std::size_t size,
+                                  const boost::shared_ptr<const void>& owner)
+{
+  if(size == 0 || data == NULL)
+    {
+    return boost::make_shared<zmq::message_t>();
+    }
+
+  boost::shared_ptr<const void>* hint = new boost::shared_ptr<const void>(owner);
+  try
+    {
+    return boost::make_shared<zmq::message_t>(const_cast<char*>(data),
+                                              size,
+                                              &release_shared_owner,
+                                              hint);
+    }
+  catch(zmq::error_t)
+    {
+    delete hint;
+    }
+
+  //fall back to copying the data if zmq couldn't use it in place
+  boost::shared_ptr<zmq::message_t> copy =
+                                  boost::make_shared<zmq::message_t>(size);
+  std::memcpy(copy->data(),data,size);
+  return copy;
+}
+
 //specify a default linger so that if what we are connecting to
 //doesn't exist and we are told to shutdown we don't hang for ever
 inline void set_socket_linger(zmq::socket_t &socket)
@@ -242,6 +325,39 @@ inline bool removeReqHeader(zmq::socket_t& socket,
   return removedHeader;
 }
 
+//Like removeReqHeader, but keeps what the ReqHeader holds. Clients that
+//have many messages in flight on one socket tag every message with a request
+//id in the header, which the server sends back in the header of its response.
+//The header is always empty for REQ and REP sockets
+inline bool removeReqHeader(zmq::socket_t& socket,
+                            std::string& header,
+                            int flags=0)
+{
+  header.clear();
+  bool removedHeader = true;
+  int socketType;
+  std::size_t socketTypeSize = sizeof(socketType);
+  socket.getsockopt(ZMQ_TYPE,&socketType,&socketTypeSize);
+  if(socketType != ZMQ_REQ && socketType != ZMQ_REP)
+    {
+    zmq::message_t reqHeader;
+    try
+      {
+      removedHeader = zmq::recv_harder(socket, &reqHeader, flags);
+      }
+    catch(zmq::error_t)
+      {
+      removedHeader = false;
+      }
+    if(removedHeader)
+      {
+      header.assign(static_cast<const char*>(reqHeader.data()),
+                    reqHeader.size());
+      }
+    }
+  return removedHeader;
+}
+
 //we presume that every message needs to be treated like a Req/Rep
 //message and we need to pad a null message on everything
 //Returns true if we added the ReqHeader, or if no header
@@ -268,6 +384,32 @@ inline bool removeReqHeader(zmq::socket_t& socket,
   return attachedHeader;
 }
 
+//Like attachReqHeader, but the ReqHeader holds the given request id.
+//An empty request id sends the same header as attachReqHeader
+inline bool attachReqHeader(zmq::socket_t& socket,
+                            const std::string& header,
+                            int flags=0)
+{
+  bool attachedHeader = true;
+  int socketType;
+  std::size_t socketTypeSize = sizeof(socketType);
+  socket.getsockopt(ZMQ_TYPE,&socketType,&socketTypeSize);
+  if(socketType != ZMQ_REQ && socketType != ZMQ_REP)
+    {
+    zmq::message_t reqHeader(header.size());
+    std::memcpy(reqHeader.data(),header.data(),header.size());
+    try
+      {
+      attachedHeader = zmq::send_harder(socket, reqHeader, flags|ZMQ_SNDMORE);
+      }
+    catch(zmq::error_t err)
+      {
+      attachedHeader = false;
+      }
+    }
+  return attachedHeader;
+}
+
 }
 
 #endif // remus_proto_zmqHelper_h
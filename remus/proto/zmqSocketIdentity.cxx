@@ -17,10 +17,13 @@
 //suppress warnings inside boost headers for gcc, clang and MSVC
 REMUS_THIRDPARTY_PRE_INCLUDE
 #include <boost/cstdint.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/lexical_cast.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
 
 namespace
 {
@@ -34,6 +37,18 @@ boost::uint32_t  convertBEToUnsignedInteger(const char buffer[256])
               static_cast<boost::uint32_t>(buffer[4]);
 }
 
+//appended to the identity of a socket to form the identity of its control
+//lane. zmq reserves identities that start with a null byte, so a custom
+//identity never ends with this by accident
+const char controlSuffix[] = "\0control";
+const std::size_t controlSuffixSize = sizeof(controlSuffix) - 1;
+
+//separates the launch id from the rest of the identity of a worker. Launch
+//ids longer than maxLaunchIdSize are ignored, so that the identity of the
+//worker and its control lane always fit
+const char launchIdSeparator = ':';
+const std::size_t maxLaunchIdSize = 128;
+
 }
 
 namespace zmq
@@ -101,5 +116,73 @@ bool SocketIdentity::operator<(const SocketIdentity& b) const
                                         b.data(), b.data()+b.size());
 }
 
+//------------------------------------------------------------------------------
+std::size_t hash_value(const SocketIdentity& identity)
+{
+  return boost::hash_range(identity.data(), identity.data()+identity.size());
+}
+
+//------------------------------------------------------------------------------
+SocketIdentity make_ControlIdentity(const SocketIdentity& socket)
+{
+  char buffer[256];
+  const std::size_t size = std::min<std::size_t>(socket.size(),
+                                                 256 - controlSuffixSize);
+  std::memcpy(buffer, socket.data(), size);
+  std::memcpy(buffer + size, controlSuffix, controlSuffixSize);
+  return SocketIdentity(buffer, size + controlSuffixSize);
+}
+
+//------------------------------------------------------------------------------
+bool is_ControlIdentity(const SocketIdentity& socket)
+{
+  return socket.size() > controlSuffixSize &&
+         std::equal(controlSuffix, controlSuffix + controlSuffixSize,
+                    socket.data() + socket.size() - controlSuffixSize);
+}
+
+//------------------------------------------------------------------------------
+SocketIdentity to_OwningIdentity(const SocketIdentity& socket)
+{
+  if(!is_ControlIdentity(socket))
+    {
+    return socket;
+    }
+  return SocketIdentity(socket.data(), socket.size() - controlSuffixSize);
+}
+
+
+//------------------------------------------------------------------------------
+const char* launchIdVariable()
+{
+  return "REMUS_WORKER_LAUNCH_ID";
+}
+
+//------------------------------------------------------------------------------
+SocketIdentity make_WorkerIdentity(const std::string& name)
+{
+  std::string identity;
+  const char* launchId = std::getenv(launchIdVariable());
+  if(launchId && launchId[0] && std::strlen(launchId) <= maxLaunchIdSize)
+    {
+    identity = std::string(launchId) + launchIdSeparator;
+    }
+  identity += name;
+
+  const std::size_t size = std::min<std::size_t>(identity.size(),
+                                                 256 - controlSuffixSize);
+  return SocketIdentity(identity.c_str(), size);
+}
+
+//------------------------------------------------------------------------------
+bool is_LaunchedWorker(const SocketIdentity& socket,
+                       const std::string& launchId)
+{
+  const SocketIdentity owner = to_OwningIdentity(socket);
+  return !launchId.empty() &&
+         owner.size() > launchId.size() &&
+         owner.data()[launchId.size()] == launchIdSeparator &&
+         std::equal(launchId.begin(), launchId.end(), owner.data());
+}
 
 }
@@ -46,6 +46,39 @@ private:
   std::string Name;
 };
 
+//hash function for SocketIdentity so that it can be used as the key of
+//a boost::unordered_map
+REMUSPROTO_EXPORT std::size_t hash_value(const SocketIdentity& identity);
+
+//Workers can talk to the server over a second connection, the control lane,
+//which carries heartbeats and status so that they are never queued behind
+//a large result on the connection that carries jobs and results. The
+//identity of the control lane is derived from the identity of the worker's
+//main connection, so that the server knows which worker it belongs to.
+REMUSPROTO_EXPORT SocketIdentity make_ControlIdentity(const SocketIdentity& socket);
+
+//returns true if the socket is the control lane of another socket
+REMUSPROTO_EXPORT bool is_ControlIdentity(const SocketIdentity& socket);
+
+//returns the socket that a control lane belongs to. Sockets that aren't
+//a control lane are returned unchanged
+REMUSPROTO_EXPORT SocketIdentity to_OwningIdentity(const SocketIdentity& socket);
+
+//Worker processes launched by a worker factory are given a launch id through
+//the environment variable named by launchIdVariable. The identities of the
+//workers of such a process start with the launch id, so that the server can
+//tell which workers belonged to a process that the factory saw fail.
+REMUSPROTO_EXPORT const char* launchIdVariable();
+
+//make the identity of a worker with the given unique name, which starts
+//with the launch id of this process when it was launched with one
+REMUSPROTO_EXPORT SocketIdentity make_WorkerIdentity(const std::string& name);
+
+//returns true if the socket belongs to a worker of the process that was
+//launched with the given launch id
+REMUSPROTO_EXPORT bool is_LaunchedWorker(const SocketIdentity& socket,
+                                         const std::string& launchId);
+
 }
 
 #endif // remus_proto_zmqSocketIdentity_h
@@ -177,6 +177,48 @@ namespace {
           environ[oneenv->string] = oneenv->valuestring;
       }
 
+    // Resident workers handle many jobs in a single process
+    std::size_t maxJobsPerProcess = 1;
+    boost::int64_t idleTimeout = -1;
+    cJSON* maxjobsobj = cJSON_GetObjectItem(root, "MaxJobsPerProcess");
+    if (maxjobsobj && maxjobsobj->type == cJSON_Number &&
+        maxjobsobj->valuedouble >= 0)
+      maxJobsPerProcess = static_cast<std::size_t>(maxjobsobj->valuedouble);
+    cJSON* idleobj = cJSON_GetObjectItem(root, "IdleTimeout");
+    if (idleobj && idleobj->type == cJSON_Number)
+      idleTimeout = static_cast<boost::int64_t>(idleobj->valuedouble);
+
+    // Workers kept launched ahead of demand
+    unsigned int minIdleWorkers = 0;
+    cJSON* minidleobj = cJSON_GetObjectItem(root, "MinIdleWorkers");
+    if (minidleobj && minidleobj->type == cJSON_Number &&
+        minidleobj->valuedouble >= 0)
+      minIdleWorkers = static_cast<unsigned int>(minidleobj->valuedouble);
+
+    // Resources each process of the worker can use
+    remus::common::ProcessLimits limits;
+    cJSON* limitsobj = cJSON_GetObjectItem(root, "ResourceLimits");
+    if (limitsobj && limitsobj->type == cJSON_Object)
+      {
+      cJSON* memobj = cJSON_GetObjectItem(limitsobj, "MaxMemoryMB");
+      if (memobj && memobj->type == cJSON_Number && memobj->valuedouble >= 0)
+        limits.MaxMemoryBytes =
+          static_cast<boost::int64_t>(memobj->valuedouble * 1024 * 1024);
+      cJSON* cpuobj = cJSON_GetObjectItem(limitsobj, "CpuQuota");
+      if (cpuobj && cpuobj->type == cJSON_Number)
+        limits.CpuQuota = cpuobj->valuedouble;
+      cJSON* cpusetobj = cJSON_GetObjectItem(limitsobj, "CpuSet");
+      if (cpusetobj && cpusetobj->type == cJSON_String && cpusetobj->valuestring)
+        limits.CpuSet = cpusetobj->valuestring;
+      cJSON* filesobj = cJSON_GetObjectItem(limitsobj, "MaxOpenFiles");
+      if (filesobj && filesobj->type == cJSON_Number &&
+          filesobj->valuedouble >= 0)
+        limits.MaxOpenFiles = static_cast<boost::int64_t>(filesobj->valuedouble);
+      cJSON* groupobj = cJSON_GetObjectItem(limitsobj, "ControlGroup");
+      if (groupobj && groupobj->type == cJSON_String && groupobj->valuestring)
+        limits.ControlGroupParent = groupobj->valuestring;
+      }
+
     cJSON_Delete(root);
 
     //try the executableName as an absolute path, if that isn't
@@ -192,7 +234,13 @@ namespace {
     #endif
       exec_path = new_path;
       }
-    return remus::server::FactoryWorkerSpecification(exec_path, cmdline, environ, reqs);
+    remus::server::FactoryWorkerSpecification spec(exec_path, cmdline,
+                                                   environ, reqs);
+    spec.MaxJobsPerProcess = maxJobsPerProcess;
+    spec.IdleTimeout = idleTimeout;
+    spec.MinIdleWorkers = minIdleWorkers;
+    spec.Limits = limits;
+    return spec;
   }
 }
 
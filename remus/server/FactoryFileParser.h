@@ -17,11 +17,13 @@
 #include <remus/server/ServerExports.h>
 
 #include <remus/common/CompilerInformation.h>
+#include <remus/common/ExecuteProcess.h>
 #include <remus/proto/JobRequirements.h>
 
 //force to use filesystem version 3
 REMUS_THIRDPARTY_PRE_INCLUDE
 #define BOOST_FILESYSTEM_VERSION 3
+#include <boost/cstdint.hpp>
 #include <boost/filesystem.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
@@ -35,12 +37,24 @@ namespace server{
 //factory can launch. Currently the ExtraCommandLineArguments and
 //EnvironmentVariables are ignored by the default WorkerFactory, but
 //exist to allow for better worker factories designed by users of remus
+//
+//Workers whose MaxJobsPerProcess isn't 1 are resident workers, whose
+//processes handle many jobs before exiting. MaxJobsPerProcess of 0 means
+//a process handles jobs until it is terminated, and an IdleTimeout that
+//isn't negative is how many milliseconds a process waits for a job before
+//it exits. MinIdleWorkers is the number of workers the factory keeps idle
+//or starting ahead of demand. Limits are the resources each process of the
+//worker can use.
 struct REMUSSERVER_EXPORT FactoryWorkerSpecification
 {
   remus::proto::JobRequirements Requirements;
   boost::filesystem::path ExecutionPath;
   std::vector< std::string > ExtraCommandLineArguments;
   std::map< std::string, std::string > EnvironmentVariables;
+  std::size_t MaxJobsPerProcess;
+  boost::int64_t IdleTimeout;
+  unsigned int MinIdleWorkers;
+  remus::common::ProcessLimits Limits;
   bool isValid;
 
   FactoryWorkerSpecification():
@@ -48,6 +62,10 @@ struct REMUSSERVER_EXPORT FactoryWorkerSpecification
     ExecutionPath(),
     ExtraCommandLineArguments(),
     EnvironmentVariables(),
+    MaxJobsPerProcess(1),
+    IdleTimeout(-1),
+    MinIdleWorkers(0),
+    Limits(),
     isValid(false)
     {
     }
@@ -58,6 +76,10 @@ struct REMUSSERVER_EXPORT FactoryWorkerSpecification
     ExecutionPath(),
     ExtraCommandLineArguments(),
     EnvironmentVariables(),
+    MaxJobsPerProcess(1),
+    IdleTimeout(-1),
+    MinIdleWorkers(0),
+    Limits(),
     isValid(false)
     {
     if(boost::filesystem::is_regular_file(exec_path))
@@ -75,6 +97,10 @@ struct REMUSSERVER_EXPORT FactoryWorkerSpecification
     ExecutionPath(),
     ExtraCommandLineArguments(extra_args),
     EnvironmentVariables(),
+    MaxJobsPerProcess(1),
+    IdleTimeout(-1),
+    MinIdleWorkers(0),
+    Limits(),
     isValid(false)
     {
     if(boost::filesystem::is_regular_file(exec_path))
@@ -93,6 +119,10 @@ struct REMUSSERVER_EXPORT FactoryWorkerSpecification
     ExecutionPath(),
     ExtraCommandLineArguments(extra_args),
     EnvironmentVariables(environment),
+    MaxJobsPerProcess(1),
+    IdleTimeout(-1),
+    MinIdleWorkers(0),
+    Limits(),
     isValid(false)
     {
     if(boost::filesystem::is_regular_file(exec_path))
@@ -102,6 +132,9 @@ struct REMUSSERVER_EXPORT FactoryWorkerSpecification
       this->isValid = true;
       }
     }
+
+  //does a process of this worker handle more than a single job
+  bool isResident() const { return this->MaxJobsPerProcess != 1; }
 };
 
 //Extensible class that determines how to parse the contents of a WorkerFactory
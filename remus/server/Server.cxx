@@ -17,15 +17,19 @@ REMUS_THIRDPARTY_PRE_INCLUDE
 REMUS_THIRDPARTY_POST_INCLUDE
 
 #include <boost/make_shared.hpp>
+#include <boost/optional.hpp>
 #include <boost/thread/locks.hpp>
+#include <boost/uuid/nil_generator.hpp>
 #include <boost/uuid/uuid.hpp>
 
+#include <remus/proto/Batch.h>
 #include <remus/proto/Job.h>
 #include <remus/proto/JobResult.h>
 #include <remus/proto/JobStatus.h>
 #include <remus/proto/JobRequirements.h>
 #include <remus/proto/Message.h>
 #include <remus/proto/Response.h>
+#include <remus/proto/Transfer.h>
 #include <remus/proto/zmqSocketIdentity.h>
 #include <remus/proto/zmqHelper.h>
 
@@ -38,11 +42,16 @@ REMUS_THIRDPARTY_POST_INCLUDE
 #include <remus/server/detail/EventPublisher.h>
 #include <remus/server/detail/JobQueue.h>
 #include <remus/server/detail/SocketMonitor.h>
+#include <remus/server/detail/TimerWheel.h>
+#include <remus/server/detail/Transfers.h>
+#include <remus/server/detail/WireFormats.h>
 #include <remus/server/detail/WorkerPool.h>
 #include <remus/server/WorkerFactory.h>
 
+#include <algorithm>
 #include <set>
 #include <ctime>
+#include <vector>
 
 //initialize the static instance variable in signal catcher in the class
 //that inherits from it
@@ -80,6 +89,85 @@ void send_terminateJob(boost::uuids::uuid jobId,
                                          workerId);
 }
 
+//------------------------------------------------------------------------------
+//tell the scheduler thread that the state of jobs or workers has changed.
+//We don't care if the notification is dropped because the scheduler
+//already has a notification pending
+void notify_scheduler(zmq::socket_t& schedulerChannel, bool workerTerminated)
+{
+  zmq::message_t note(1);
+  static_cast<char*>(note.data())[0] = workerTerminated ? 1 : 0;
+  schedulerChannel.send(note, ZMQ_DONTWAIT);
+}
+
+//------------------------------------------------------------------------------
+//the room that results streamed from workers need in front of their data,
+//for the binary encoding of the rest of the result
+std::size_t result_headroom()
+{
+  return remus::proto::to_binaryPrefix(
+            remus::proto::JobResult(boost::uuids::nil_uuid()),0).size();
+}
+
+//------------------------------------------------------------------------------
+//send the response to a client query. Stored results that can be sent as
+//the worker encoded them are handed to zmq without being copied. The
+//request id of the query is sent back, so that clients with many queries
+//in flight know which one we are answering
+void send_ClientResponse(remus::SERVICE_TYPE service,
+                         const std::string& data,
+                         const EncodedResult& encoded,
+                         zmq::socket_t& clientChannel,
+                         const zmq::SocketIdentity& clientIdentity,
+                         const std::string& requestId)
+{
+  if(!encoded.empty())
+    {
+    remus::proto::send_NonBlockingResponse(service,
+                                           encoded.Data,
+                                           encoded.Size,
+                                           encoded.Owner,
+                                           &clientChannel,
+                                           clientIdentity,
+                                           requestId);
+    }
+  else
+    {
+    remus::proto::send_NonBlockingResponse(service, data,
+                                           &clientChannel, clientIdentity,
+                                           requestId);
+    }
+}
+
+//------------------------------------------------------------------------------
+//The results and statuses of a worker message, decoded before the broker
+//state is locked. Text encoded results are copied while they are decoded,
+//so doing it up front means the lock is only held while they are stored
+struct DecodedWorkerMessage
+{
+  explicit DecodedWorkerMessage(const remus::proto::Message& msg)
+  {
+    if(!msg.isValid() || msg.dataSize() == 0)
+      {
+      return;
+      }
+    if(msg.serviceType() == remus::MESH_STATUS)
+      {
+      this->Status = remus::proto::to_JobStatus(msg.data(),msg.dataSize());
+      }
+    else if(msg.serviceType() == remus::RETRIEVE_RESULT)
+      {
+      //the result shares the message's storage so it is never copied
+      this->Result = remus::proto::to_JobResult(msg.data(),
+                                                msg.dataSize(),
+                                                msg.storage());
+      }
+  }
+
+  boost::optional<remus::proto::JobStatus> Status;
+  boost::optional<remus::proto::JobResult> Result;
+};
+
 //------------------------------------------------------------------------------
 struct UUIDManagement
 {
@@ -108,7 +196,11 @@ struct ThreadManagement
     BrokerThread( new boost::thread() ),
     BrokeringStatus(),
     BrokerStatusChanged(),
-    BrokerIsRunning(false)
+    BrokerIsRunning(false),
+    MessageBatchSize(64),
+    CheckInterval(250),
+    Threading(remus::server::Server::SINGLE_THREADED),
+    BrokerState()
   {
   }
 
@@ -190,6 +282,57 @@ struct ThreadManagement
   this->BrokerStatusChanged.notify_all();
   }
 
+  //----------------------------------------------------------------------------
+  std::size_t messageBatchSize()
+  {
+  boost::lock_guard<boost::mutex> lock(this->BrokeringStatus);
+  return this->MessageBatchSize;
+  }
+
+  //----------------------------------------------------------------------------
+  void setMessageBatchSize(std::size_t size)
+  {
+  boost::lock_guard<boost::mutex> lock(this->BrokeringStatus);
+  this->MessageBatchSize = (size > 0) ? size : 1;
+  }
+
+  //----------------------------------------------------------------------------
+  boost::int64_t checkInterval()
+  {
+  boost::lock_guard<boost::mutex> lock(this->BrokeringStatus);
+  return this->CheckInterval;
+  }
+
+  //----------------------------------------------------------------------------
+  void setCheckInterval(boost::int64_t millisec)
+  {
+  boost::lock_guard<boost::mutex> lock(this->BrokeringStatus);
+  this->CheckInterval = (millisec > 0) ? millisec : 1;
+  }
+
+  //----------------------------------------------------------------------------
+  remus::server::Server::BrokerThreading threading()
+  {
+  boost::lock_guard<boost::mutex> lock(this->BrokeringStatus);
+  return this->Threading;
+  }
+
+  //----------------------------------------------------------------------------
+  void setThreading(remus::server::Server::BrokerThreading mode)
+  {
+  boost::lock_guard<boost::mutex> lock(this->BrokeringStatus);
+  this->Threading = mode;
+  }
+
+  //----------------------------------------------------------------------------
+  //When brokering with multiple threads the job queue, worker pool,
+  //active jobs, socket monitor, event publisher and worker factory are
+  //shared between the threads. Any access to them must hold this mutex.
+  boost::mutex& brokerState()
+  {
+  return this->BrokerState;
+  }
+
 private:
   boost::scoped_ptr<boost::thread> BrokerThread;
 
@@ -197,6 +340,14 @@ private:
   boost::condition_variable BrokerStatusChanged;
   bool BrokerIsRunning;
 
+  //the batch size, check interval and threading mode are stored here as
+  //they are modified by the calling thread and read by the brokering thread
+  std::size_t MessageBatchSize;
+  boost::int64_t CheckInterval;
+  remus::server::Server::BrokerThreading Threading;
+
+  boost::mutex BrokerState;
+
 
 };
 
@@ -214,10 +365,15 @@ Server::Server():
   SocketMonitor( new remus::server::detail::SocketMonitor() ),
   WorkerPool( new remus::server::detail::WorkerPool() ),
   ActiveJobs( new remus::server::detail::ActiveJobs () ),
+  ClientFormats( new remus::server::detail::WireFormats() ),
+  WorkerFormats( new remus::server::detail::WireFormats() ),
+  Transfers( new remus::server::detail::Transfers() ),
   Publish( new remus::server::detail::EventPublisher() ),
   UUIDGenerator( new detail::UUIDManagement() ),
   Thread( new detail::ThreadManagement() ),
-  WorkerFactory( boost::make_shared<remus::server::WorkerFactory>() )
+  WorkerFactory( boost::make_shared<remus::server::WorkerFactory>() ),
+  ChangedRequirements(),
+  RescheduleAllRequirements(false)
 {
 }
 
@@ -228,10 +384,15 @@ Server::Server(const boost::shared_ptr<remus::server::WorkerFactoryBase>& factor
   SocketMonitor( new remus::server::detail::SocketMonitor() ),
   WorkerPool( new remus::server::detail::WorkerPool() ),
   ActiveJobs( new remus::server::detail::ActiveJobs () ),
+  ClientFormats( new remus::server::detail::WireFormats() ),
+  WorkerFormats( new remus::server::detail::WireFormats() ),
+  Transfers( new remus::server::detail::Transfers() ),
   Publish( new remus::server::detail::EventPublisher() ),
   UUIDGenerator( new detail::UUIDManagement() ),
   Thread( new detail::ThreadManagement() ),
-  WorkerFactory( factory )
+  WorkerFactory( factory ),
+  ChangedRequirements(),
+  RescheduleAllRequirements(false)
 {
 }
 
@@ -242,10 +403,15 @@ Server::Server(const remus::server::ServerPorts& ports):
   SocketMonitor( new remus::server::detail::SocketMonitor() ),
   WorkerPool( new remus::server::detail::WorkerPool() ),
   ActiveJobs( new remus::server::detail::ActiveJobs () ),
+  ClientFormats( new remus::server::detail::WireFormats() ),
+  WorkerFormats( new remus::server::detail::WireFormats() ),
+  Transfers( new remus::server::detail::Transfers() ),
   Publish( new remus::server::detail::EventPublisher() ),
   UUIDGenerator( new detail::UUIDManagement() ),
   Thread( new detail::ThreadManagement() ),
-  WorkerFactory( boost::make_shared<remus::server::WorkerFactory>() )
+  WorkerFactory( boost::make_shared<remus::server::WorkerFactory>() ),
+  ChangedRequirements(),
+  RescheduleAllRequirements(false)
 {
 }
 
@@ -257,10 +423,15 @@ Server::Server(const remus::server::ServerPorts& ports,
   SocketMonitor( new remus::server::detail::SocketMonitor() ),
   WorkerPool( new remus::server::detail::WorkerPool() ),
   ActiveJobs( new remus::server::detail::ActiveJobs () ),
+  ClientFormats( new remus::server::detail::WireFormats() ),
+  WorkerFormats( new remus::server::detail::WireFormats() ),
+  Transfers( new remus::server::detail::Transfers() ),
   Publish( new remus::server::detail::EventPublisher() ),
   UUIDGenerator( new detail::UUIDManagement() ),
   Thread( new detail::ThreadManagement() ),
-  WorkerFactory( factory )
+  WorkerFactory( factory ),
+  ChangedRequirements(),
+  RescheduleAllRequirements(false)
 {
 }
 
@@ -291,6 +462,71 @@ remus::server::PollingRates Server::pollingRates() const
   return remus::server::PollingRates(low,high);
 }
 
+//------------------------------------------------------------------------------
+void Server::messageBatchSize(std::size_t size)
+{
+  this->Thread->setMessageBatchSize(size);
+}
+
+//------------------------------------------------------------------------------
+std::size_t Server::messageBatchSize() const
+{
+  return this->Thread->messageBatchSize();
+}
+
+//------------------------------------------------------------------------------
+void Server::heartbeatCheckInterval(boost::int64_t millisec)
+{
+  this->Thread->setCheckInterval(millisec);
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t Server::heartbeatCheckInterval() const
+{
+  return this->Thread->checkInterval();
+}
+
+//------------------------------------------------------------------------------
+void Server::maxJobsPerWorker(std::size_t count)
+{
+  boost::lock_guard<boost::mutex> lock(this->Thread->brokerState());
+  const remus::proto::JobRequirementsSet nowWaiting =
+                              this->WorkerPool->maxJobsPerWorker(count);
+  this->ChangedRequirements.insert(nowWaiting.begin(), nowWaiting.end());
+}
+
+//------------------------------------------------------------------------------
+std::size_t Server::maxJobsPerWorker() const
+{
+  return this->WorkerPool->maxJobsPerWorker();
+}
+
+//------------------------------------------------------------------------------
+void Server::maxTransferSize(boost::uint64_t bytes)
+{
+  boost::lock_guard<boost::mutex> lock(this->Thread->brokerState());
+  this->Transfers->maxSize(bytes);
+}
+
+//------------------------------------------------------------------------------
+boost::uint64_t Server::maxTransferSize() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Thread->brokerState());
+  return this->Transfers->maxSize();
+}
+
+//------------------------------------------------------------------------------
+void Server::brokerThreading(Server::BrokerThreading mode)
+{
+  this->Thread->setThreading(mode);
+}
+
+//------------------------------------------------------------------------------
+Server::BrokerThreading Server::brokerThreading() const
+{
+  return this->Thread->threading();
+}
+
 //------------------------------------------------------------------------------
 bool Server::Brokering(Server::SignalHandling sh)
   {
@@ -318,6 +554,34 @@ bool Server::Brokering(Server::SignalHandling sh)
   //setup workers. This needs to happen after the binding of the worker socket
   this->WorkerFactory->portForWorkersToUse( this->PortInfo.worker() );
 
+  if(this->Thread->threading() == MULTI_THREADED)
+    {
+    this->ThreadedBrokering(clientChannel, workerChannel);
+    }
+  else
+    {
+    this->SingleThreadedBrokering(clientChannel, workerChannel);
+    }
+
+  this->Publish->stop();
+
+  //this should only happen with interrupted threads is hit; lets make sure we close
+  //down all workers.
+  this->WorkerFactory->setMaxWorkerCount(0);
+  this->TerminateAllWorkers( workerChannel );
+
+  if(sh == CAPTURE)
+    {
+    this->StopCatchingSignals();
+    }
+
+  return true;
+  }
+
+//------------------------------------------------------------------------------
+void Server::SingleThreadedBrokering(zmq::socket_t& clientChannel,
+                                     zmq::socket_t& workerChannel)
+  {
   //construct the pollitems to have client and workers so that we process
   //messages from both sockets.
   zmq::pollitem_t items[2] = {
@@ -329,14 +593,14 @@ bool Server::Brokering(Server::SignalHandling sh)
   remus::common::PollingMonitor monitor = this->SocketMonitor->pollingMonitor();
 
   //keep track of current time since we last purged dead workers
-  //we want to clear every dead workers every 250ms.
+  //we want to clear dead workers every heartbeat check interval.
   boost::posix_time::ptime currentTime =
                             boost::posix_time::microsec_clock::local_time();
 
-  const boost::int64_t workerCheckInterval(250);
   boost::posix_time::ptime whenToCheckForDeadOrCompletedWorkers =
                       boost::posix_time::microsec_clock::local_time() +
-                      boost::posix_time::milliseconds(workerCheckInterval);
+                      boost::posix_time::milliseconds(
+                                          this->Thread->checkInterval());
 
   //We need to notify the Thread management that brokering is about to start.
   //This allows the calling thread to resume, as it has been waiting for this
@@ -356,26 +620,55 @@ bool Server::Brokering(Server::SignalHandling sh)
     //update the current time
     currentTime = boost::posix_time::microsec_clock::local_time();
 
-    if (items[0].revents & ZMQ_POLLIN)
-      {
-      //we need to strip the client address from the message
-      zmq::SocketIdentity clientIdentity = zmq::address_recv(clientChannel);
-      this->DetermineClientResponse(clientChannel, clientIdentity, workerChannel);
-      }
-    if (items[1].revents & ZMQ_POLLIN)
+    //drain the client and worker channels without blocking, alternating
+    //between them so that a flood of messages on one channel can't starve
+    //the other. We stop once both are empty or we hit the batch budget,
+    //at which point we go back to polling.
+    bool clientHasMessages = (items[0].revents & ZMQ_POLLIN) != 0;
+    bool workerHasMessages = (items[1].revents & ZMQ_POLLIN) != 0;
+    const std::size_t batchSize = this->Thread->messageBatchSize();
+    for(std::size_t i=0;
+        i < batchSize && (clientHasMessages || workerHasMessages);
+        ++i)
       {
-      //a worker is registering
-      //we need to strip the worker address from the message
-      zmq::SocketIdentity workerIdentity = zmq::address_recv(workerChannel);
-      this->DetermineWorkerResponse(workerChannel,workerIdentity,worker_shutting_down  );
+      if (clientHasMessages)
+        {
+        //we need to strip the client address from the message
+        zmq::SocketIdentity clientIdentity;
+        clientHasMessages = zmq::address_recv_nonblocking(clientChannel,
+                                                          clientIdentity);
+        if (clientHasMessages)
+          {
+          this->DetermineClientResponse(clientChannel, clientIdentity, workerChannel);
+          }
+        }
+      if (workerHasMessages)
+        {
+        //a worker is registering
+        //we need to strip the worker address from the message
+        zmq::SocketIdentity workerIdentity;
+        workerHasMessages = zmq::address_recv_nonblocking(workerChannel,
+                                                          workerIdentity);
+        if (workerHasMessages)
+          {
+          this->DetermineWorkerResponse(workerChannel,workerIdentity,worker_shutting_down  );
+          }
+        }
       }
 
-    //only purge dead workers every 250ms or every time a worker shuts down
+    //workers can send many status updates for a job in a single batch,
+    //so we only publish the latest status of each job once it is done
+    this->Publish->publishPendingStatus();
+
+    //only purge dead workers every check interval or every time a worker
+    //shuts down
     if(whenToCheckForDeadOrCompletedWorkers <= currentTime || worker_shutting_down)
       {
       this->CheckForChangeInWorkersAndJobs();
+      this->TerminateIdleWorkers( workerChannel );
       whenToCheckForDeadOrCompletedWorkers = currentTime +
-                      boost::posix_time::milliseconds(workerCheckInterval);
+                      boost::posix_time::milliseconds(
+                                          this->Thread->checkInterval());
       }
 
     //see if we have a worker in the pool for the next job in the queue,
@@ -385,21 +678,253 @@ bool Server::Brokering(Server::SignalHandling sh)
       this->FindWorkerForQueuedJob( workerChannel );
       }
     }
+  }
 
-  this->Publish->stop();
+//------------------------------------------------------------------------------
+void Server::ThreadedBrokering(zmq::socket_t& clientChannel,
+                               zmq::socket_t& workerChannel)
+{
+  zmq::context_t& context = *(this->PortInfo.context());
+
+  //The client, worker and scheduler threads hand off work to each other
+  //using inproc sockets. Everything that needs to be sent to a worker is
+  //pushed onto the worker queue, which the worker thread forwards to the
+  //worker channel. Both the client and worker threads notify the scheduler
+  //when they have changed the state of jobs or workers.
+  //All job and worker state is still guarded by the single brokerState
+  //mutex, so the threads only overlap while receiving, decoding and
+  //sending messages; storing results and appending chunks is serialized.
+  const std::string channelId =
+                  boost::uuids::to_string((*this->UUIDGenerator)());
+  const std::string workerQueueEndpoint =
+                  "inproc://remus_server_worker_queue_" + channelId;
+  const std::string schedulerEndpoint =
+                  "inproc://remus_server_scheduler_" + channelId;
+
+  //inproc requires the endpoints to be bound before being connected too
+  zmq::socket_t workerQueue(context, ZMQ_PULL);
+  zmq::socket_t schedulerChannel(context, ZMQ_PULL);
+  zmq::set_socket_linger(workerQueue);
+  zmq::set_socket_linger(schedulerChannel);
+  workerQueue.bind(workerQueueEndpoint.c_str());
+  schedulerChannel.bind(schedulerEndpoint.c_str());
+
+  zmq::socket_t clientToWorkers(context, ZMQ_PUSH);
+  zmq::socket_t clientToScheduler(context, ZMQ_PUSH);
+  zmq::socket_t workerToScheduler(context, ZMQ_PUSH);
+  zmq::socket_t schedulerToWorkers(context, ZMQ_PUSH);
+  zmq::connectToAddress(clientToWorkers, workerQueueEndpoint);
+  zmq::connectToAddress(schedulerToWorkers, workerQueueEndpoint);
+  zmq::connectToAddress(clientToScheduler, schedulerEndpoint);
+  zmq::connectToAddress(workerToScheduler, schedulerEndpoint);
+
+  //We need to notify the Thread management that brokering is about to start
+  //before launching the client and worker threads, as they run only while
+  //we are brokering
+  Thread->setIsBrokering(true);
 
-  //this should only happen with interrupted threads is hit; lets make sure we close
-  //down all workers.
-  this->WorkerFactory->setMaxWorkerCount(0);
-  this->TerminateAllWorkers( workerChannel );
+  boost::thread clientThread(&Server::ClientBrokering, this,
+                             boost::ref(clientChannel),
+                             boost::ref(clientToWorkers),
+                             boost::ref(clientToScheduler));
+  boost::thread workerThread(&Server::WorkerBrokering, this,
+                             boost::ref(workerChannel),
+                             boost::ref(workerQueue),
+                             boost::ref(workerToScheduler));
 
-  if(sh == CAPTURE)
+  this->SchedulerBrokering(schedulerChannel, schedulerToWorkers);
+
+  clientThread.join();
+  workerThread.join();
+
+  //now that the worker thread has stopped, send along anything that was
+  //still queued for workers
+  while(zmq::forward_nonblocking(workerQueue, workerChannel)) {}
+}
+
+//------------------------------------------------------------------------------
+void Server::ClientBrokering(zmq::socket_t& clientChannel,
+                             zmq::socket_t& workerChannel,
+                             zmq::socket_t& schedulerChannel)
+{
+  zmq::pollitem_t items[1] = { { clientChannel, 0, ZMQ_POLLIN, 0 } };
+
+  //the client thread has its own polling monitor, as the one owned by
+  //the SocketMonitor is used by the scheduler
+  const remus::server::PollingRates rates = this->pollingRates();
+  remus::common::PollingMonitor monitor(rates.minRate(), rates.maxRate());
+
+  while (Thread->isBrokering())
     {
-    this->StopCatchingSignals();
+    zmq::poll_safely(&items[0], 1, monitor.current());
+    monitor.pollOccurred();
+
+    bool clientHasMessages = (items[0].revents & ZMQ_POLLIN) != 0;
+    const std::size_t batchSize = this->Thread->messageBatchSize();
+    std::size_t numProcessed = 0;
+    for(; numProcessed < batchSize && clientHasMessages; ++numProcessed)
+      {
+      //we need to strip the client address from the message
+      zmq::SocketIdentity clientIdentity;
+      clientHasMessages = zmq::address_recv_nonblocking(clientChannel,
+                                                        clientIdentity);
+      if(!clientHasMessages)
+        {
+        break;
+        }
+
+      //receive and respond outside the lock, so we only block the
+      //other threads while we are computing the response
+      remus::proto::Message msg = remus::proto::receive_Message(&clientChannel);
+      std::string responseData;
+      detail::EncodedResult encodedData;
+      remus::SERVICE_TYPE responseService;
+        {
+        boost::lock_guard<boost::mutex> lock(this->Thread->brokerState());
+        responseService = this->DetermineClientResponse(clientIdentity,
+                                                        msg,
+                                                        workerChannel,
+                                                        responseData,
+                                                        encodedData);
+        }
+      detail::send_ClientResponse(responseService, responseData, encodedData,
+                                  clientChannel, clientIdentity,
+                                  msg.requestId());
+      }
+
+    if(numProcessed > 0)
+      {
+      detail::notify_scheduler(schedulerChannel, false);
+      }
     }
+}
 
-  return true;
-  }
+//------------------------------------------------------------------------------
+void Server::WorkerBrokering(zmq::socket_t& workerChannel,
+                             zmq::socket_t& workerQueue,
+                             zmq::socket_t& schedulerChannel)
+{
+  zmq::pollitem_t items[2] = {
+      { workerChannel, 0, ZMQ_POLLIN, 0 },
+      { workerQueue, 0, ZMQ_POLLIN, 0 } };
+
+  //the worker thread has its own polling monitor, as the one owned by
+  //the SocketMonitor is used by the scheduler
+  const remus::server::PollingRates rates = this->pollingRates();
+  remus::common::PollingMonitor monitor(rates.minRate(), rates.maxRate());
+
+  while (Thread->isBrokering())
+    {
+    zmq::poll_safely(&items[0], 2, monitor.current());
+    monitor.pollOccurred();
+
+    bool workerHasMessages = (items[0].revents & ZMQ_POLLIN) != 0;
+    bool queueHasMessages = (items[1].revents & ZMQ_POLLIN) != 0;
+    bool workerTerminated = false;
+    bool processedWorkerMessage = false;
+    const std::size_t batchSize = this->Thread->messageBatchSize();
+    for(std::size_t i=0;
+        i < batchSize && (workerHasMessages || queueHasMessages);
+        ++i)
+      {
+      if (workerHasMessages)
+        {
+        zmq::SocketIdentity workerIdentity;
+        workerHasMessages = zmq::address_recv_nonblocking(workerChannel,
+                                                          workerIdentity);
+        if (workerHasMessages)
+          {
+          //receive and decode the message outside the lock, as results
+          //from workers can be very large
+          remus::proto::Message msg = remus::proto::receive_Message(&workerChannel);
+          const detail::DecodedWorkerMessage decoded(msg);
+          boost::lock_guard<boost::mutex> lock(this->Thread->brokerState());
+          this->DetermineWorkerResponse(workerChannel, workerIdentity, msg,
+                                        decoded, workerTerminated);
+          processedWorkerMessage = true;
+          }
+        }
+      if (queueHasMessages)
+        {
+        //forward jobs and terminate requests from the client and scheduler
+        //threads onto the workers
+        queueHasMessages = zmq::forward_nonblocking(workerQueue, workerChannel);
+        }
+      }
+
+    if(processedWorkerMessage)
+      {
+        {
+        //workers can send many status updates for a job in a single batch,
+        //so we only publish the latest status of each job once it is done
+        boost::lock_guard<boost::mutex> lock(this->Thread->brokerState());
+        this->Publish->publishPendingStatus();
+        }
+      detail::notify_scheduler(schedulerChannel, workerTerminated);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void Server::SchedulerBrokering(zmq::socket_t& schedulerChannel,
+                                zmq::socket_t& workerChannel)
+{
+  zmq::pollitem_t items[1] = { { schedulerChannel, 0, ZMQ_POLLIN, 0 } };
+
+  //keeps track of what our polling interval is, and adjusts it to
+  //handle operating systems that throttle our polling.
+  remus::common::PollingMonitor monitor = this->SocketMonitor->pollingMonitor();
+
+  boost::posix_time::ptime currentTime =
+                            boost::posix_time::microsec_clock::local_time();
+  boost::posix_time::ptime whenToCheckForDeadOrCompletedWorkers =
+                      currentTime +
+                      boost::posix_time::milliseconds(
+                                          this->Thread->checkInterval());
+
+  while (Thread->isBrokering())
+    {
+    //make sure we wake up in time to check for dead workers even
+    //when no notifications arrive
+    boost::int64_t timeout;
+      {
+      boost::lock_guard<boost::mutex> lock(this->Thread->brokerState());
+      timeout = std::min(monitor.current(), this->Thread->checkInterval());
+      }
+    zmq::poll_safely(&items[0], 1, timeout);
+
+    //drain all notifications, we only care if any worker has terminated
+    bool worker_shutting_down = false;
+    zmq::message_t note;
+    while(schedulerChannel.recv(&note, ZMQ_DONTWAIT))
+      {
+      if(note.size() > 0 && static_cast<char*>(note.data())[0] != 0)
+        {
+        worker_shutting_down = true;
+        }
+      }
+
+    boost::lock_guard<boost::mutex> lock(this->Thread->brokerState());
+    monitor.pollOccurred();
+    currentTime = boost::posix_time::microsec_clock::local_time();
+
+    //only purge dead workers every check interval or every time a worker
+    //shuts down
+    if(whenToCheckForDeadOrCompletedWorkers <= currentTime || worker_shutting_down)
+      {
+      this->CheckForChangeInWorkersAndJobs();
+      this->TerminateIdleWorkers( workerChannel );
+      whenToCheckForDeadOrCompletedWorkers = currentTime +
+                      boost::posix_time::milliseconds(
+                                          this->Thread->checkInterval());
+      }
+
+    if(Thread->isBrokering())
+      {
+      this->FindWorkerForQueuedJob( workerChannel );
+      }
+    }
+}
 
 //------------------------------------------------------------------------------
 bool Server::startBrokering(SignalHandling sh)
@@ -437,24 +962,45 @@ void Server::DetermineClientResponse(zmq::socket_t& clientChannel,
                                      zmq::socket_t& workerChannel)
 {
   remus::proto::Message msg = remus::proto::receive_Message(&clientChannel);
+
+  std::string response_data;
+  detail::EncodedResult encoded_data;
+  remus::SERVICE_TYPE response_service =
+    this->DetermineClientResponse(clientIdentity, msg, workerChannel,
+                                  response_data, encoded_data);
+
+  //now that we have the proper service_type and data send it in a non
+  //blocking manner so the server doesn't stall out sending to a client
+  //that has disconnected
+  detail::send_ClientResponse(response_service, response_data, encoded_data,
+                              clientChannel, clientIdentity, msg.requestId());
+  return;
+}
+
+//------------------------------------------------------------------------------
+remus::SERVICE_TYPE Server::DetermineClientResponse(
+                                      const zmq::SocketIdentity& clientIdentity,
+                                      const remus::proto::Message& msg,
+                                      zmq::socket_t& workerChannel,
+                                      std::string& response_data,
+                                      detail::EncodedResult& encoded_data)
+{
   //server response is the general response message type
   //the client can than convert it to the expected type
   if(!msg.isValid())
     {
     //send an invalid response.
-    remus::proto::send_NonBlockingResponse(remus::INVALID_SERVICE,
-                                           remus::INVALID_MSG,
-                                           &clientChannel,
-                                           clientIdentity);
-    return; //no need to continue
+    response_data = remus::INVALID_MSG;
+    return remus::INVALID_SERVICE; //no need to continue
     }
 
+  //the client is still around, so keep the format it negotiated
+  this->ClientFormats->seen(clientIdentity);
 
   //the service and data to return as a response. In case
   //of not being able to handle the given service types,
   //we will send back INVALID_SERVICE as the service type
   remus::SERVICE_TYPE response_service = msg.serviceType();
-  std::string response_data;
 
   //we have a valid job, determine what to do with it
   switch(msg.serviceType())
@@ -483,19 +1029,34 @@ void Server::DetermineClientResponse(zmq::socket_t& clientChannel,
     case remus::MAKE_MESH:
       //queues the proto::JobSubmission and returns
       //a proto::Job that can be used to track that job
-      response_data = this->queueJob(msg);
+      response_data = this->queueJob(clientIdentity, msg);
       break;
     case remus::MESH_STATUS:
       //retrieves the current status of the job related to the passed
       //proto::Job. Returns a proto::JobStatus
-      response_data = this->meshStatus(msg);
+      response_data = this->meshStatus(clientIdentity, msg);
       break;
     case remus::RETRIEVE_RESULT:
       //retrieves the current result of the job related to the passed
       //proto::Job. Returns a proto::JobResult. The result is than deleted
       //from the server.
       //If no result exists will return an invalid JobResult
-      response_data = this->retrieveResult(msg);
+      response_data = this->retrieveResult(clientIdentity, msg, encoded_data);
+      break;
+    case remus::MAKE_MESH_BATCH:
+      //queues every proto::JobSubmission of the batch and returns a
+      //batch of the proto::Jobs that track them, in the same order
+      response_data = this->queueJobs(clientIdentity, msg);
+      break;
+    case remus::MESH_STATUS_BATCH:
+      //returns a batch of the proto::JobStatus of every proto::Job
+      //of the batch, in the same order
+      response_data = this->meshStatuses(clientIdentity, msg);
+      break;
+    case remus::TERMINATE_JOB_BATCH:
+      //tries to terminate every proto::Job of the batch like TERMINATE_JOB,
+      //and returns a batch of their proto::JobStatus
+      response_data = this->terminateJobs(workerChannel,clientIdentity,msg);
       break;
     case remus::TERMINATE_JOB:
       //Will try to terminate the given proto::Job.
@@ -504,19 +1065,30 @@ void Server::DetermineClientResponse(zmq::socket_t& clientChannel,
       //terminate the job. As long as the job is in the workers task
       //queue the job will be removed. If the job is currently being processed
       //we can do nothing to stop it
-      response_data = this->terminateJob(workerChannel,msg);
+      response_data = this->terminateJob(workerChannel,clientIdentity,msg);
+      break;
+    case remus::WIRE_FORMAT:
+      //records the wire format the client wants proto objects to be
+      //sent with, and returns the format the server will use
+      response_data = this->wireFormat(clientIdentity,msg);
+      break;
+    case remus::TRANSFER_BEGIN:
+    case remus::TRANSFER_CHUNK:
+      //starts or adds a chunk to a large submission that the client is
+      //streaming to us. Returns a proto::Transfer stating how much of the
+      //submission we have, and how many chunks the client can send
+      response_data = this->transferData(clientIdentity,msg,0);
+      break;
+    case remus::TRANSFER_COMMIT:
+      //queues the submission the client has finished streaming to us
+      //and returns a proto::Job that can be used to track that job
+      response_data = this->queueTransferredJob(clientIdentity,msg);
       break;
     default:
       response_service = remus::INVALID_SERVICE;
       response_data = remus::INVALID_MSG;
     }
-
-  //now that we have the proper service_type and data send it in a non
-  //blocking manner so the server doesn't stall out sending to a client
-  //that has disconnected
-  remus::proto::send_NonBlockingResponse(response_service, response_data,
-                                         &clientChannel,   clientIdentity);
-  return;
+  return response_service;
 }
 
 //------------------------------------------------------------------------------
@@ -597,9 +1169,17 @@ std::string Server::meshRequirements(const remus::proto::Message& msg)
 }
 
 //------------------------------------------------------------------------------
-std::string Server::meshStatus(const remus::proto::Message& msg)
+std::string Server::meshStatus(const zmq::SocketIdentity& clientIdentity,
+                               const remus::proto::Message& msg)
 {
   remus::proto::Job job = remus::proto::to_Job(msg.data(),msg.dataSize());
+  return remus::proto::to_string(this->meshStatus(job),
+                                 this->ClientFormats->format(clientIdentity));
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus Server::meshStatus(const remus::proto::Job& job)
+{
   remus::proto::JobStatus js(job.id(),remus::INVALID_STATUS);
   if(this->QueuedJobs->haveUUID(job.id()))
     {
@@ -609,23 +1189,68 @@ std::string Server::meshStatus(const remus::proto::Message& msg)
     {
     js = this->ActiveJobs->status(job.id());
     }
-  return remus::proto::to_string(js);
+  return js;
+}
+
+//------------------------------------------------------------------------------
+std::string Server::meshStatuses(const zmq::SocketIdentity& clientIdentity,
+                                 const remus::proto::Message& msg)
+{
+  const std::vector<remus::proto::Job> jobs =
+                  remus::proto::to_JobVector(msg.data(),msg.dataSize());
+
+  std::vector<remus::proto::JobStatus> statuses;
+  statuses.reserve(jobs.size());
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    statuses.push_back( this->meshStatus(jobs[i]) );
+    }
+  return remus::proto::to_batch(statuses,
+                                this->ClientFormats->format(clientIdentity));
 }
 
 //------------------------------------------------------------------------------
-std::string Server::queueJob(const remus::proto::Message& msg)
+std::string Server::queueJob(const zmq::SocketIdentity& clientIdentity,
+                             const remus::proto::Message& msg)
+{
+  //create a new job to place on the queue. Clients that send the
+  //submission as a payload only send the requirements as the header, which
+  //is all we need to schedule the job. The payload is kept as the message
+  //we received and handed to the worker untouched.
+  remus::proto::JobSubmission submission;
+  boost::shared_ptr<zmq::message_t> payload;
+  if(msg.payloadSize() > 0)
+    {
+    submission = remus::proto::JobSubmission(
+          remus::proto::to_JobRequirements(msg.data(),msg.dataSize()));
+    payload = msg.payloadStorage();
+    }
+  else
+    {
+    //the submission shares the message's storage so large contents
+    //are never copied
+    submission = remus::proto::to_JobSubmission(msg.data(),msg.dataSize(),
+                                                msg.storage());
+    }
+
+  return this->queueJob(clientIdentity,submission,payload);
+}
+
+//------------------------------------------------------------------------------
+std::string Server::queueJob(const zmq::SocketIdentity& clientIdentity,
+                        const remus::proto::JobSubmission& submission,
+                        const boost::shared_ptr<zmq::message_t>& payload)
 {
   //generate an UUID
   const boost::uuids::uuid jobUUID = (*this->UUIDGenerator)();
 
-  //create a new job to place on the queue
-  const remus::proto::JobSubmission submission =
-                  remus::proto::to_JobSubmission(msg.data(),msg.dataSize());
-
-  this->QueuedJobs->addJob(jobUUID,submission);
+  //jobs are queued per client so that they are handed out to workers
+  //round robin between clients
+  this->QueuedJobs->addJob(jobUUID,submission,clientIdentity,payload);
+  this->ChangedRequirements.insert(submission.requirements());
 
 
-  const remus::proto::Job validJob(jobUUID,msg.MeshIOType());
+  const remus::proto::Job validJob(jobUUID,submission.type());
 
   //publish the job has been queued
   this->Publish->jobQueued(validJob, submission.requirements() );
@@ -635,29 +1260,138 @@ std::string Server::queueJob(const remus::proto::Message& msg)
 }
 
 //------------------------------------------------------------------------------
-std::string Server::retrieveResult(const remus::proto::Message& msg)
+std::string Server::queueJobs(const zmq::SocketIdentity& clientIdentity,
+                              const remus::proto::Message& msg)
+{
+  std::vector<remus::proto::BatchItem> items;
+  if(!remus::proto::to_BatchItems(msg.data(),msg.dataSize(),items))
+    {
+    return remus::INVALID_MSG;
+    }
+
+  //binary submissions are forwarded to the worker as the client encoded
+  //them, so we only decode their requirements. The payloads share the
+  //message, so the contents of the batch are never copied
+  std::vector<std::string> jobs;
+  jobs.reserve(items.size());
+  for(std::size_t i=0; i < items.size(); ++i)
+    {
+    const char* data = items[i].first;
+    const std::size_t size = items[i].second;
+    const remus::proto::JobSubmission submission =
+          remus::proto::to_JobSubmission(data,size,msg.storage());
+    if(remus::proto::detect_WireFormat(data,size) ==
+                                          remus::proto::WireFormat::Binary)
+      {
+      jobs.push_back( this->queueJob(clientIdentity,
+                  remus::proto::JobSubmission(submission.requirements()),
+                  zmq::make_shared_message(data,size,msg.storage())) );
+      }
+    else
+      {
+      jobs.push_back( this->queueJob(clientIdentity,submission,
+                                 boost::shared_ptr<zmq::message_t>()) );
+      }
+    }
+  return remus::proto::to_batch(jobs);
+}
+
+//------------------------------------------------------------------------------
+std::string Server::queueTransferredJob(
+                                    const zmq::SocketIdentity& clientIdentity,
+                                    const remus::proto::Message& msg)
+{
+  const remus::proto::Transfer transfer =
+                  remus::proto::to_Transfer(msg.data(),msg.dataSize());
+  boost::shared_ptr<std::string> data;
+  if(!this->Transfers->commit(transfer,data))
+    {
+    return remus::INVALID_MSG;
+    }
+
+  //the transfer is the binary encoded submission. We only need the
+  //requirements to schedule the job, and the assembled buffer becomes
+  //the payload that is forwarded to the worker, so that the streamed
+  //contents are never copied again
+  const remus::proto::JobSubmission submission =
+        remus::proto::to_JobSubmission(data->data(),data->size(),data);
+  const boost::shared_ptr<zmq::message_t> payload =
+        zmq::make_shared_message(data->data(),data->size(),data);
+  return this->queueJob(clientIdentity,
+                    remus::proto::JobSubmission(submission.requirements()),
+                    payload);
+}
+
+//------------------------------------------------------------------------------
+std::string Server::retrieveResult(const zmq::SocketIdentity& clientIdentity,
+                                   const remus::proto::Message& msg,
+                                   detail::EncodedResult& encodedResult)
 {
   //go to the active jobs list and grab the mesh result if it exists
   remus::proto::Job job = remus::proto::to_Job(msg.data(),msg.dataSize());
+  const remus::proto::WireFormat::Type format =
+                                this->ClientFormats->format(clientIdentity);
 
   remus::proto::JobResult result(job.id());
   if( this->ActiveJobs->haveUUID(job.id()) &&
       this->ActiveJobs->haveResult(job.id()))
     {
     result = this->ActiveJobs->result(job.id());
+
+    //when the client uses the same wire format as the worker, we send the
+    //message the worker gave us instead of encoding the result again
+    const detail::EncodedResult& encoded =
+                                this->ActiveJobs->encodedResult(job.id());
+    const bool sendAsIs = !encoded.empty() && encoded.Format == format;
+    if(sendAsIs)
+      {
+      encodedResult = encoded;
+      }
+
     //for now we remove all references from this job being active
     this->ActiveJobs->remove(job.id());
+
+    if(sendAsIs)
+      {
+      return std::string();
+      }
     }
   //return an empty result
-  return remus::proto::to_string(result);
+  return remus::proto::to_string(result,format);
 }
 
 //------------------------------------------------------------------------------
 std::string Server::terminateJob(zmq::socket_t& workerChannel,
+                                 const zmq::SocketIdentity& clientIdentity,
                                  const remus::proto::Message& msg)
 {
   remus::proto::Job job = remus::proto::to_Job(msg.data(),msg.dataSize());
+  return remus::proto::to_string(this->terminateJob(workerChannel,job),
+                                 this->ClientFormats->format(clientIdentity));
+}
+
+//------------------------------------------------------------------------------
+std::string Server::terminateJobs(zmq::socket_t& workerChannel,
+                                  const zmq::SocketIdentity& clientIdentity,
+                                  const remus::proto::Message& msg)
+{
+  const std::vector<remus::proto::Job> jobs =
+                  remus::proto::to_JobVector(msg.data(),msg.dataSize());
+
+  std::vector<remus::proto::JobStatus> statuses;
+  statuses.reserve(jobs.size());
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    statuses.push_back( this->terminateJob(workerChannel,jobs[i]) );
+    }
+  return remus::proto::to_batch(statuses,
+                                this->ClientFormats->format(clientIdentity));
+}
 
+//------------------------------------------------------------------------------
+remus::proto::JobStatus Server::terminateJob(zmq::socket_t& workerChannel,
+                                             const remus::proto::Job& job)
+{
   const bool currentlyInQueue = this->QueuedJobs->haveUUID(job.id());
   const bool currentlyActive = this->ActiveJobs->haveUUID(job.id());
   const bool eligableForTermination = currentlyInQueue || currentlyActive;
@@ -666,8 +1400,7 @@ std::string Server::terminateJob(zmq::socket_t& workerChannel,
     {
     //state that the job can't be terminated since it is not active
     //or queued ( either an invalid job id or job is completed )
-    remus::proto::JobStatus jstatus(job.id(),remus::INVALID_STATUS);
-    return remus::proto::to_string(jstatus);
+    return remus::proto::JobStatus(job.id(),remus::INVALID_STATUS);
     }
 
   remus::proto::JobStatus jstatus(job.id(),remus::FAILED);
@@ -689,13 +1422,42 @@ std::string Server::terminateJob(zmq::socket_t& workerChannel,
     const remus::proto::JobStatus lastStatus = this->ActiveJobs->status(job.id());
 
     detail::send_terminateJob(job.id(), workerChannel, worker);
+    this->releaseWorkerJob(job.id());
 
     //publish that this terminate call was sent to to the worker, and
     //what was the last status we had for the job
     this->Publish->jobTerminated(lastStatus, worker);
     }
 
-  return remus::proto::to_string(jstatus);
+  return jstatus;
+}
+
+//------------------------------------------------------------------------------
+std::string Server::wireFormat(const zmq::SocketIdentity& clientIdentity,
+                               const remus::proto::Message& msg)
+{
+  const remus::proto::WireFormat::Type requested =
+                remus::proto::to_WireFormat(msg.data(),msg.dataSize());
+  return remus::proto::to_string(
+                this->ClientFormats->negotiate(clientIdentity,requested));
+}
+
+//------------------------------------------------------------------------------
+std::string Server::transferData(const zmq::SocketIdentity& senderIdentity,
+                                 const remus::proto::Message& msg,
+                                 std::size_t headroom)
+{
+  const remus::proto::Transfer transfer =
+                  remus::proto::to_Transfer(msg.data(),msg.dataSize());
+
+  //the chunk's bytes are the payload of the message, and are copied once
+  //into the buffer of the transfer
+  const remus::proto::Transfer reply =
+    (msg.serviceType() == remus::TRANSFER_BEGIN) ?
+        this->Transfers->begin(senderIdentity,transfer,headroom) :
+        this->Transfers->append(transfer,msg.payload(),msg.payloadSize());
+  return reply.valid() ? remus::proto::to_binary(reply)
+                       : remus::INVALID_MSG;
 }
 
 //------------------------------------------------------------------------------
@@ -704,6 +1466,24 @@ void Server::DetermineWorkerResponse(zmq::socket_t& workerChannel,
                                      bool& workerTerminated )
 {
   remus::proto::Message msg = remus::proto::receive_Message(&workerChannel);
+  this->DetermineWorkerResponse(workerChannel, workerIdentity, msg,
+                                detail::DecodedWorkerMessage(msg),
+                                workerTerminated);
+}
+
+//------------------------------------------------------------------------------
+void Server::DetermineWorkerResponse(zmq::socket_t& workerChannel,
+                                     const zmq::SocketIdentity &senderIdentity,
+                                     const remus::proto::Message& msg,
+                                     const detail::DecodedWorkerMessage& decoded,
+                                     bool& workerTerminated )
+{
+  //heartbeats and status can arrive on the control lane of a worker, which
+  //is its own connection so that they aren't stuck behind a large result.
+  //They are about the worker that owns the control lane
+  const zmq::SocketIdentity workerIdentity =
+                                      zmq::to_OwningIdentity(senderIdentity);
+
   //if we have an invalid message just ignore it
   if(!msg.isValid())
     {
@@ -739,18 +1519,19 @@ void Server::DetermineWorkerResponse(zmq::socket_t& workerChannel,
       const remus::proto::JobRequirements reqs =
             remus::proto::to_JobRequirements(msg.data(),msg.dataSize());
       this->WorkerPool->readyForWork(workerIdentity,reqs);
+      this->ChangedRequirements.insert(reqs);
       this->Publish->workerReady(workerIdentity, reqs);
       }
       break;
     case remus::MESH_STATUS:
       //store the mesh status msg which is a proto::JobStatus
       //no response needed
-      this->storeMeshStatus(workerIdentity, msg);
+      this->storeMeshStatus(workerIdentity, *decoded.Status);
       break;
     case remus::RETRIEVE_RESULT:
       //we need to store the mesh result, no response needed
       //store mesh does it's own notification
-      this->storeMesh(workerIdentity, msg);
+      this->storeMesh(workerIdentity, *decoded.Result, msg);
       {
       //now that we have stored the mesh we can tell the worker
       //we have the results, which allows it to shutdown.
@@ -775,6 +1556,39 @@ void Server::DetermineWorkerResponse(zmq::socket_t& workerChannel,
       this->Publish->workerHeartbeat(workerIdentity);
       }
       break;
+    case remus::WIRE_FORMAT:
+      //record the wire format the worker wants jobs to be sent with, and
+      //tell the worker what format the server will accept from it
+      {
+      const remus::proto::WireFormat::Type format =
+        this->WorkerFormats->negotiate(workerIdentity,
+                  remus::proto::to_WireFormat(msg.data(),msg.dataSize()));
+      remus::proto::send_NonBlockingResponse(remus::WIRE_FORMAT,
+                                             remus::proto::to_string(format),
+                                             &workerChannel,
+                                             workerIdentity);
+      }
+      break;
+    case remus::TRANSFER_BEGIN:
+    case remus::TRANSFER_CHUNK:
+      //starts or adds a chunk to a large result that the worker is
+      //streaming to us. We reserve room in front of the data for the
+      //encoding of the result, which is written once the worker commits
+      remus::proto::send_NonBlockingResponse(msg.serviceType(),
+          this->transferData(workerIdentity, msg,
+                             detail::result_headroom()),
+          &workerChannel,
+          workerIdentity);
+      break;
+    case remus::TRANSFER_COMMIT:
+      //store the result the worker has finished streaming to us. Like
+      //RETRIEVE_RESULT the worker waits for us to have the result
+      //before it can shutdown
+      remus::proto::send_NonBlockingResponse(remus::TRANSFER_COMMIT,
+                                this->storeTransferredMesh(workerIdentity,msg),
+                                &workerChannel,
+                                workerIdentity);
+      break;
     case remus::TERMINATE_WORKER:
       //we have found out the worker is dead, dead since it has told
       //us itself that it is shutting down. We don't need to do anything
@@ -799,42 +1613,124 @@ void Server::DetermineWorkerResponse(zmq::socket_t& workerChannel,
 
 //------------------------------------------------------------------------------
 void Server::storeMeshStatus(const zmq::SocketIdentity &workerIdentity,
-                             const remus::proto::Message& msg)
+                             const remus::proto::JobStatus& js)
 {
-  //the string in the data is actually a job status object
-  remus::proto::JobStatus js = remus::proto::to_JobStatus(msg.data(),
-                                                          msg.dataSize());
   this->ActiveJobs->updateStatus(js);
+  if(js.failed())
+    {
+    this->releaseWorkerJob(js.id());
+    }
 
   this->Publish->jobStatus(js, workerIdentity);
 }
 
 //------------------------------------------------------------------------------
 void Server::storeMesh(const zmq::SocketIdentity &workerIdentity,
+                       const remus::proto::JobResult& jr,
                        const remus::proto::Message& msg)
 {
-  remus::proto::JobResult jr = remus::proto::to_JobResult(msg.data(),
-                                                            msg.dataSize());
-  this->ActiveJobs->updateResult(jr);
+  //we keep the message the result was decoded from so we can hand it to
+  //the client as is
+  this->ActiveJobs->updateResult(jr,
+        detail::EncodedResult(msg.data(), msg.dataSize(), msg.storage()));
+  this->releaseWorkerJob(jr.id());
 
   this->Publish->jobFinished(jr, workerIdentity);
 }
 
+//------------------------------------------------------------------------------
+std::string Server::storeTransferredMesh(
+                                    const zmq::SocketIdentity &workerIdentity,
+                                    const remus::proto::Message& msg)
+{
+  const remus::proto::Transfer transfer =
+                  remus::proto::to_Transfer(msg.data(),msg.dataSize());
+  boost::shared_ptr<std::string> data;
+  if(!this->Transfers->commit(transfer,data))
+    {
+    return remus::INVALID_MSG;
+    }
+
+  //the worker sends the result without any data as the payload of the
+  //commit. Writing its encoding into the room we reserved in front of the
+  //streamed data turns the buffer into a binary encoded result, which we
+  //decode in place and hand to the client as is
+  const remus::proto::JobResult header =
+        remus::proto::to_JobResult(msg.payload(),msg.payloadSize());
+  const std::string prefix = remus::proto::to_binaryPrefix(header,
+                                data->size() - detail::result_headroom());
+  std::copy(prefix.begin(), prefix.end(), data->begin());
+
+  remus::proto::JobResult jr =
+        remus::proto::to_JobResult(data->data(),data->size(),data);
+  this->ActiveJobs->updateResult(jr,
+        detail::EncodedResult(data->data(), data->size(), data));
+  this->releaseWorkerJob(jr.id());
+
+  this->Publish->jobFinished(jr, workerIdentity);
+  return remus::proto::to_binary(transfer);
+}
+
+//------------------------------------------------------------------------------
+void Server::releaseWorkerJob(const boost::uuids::uuid& id)
+{
+  //a worker that was holding as many jobs as it is allowed to can
+  //take the jobs that it is waiting for again
+  const remus::proto::JobRequirementsSet nowWaiting =
+                                        this->WorkerPool->releaseJob(id);
+  this->ChangedRequirements.insert(nowWaiting.begin(), nowWaiting.end());
+}
+
 //------------------------------------------------------------------------------
 void Server::assignJobToWorker(zmq::socket_t& workerChannel,
                                const zmq::SocketIdentity &workerIdentity,
-                               const remus::worker::Job& job )
+                               const remus::worker::Job& job,
+                               const boost::shared_ptr<zmq::message_t>& payload)
 {
   this->ActiveJobs->add( workerIdentity, job.id() );
+  this->WorkerPool->holdJob( workerIdentity, job.id() );
+
+  const remus::proto::WireFormat::Type format =
+                              this->WorkerFormats->format(workerIdentity);
+
+  //jobs queued with a payload only hold the requirements. Workers using
+  //the binary format decode the rest of the submission from the payload,
+  //which we forward untouched. Other workers need the whole submission
+  boost::shared_ptr<zmq::message_t> forwardedPayload;
+  std::string encodedJob;
+  if(payload && format == remus::proto::WireFormat::Binary)
+    {
+    forwardedPayload = payload;
+    encodedJob = remus::proto::to_string(job,format);
+    }
+  else if(payload)
+    {
+    const remus::worker::Job fullJob(job.id(),
+          remus::proto::to_JobSubmission(
+                            static_cast<const char*>(payload->data()),
+                            payload->size(),
+                            payload));
+    encodedJob = remus::proto::to_string(fullJob,format);
+    }
+  else
+    {
+    encodedJob = remus::proto::to_string(job,format);
+    }
 
   remus::proto::Response response =
         remus::proto::send_NonBlockingResponse(remus::MAKE_MESH,
-                                               remus::worker::to_string(job),
+                                               encodedJob,
+                                               forwardedPayload,
                                                &workerChannel,
                                                workerIdentity);
   if(response.isValid())
-    { //consider sending the job to be refreshing the worker
-    this->SocketMonitor->refresh(workerIdentity);
+    { //consider sending the job to be refreshing the worker, unless it
+      //has already stopped responding. Refreshing it then would hide that
+      //from the next check, which is what expires the job
+    if(!this->SocketMonitor->isUnresponsive(workerIdentity))
+      {
+      this->SocketMonitor->refresh(workerIdentity);
+      }
 
     //we should encode the worker id as part of the string
     std::string wi(workerIdentity.data(), workerIdentity.size());
@@ -858,40 +1754,57 @@ void Server::FindWorkerForQueuedJob(zmq::socket_t& workerChannel)
     {
     //we have no jobs waiting for work so no need to do
     //all the heavy queries below
+    this->ChangedRequirements = remus::proto::JobRequirementsSet();
+    this->RescheduleAllRequirements = false;
+    return;
+    }
+
+  if(!this->RescheduleAllRequirements &&
+     this->ChangedRequirements.size() == 0)
+    {
+    //nothing has changed since the last time we matched jobs to workers,
+    //so we can't match anything new
     return;
     }
 
+  //grab the requirements that have changed, and reset the tracking so that
+  //changes made while we are matching are seen the next time around
+  const bool rescheduleAll = this->RescheduleAllRequirements;
+  const remus::proto::JobRequirementsSet changed = this->ChangedRequirements;
+  this->ChangedRequirements = remus::proto::JobRequirementsSet();
+  this->RescheduleAllRequirements = false;
+
   typedef remus::proto::JobRequirementsSet::const_iterator it;
   remus::proto::JobRequirementsSet waiting_types;
   remus::proto::JobRequirementsSet queued_types;
 
-  //find all the jobs that have been marked as waiting for a worker
-  //and ask if we have a worker in the poll that can mesh that job
+  //find all the jobs that have been marked as waiting for a worker or just
+  //queued, and give them to workers in the pool that can mesh them. We
+  //only need to look at requirements whose jobs or waiting workers have
+  //changed, and we keep matching until we run out of jobs or workers
   waiting_types = this->QueuedJobs->waitingJobRequirements();
+  queued_types = this->QueuedJobs->queuedJobRequirements();
+  waiting_types.insert(queued_types.begin(), queued_types.end());
+  bool assignedJob = false;
   for(it type = waiting_types.begin(); type != waiting_types.end(); ++type)
     {
-    if(this->WorkerPool->haveWaitingWorker(*type))
+    if(!rescheduleAll && changed.count(*type) == 0)
       {
-      //give this job to that worker
-      this->assignJobToWorker(workerChannel,
-                              this->WorkerPool->takeWorker(*type),
-                              this->QueuedJobs->takeJob(*type));
+      continue;
       }
-    }
-
-
-  //find all jobs that queued up and check if we can assign it to an item in
-  //the worker pool
-  queued_types = this->QueuedJobs->queuedJobRequirements();
-  bool assignedJob = false;
-  for(it type = queued_types.begin(); type != queued_types.end(); ++type)
-    {
-    if(this->WorkerPool->haveWaitingWorker(*type))
+    while(this->WorkerPool->haveWaitingWorker(*type))
       {
+      boost::shared_ptr<zmq::message_t> payload;
+      remus::worker::Job job = this->QueuedJobs->takeJob(*type, payload);
+      if(!job.valid())
+        {
+        break;
+        }
       //give this job to that worker
       this->assignJobToWorker(workerChannel,
                               this->WorkerPool->takeWorker(*type),
-                              this->QueuedJobs->takeJob(*type));
+                              job,
+                              payload);
       assignedJob = true;
       }
     }
@@ -910,39 +1823,161 @@ void Server::FindWorkerForQueuedJob(zmq::socket_t& workerChannel)
     //We are not going to assign the job to the worker now, instead we will
     //move the job to the waiting queue, and give it to the worker once
     //it has registered with us through the worker port.
+    //The factory decides how many workers to launch from how many jobs of
+    //each type are queued, and how long the oldest of them has waited.
+    const boost::int64_t now = detail::TimerWheel::now();
     for(it type = queued_types.begin(); type != queued_types.end(); ++type)
       {
-      if(this->WorkerFactory->createWorker(*type,
-                           WorkerFactoryBase::KillOnFactoryDeletion))
+      if(!rescheduleAll && changed.count(*type) == 0)
+        {
+        continue;
+        }
+      const unsigned int toLaunch = this->WorkerFactory->workersToLaunch(*type,
+                        this->QueuedJobs->numJobsJustQueued(*type),
+                        this->QueuedJobs->oldestQueuedJobWait(*type, now));
+      for(unsigned int i=0; i < toLaunch; ++i)
         {
+        if(!this->WorkerFactory->createWorker(*type,
+                             WorkerFactoryBase::KillOnFactoryDeletion))
+          {
+          break;
+          }
         this->QueuedJobs->workerDispatched(*type);
         }
       }
     }
 }
 
+//------------------------------------------------------------------------------
+void Server::FailJobsOfFailedWorkers()
+{
+  const std::vector<remus::server::WorkerFailure> failures =
+                                  this->WorkerFactory->takeWorkerFailures();
+  if(failures.empty())
+    {
+    return;
+    }
+
+  //the workers that could belong to a failed process are the ones with
+  //jobs and the ones waiting for jobs
+  std::set<zmq::SocketIdentity> workers = this->ActiveJobs->activeWorkers();
+  const std::set<zmq::SocketIdentity> pooled = this->WorkerPool->allWorkers();
+  workers.insert(pooled.begin(), pooled.end());
+
+  typedef std::vector<remus::server::WorkerFailure>::const_iterator FailureIt;
+  typedef std::set<zmq::SocketIdentity>::const_iterator WorkerIt;
+  typedef std::vector< remus::proto::JobStatus >::const_iterator StatusIt;
+  for(FailureIt f = failures.begin(); f != failures.end(); ++f)
+    {
+    for(WorkerIt w = workers.begin(); w != workers.end(); ++w)
+      {
+      if(!zmq::is_LaunchedWorker(*w, f->LaunchId))
+        {
+        continue;
+        }
+
+      const std::vector< remus::proto::JobStatus > failedJobs =
+                            this->ActiveJobs->markFailedJobs(*w, f->Reason);
+      for(StatusIt s = failedJobs.begin(); s != failedJobs.end(); ++s)
+        {
+        this->releaseWorkerJob(s->id());
+        this->Publish->jobStatus(*s, *w);
+        }
+      this->WorkerPool->removeWorker(*w);
+      }
+    }
+}
+
 //------------------------------------------------------------------------------
 void Server::CheckForChangeInWorkersAndJobs()
 {
+  //find the workers that have missed a heartbeat, come back, or been
+  //marked as dead since we last checked
+  detail::SocketChanges changedWorkers = this->SocketMonitor->checkHeartbeats();
+
   //mark all jobs whose worker haven't sent a heartbeat in time
   //as a job that failed. We are returned the set of job's that are
   //expired
   std::vector< remus::proto::JobStatus > expiredJobs =
-              this->ActiveJobs->markExpiredJobs((*this->SocketMonitor));
+              this->ActiveJobs->markExpiredJobs(changedWorkers,
+                                                *this->SocketMonitor);
 
   //publish the jobs that have failed
   this->Publish->jobsExpired( expiredJobs );
+  typedef std::vector< remus::proto::JobStatus >::const_iterator StatusIt;
+  for(StatusIt i = expiredJobs.begin(); i != expiredJobs.end(); ++i)
+    {
+    this->releaseWorkerJob(i->id());
+    }
 
   //purge all pending workers that have been explicitly terminated
   //with a TERMINATE service call. No need to publish this
   //as we do that when the service call comes in. This also updates
-  //the responsive state of all workers.
-  // detail::ChangedWorkers updatedWorkers =
-          this->WorkerPool->purgeDeadWorkers((*this->SocketMonitor));
+  //the responsive state of all workers. Workers that are responsive again
+  //can take the jobs that they are waiting for.
+  remus::proto::JobRequirementsSet nowWaiting =
+          this->WorkerPool->purgeDeadWorkers(changedWorkers);
+  this->ChangedRequirements.insert(nowWaiting.begin(), nowWaiting.end());
+
+  //dead workers won't be sent anything again
+  typedef std::vector<zmq::SocketIdentity>::const_iterator SocketIt;
+  for(SocketIt i = changedWorkers.Dead.begin();
+      i != changedWorkers.Dead.end(); ++i)
+    {
+    this->WorkerFormats->remove(*i);
+    this->Transfers->remove(*i);
+    }
+
+  //drop the transfers of clients and workers that have gone quiet, and
+  //the formats of clients that have gone away
+  const boost::int64_t now = detail::TimerWheel::now();
+  this->Transfers->removeIdle(now);
+  this->ClientFormats->removeIdle(now);
 
   //Resync the worker factory with the updated status of workers. If we have
   //purged dead workers, the factory itself needs to become aware of this!
   this->WorkerFactory->updateWorkerCount();
+  this->FailJobsOfFailedWorkers();
+
+  //jobs waiting for a worker the factory launched are queued again once
+  //no launched worker is left to take them, such as when a resident worker
+  //has exited after handling as many jobs as it can, or a worker failed
+  //to start
+  if(this->QueuedJobs->numJobsWaitingForWorkers() > 0)
+    {
+    typedef remus::proto::JobRequirementsSet::const_iterator ReqIt;
+    const remus::proto::JobRequirementsSet waiting =
+                              this->QueuedJobs->waitingJobRequirements();
+    for(ReqIt i = waiting.begin(); i != waiting.end(); ++i)
+      {
+      if(!this->WorkerFactory->haveLaunchedWorker(*i) &&
+         this->QueuedJobs->requeueWaitingJobs(*i) > 0)
+        {
+        this->ChangedRequirements.insert(*i);
+        }
+      }
+    }
+
+  //top up the workers the factory keeps idle ahead of demand, counting
+  //the workers that have registered with us
+  const remus::proto::JobRequirementsSet prewarmed =
+                              this->WorkerFactory->prewarmedRequirements();
+  typedef remus::proto::JobRequirementsSet::const_iterator PrewarmIt;
+  for(PrewarmIt i = prewarmed.begin(); i != prewarmed.end(); ++i)
+    {
+    this->WorkerFactory->prewarmWorkers(*i,
+        static_cast<unsigned int>(this->WorkerPool->waitingWorkerCount(*i)),
+        static_cast<unsigned int>(this->WorkerPool->busyWorkerCount(*i)));
+    }
+
+  //if the factory has room for more workers, every queued job is again a
+  //candidate for a new worker, since the factory could have freed up space
+  //or had its max worker count changed
+  if(this->QueuedJobs->numJobsJustQueued() > 0 &&
+     this->WorkerFactory->currentWorkerCount() < this->WorkerFactory->maxWorkerCount())
+    {
+    this->RescheduleAllRequirements = true;
+    }
 
   // for( worker : updatedWorkers.workers())
   //   {
@@ -971,6 +2006,50 @@ void Server::CheckForChangeInWorkersAndJobs()
   //  3. Alive
 }
 
+//------------------------------------------------------------------------------
+void Server::TerminateIdleWorkers(zmq::socket_t& workerChannel)
+{
+  const boost::int64_t timeout = this->WorkerFactory->idleWorkerTimeout();
+  if(timeout < 0)
+    {
+    return;
+    }
+
+  //find the requirements that have workers waiting for a job
+  remus::proto::JobRequirementsSet waiting;
+  const remus::common::MeshIOTypeSet types =
+                                      this->WorkerPool->supportedIOTypes();
+  typedef remus::common::MeshIOTypeSet::const_iterator TypeIt;
+  for(TypeIt i = types.begin(); i != types.end(); ++i)
+    {
+    const remus::proto::JobRequirementsSet reqs =
+                            this->WorkerPool->waitingWorkerRequirements(*i);
+    waiting.insert(reqs.begin(), reqs.end());
+    }
+
+  //tell the workers that have been idle the longest to terminate, keeping
+  //the workers the factory wants kept idle ahead of demand. The workers are
+  //removed from the pool right away so they aren't given another job, and
+  //tell us themselves once they have shutdown
+  const boost::int64_t now = detail::TimerWheel::now();
+  typedef remus::proto::JobRequirementsSet::const_iterator ReqIt;
+  for(ReqIt i = waiting.begin(); i != waiting.end(); ++i)
+    {
+    const std::vector<zmq::SocketIdentity> idle =
+                            this->WorkerPool->idleWorkers(*i, timeout, now);
+    const std::size_t numWaiting = this->WorkerPool->waitingWorkerCount(*i);
+    const std::size_t keep = this->WorkerFactory->minIdleWorkers(*i);
+    const std::size_t numToTerminate = (numWaiting > keep) ?
+                      std::min(idle.size(), numWaiting - keep) : 0;
+    for(std::size_t j=0; j < numToTerminate; ++j)
+      {
+      detail::send_terminateWorker((*this->UUIDGenerator)(), workerChannel,
+                                   idle[j]);
+      this->WorkerPool->removeWorker(idle[j]);
+      }
+    }
+}
+
 //We are crashing we need to terminate all workers
 //------------------------------------------------------------------------------
 void Server::signalCaught( SignalCatcher::SignalType )
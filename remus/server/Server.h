@@ -14,6 +14,7 @@
 #define remus_server_Server_h
 
 #include <remus/common/CompilerInformation.h>
+#include <remus/common/ServiceTypes.h>
 #include <remus/common/SignalCatcher.h>
 
 REMUS_THIRDPARTY_PRE_INCLUDE
@@ -30,11 +31,15 @@ REMUS_THIRDPARTY_POST_INCLUDE
 
 
 //forward declaration of classes only the implementation needs
-namespace zmq { struct SocketIdentity; }
+namespace zmq { struct SocketIdentity; class message_t; }
 
 namespace remus {
   //forward declaration of classes only the implementation needs
   namespace proto {
+  class Job;
+  class JobResult;
+  class JobStatus;
+  class JobSubmission;
   class Message;
   }
 
@@ -51,9 +56,14 @@ namespace server{
     class ActiveJobs;
     class JobQueue;
     class SocketMonitor;
+    class Transfers;
+    class WireFormats;
     class WorkerPool;
     class EventPublisher;
 
+    struct DecodedWorkerMessage;
+    struct EncodedResult;
+
     struct ThreadManagement;
     struct UUIDManagement;
     }
@@ -88,6 +98,7 @@ class REMUSSERVER_EXPORT Server : public remus::common::SignalCatcher
 public:
   friend struct remus::server::detail::ThreadManagement;
   enum SignalHandling {NONE, CAPTURE};
+  enum BrokerThreading {SINGLE_THREADED, MULTI_THREADED};
   //construct a new server with the default worker factory and server ports.
   Server();
 
@@ -116,6 +127,59 @@ public:
   void pollingRates( const remus::server::PollingRates& rates );
   remus::server::PollingRates pollingRates() const;
 
+  //Modify the maximum number of messages the server will read from each
+  //of the client and worker channels every time polling wakes up. The server
+  //drains both channels until they are empty or this budget is used up,
+  //and only then schedules queued jobs onto workers. Larger values increase
+  //throughput under heavy load, smaller values reduce the latency of
+  //scheduling and the amount of time a single busy channel can hold the
+  //server.
+  //
+  //Note: A batch size of zero is treated as one
+  void messageBatchSize( std::size_t size );
+  std::size_t messageBatchSize() const;
+
+  //Modify how often the server checks for workers that have missed their
+  //heartbeat, expires the jobs of those workers, and resyncs the worker
+  //factory. Shorter intervals detect dead workers sooner, longer intervals
+  //reduce the amount of time the server spends checking.
+  //
+  //Note: All intervals are in milliseconds, and the default is 250
+  //Note: A non positive interval is treated as one millisecond
+  void heartbeatCheckInterval( boost::int64_t millisec );
+  boost::int64_t heartbeatCheckInterval() const;
+
+  //Modify the most jobs a single worker can hold at once. A worker holds
+  //every job it has been sent until the job finishes, fails, is terminated
+  //or expires. Workers that prefetch jobs ask for more jobs than they are
+  //processing, and the limit keeps a single worker from taking every
+  //queued job while other workers are busy. Queued jobs always go to the
+  //waiting worker that holds the fewest jobs.
+  //
+  //Note: The default of zero doesn't limit the jobs a worker can hold
+  void maxJobsPerWorker( std::size_t count );
+  std::size_t maxJobsPerWorker() const;
+
+  //Modify the largest result or submission in bytes that clients and
+  //workers can stream to the server in chunks. Streams that declare a
+  //larger size, or grow past it, are rejected.
+  //
+  //Note: The default is 4GB
+  void maxTransferSize( boost::uint64_t bytes );
+  boost::uint64_t maxTransferSize() const;
+
+  //Control if the server brokers all requests from a single thread, or
+  //uses a separate thread for client requests, worker requests, and the
+  //scheduling of jobs onto workers. The multi threaded broker allows
+  //client queries to be answered while the server is receiving large
+  //results from workers.
+  //
+  //Note: The threading mode is only read when brokering starts, so changes
+  //made while the server is brokering take effect the next time brokering
+  //is started.
+  void brokerThreading( BrokerThreading mode );
+  BrokerThreading brokerThreading() const;
+
   //when you call start brokering the server will actually start accepting
   //worker and client requests.
   //IMPORTANT:
@@ -177,34 +241,108 @@ protected:
   //The main brokering loop, called by thread
   virtual bool Brokering(SignalHandling sh = CAPTURE);
 
+  //The brokering loop used when the server is brokering from a single
+  //thread
+  void SingleThreadedBrokering(zmq::socket_t& clientChannel,
+                               zmq::socket_t& workerChannel);
+
+  //The brokering loops used when the server is brokering with multiple
+  //threads. ThreadedBrokering sets up the inproc channels that the
+  //client, worker, and scheduler loops use to hand off work, launches
+  //the client and worker threads, and runs the scheduler on the
+  //calling thread.
+  void ThreadedBrokering(zmq::socket_t& clientChannel,
+                         zmq::socket_t& workerChannel);
+  void ClientBrokering(zmq::socket_t& clientChannel,
+                       zmq::socket_t& workerChannel,
+                       zmq::socket_t& schedulerChannel);
+  void WorkerBrokering(zmq::socket_t& workerChannel,
+                       zmq::socket_t& workerQueue,
+                       zmq::socket_t& schedulerChannel);
+  void SchedulerBrokering(zmq::socket_t& schedulerChannel,
+                          zmq::socket_t& workerChannel);
+
   //processes all client queries
   void DetermineClientResponse(zmq::socket_t& clientChannel,
                                const zmq::SocketIdentity &clientIdentity,
                                zmq::socket_t& WorkerChannel);
 
+  //processes a client query that has already been received, returning
+  //the service type and filling in the data to send back to the client.
+  //When the response is a stored result that can be sent as is, the
+  //encoded result is filled in instead of the response data.
+  remus::SERVICE_TYPE DetermineClientResponse(const zmq::SocketIdentity &clientIdentity,
+                                              const remus::proto::Message& msg,
+                                              zmq::socket_t& WorkerChannel,
+                                              std::string& responseData,
+                                              detail::EncodedResult& encodedData);
+
   //These methods are all to do with sending responses to clients
   std::string allSupportedMeshIOTypes(const remus::proto::Message& msg);
   std::string canMesh(const remus::proto::Message& msg);
   std::string canMeshRequirements(const remus::proto::Message& msg);
   std::string meshRequirements(const remus::proto::Message& msg);
-  std::string meshStatus(const remus::proto::Message& msg);
-  std::string queueJob(const remus::proto::Message& msg);
-  std::string retrieveResult(const remus::proto::Message& msg);
-  std::string terminateJob(zmq::socket_t& WorkerChannel,const remus::proto::Message& msg);
+  std::string meshStatus(const zmq::SocketIdentity &clientIdentity,
+                         const remus::proto::Message& msg);
+  std::string meshStatuses(const zmq::SocketIdentity &clientIdentity,
+                           const remus::proto::Message& msg);
+  remus::proto::JobStatus meshStatus(const remus::proto::Job& job);
+  std::string queueJob(const zmq::SocketIdentity &clientIdentity,
+                       const remus::proto::Message& msg);
+  std::string queueJobs(const zmq::SocketIdentity &clientIdentity,
+                        const remus::proto::Message& msg);
+  std::string queueJob(const zmq::SocketIdentity &clientIdentity,
+                       const remus::proto::JobSubmission& submission,
+                       const boost::shared_ptr<zmq::message_t>& payload);
+  std::string queueTransferredJob(const zmq::SocketIdentity &clientIdentity,
+                                  const remus::proto::Message& msg);
+  std::string retrieveResult(const zmq::SocketIdentity &clientIdentity,
+                             const remus::proto::Message& msg,
+                             detail::EncodedResult& encodedResult);
+  std::string terminateJob(zmq::socket_t& WorkerChannel,
+                           const zmq::SocketIdentity &clientIdentity,
+                           const remus::proto::Message& msg);
+  std::string terminateJobs(zmq::socket_t& WorkerChannel,
+                            const zmq::SocketIdentity &clientIdentity,
+                            const remus::proto::Message& msg);
+  remus::proto::JobStatus terminateJob(zmq::socket_t& WorkerChannel,
+                                       const remus::proto::Job& job);
+  std::string wireFormat(const zmq::SocketIdentity &clientIdentity,
+                         const remus::proto::Message& msg);
+
+  //start, resume or add a chunk to a transfer from a client or worker,
+  //returning the reply to send back
+  std::string transferData(const zmq::SocketIdentity &senderIdentity,
+                           const remus::proto::Message& msg,
+                           std::size_t headroom);
 
   //Methods for processing Worker queries
   void DetermineWorkerResponse(zmq::socket_t& clientChannel,
                                const zmq::SocketIdentity &workerIdentity,
                                bool& workerTerminated);
 
+  //processes a worker message that has already been received and decoded
+  void DetermineWorkerResponse(zmq::socket_t& workerChannel,
+                               const zmq::SocketIdentity &workerIdentity,
+                               const remus::proto::Message& msg,
+                               const detail::DecodedWorkerMessage& decoded,
+                               bool& workerTerminated);
+
   //These methods are all to do with sending/recving to workers
   void storeMeshStatus(const zmq::SocketIdentity &workerIdentity,
-                       const remus::proto::Message& msg);
+                       const remus::proto::JobStatus& status);
   void storeMesh(const zmq::SocketIdentity &workerIdentity,
+                 const remus::proto::JobResult& result,
                  const remus::proto::Message& msg);
+  std::string storeTransferredMesh(const zmq::SocketIdentity &workerIdentity,
+                                   const remus::proto::Message& msg);
+  //mark that the worker holding a job has finished with it, so that it
+  //can be given another job
+  void releaseWorkerJob(const boost::uuids::uuid& id);
   void assignJobToWorker(zmq::socket_t& workerChannel,
                          const zmq::SocketIdentity &workerIdentity,
-                         const remus::worker::Job& job);
+                         const remus::worker::Job& job,
+                         const boost::shared_ptr<zmq::message_t>& payload);
 
   //see if we have a worker in the pool for the next job in the queue,
   //otherwise ask the factory to generate a new worker to handle that job
@@ -220,6 +358,14 @@ protected:
   //for changes, and lastly publish this all through our event publisher
   void CheckForChangeInWorkersAndJobs();
 
+  //fail the jobs of the workers whose process the worker factory has
+  //found to have failed, and stop sending those workers jobs
+  void FailJobsOfFailedWorkers();
+
+  //terminate the workers that have gone without a job for longer than the
+  //idle worker timeout of the worker factory
+  void TerminateIdleWorkers(zmq::socket_t& workerChannel);
+
   //terminate all workers that are doing jobs or waiting for jobs
   void TerminateAllWorkers(zmq::socket_t& workerChannel);
 
@@ -234,6 +380,9 @@ private:
   boost::scoped_ptr<remus::server::detail::SocketMonitor> SocketMonitor;
   boost::scoped_ptr<remus::server::detail::WorkerPool> WorkerPool;
   boost::scoped_ptr<remus::server::detail::ActiveJobs> ActiveJobs;
+  boost::scoped_ptr<remus::server::detail::WireFormats> ClientFormats;
+  boost::scoped_ptr<remus::server::detail::WireFormats> WorkerFormats;
+  boost::scoped_ptr<remus::server::detail::Transfers> Transfers;
 
   boost::scoped_ptr<remus::server::detail::EventPublisher> Publish;
 
@@ -243,6 +392,13 @@ private:
 protected:
   //needs to be a shared_ptr since we can be passed in a WorkerFactoryBase
   boost::shared_ptr<remus::server::WorkerFactoryBase> WorkerFactory;
+
+  //the requirements whose queued jobs or waiting workers have changed since
+  //FindWorkerForQueuedJob last matched jobs to workers. When
+  //RescheduleAllRequirements is set every queued requirement is considered,
+  //which happens when the worker factory has room for new workers.
+  remus::proto::JobRequirementsSet ChangedRequirements;
+  bool RescheduleAllRequirements;
 };
 
 }
@@ -15,13 +15,18 @@
 #include <remus/common/CompilerInformation.h>
 #include <remus/common/ExecuteProcess.h>
 #include <remus/common/MeshIOType.h>
+#include <remus/proto/zmqSocketIdentity.h>
 #include <remus/server/FactoryFileParser.h>
+#include <remus/server/detail/ProcessLauncher.h>
 #include <remus/server/detail/WorkerFinder.h>
+#include <remus/server/detail/uuidHelper.h>
+#include <remus/worker/ResidentLimits.h>
 
 //force to use filesystem version 3
 REMUS_THIRDPARTY_PRE_INCLUDE
 #define BOOST_FILESYSTEM_VERSION 3
 #include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/make_shared.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
@@ -33,9 +38,51 @@ namespace
   //typedefs required
   typedef remus::common::ExecuteProcess ExecuteProcess;
   typedef boost::shared_ptr<ExecuteProcess> ExecuteProcessPtr;
-  typedef std::pair<ExecuteProcessPtr,
-                    remus::server::WorkerFactoryBase::FactoryDeletionBehavior>
-              RunningProcessInfo;
+
+  //----------------------------------------------------------------------------
+  //a process the factory has launched. The process of a resident worker
+  //counts as a worker for every job it can still handle, which are the jobs
+  //it is launched for and dispatched to it after it has been launched.
+  //Processes launched ahead of demand aren't launched for a job
+  struct RunningProcessInfo
+  {
+    RunningProcessInfo(const ExecuteProcessPtr& process,
+                       const boost::shared_future<void>& launched,
+                       const std::string& launchId,
+                       remus::server::WorkerFactoryBase::FactoryDeletionBehavior lifespan,
+                       const remus::server::FactoryWorkerSpecification& spec):
+      Process(process),
+      Launched(launched),
+      LaunchId(launchId),
+      Lifespan(lifespan),
+      Requirements(spec.Requirements),
+      MaxJobs(spec.MaxJobsPerProcess),
+      IsResident(spec.isResident()),
+      JobsDispatched(1)
+      {
+      }
+
+    bool canTakeJob() const
+      {
+      return this->IsResident &&
+             (this->MaxJobs == 0 || this->JobsDispatched < this->MaxJobs);
+      }
+
+    //is the process still being launched by a helper thread
+    bool isLaunching() const
+      {
+      return !this->Launched.is_ready();
+      }
+
+    ExecuteProcessPtr Process;
+    boost::shared_future<void> Launched;
+    std::string LaunchId;
+    remus::server::WorkerFactoryBase::FactoryDeletionBehavior Lifespan;
+    remus::proto::JobRequirements Requirements;
+    std::size_t MaxJobs;
+    bool IsResident;
+    std::size_t JobsDispatched;
+  };
 
   typedef std::vector<remus::server::FactoryWorkerSpecification>::const_iterator WorkerIterator;
   typedef std::vector< RunningProcessInfo >::iterator ProcessIterator;
@@ -69,10 +116,39 @@ namespace
   {
     bool operator()(const RunningProcessInfo& process) const
       {
-      return !process.first->isAlive();
+      return !process.isLaunching() && !process.Process->isAlive();
       }
   };
 
+  //----------------------------------------------------------------------------
+  struct is_running
+  {
+    bool operator()(const RunningProcessInfo& process) const
+      {
+      return !is_dead()(process);
+      }
+  };
+
+  //----------------------------------------------------------------------------
+  //a dead process failed when it didn't exit by itself with a zero exit
+  //code, for example when it returned an error, crashed or was killed for
+  //going over its memory limit
+  remus::server::WorkerFailure make_failure(const RunningProcessInfo& process)
+  {
+    std::string reason = "worker process ended abnormally";
+    const int exitCode = process.Process->exitCode();
+    if(process.Process->exceededMemoryLimit())
+      {
+      reason = "worker process was killed for exceeding its memory limit";
+      }
+    else if(exitCode > 0)
+      {
+      reason = "worker process exited with code " +
+               boost::lexical_cast<std::string>(exitCode);
+      }
+    return remus::server::WorkerFailure(process.LaunchId, reason);
+  }
+
   //----------------------------------------------------------------------------
   struct kill_on_deletion
   {
@@ -80,15 +156,46 @@ namespace
       {
       is_dead isDead;
       const bool shouldBeTerminated =
-        (process.second == remus::server::WorkerFactoryBase::KillOnFactoryDeletion);
+        (process.Lifespan == remus::server::WorkerFactoryBase::KillOnFactoryDeletion);
       const bool is_alive = !isDead(process);
       if(shouldBeTerminated && is_alive)
         {
-        process.first->kill();
+        process.Process->kill();
         }
       }
   };
 
+  //----------------------------------------------------------------------------
+  struct launched_for
+  {
+    const remus::proto::JobRequirements& Requirements;
+    launched_for(const remus::proto::JobRequirements& reqs):
+      Requirements(reqs)
+    {}
+    bool operator()(const RunningProcessInfo& process) const
+      {
+      return process.Requirements == this->Requirements;
+      }
+  };
+
+  //----------------------------------------------------------------------------
+  struct can_take_job
+  {
+    const remus::proto::JobRequirements& Requirements;
+    remus::server::WorkerFactoryBase::FactoryDeletionBehavior Lifespan;
+    can_take_job(const remus::proto::JobRequirements& reqs,
+                 remus::server::WorkerFactoryBase::FactoryDeletionBehavior lifespan):
+      Requirements(reqs),
+      Lifespan(lifespan)
+    {}
+    bool operator()(const RunningProcessInfo& process) const
+      {
+      return process.Lifespan == this->Lifespan &&
+             process.Requirements == this->Requirements &&
+             process.canTakeJob();
+      }
+  };
+
   //----------------------------------------------------------------------------
   struct ValidWorker
   {
@@ -163,7 +270,9 @@ struct WorkerFactory::WorkerTracker
 {
   WorkerTracker():
     PossibleWorkers(),
-    CurrentProcesses()
+    CurrentProcesses(),
+    Launcher(4),
+    Failures()
     {
 
     }
@@ -174,7 +283,10 @@ struct WorkerFactory::WorkerTracker
 
   std::vector< remus::server::FactoryWorkerSpecification > PossibleWorkers;
   std::vector< RunningProcessInfo > CurrentProcesses;
+  remus::server::detail::ProcessLauncher Launcher;
 
+  //processes that failed since the last call to takeWorkerFailures
+  std::vector< remus::server::WorkerFailure > Failures;
 };
 
 //----------------------------------------------------------------------------
@@ -227,6 +339,9 @@ WorkerFactory::WorkerFactory(const std::string& ext,
 //----------------------------------------------------------------------------
 WorkerFactory::~WorkerFactory()
 {
+  //processes that are still starting can only be killed once they started
+  this->Tracker->Launcher.waitForLaunches();
+
   //kill any worker whose FactoryDeletionBehavior is KillOnFactoryDeletion
   //the kill_on_deletion functor will call terminate
   std::for_each(this->Tracker->CurrentProcesses.begin(),
@@ -280,7 +395,23 @@ bool WorkerFactory::createWorker(const remus::proto::JobRequirements& reqs,
   if(w.valid)
     {
     this->updateWorkerCount(); //remove dead workers
-    if(this->currentWorkerCount() < this->maxWorkerCount())
+
+    //a resident worker that can handle another job will take the job once
+    //it asks for one, so we don't need to launch another process
+    if(w.spec.isResident())
+      {
+      ProcessIterator process =
+        std::find_if(this->Tracker->CurrentProcesses.begin(),
+                     this->Tracker->CurrentProcesses.end(),
+                     can_take_job(w.spec.Requirements, lifespan));
+      if(process != this->Tracker->CurrentProcesses.end())
+        {
+        ++process->JobsDispatched;
+        return true;
+        }
+      }
+
+    if(this->haveRoomForWorker(reqs))
       {
       return this->addWorker(w.spec, lifespan);
       }
@@ -291,12 +422,30 @@ bool WorkerFactory::createWorker(const remus::proto::JobRequirements& reqs,
 //----------------------------------------------------------------------------
 void WorkerFactory::updateWorkerCount()
 {
-  //foreach current worker remove any that return they are not alive
-  this->Tracker->CurrentProcesses.erase(
-      std::remove_if(this->Tracker->CurrentProcesses.begin(),
-                     this->Tracker->CurrentProcesses.end(),
-                     is_dead()),
-      this->Tracker->CurrentProcesses.end());
+  //foreach current worker remove any that return they are not alive,
+  //remembering the ones that didn't exit by themselves. Unlike remove_if
+  //partitioning keeps the dead processes around so we can look at them
+  ProcessIterator dead =
+      std::stable_partition(this->Tracker->CurrentProcesses.begin(),
+                            this->Tracker->CurrentProcesses.end(),
+                            is_running());
+  for(ProcessIterator i = dead; i != this->Tracker->CurrentProcesses.end(); ++i)
+    {
+    if(!i->Process->exitedNormally())
+      {
+      this->Tracker->Failures.push_back( make_failure(*i) );
+      }
+    }
+  this->Tracker->CurrentProcesses.erase(dead,
+                                        this->Tracker->CurrentProcesses.end());
+}
+
+//----------------------------------------------------------------------------
+std::vector<WorkerFailure> WorkerFactory::takeWorkerFailures()
+{
+  std::vector<WorkerFailure> failures;
+  failures.swap(this->Tracker->Failures);
+  return failures;
 }
 
 //----------------------------------------------------------------------------
@@ -305,6 +454,106 @@ unsigned int WorkerFactory::currentWorkerCount() const
   return static_cast<unsigned int>(this->Tracker->CurrentProcesses.size());
 }
 
+//----------------------------------------------------------------------------
+unsigned int WorkerFactory::minIdleWorkers(
+                            const remus::proto::JobRequirements& reqs) const
+{
+  if(this->hasMinIdleWorkers(reqs))
+    {
+    return this->WorkerFactoryBase::minIdleWorkers(reqs);
+    }
+  const ValidWorker w = find_worker_path(reqs, this->Tracker->PossibleWorkers);
+  return w.valid ? w.spec.MinIdleWorkers : 0;
+}
+
+//----------------------------------------------------------------------------
+remus::proto::JobRequirementsSet WorkerFactory::prewarmedRequirements() const
+{
+  //requirements set on the factory, or in the worker files, that still
+  //have a minimum once the factory has overridden the worker files
+  remus::proto::JobRequirementsSet candidates =
+                          this->WorkerFactoryBase::prewarmedRequirements();
+  for(WorkerIterator i = this->Tracker->PossibleWorkers.begin();
+      i != this->Tracker->PossibleWorkers.end(); ++i)
+    {
+    if(i->MinIdleWorkers > 0) { candidates.insert(i->Requirements); }
+    }
+
+  remus::proto::JobRequirementsSet prewarmed;
+  typedef remus::proto::JobRequirementsSet::const_iterator ReqIt;
+  for(ReqIt i = candidates.begin(); i != candidates.end(); ++i)
+    {
+    if(this->minIdleWorkers(*i) > 0 && this->haveSupport(*i))
+      { prewarmed.insert(*i); }
+    }
+  return prewarmed;
+}
+
+//----------------------------------------------------------------------------
+unsigned int WorkerFactory::prewarmWorkers(
+                                const remus::proto::JobRequirements& reqs,
+                                unsigned int idleWorkers,
+                                unsigned int busyWorkers)
+{
+  const unsigned int minIdle = this->minIdleWorkers(reqs);
+  const ValidWorker w = find_worker_path(reqs, this->Tracker->PossibleWorkers);
+  if(minIdle == 0 || !w.valid)
+    {
+    return 0;
+    }
+
+  this->updateWorkerCount(); //remove dead workers
+
+  //the processes we launched that aren't busy are idle or still starting,
+  //but the server can also have idle workers we didn't launch
+  const unsigned int launched = this->launchedWorkerCount(reqs);
+  const unsigned int available = std::max(idleWorkers,
+                      (launched > busyWorkers) ? launched - busyWorkers : 0u);
+
+  unsigned int count = 0;
+  while(available + count < minIdle &&
+        this->haveRoomForWorker(reqs) &&
+        this->addWorker(w.spec, WorkerFactoryBase::KillOnFactoryDeletion))
+    {
+    //no job has been dispatched to the worker
+    this->Tracker->CurrentProcesses.back().JobsDispatched = 0;
+    ++count;
+    }
+  return count;
+}
+
+//----------------------------------------------------------------------------
+void WorkerFactory::setMaxParallelLaunches(unsigned int count)
+{
+  this->Tracker->Launcher.setMaxThreads(count);
+}
+
+//----------------------------------------------------------------------------
+unsigned int WorkerFactory::maxParallelLaunches() const
+{
+  return static_cast<unsigned int>(this->Tracker->Launcher.maxThreads());
+}
+
+//----------------------------------------------------------------------------
+unsigned int WorkerFactory::launchedWorkerCount(
+                            const remus::proto::JobRequirements& reqs) const
+{
+  return static_cast<unsigned int>(
+      std::count_if(this->Tracker->CurrentProcesses.begin(),
+                    this->Tracker->CurrentProcesses.end(),
+                    launched_for(reqs)));
+}
+
+//----------------------------------------------------------------------------
+bool WorkerFactory::haveLaunchedWorker(
+                            const remus::proto::JobRequirements& reqs) const
+{
+  return std::find_if(this->Tracker->CurrentProcesses.begin(),
+                      this->Tracker->CurrentProcesses.end(),
+                      launched_for(reqs)) !=
+         this->Tracker->CurrentProcesses.end();
+}
+
 //----------------------------------------------------------------------------
 bool WorkerFactory::addWorker(
   const FactoryWorkerSpecification& spec,
@@ -326,18 +575,38 @@ bool WorkerFactory::addWorker(
   arguments.insert( arguments.end(), cmlArgs.begin(), cmlArgs.end() );
   arguments.insert( arguments.end(), spec.ExtraCommandLineArguments.begin(), spec.ExtraCommandLineArguments.end() );
 
+  //resident workers are told their limits through the environment
+  std::map< std::string, std::string > environment = spec.EnvironmentVariables;
+  if(spec.isResident())
+    {
+    typedef remus::worker::ResidentLimits ResidentLimits;
+    environment[ResidentLimits::maxJobsVariable()] =
+          boost::lexical_cast<std::string>(spec.MaxJobsPerProcess);
+    environment[ResidentLimits::idleTimeoutVariable()] =
+          boost::lexical_cast<std::string>(spec.IdleTimeout);
+    }
+
+  //the workers of the process register with identities that start with the
+  //launch id, so that we can find their jobs if the process fails
+  boost::uuids::random_generator generator;
+  const std::string launchId = remus::to_string(generator());
+  environment[zmq::launchIdVariable()] = launchId;
+
   ExecuteProcessPtr ep(
     boost::make_shared<ExecuteProcess>(
-      spec.ExecutionPath.string(), arguments, spec.EnvironmentVariables
+      spec.ExecutionPath.string(), arguments, environment
       )
     );
+  ep->setLimits(spec.Limits);
 
   //launch all process in attached mode, that way we can determine if
   //they are still alive or not. Once a process goes to detached mode
-  //it is impossible to determine if it is still running or not
-  ep->execute( );
+  //it is impossible to determine if it is still running or not.
+  //The process is started by a helper thread of the launcher, so we
+  //don't wait for it to start
+  boost::shared_future<void> launched = this->Tracker->Launcher.launch(ep);
 
-  RunningProcessInfo p_info(ep,lifespan);
+  RunningProcessInfo p_info(ep,launched,launchId,lifespan,spec);
 
   this->Tracker->CurrentProcesses.push_back(p_info);
   return true;
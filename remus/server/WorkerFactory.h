@@ -30,6 +30,11 @@ struct FactoryWorkerSpecification;
 //First it locates all files that match a given extension of the default extension
 //of .rw. These files are than parsed to determine what type of local Remus workers
 //we can launch.
+//
+//Worker processes are launched by helper threads, so that asking for a
+//worker never waits for its process to start, and many workers can be
+//starting at once. A worker whose process is still starting counts as
+//a running worker.
 class REMUSSERVER_EXPORT WorkerFactory : public WorkerFactoryBase
 {
 public:
@@ -66,7 +71,11 @@ public:
 
   //request the factory to construct a worker given a requirements and a lifespan
   //can return false if the factory doesn't support these requirements, or
-  //if the factory already has too many workers in existence already.
+  //if the factory already has too many workers in existence already, either
+  //in total or with the given requirements.
+  //Resident workers, whose worker file sets MaxJobsPerProcess, are launched
+  //once for as many jobs as a process can handle. While a running process
+  //can handle more jobs no other process is launched for them.
   virtual bool createWorker(const remus::proto::JobRequirements& type,
                             WorkerFactoryBase::FactoryDeletionBehavior lifespan);
 
@@ -74,11 +83,49 @@ public:
   //shutdown
   virtual void updateWorkerCount();
 
+  //return the processes found by updateWorkerCount to have died without
+  //exiting by themselves since the last call, such as those killed for
+  //going over the memory limit of their worker file
+  virtual std::vector<WorkerFailure> takeWorkerFailures();
+
   virtual unsigned int currentWorkerCount() const;
 
+  //return the number of running processes launched for the given
+  //requirements, as of the last call to updateWorkerCount
+  virtual unsigned int launchedWorkerCount(
+                          const remus::proto::JobRequirements& reqs) const;
+
+  //return if a process that was launched for the given requirements is
+  //still running, as of the last call to updateWorkerCount
+  virtual bool haveLaunchedWorker(
+                          const remus::proto::JobRequirements& reqs) const;
+
+  //the number of workers kept idle or starting ahead of demand, which is
+  //the MinIdleWorkers of the worker file unless it has been set with
+  //setMinIdleWorkers
+  virtual unsigned int minIdleWorkers(
+                        const remus::proto::JobRequirements& reqs) const;
+
+  //return all the requirements that have workers kept idle ahead of demand
+  virtual remus::proto::JobRequirementsSet prewarmedRequirements() const;
+
+  //launch workers until minIdleWorkers are idle or starting. Every process
+  //launched for the requirements that isn't busy with a job is taken to be
+  //idle or starting, as are the idle workers registered with the server.
+  //Never launches more workers than the max worker counts allow
+  virtual unsigned int prewarmWorkers(const remus::proto::JobRequirements& reqs,
+                                      unsigned int idleWorkers,
+                                      unsigned int busyWorkers);
+
   //return the worker file extension we have
   std::string workerExtension() const { return this->WorkerExtension;  }
 
+  //set the number of helper threads that launch worker processes at once,
+  //which defaults to 4. A count of 0 launches each process on the thread
+  //that asks for the worker, waiting for the process to start
+  void setMaxParallelLaunches(unsigned int count);
+  unsigned int maxParallelLaunches() const;
+
 private:
   //this method only handles constructing the worker
   //it is expected that all checks to make sure that the worker type
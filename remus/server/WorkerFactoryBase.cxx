@@ -14,6 +14,7 @@
 
 #include <remus/server/ServerPorts.h>
 
+#include <algorithm>
 
 namespace remus{
 namespace server{
@@ -22,6 +23,10 @@ namespace server{
 WorkerFactoryBase::WorkerFactoryBase():
   MaxWorkers(1),
   WorkerEndpoint(),
+  MinIdleWorkers(),
+  MaxWorkersPerRequirements(),
+  TargetQueueWait(-1),
+  IdleWorkerTimeout(-1),
   GlobalCommandLineArguments()
 {
 
@@ -39,6 +44,96 @@ void WorkerFactoryBase::portForWorkersToUse(const remus::server::PortConnection&
   this->WorkerEndpoint = port.endpoint();
 }
 
+//----------------------------------------------------------------------------
+unsigned int WorkerFactoryBase::maxWorkerCount(
+                          const remus::proto::JobRequirements& reqs) const
+{
+  typedef std::map<remus::proto::JobRequirements,
+                   unsigned int>::const_iterator MaxIt;
+  MaxIt i = this->MaxWorkersPerRequirements.find(reqs);
+  return (i != this->MaxWorkersPerRequirements.end()) ?
+          std::min(i->second, this->MaxWorkers) : this->MaxWorkers;
+}
+
+//----------------------------------------------------------------------------
+bool WorkerFactoryBase::haveRoomForWorker(
+                          const remus::proto::JobRequirements& reqs) const
+{
+  return this->currentWorkerCount() < this->maxWorkerCount() &&
+         this->launchedWorkerCount(reqs) < this->maxWorkerCount(reqs);
+}
+
+//----------------------------------------------------------------------------
+unsigned int WorkerFactoryBase::workersToLaunch(
+                                const remus::proto::JobRequirements& reqs,
+                                std::size_t queuedJobs,
+                                boost::int64_t oldestJobWait) const
+{
+  const unsigned int launched = this->launchedWorkerCount(reqs);
+  const unsigned int current = this->currentWorkerCount();
+  if(queuedJobs == 0 ||
+     launched >= this->maxWorkerCount(reqs) ||
+     current >= this->maxWorkerCount())
+    {
+    return 0;
+    }
+
+  //a job that has waited longer than the target needs more workers than
+  //the one we launch each time we are asked
+  const bool pastTarget = this->TargetQueueWait >= 0 &&
+                          oldestJobWait >= this->TargetQueueWait;
+  const std::size_t wanted = pastTarget ? queuedJobs : 1;
+
+  const std::size_t room = std::min(this->maxWorkerCount(reqs) - launched,
+                                    this->maxWorkerCount() - current);
+  return static_cast<unsigned int>(std::min(wanted, room));
+}
+
+//----------------------------------------------------------------------------
+unsigned int WorkerFactoryBase::minIdleWorkers(
+                          const remus::proto::JobRequirements& reqs) const
+{
+  typedef std::map<remus::proto::JobRequirements,
+                   unsigned int>::const_iterator MinIt;
+  MinIt i = this->MinIdleWorkers.find(reqs);
+  return (i != this->MinIdleWorkers.end()) ? i->second : 0;
+}
+
+//----------------------------------------------------------------------------
+remus::proto::JobRequirementsSet
+WorkerFactoryBase::prewarmedRequirements() const
+{
+  typedef std::map<remus::proto::JobRequirements,
+                   unsigned int>::const_iterator MinIt;
+  remus::proto::JobRequirementsSet prewarmed;
+  for(MinIt i = this->MinIdleWorkers.begin();
+      i != this->MinIdleWorkers.end(); ++i)
+    {
+    if(i->second > 0)
+      { prewarmed.insert(i->first); }
+    }
+  return prewarmed;
+}
+
+//----------------------------------------------------------------------------
+unsigned int WorkerFactoryBase::prewarmWorkers(
+                                const remus::proto::JobRequirements& reqs,
+                                unsigned int idleWorkers,
+                                unsigned int busyWorkers)
+{
+  (void) reqs;
+  (void) idleWorkers;
+  (void) busyWorkers;
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+bool WorkerFactoryBase::hasMinIdleWorkers(
+                          const remus::proto::JobRequirements& reqs) const
+{
+  return this->MinIdleWorkers.count(reqs) > 0;
+}
+
 }
 
 }
@@ -13,8 +13,10 @@
 #ifndef remus_server_WorkeryFactoryBase_h
 #define remus_server_WorkeryFactoryBase_h
 
+#include <map>
 #include <vector>
 
+#include <boost/cstdint.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include <remus/common/MeshIOType.h>
@@ -29,6 +31,23 @@ namespace server{
 //forward declare the port connection class
 class PortConnection;
 
+//A worker process launched by a factory that ended before it finished,
+//such as by crashing or by being killed for going over its memory limit.
+//The identities of the workers the process registered with the server
+//start with the launch id the process was launched with, which is how the
+//server finds the jobs those workers had.
+struct REMUSSERVER_EXPORT WorkerFailure
+{
+  WorkerFailure(const std::string& launchId, const std::string& reason):
+    LaunchId(launchId),
+    Reason(reason)
+  {
+  }
+
+  std::string LaunchId;
+  std::string Reason;
+};
+
 
 //The Worker Factory Base task.
 //A common interface for abstracting out how the server can ask for workers
@@ -38,6 +57,18 @@ class PortConnection;
 //when the WorkerFactory instance gets deleted. If you created workers that stay after
 //the factory is deleted, you better make sure they are connected to the server,
 //or you will have zombie workers
+//
+//Factories can also keep workers launched ahead of demand, so that the
+//first jobs of a type don't wait for a worker to start. The server asks the
+//factory to top up these workers with prewarmWorkers every time it checks
+//on its workers.
+//
+//How quickly the factory scales up is driven by how long jobs wait in the
+//queue. Once a target queue wait is set, workers are only launched for a
+//type of job when its oldest queued job has waited longer than the target,
+//and then for every job of the type that is queued, up to the max worker
+//count of the type and of the factory. Workers that have been idle for
+//longer than the idle worker timeout are told to terminate by the server.
 class REMUSSERVER_EXPORT WorkerFactoryBase
 {
 public:
@@ -85,14 +116,104 @@ public:
 
   virtual void updateWorkerCount() = 0;
 
+  //return the worker processes that updateWorkerCount has found to have
+  //failed since the last call. The server fails the jobs that the workers
+  //of those processes had, with the reason the process failed. By default
+  //the factory can't tell how its workers ended, and returns none
+  virtual std::vector<WorkerFailure> takeWorkerFailures()
+    { return std::vector<WorkerFailure>(); }
+
   //Set the maximum number of total workers that can be returning at once
   void setMaxWorkerCount(unsigned int count){MaxWorkers = count;}
   unsigned int maxWorkerCount() const {return MaxWorkers;}
   virtual unsigned int currentWorkerCount() const =0;
 
+  //Set the maximum number of workers with the given requirements that can be
+  //running at once, which is still bounded by the max worker count
+  void setMaxWorkerCount(const remus::proto::JobRequirements& reqs,
+                         unsigned int count)
+    { this->MaxWorkersPerRequirements[reqs] = count; }
+  unsigned int maxWorkerCount(const remus::proto::JobRequirements& reqs) const;
+
+  //the number of running workers that were launched for the given
+  //requirements. By default every running worker is counted
+  virtual unsigned int launchedWorkerCount(
+                          const remus::proto::JobRequirements& reqs) const
+    { (void)reqs; return this->currentWorkerCount(); }
+
+  //is there room for another worker with the given requirements under both
+  //the max worker count of the requirements and of the factory
+  bool haveRoomForWorker(const remus::proto::JobRequirements& reqs) const;
+
+  //Set how many milliseconds the oldest queued job of a type can wait before
+  //workers are launched for all the queued jobs of the type. A negative
+  //target, the default, never launches more than one worker at a time
+  void setTargetQueueWait(boost::int64_t millisec)
+    { this->TargetQueueWait = millisec; }
+  boost::int64_t targetQueueWait() const { return this->TargetQueueWait; }
+
+  //the number of workers to launch for the jobs with the given requirements
+  //that are queued, given how many are queued and how many milliseconds the
+  //oldest of them has waited. A single worker is launched each time the
+  //server looks for workers, and once the oldest job has waited for the
+  //target queue wait a worker is launched for every queued job. The count
+  //is limited to the room left under the max worker counts
+  virtual unsigned int workersToLaunch(const remus::proto::JobRequirements& reqs,
+                                       std::size_t queuedJobs,
+                                       boost::int64_t oldestJobWait) const;
+
+  //Set how many milliseconds a worker can go without a job before the server
+  //tells it to terminate, which frees the resources it holds. Workers kept
+  //idle ahead of demand with setMinIdleWorkers aren't terminated. A negative
+  //timeout, the default, never terminates idle workers
+  void setIdleWorkerTimeout(boost::int64_t millisec)
+    { this->IdleWorkerTimeout = millisec; }
+  boost::int64_t idleWorkerTimeout() const { return this->IdleWorkerTimeout; }
+
+  //Set the number of workers with the given requirements that are kept
+  //idle or starting ahead of demand. Workers launched ahead of demand still
+  //count against the max worker count. Overrides the minimum the factory
+  //would otherwise use for the requirements
+  void setMinIdleWorkers(const remus::proto::JobRequirements& reqs,
+                         unsigned int count)
+    { this->MinIdleWorkers[reqs] = count; }
+
+  //the number of workers with the given requirements that are kept idle
+  //or starting ahead of demand, which is zero unless it has been set
+  virtual unsigned int minIdleWorkers(
+                        const remus::proto::JobRequirements& reqs) const;
+
+  //return all the requirements that have workers kept idle ahead of demand
+  virtual remus::proto::JobRequirementsSet prewarmedRequirements() const;
+
+  //launch workers with the given requirements until minIdleWorkers of them
+  //are idle or starting. The server passes in how many workers with the
+  //requirements are registered with it and waiting for a job, and how many
+  //are busy with jobs. Returns the number of workers launched, which is
+  //always zero for factories that can't launch workers ahead of demand
+  virtual unsigned int prewarmWorkers(const remus::proto::JobRequirements& reqs,
+                                      unsigned int idleWorkers,
+                                      unsigned int busyWorkers);
+
+  //return if a worker that was launched for the given requirements could
+  //still take the jobs that are waiting for it. The server queues those jobs
+  //again once this is false. By default any launched worker could.
+  virtual bool haveLaunchedWorker(
+                          const remus::proto::JobRequirements& reqs) const
+    { (void)reqs; return this->currentWorkerCount() > 0; }
+
+protected:
+  //has the number of idle workers been set for the given requirements
+  bool hasMinIdleWorkers(const remus::proto::JobRequirements& reqs) const;
+
 private:
   unsigned int MaxWorkers;
   std::string WorkerEndpoint;
+  std::map<remus::proto::JobRequirements, unsigned int> MinIdleWorkers;
+  std::map<remus::proto::JobRequirements, unsigned int>
+                                            MaxWorkersPerRequirements;
+  boost::int64_t TargetQueueWait;
+  boost::int64_t IdleWorkerTimeout;
 
   std::vector<std::string> GlobalCommandLineArguments;
 };
@@ -25,6 +25,7 @@ ActiveJobs::JobState::JobState(const zmq::SocketIdentity& workerIdentity,
   WorkerAddress(workerIdentity),
   jstatus(id,stat),
   jresult(id),
+  jencoded(),
   haveResult(false)
 {
 
@@ -51,6 +52,8 @@ bool ActiveJobs::add(const zmq::SocketIdentity &workerIdentity,
     JobState ws(workerIdentity,id,remus::QUEUED);
     InfoPair pair(id,ws);
     this->Info.insert(pair);
+    this->JobsByWorker[workerIdentity].insert(id);
+    this->NewlyAssigned.insert(workerIdentity);
     return true;
     }
   return false;
@@ -59,9 +62,20 @@ bool ActiveJobs::add(const zmq::SocketIdentity &workerIdentity,
 //-----------------------------------------------------------------------------
 bool ActiveJobs::remove(const boost::uuids::uuid& id)
 {
-  if(this->haveUUID(id))
+  InfoIt item = this->Info.find(id);
+  if(item != this->Info.end())
     {
-    this->Info.erase(id);
+    typedef boost::unordered_map<zmq::SocketIdentity, JobIdSet>::iterator WIt;
+    WIt worker = this->JobsByWorker.find(item->second.WorkerAddress);
+    if(worker != this->JobsByWorker.end())
+      {
+      worker->second.erase(id);
+      if(worker->second.empty())
+        {
+        this->JobsByWorker.erase(worker);
+        }
+      }
+    this->Info.erase(item);
     return true;
     }
   return false;
@@ -112,6 +126,13 @@ const remus::proto::JobResult& ActiveJobs::result(
   return item->second.jresult;
 }
 
+//-----------------------------------------------------------------------------
+const EncodedResult& ActiveJobs::encodedResult(const boost::uuids::uuid& id)
+{
+  InfoConstIt item = this->Info.find(id);
+  return item->second.jencoded;
+}
+
 //-----------------------------------------------------------------------------
 void ActiveJobs::updateStatus(const remus::proto::JobStatus& s)
 {
@@ -127,7 +148,8 @@ void ActiveJobs::updateStatus(const remus::proto::JobStatus& s)
 }
 
 //-----------------------------------------------------------------------------
-void ActiveJobs::updateResult(const remus::proto::JobResult& r)
+void ActiveJobs::updateResult(const remus::proto::JobResult& r,
+                              const EncodedResult& encoded)
 {
   InfoIt item = this->Info.find(r.id());
   if(item != this->Info.end())
@@ -141,24 +163,64 @@ void ActiveJobs::updateResult(const remus::proto::JobResult& r)
 
     //update the client result data to equal the server data
     item->second.jresult = r;
+    item->second.jencoded = encoded;
     item->second.haveResult = true;
     }
 }
 
 //-----------------------------------------------------------------------------
 std::vector< remus::proto::JobStatus >
-ActiveJobs::markExpiredJobs(remus::server::detail::SocketMonitor monitor)
+ActiveJobs::markExpiredJobs(const remus::server::detail::SocketChanges& changes,
+                            const remus::server::detail::SocketMonitor& monitor)
 {
+  //jobs of workers that have been marked as dead are expired as well, since
+  //the worker is never going to finish them
   std::vector< remus::proto::JobStatus > expiredJobs;
-  for(InfoIt item = this->Info.begin(); item != this->Info.end(); ++item)
+  typedef std::vector<zmq::SocketIdentity>::const_iterator SIt;
+  for(SIt i = changes.Unresponsive.begin(); i != changes.Unresponsive.end(); ++i)
+    {
+    this->markExpiredJobs(*i, expiredJobs);
+    }
+  for(SIt i = changes.Dead.begin(); i != changes.Dead.end(); ++i)
     {
+    this->markExpiredJobs(*i, expiredJobs);
+    }
+
+  //a worker that was already unresponsive when it was given a job won't
+  //be in the changes, so look at the state of the workers that have been
+  //given jobs since we were last called
+  typedef std::set<zmq::SocketIdentity>::const_iterator NIt;
+  for(NIt i = this->NewlyAssigned.begin(); i != this->NewlyAssigned.end(); ++i)
+    {
+    if(monitor.isUnresponsive(*i))
+      {
+      this->markExpiredJobs(*i, expiredJobs);
+      }
+    }
+  this->NewlyAssigned.clear();
+  return expiredJobs;
+}
+
+//-----------------------------------------------------------------------------
+void ActiveJobs::markExpiredJobs(const zmq::SocketIdentity& workerIdentity,
+                          std::vector< remus::proto::JobStatus >& expiredJobs)
+{
+  typedef boost::unordered_map<zmq::SocketIdentity, JobIdSet>::const_iterator WIt;
+  WIt worker = this->JobsByWorker.find(workerIdentity);
+  if(worker == this->JobsByWorker.end())
+    {
+    return;
+    }
+
+  for(JobIdSet::const_iterator id = worker->second.begin();
+      id != worker->second.end(); ++id)
+    {
+    InfoIt item = this->Info.find(*id);
     //we can only mark jobs that are IN_PROGRESS or QUEUED as failed.
     //FINISHED is more important than failed
     const bool is_status_valid_to_expire = (item->second.jstatus.queued() ||
                                            item->second.jstatus.inProgress());
-    const bool worker_is_unresponsive = monitor.isUnresponsive(
-                                                  item->second.WorkerAddress);
-    if (is_status_valid_to_expire && worker_is_unresponsive)
+    if (is_status_valid_to_expire)
       {
       //marking the job status as expired
       item->second.jstatus =
@@ -166,7 +228,37 @@ ActiveJobs::markExpiredJobs(remus::server::detail::SocketMonitor monitor)
       expiredJobs.push_back( item->second.jstatus );
       }
     }
-  return expiredJobs;
+}
+
+//-----------------------------------------------------------------------------
+std::vector< remus::proto::JobStatus >
+ActiveJobs::markFailedJobs(const zmq::SocketIdentity& workerIdentity,
+                           const std::string& reason)
+{
+  std::vector< remus::proto::JobStatus > failedJobs;
+  typedef boost::unordered_map<zmq::SocketIdentity, JobIdSet>::const_iterator WIt;
+  WIt worker = this->JobsByWorker.find(workerIdentity);
+  if(worker == this->JobsByWorker.end())
+    {
+    return failedJobs;
+    }
+
+  for(JobIdSet::const_iterator id = worker->second.begin();
+      id != worker->second.end(); ++id)
+    {
+    InfoIt item = this->Info.find(*id);
+    //FINISHED is more important than failed, and a job that has already
+    //failed or expired keeps the reason it was given
+    const bool is_status_valid_to_fail = (item->second.jstatus.queued() ||
+                                         item->second.jstatus.inProgress());
+    if (is_status_valid_to_fail)
+      {
+      item->second.jstatus =
+          remus::proto::make_FailedJobStatus(item->second.jstatus.id(), reason);
+      failedJobs.push_back( item->second.jstatus );
+      }
+    }
+  return failedJobs;
 }
 
 //-----------------------------------------------------------------------------
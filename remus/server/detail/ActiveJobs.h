@@ -15,10 +15,13 @@
 
 #include <remus/proto/JobResult.h>
 #include <remus/proto/JobStatus.h>
+#include <remus/proto/WireFormat.h>
 #include <remus/proto/zmqSocketIdentity.h>
 
 #include <remus/server/detail/SocketMonitor.h>
 
+#include <boost/unordered_map.hpp>
+
 #include <map>
 #include <set>
 #include <vector>
@@ -27,10 +30,38 @@ namespace remus{
 namespace server{
 namespace detail{
 
+//A job result exactly as the worker sent it to the server. Keeping it
+//lets us hand the result to a client that uses the same wire format
+//without encoding it again. The owner keeps the data alive.
+struct EncodedResult
+{
+  EncodedResult():
+    Data(NULL),
+    Size(0),
+    Format(remus::proto::WireFormat::Text),
+    Owner()
+    {}
+
+  EncodedResult(const char* data, std::size_t size,
+                const boost::shared_ptr<const void>& owner):
+    Data(data),
+    Size(size),
+    Format(remus::proto::detect_WireFormat(data,size)),
+    Owner(owner)
+    {}
+
+  bool empty() const { return this->Size == 0 || !this->Owner; }
+
+  const char* Data;
+  std::size_t Size;
+  remus::proto::WireFormat::Type Format;
+  boost::shared_ptr<const void> Owner;
+};
+
 class ActiveJobs
 {
   public:
-    ActiveJobs():Info(){}
+    ActiveJobs():Info(),JobsByWorker(),NewlyAssigned(){}
 
     bool add(const zmq::SocketIdentity& workerIdentity,
              const boost::uuids::uuid& id);
@@ -49,6 +80,10 @@ class ActiveJobs
     //returns a worker side job result object for a job
     const remus::proto::JobResult& result(const boost::uuids::uuid& id);
 
+    //returns the result of a job as the worker encoded it, which is
+    //empty when the result wasn't stored with its encoding
+    const EncodedResult& encodedResult(const boost::uuids::uuid& id);
+
     //update the job status of a job.
     //valid values are:
     // QUEUED
@@ -59,10 +94,24 @@ class ActiveJobs
     // not update status
     void updateStatus(const remus::proto::JobStatus& s);
 
-    void updateResult(const remus::proto::JobResult& r);
+    //the encoded result should be the message the result was decoded from
+    void updateResult(const remus::proto::JobResult& r,
+                      const EncodedResult& encoded = EncodedResult());
 
+    //mark all jobs whose worker has become unresponsive or dead
+    //as expired, and return the status of those jobs. A worker can stop
+    //responding before it is given a job, so the jobs of workers that were
+    //given one since the last call are expired when the monitor says their
+    //worker is unresponsive now
     std::vector< remus::proto::JobStatus > markExpiredJobs(
-                                 remus::server::detail::SocketMonitor monitor);
+                             const remus::server::detail::SocketChanges& changes,
+                             const remus::server::detail::SocketMonitor& monitor);
+
+    //mark all jobs of a worker whose process has failed as failed with
+    //the given reason, and return the status of those jobs
+    std::vector< remus::proto::JobStatus > markFailedJobs(
+                             const zmq::SocketIdentity& workerIdentity,
+                             const std::string& reason);
 
     std::set<zmq::SocketIdentity> activeWorkers() const;
 
@@ -72,6 +121,7 @@ private:
       zmq::SocketIdentity WorkerAddress;
       remus::proto::JobStatus jstatus;
       remus::proto::JobResult jresult;
+      EncodedResult jencoded;
       bool haveResult;
 
       JobState(const zmq::SocketIdentity& workerIdentity,
@@ -85,6 +135,18 @@ private:
     typedef std::map< boost::uuids::uuid, JobState>::const_iterator InfoConstIt;
     typedef std::map< boost::uuids::uuid, JobState>::iterator InfoIt;
     std::map<boost::uuids::uuid, JobState> Info;
+
+    //the jobs of each worker, so that we only need to look at the jobs
+    //of workers that have become unresponsive
+    typedef std::set<boost::uuids::uuid> JobIdSet;
+    boost::unordered_map<zmq::SocketIdentity, JobIdSet> JobsByWorker;
+
+    //the workers that have been given a job since we last expired jobs
+    std::set<zmq::SocketIdentity> NewlyAssigned;
+
+    //expire all the jobs of the given worker that can be expired
+    void markExpiredJobs(const zmq::SocketIdentity& workerIdentity,
+                         std::vector< remus::proto::JobStatus >& expiredJobs);
 };
 
 }
@@ -53,7 +53,8 @@ namespace detail{
 //----------------------------------------------------------------------------
 EventPublisher::EventPublisher():
   socket(NULL),
-  buffer()
+  buffer(),
+  PendingStatus()
   {
 
   }
@@ -101,6 +102,44 @@ void EventPublisher::jobQueued(const remus::proto::Job& j,
 
 //----------------------------------------------------------------------------
 void EventPublisher::jobStatus(const remus::proto::JobStatus& s, const zmq::SocketIdentity &si)
+{ //only keep the latest status of each job until we are asked to publish
+  StatusMap::iterator i = this->PendingStatus.find(s.id());
+  if(i != this->PendingStatus.end())
+    {
+    i->second = StatusAndWorker(s,si);
+    }
+  else
+    {
+    this->PendingStatus.insert( StatusMap::value_type(s.id(),
+                                                      StatusAndWorker(s,si)) );
+    }
+}
+
+//----------------------------------------------------------------------------
+void EventPublisher::publishPendingStatus()
+{
+  for(StatusMap::const_iterator i = this->PendingStatus.begin();
+      i != this->PendingStatus.end(); ++i)
+    {
+    this->publishStatus(i->second.first, i->second.second);
+    }
+  this->PendingStatus.clear();
+}
+
+//----------------------------------------------------------------------------
+void EventPublisher::publishPendingStatus(const boost::uuids::uuid& id)
+{ //publish the status of a job before any other event about it, so that
+  //listeners see the events of a job in the order they happened
+  StatusMap::iterator i = this->PendingStatus.find(id);
+  if(i != this->PendingStatus.end())
+    {
+    this->publishStatus(i->second.first, i->second.second);
+    this->PendingStatus.erase(i);
+    }
+}
+
+//----------------------------------------------------------------------------
+void EventPublisher::publishStatus(const remus::proto::JobStatus& s, const zmq::SocketIdentity &si)
 { //status
   buffer << s.id();
   const std::string suid = buffer.str(); buffer.str("");
@@ -131,6 +170,7 @@ void EventPublisher::jobStatus(const remus::proto::JobStatus& s, const zmq::Sock
 void EventPublisher::jobTerminated(const remus::proto::JobStatus& s,
                                    const zmq::SocketIdentity &si)
 { //job assigned to a worker has been terminated
+  this->publishPendingStatus(s.id());
   buffer << s.id();
   const std::string suid = buffer.str(); buffer.str("");
   const std::string work_t = si.name();
@@ -157,6 +197,7 @@ void EventPublisher::jobTerminated(const remus::proto::JobStatus& s,
 //----------------------------------------------------------------------------
 void EventPublisher::jobTerminated(const remus::proto::JobStatus& s)
 { //job queued has been terminated
+  this->publishPendingStatus(s.id());
   buffer << s.id();
   const std::string suid = buffer.str(); buffer.str("");
   const std::string work_t = ""; //kept for easier parsing of the json message
@@ -183,6 +224,7 @@ void EventPublisher::jobTerminated(const remus::proto::JobStatus& s)
 void EventPublisher::jobExpired(const remus::proto::JobStatus& s)
 { //active job has been marked as expired as the worker it was assigned to
   //has stopped heartbeating
+  this->publishPendingStatus(s.id());
   buffer << s.id();
   const std::string suid = buffer.str(); buffer.str("");
   const std::string work_t = ""; //kept for easier parsing of the json message
@@ -214,6 +256,7 @@ void EventPublisher::jobExpired(const remus::proto::JobStatus& s)
 //----------------------------------------------------------------------------
 void EventPublisher::jobFinished(const remus::proto::JobResult& r, const zmq::SocketIdentity &si)
 { //have result to fetch
+  this->publishPendingStatus(r.id());
   buffer << r.id();
   const std::string suid = buffer.str(); buffer.str("");
   const std::string work_t = si.name();
@@ -439,6 +482,9 @@ void EventPublisher::error(const std::string& msg)
 //----------------------------------------------------------------------------
 void EventPublisher::stop()
 {
+  //publish the status updates that are still waiting
+  this->publishPendingStatus();
+
   //first send a message on error that the server is ending
   this->error("END");
 
@@ -37,6 +37,11 @@ struct cJSON;
 
 #include <remus/proto/zmq.hpp>
 #include <remus/proto/EventTypes.h>
+#include <remus/proto/JobStatus.h>
+#include <remus/proto/zmqSocketIdentity.h>
+
+#include <boost/unordered_map.hpp>
+#include <boost/uuid/uuid.hpp>
 
 #include <sstream>
 #include <vector>
@@ -81,8 +86,14 @@ public:
   void jobQueued( const remus::proto::Job& j,
                                 const remus::proto::JobRequirements& reqs);
 
+  //Status updates are conflated, so that when a worker sends many updates
+  //for a job in a row only the latest is published. They are published
+  //when publishPendingStatus is called, or before any other event about
+  //the same job is published.
   void jobStatus( const remus::proto::JobStatus& s,
                   const zmq::SocketIdentity &workerIdentity);
+  void publishPendingStatus();
+
   void jobTerminated( const remus::proto::JobStatus& last_status,
                       const zmq::SocketIdentity &workerIdentity);
   void jobTerminated( const remus::proto::JobStatus& last_status );
@@ -116,11 +127,19 @@ public:
   void stop();
 
 private:
+  void publishPendingStatus(const boost::uuids::uuid& id);
+  void publishStatus( const remus::proto::JobStatus& s,
+                      const zmq::SocketIdentity &workerIdentity);
+
   void pubJob(const std::string& st, const std::string suid, cJSON *root);
   void pubWorker(const std::string& st, const std::string suid, cJSON *root);
 
   zmq::socket_t* socket;
   std::stringstream buffer;
+
+  typedef std::pair<remus::proto::JobStatus, zmq::SocketIdentity> StatusAndWorker;
+  typedef boost::unordered_map<boost::uuids::uuid, StatusAndWorker> StatusMap;
+  StatusMap PendingStatus;
 };
 
 }
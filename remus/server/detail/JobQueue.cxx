@@ -11,7 +11,10 @@
 //=============================================================================
 
 #include <remus/server/detail/JobQueue.h>
-#include <iostream>
+
+#include <remus/server/detail/TimerWheel.h>
+
+#include <algorithm>
 
 namespace remus{
 namespace server{
@@ -19,19 +22,35 @@ namespace detail{
 
 //------------------------------------------------------------------------------
 bool JobQueue::addJob(const boost::uuids::uuid &id,
-                      const remus::proto::JobSubmission& submission)
+                      const remus::proto::JobSubmission& submission,
+                      const zmq::SocketIdentity& client,
+                      const boost::shared_ptr<zmq::message_t>& payload)
 {
   //only add the message as a job if the uuid hasn't been used already
-  const bool can_add = QueuedIds.count(id) == 0;
+  const bool can_add = this->Jobs.count(id) == 0;
   if(can_add)
     {
-    QueuedJob newQueuedJob(id,submission);
-    this->QueuedJobs.insert(
-          std::lower_bound( this->QueuedJobs.begin(), this->QueuedJobs.end(),
-                            newQueuedJob ),
-          newQueuedJob);
-    this->QueuedIds.insert(id);
-    this->CachedQueuedJobRequirements.insert( submission.requirements() );
+    const std::string clientKey(client.data(), client.size());
+    Bucket& bucket = this->Buckets[submission.requirements()];
+
+    //find the jobs for this client, if the client has no jobs queued
+    //it goes to the back of the round robin order
+    typedef boost::unordered_map<std::string, ClientList::iterator>::iterator
+            IndexIt;
+    IndexIt clientJobs = bucket.ClientIndex.find(clientKey);
+    if(clientJobs == bucket.ClientIndex.end())
+      {
+      bucket.Clients.push_back(ClientJobs(clientKey));
+      clientJobs = bucket.ClientIndex.insert(
+                    std::make_pair(clientKey, --bucket.Clients.end())).first;
+      }
+
+    JobList& jobs = clientJobs->second->Jobs;
+    QueuedJob newQueuedJob(submission, clientKey, payload,
+                           TimerWheel::now());
+    newQueuedJob.Position = jobs.insert(jobs.end(), id);
+    this->Jobs.insert(std::make_pair(id, newQueuedJob));
+    ++bucket.NumQueued;
     }
   return can_add;
 }
@@ -39,47 +58,45 @@ bool JobQueue::addJob(const boost::uuids::uuid &id,
 //------------------------------------------------------------------------------
 remus::worker::Job JobQueue::takeJob(const remus::proto::JobRequirements& reqs)
 {
-  std::vector<QueuedJob>* searched_vector = &this->JobsWaitingForWorker;
-  typedef std::vector<QueuedJob>::iterator iter;
-
-  JobTypeMatches pred(reqs);
-  iter item = std::find_if(searched_vector->begin(), searched_vector->end(),
-                           pred);
-  if(item == searched_vector->end())
-    {
-    searched_vector = &this->QueuedJobs;
-    item = std::find_if(searched_vector->begin(), searched_vector->end(),
-                        pred);
-    if(item == searched_vector->end())
-      {
-      //return an invalid job
-      return remus::worker::Job();
-      }
+  boost::shared_ptr<zmq::message_t> payload;
+  return this->takeJob(reqs, payload);
+}
 
-    //the job is from the queue, so invalidate the cache. This is overaggressive
-    //but to fix it we would need to track the number of jobs that each requirement
-    //maps too
-    this->CachedQueuedJobRequirements.clear();
+//------------------------------------------------------------------------------
+remus::worker::Job JobQueue::takeJob(const remus::proto::JobRequirements& reqs,
+                                     boost::shared_ptr<zmq::message_t>& payload)
+{
+  payload.reset();
+  BucketMap::iterator bucket = this->Buckets.find(reqs);
+  if(bucket == this->Buckets.end())
+    {
+    //return an invalid job
+    return remus::worker::Job();
     }
 
-  //we need to copy the id and the contents of item now into a job
-  //submission, if we use item after the remove_if it is invalid as
-  //remove_if moves the vector items around making what item
-  //is pointing too change
-  remus::worker::Job job(item->Id,item->Submission);
-
-  //again don't use item after the remove_if the iterator is invalid
-  JobIdMatches id_pred(job.id());
-
-  iter new_end = std::remove_if(searched_vector->begin(),
-                                searched_vector->end(),
-                                id_pred);
-  searched_vector->erase(new_end,searched_vector->end());
-
-  this->QueuedIds.erase(job.id());
+  //jobs that are waiting for a worker take priority over the jobs that
+  //are just queued
+  boost::uuids::uuid id;
+  if(!bucket->second.Waiting.empty())
+    {
+    id = bucket->second.Waiting.front();
+    bucket->second.Waiting.pop_front();
+    --this->NumWaiting;
+    }
+  else
+    {
+    id = this->takeQueuedJob(bucket->second);
+    }
 
-  //clear the queued job cache
+  JobMap::iterator item = this->Jobs.find(id);
+  remus::worker::Job job(id,item->second.Submission);
+  payload = item->second.Payload;
+  this->Jobs.erase(item);
 
+  if(bucket->second.empty())
+    {
+    this->Buckets.erase(bucket);
+    }
   return job;
 }
 
@@ -87,96 +104,204 @@ remus::worker::Job JobQueue::takeJob(const remus::proto::JobRequirements& reqs)
 remus::proto::JobRequirementsSet JobQueue::waitingJobRequirements() const
 {
   remus::proto::JobRequirementsSet result;
-  for(std::vector<QueuedJob>::const_iterator i= this->JobsWaitingForWorker.begin();
-      i != this->JobsWaitingForWorker.end();
+  for(BucketMap::const_iterator i = this->Buckets.begin();
+      i != this->Buckets.end();
       ++i)
     {
-    result.insert(i->Submission.requirements());
+    if(!i->second.Waiting.empty())
+      {
+      result.insert(i->first);
+      }
     }
   return result;
 }
 
 //------------------------------------------------------------------------------
-remus::proto::JobRequirementsSet JobQueue::queuedJobRequirements()
+remus::proto::JobRequirementsSet JobQueue::queuedJobRequirements() const
 {
-  if(this->CachedQueuedJobRequirements.size() == 0)
-    {
-    for(std::vector<QueuedJob>::const_iterator i= this->QueuedJobs.begin();
-      i != this->QueuedJobs.end();
+  remus::proto::JobRequirementsSet result;
+  for(BucketMap::const_iterator i = this->Buckets.begin();
+      i != this->Buckets.end();
       ++i)
+    {
+    if(i->second.NumQueued > 0)
       {
-      this->CachedQueuedJobRequirements.insert(i->Submission.requirements());
+      result.insert(i->first);
       }
     }
+  return result;
+}
 
-  return CachedQueuedJobRequirements;
+//------------------------------------------------------------------------------
+std::size_t JobQueue::numJobsJustQueued(
+                          const remus::proto::JobRequirements& reqs) const
+{
+  BucketMap::const_iterator bucket = this->Buckets.find(reqs);
+  return (bucket != this->Buckets.end()) ? bucket->second.NumQueued : 0;
 }
 
 //------------------------------------------------------------------------------
-bool JobQueue::workerDispatched(const remus::proto::JobRequirements& reqs)
+boost::int64_t JobQueue::oldestQueuedJobWait(
+                          const remus::proto::JobRequirements& reqs,
+                          boost::int64_t now) const
 {
-  typedef std::vector<QueuedJob>::iterator iter;
-  JobTypeMatches pred(reqs);
+  BucketMap::const_iterator bucket = this->Buckets.find(reqs);
+  if(bucket == this->Buckets.end())
+    {
+    return 0;
+    }
+
+  //the jobs of each client are in the order they were queued, so only
+  //the first job of each client needs to be looked at
+  boost::int64_t oldest = now;
+  for(ClientList::const_iterator i = bucket->second.Clients.begin();
+      i != bucket->second.Clients.end(); ++i)
+    {
+    if(!i->Jobs.empty())
+      {
+      const QueuedJob& job = this->Jobs.find(i->Jobs.front())->second;
+      oldest = std::min(oldest, job.QueuedAt);
+      }
+    }
+  return now - oldest;
+}
 
-  iter item = std::find_if(this->QueuedJobs.begin(),
-                           this->QueuedJobs.end(), pred);
-  const bool found = this->QueuedJobs.end() != item;
+//------------------------------------------------------------------------------
+bool JobQueue::workerDispatched(const remus::proto::JobRequirements& reqs)
+{
+  BucketMap::iterator bucket = this->Buckets.find(reqs);
+  const bool found = (bucket != this->Buckets.end()) &&
+                     (bucket->second.NumQueued > 0);
   if(found)
     {
-    this->JobsWaitingForWorker.push_back(*item);
-    this->QueuedJobs.erase(item);
-    this->CachedQueuedJobRequirements.clear();
+    const boost::uuids::uuid id = this->takeQueuedJob(bucket->second);
+
+    QueuedJob& job = this->Jobs.find(id)->second;
+    job.IsWaiting = true;
+    job.Position = bucket->second.Waiting.insert(bucket->second.Waiting.end(),
+                                                 id);
+    ++this->NumWaiting;
     }
   return found;
 }
 
+//------------------------------------------------------------------------------
+std::size_t JobQueue::requeueWaitingJobs(
+                                    const remus::proto::JobRequirements& reqs)
+{
+  BucketMap::iterator bucket = this->Buckets.find(reqs);
+  if(bucket == this->Buckets.end())
+    {
+    return 0;
+    }
+
+  //walk the waiting jobs from the newest, so that each client gets its
+  //jobs back in the order they were dispatched
+  JobList& waiting = bucket->second.Waiting;
+  const std::size_t count = waiting.size();
+  while(!waiting.empty())
+    {
+    const boost::uuids::uuid id = waiting.back();
+    waiting.pop_back();
+
+    QueuedJob& job = this->Jobs.find(id)->second;
+    typedef boost::unordered_map<std::string, ClientList::iterator>::iterator
+            IndexIt;
+    IndexIt clientJobs = bucket->second.ClientIndex.find(job.Client);
+    if(clientJobs == bucket->second.ClientIndex.end())
+      {
+      bucket->second.Clients.push_front(ClientJobs(job.Client));
+      clientJobs = bucket->second.ClientIndex.insert(
+          std::make_pair(job.Client, bucket->second.Clients.begin())).first;
+      }
+
+    JobList& jobs = clientJobs->second->Jobs;
+    job.IsWaiting = false;
+    job.Position = jobs.insert(jobs.begin(), id);
+    ++bucket->second.NumQueued;
+    --this->NumWaiting;
+    }
+  return count;
+}
+
 //------------------------------------------------------------------------------
 bool JobQueue::haveUUID(const boost::uuids::uuid &id) const
 {
-  return this->QueuedIds.count(id) == 1;
+  return this->Jobs.count(id) == 1;
 }
 
 //------------------------------------------------------------------------------
 bool JobQueue::remove(const boost::uuids::uuid& id)
 {
-  typedef std::vector<QueuedJob>::iterator iter;
-  JobIdMatches pred(id);
-
-  bool id_found = false;
-
-  iter new_end = std::remove_if(this->QueuedJobs.begin(),
-                                this->QueuedJobs.end(),
-                                pred);
+  JobMap::iterator item = this->Jobs.find(id);
+  if(item == this->Jobs.end())
+    {
+    return false;
+    }
 
-  id_found = (new_end != this->QueuedJobs.end());
-  if( id_found )
+  BucketMap::iterator bucket =
+                  this->Buckets.find(item->second.Submission.requirements());
+  if(item->second.IsWaiting)
     {
-    this->QueuedJobs.erase(new_end,this->QueuedJobs.end());
-    this->CachedQueuedJobRequirements.clear();
+    bucket->second.Waiting.erase(item->second.Position);
+    --this->NumWaiting;
     }
   else
     {
-    new_end = std::remove_if(this->JobsWaitingForWorker.begin(),
-                            this->JobsWaitingForWorker.end(),
-                            pred);
-
-    id_found = (new_end != this->JobsWaitingForWorker.end());
+    this->removeQueuedJob(bucket->second, item->second);
+    }
+  this->Jobs.erase(item);
 
-    if( id_found )
-      {
-      this->JobsWaitingForWorker.erase(new_end,this->JobsWaitingForWorker.end());
-      }
+  if(bucket->second.empty())
+    {
+    this->Buckets.erase(bucket);
     }
-  return this->QueuedIds.erase(id)==1;
+  return true;
 }
 
 //------------------------------------------------------------------------------
 void JobQueue::clear()
 {
-  this->QueuedIds.clear();
-  this->QueuedJobs.clear();
-  this->QueuedJobs.clear();
-  this->CachedQueuedJobRequirements.clear();
+  this->Buckets.clear();
+  this->Jobs.clear();
+  this->NumWaiting = 0;
+}
+
+//------------------------------------------------------------------------------
+boost::uuids::uuid JobQueue::takeQueuedJob(Bucket& bucket)
+{
+  //the client at the front of the list is next in the round robin order
+  ClientList::iterator client = bucket.Clients.begin();
+  const boost::uuids::uuid id = client->Jobs.front();
+  client->Jobs.pop_front();
+  --bucket.NumQueued;
+
+  if(client->Jobs.empty())
+    {
+    bucket.ClientIndex.erase(client->Client);
+    bucket.Clients.erase(client);
+    }
+  else
+    {
+    //move the client to the back so every other client gets a job
+    //taken before this client does again
+    bucket.Clients.splice(bucket.Clients.end(), bucket.Clients, client);
+    }
+  return id;
+}
+
+//------------------------------------------------------------------------------
+void JobQueue::removeQueuedJob(Bucket& bucket, const QueuedJob& job)
+{
+  ClientList::iterator client = bucket.ClientIndex.find(job.Client)->second;
+  client->Jobs.erase(job.Position);
+  --bucket.NumQueued;
+
+  if(client->Jobs.empty())
+    {
+    bucket.ClientIndex.erase(client->Client);
+    bucket.Clients.erase(client);
+    }
 }
 
 }
@@ -15,63 +15,103 @@
 
 #include <remus/proto/JobSubmission.h>
 #include <remus/proto/Message.h>
+#include <remus/proto/zmqSocketIdentity.h>
 
 #include <remus/server/detail/uuidHelper.h>
 
 #include <remus/worker/Job.h>
 
+#include <boost/cstdint.hpp>
 #include <boost/uuid/uuid.hpp>
+#include <boost/unordered_map.hpp>
 
-#include <algorithm>
-#include <set>
-#include <vector>
+#include <list>
+#include <string>
 
 namespace remus{
 namespace server{
 namespace detail{
 
-//A job id based queue. When jobs are added they are inserted based on
-//the uuid of the job. We use the uuid as the priority of the queue to
-//help alleviate the issue of a single client submitting many jobs and
-//stopping any other client from getting a job finished in a reasonable
+//A queue of jobs bucketed by their JobRequirements. Each bucket holds
+//the jobs that are waiting for a worker that has been dispatched in the
+//order they were dispatched, and the jobs that are just queued grouped
+//by the client that submitted them. Jobs that are just queued are taken
+//round robin across clients so that a single client submitting many jobs
+//doesn't stop any other client from getting a job finished in a reasonable
 //amount of time.
+//
+//Buckets and jobs are found through hash maps so adding, taking, removing
+//and looking up a job are all constant time operations.
 class JobQueue
 {
 public:
   JobQueue():
-    QueuedJobs(),
-    JobsWaitingForWorker(),
-    QueuedIds()
+    Buckets(),
+    Jobs(),
+    NumWaiting(0)
   {}
 
   //Convert a Message and UUID into a WorkerMessage.
   //will return false if the uuid is already queued
+  //The client is used to provide round robin ordering of queued jobs
+  //between clients
+  //The payload is the opaque encoded submission that the client sent
+  //along with the scheduling header, and is held untouched until the job
+  //is taken. Submissions that come with a payload only need to hold the
+  //requirements of the job.
   bool addJob( const boost::uuids::uuid& id,
-               const remus::proto::JobSubmission& submission);
+               const remus::proto::JobSubmission& submission,
+               const zmq::SocketIdentity& client = zmq::SocketIdentity(),
+               const boost::shared_ptr<zmq::message_t>& payload =
+                                        boost::shared_ptr<zmq::message_t>());
 
   //Removes a job from the queue of the given mesh type.
   //Return it as a worker Job. We prioritize jobs waiting for
   //workers, and than take jobs that are just queued.
   remus::worker::Job takeJob(const remus::proto::JobRequirements& reqs);
 
+  //Removes a job from the queue of the given mesh type, and returns
+  //the payload that was queued with it, which is empty when the job
+  //was queued without a payload.
+  remus::worker::Job takeJob(const remus::proto::JobRequirements& reqs,
+                             boost::shared_ptr<zmq::message_t>& payload);
+
   //returns the types of jobs that are waiting for a worker
   remus::proto::JobRequirementsSet waitingJobRequirements() const;
 
   //returns the types of jobs that are queued and aren't waiting for a worker
-  remus::proto::JobRequirementsSet queuedJobRequirements();
+  remus::proto::JobRequirementsSet queuedJobRequirements() const;
 
   //return the number of jobs waiting for workers
   std::size_t numJobsWaitingForWorkers() const
-    { return JobsWaitingForWorker.size(); }
+    { return NumWaiting; }
 
   //return the number of jobs queued but not waiting for a worker
   std::size_t numJobsJustQueued() const
-    { return QueuedJobs.size(); }
+    { return Jobs.size() - NumWaiting; }
+
+  //return the number of jobs of the given type queued but not waiting
+  //for a worker
+  std::size_t numJobsJustQueued(
+                      const remus::proto::JobRequirements& reqs) const;
+
+  //return how many milliseconds the oldest job of the given type that is
+  //queued but not waiting for a worker has been in the queue, as of now
+  //in milliseconds of remus::server::detail::TimerWheel::now(). Returns
+  //zero when no job of the type is queued
+  boost::int64_t oldestQueuedJobWait(const remus::proto::JobRequirements& reqs,
+                                     boost::int64_t now) const;
 
-  //marks the first job with the given type as having
+  //marks the next queued job with the given type as having
   //a worker dispatched for it.
   bool workerDispatched(const remus::proto::JobRequirements& reqs);
 
+  //marks every job of the given type that is waiting for a worker as
+  //just queued again, ahead of the other queued jobs of its client. Used
+  //when the workers dispatched for the jobs have gone away. Returns the
+  //number of jobs that were queued again.
+  std::size_t requeueWaitingJobs(const remus::proto::JobRequirements& reqs);
+
   //Returns true if we contain the UUID
   bool haveUUID(const boost::uuids::uuid& id) const;
 
@@ -82,57 +122,78 @@ public:
   void clear();
 
 private:
-  struct QueuedJob
-  {
-    QueuedJob(const boost::uuids::uuid& id,
-              const remus::proto::JobSubmission& submission):
-              Id(id),
-              Submission(submission)
-              {}
+  typedef std::list<boost::uuids::uuid> JobList;
 
-    boost::uuids::uuid Id;
-    remus::proto::JobSubmission Submission;
-
-    bool operator<(const QueuedJob& other) const
-      { return this->Id < other.Id; }
+  //the jobs submitted by a single client for a given set of requirements
+  struct ClientJobs
+  {
+    explicit ClientJobs(const std::string& client):
+      Client(client),
+      Jobs()
+      {}
 
+    std::string Client;
+    JobList Jobs;
   };
+  typedef std::list<ClientJobs> ClientList;
 
-  struct JobIdMatches
+  //all the jobs for a given set of requirements
+  struct Bucket
   {
-    JobIdMatches(boost::uuids::uuid id):
-    UUID(id) {}
-
-    bool operator()(const QueuedJob& job) const
-      { return job.Id == UUID; }
-
-    boost::uuids::uuid UUID;
+    Bucket():
+      Waiting(),
+      Clients(),
+      ClientIndex(),
+      NumQueued(0)
+      {}
+
+    //jobs that have a worker dispatched for them, in dispatch order
+    JobList Waiting;
+
+    //clients that have queued jobs, in the order we will take from them
+    ClientList Clients;
+    boost::unordered_map<std::string, ClientList::iterator> ClientIndex;
+    std::size_t NumQueued;
+
+    bool empty() const { return Waiting.empty() && NumQueued == 0; }
   };
+  typedef boost::unordered_map<remus::proto::JobRequirements,
+                               Bucket> BucketMap;
 
-  struct JobTypeMatches
+  //where a job lives inside its bucket
+  struct QueuedJob
   {
-    JobTypeMatches(const remus::proto::JobRequirements& r):
-    Reqs(r) {}
-
-    bool operator()(const QueuedJob& job) const
-      { return Reqs == job.Submission.requirements(); }
+    QueuedJob(const remus::proto::JobSubmission& submission,
+              const std::string& client,
+              const boost::shared_ptr<zmq::message_t>& payload,
+              boost::int64_t queuedAt):
+      Submission(submission),
+      Client(client),
+      Payload(payload),
+      QueuedAt(queuedAt),
+      IsWaiting(false),
+      Position()
+      {}
 
-    const remus::proto::JobRequirements& Reqs;
+    remus::proto::JobSubmission Submission;
+    std::string Client;
+    boost::shared_ptr<zmq::message_t> Payload;
+    boost::int64_t QueuedAt;
+    bool IsWaiting;
+    JobList::iterator Position;
   };
+  typedef boost::unordered_map<boost::uuids::uuid, QueuedJob> JobMap;
 
-  //job queue info, sorted by id when items are added so that we can get
-  //a really rough load balancing when we have multiple clients. This
-  //way jobs that come up for new workers are roughly round robin when
-  //the number of jobs per client is similar.
-  std::vector<QueuedJob> QueuedJobs;
+  //take the next just queued job from the bucket, rotating the client
+  //that it came from to the back of the round robin order
+  boost::uuids::uuid takeQueuedJob(Bucket& bucket);
 
-  //kept in the order that the jobs are added since this is a real queue
-  //we want the priority of queued jobs that have a working incoming to
-  //match the dispatch order
-  std::vector<QueuedJob> JobsWaitingForWorker;
+  //removes a job that is just queued from the list of its client
+  void removeQueuedJob(Bucket& bucket, const QueuedJob& job);
 
-  std::set<boost::uuids::uuid> QueuedIds;
-  std::set<remus::proto::JobRequirements> CachedQueuedJobRequirements;
+  BucketMap Buckets;
+  JobMap Jobs;
+  std::size_t NumWaiting;
 
   //make copying not possible
   JobQueue (const JobQueue&);
@@ -0,0 +1,253 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/ProcessLauncher.h>
+
+//suppress warnings inside boost headers for gcc and clang
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/locks.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <deque>
+
+namespace
+{
+  typedef boost::shared_ptr<remus::common::ExecuteProcess> ExecuteProcessPtr;
+  typedef boost::shared_ptr< boost::promise<void> > PromisePtr;
+
+  //----------------------------------------------------------------------------
+  struct QueuedLaunch
+  {
+    QueuedLaunch(const ExecuteProcessPtr& process, const PromisePtr& promise):
+      Process(process),
+      Promise(promise)
+    {
+    }
+
+    ExecuteProcessPtr Process;
+    PromisePtr Promise;
+  };
+
+  //----------------------------------------------------------------------------
+  void execute(const QueuedLaunch& launch)
+  {
+    try
+      {
+      launch.Process->execute();
+      launch.Promise->set_value();
+      }
+    catch(...)
+      {
+      launch.Promise->set_exception(boost::current_exception());
+      }
+  }
+}
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//-----------------------------------------------------------------------------
+class ProcessLauncher::LauncherImplementation
+{
+  mutable boost::mutex QueueMutex;
+  boost::condition_variable QueueChanged;
+  std::deque< QueuedLaunch > Queue;
+
+  //the number of queued processes that haven't finished executing,
+  //including the ones a thread is executing
+  std::size_t Pending;
+  std::size_t IdleThreads;
+  std::size_t MaxThreads;
+  bool Shutdown;
+
+  boost::thread_group Threads;
+
+public:
+//-----------------------------------------------------------------------------
+LauncherImplementation(std::size_t maxThreads):
+  QueueMutex(),
+  QueueChanged(),
+  Queue(),
+  Pending(0),
+  IdleThreads(0),
+  MaxThreads(maxThreads),
+  Shutdown(false),
+  Threads()
+{
+}
+
+//-----------------------------------------------------------------------------
+~LauncherImplementation()
+{
+  {
+  boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  this->Shutdown = true;
+  this->QueueChanged.notify_all();
+  }
+  //the threads empty the queue before they exit
+  this->Threads.join_all();
+}
+
+//-----------------------------------------------------------------------------
+void setMaxThreads(std::size_t maxThreads)
+{
+  boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  this->MaxThreads = maxThreads;
+}
+
+//-----------------------------------------------------------------------------
+std::size_t maxThreads() const
+{
+  boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  return this->MaxThreads;
+}
+
+//-----------------------------------------------------------------------------
+boost::shared_future<void> launch(const ExecuteProcessPtr& process)
+{
+  PromisePtr promise = boost::make_shared< boost::promise<void> >();
+  boost::shared_future<void> result(promise->get_future());
+
+  boost::unique_lock<boost::mutex> lock(this->QueueMutex);
+  if(this->MaxThreads == 0)
+    {
+    lock.unlock();
+    execute( QueuedLaunch(process,promise) );
+    return result;
+    }
+
+  this->Queue.push_back( QueuedLaunch(process,promise) );
+  ++this->Pending;
+
+  //only start another thread when every thread is busy
+  if(this->IdleThreads < this->Queue.size() &&
+     this->Threads.size() < this->MaxThreads)
+    {
+    this->Threads.create_thread(
+        boost::bind(&LauncherImplementation::run, this));
+    }
+  this->QueueChanged.notify_all();
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+std::size_t pendingLaunches() const
+{
+  boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  return this->Pending;
+}
+
+//-----------------------------------------------------------------------------
+std::size_t threadCount() const
+{
+  boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  return this->Threads.size();
+}
+
+//-----------------------------------------------------------------------------
+void waitForLaunches()
+{
+  boost::unique_lock<boost::mutex> lock(this->QueueMutex);
+  while(this->Pending > 0)
+    {
+    this->QueueChanged.wait(lock);
+    }
+}
+
+private:
+//-----------------------------------------------------------------------------
+void run()
+{
+  boost::unique_lock<boost::mutex> lock(this->QueueMutex);
+  while(true)
+    {
+    ++this->IdleThreads;
+    while(this->Queue.empty() && !this->Shutdown)
+      {
+      this->QueueChanged.wait(lock);
+      }
+    --this->IdleThreads;
+
+    if(this->Queue.empty())
+      { //we have been shutdown, and everything has been executed
+      return;
+      }
+
+    QueuedLaunch launch = this->Queue.front();
+    this->Queue.pop_front();
+
+    lock.unlock();
+    execute(launch);
+    lock.lock();
+
+    --this->Pending;
+    this->QueueChanged.notify_all();
+    }
+}
+
+};
+
+//-----------------------------------------------------------------------------
+ProcessLauncher::ProcessLauncher(std::size_t maxThreads):
+  Implementation( new LauncherImplementation(maxThreads) )
+{
+}
+
+//-----------------------------------------------------------------------------
+ProcessLauncher::~ProcessLauncher()
+{
+}
+
+//-----------------------------------------------------------------------------
+void ProcessLauncher::setMaxThreads(std::size_t maxThreads)
+{
+  this->Implementation->setMaxThreads(maxThreads);
+}
+
+//-----------------------------------------------------------------------------
+std::size_t ProcessLauncher::maxThreads() const
+{
+  return this->Implementation->maxThreads();
+}
+
+//-----------------------------------------------------------------------------
+boost::shared_future<void> ProcessLauncher::launch(
+                const boost::shared_ptr<remus::common::ExecuteProcess>& process)
+{
+  return this->Implementation->launch(process);
+}
+
+//-----------------------------------------------------------------------------
+std::size_t ProcessLauncher::pendingLaunches() const
+{
+  return this->Implementation->pendingLaunches();
+}
+
+//-----------------------------------------------------------------------------
+std::size_t ProcessLauncher::threadCount() const
+{
+  return this->Implementation->threadCount();
+}
+
+//-----------------------------------------------------------------------------
+void ProcessLauncher::waitForLaunches()
+{
+  this->Implementation->waitForLaunches();
+}
+
+}
+}
+}
@@ -0,0 +1,80 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_ProcessLauncher_h
+#define remus_server_detail_ProcessLauncher_h
+
+#include <remus/common/ExecuteProcess.h>
+
+//suppress warnings inside boost headers for gcc and clang
+#include <remus/common/CompilerInformation.h>
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/future.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <cstddef>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//Executes processes on helper threads, so that the thread which asks for
+//a process to be launched doesn't wait for it to start. Launching many
+//worker processes at once, for example when the server starts, would
+//otherwise stop the server from brokering until every one has started.
+//
+//Helper threads are started as launches are queued, up to the maximum
+//number of threads, and run until the launcher is destroyed.
+class ProcessLauncher
+{
+public:
+  //a maxThreads of 0 executes processes on the thread that launches them
+  explicit ProcessLauncher(std::size_t maxThreads);
+
+  //waits for every queued process to be executed
+  ~ProcessLauncher();
+
+  //set the number of helper threads that can execute processes at once.
+  //Threads that have already been started keep running
+  void setMaxThreads(std::size_t maxThreads);
+  std::size_t maxThreads() const;
+
+  //queue the process to be executed. The returned future is ready once
+  //the process has been executed
+  boost::shared_future<void> launch(
+                const boost::shared_ptr<remus::common::ExecuteProcess>& process);
+
+  //the number of processes that have been queued but not yet executed
+  std::size_t pendingLaunches() const;
+
+  //the number of helper threads that have been started
+  std::size_t threadCount() const;
+
+  //wait for every queued process to be executed
+  void waitForLaunches();
+
+private:
+  class LauncherImplementation;
+  boost::scoped_ptr<LauncherImplementation> Implementation;
+
+  //make copying not possible
+  ProcessLauncher(const ProcessLauncher&);
+  void operator=(const ProcessLauncher&);
+};
+
+}
+}
+}
+
+#endif
@@ -12,8 +12,10 @@
 
 #include <remus/server/detail/SocketMonitor.h>
 
+#include <remus/server/detail/TimerWheel.h>
+
 REMUS_THIRDPARTY_PRE_INCLUDE
-#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/unordered_map.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
 #include <algorithm>
@@ -25,24 +27,37 @@ namespace detail{
 //------------------------------------------------------------------------------
 class SocketMonitor::WorkerTracker
 {
-  typedef boost::posix_time::ptime ptime;
-
   struct BeatInfo
     {
+    BeatInfo(): Duration(0), LastOccurrence(0), ReportedUnresponsive(false) {}
+
     boost::int64_t Duration;
-    ptime LastOccurrence;
+    boost::int64_t LastOccurrence;
+    bool ReportedUnresponsive;
     };
 
 public:
   remus::common::PollingMonitor PollMonitor;
 
-  std::map< zmq::SocketIdentity, BeatInfo > HeartBeats;
+  boost::unordered_map< zmq::SocketIdentity, BeatInfo > HeartBeats;
+
+  //the time at which each socket becomes unresponsive
+  remus::server::detail::TimerWheel Deadlines;
+
+  //the changes to report on the next call to checkHeartbeats
+  std::vector<zmq::SocketIdentity> NowResponsive;
+  std::vector<zmq::SocketIdentity> NowDead;
 
   typedef std::pair< zmq::SocketIdentity, BeatInfo > InsertType;
-  typedef std::map< zmq::SocketIdentity, BeatInfo >::iterator IteratorType;
+  typedef boost::unordered_map< zmq::SocketIdentity, BeatInfo >::iterator IteratorType;
+  typedef boost::unordered_map< zmq::SocketIdentity, BeatInfo >::const_iterator ConstIteratorType;
 
   WorkerTracker( remus::common::PollingMonitor p):
-    PollMonitor(p)
+    PollMonitor(p),
+    HeartBeats(),
+    Deadlines(),
+    NowResponsive(),
+    NowDead()
   {}
 
   //----------------------------------------------------------------------------
@@ -62,8 +77,6 @@ public:
     IteratorType iter = (this->HeartBeats.insert(key_value)).first;
     BeatInfo& beat = iter->second;
 
-    beat.LastOccurrence = boost::posix_time::microsec_clock::local_time();
-
     //look at our current max time out and the and the current duration that
     //we last polled the worker at. Take the slower of the two.
     //
@@ -73,7 +86,7 @@ public:
     //Plus when we are polling really really fast, but the worker is busy
     //decoding a message that is really large we don't want to mark it as
     //expired, so we always use our max time out
-    beat.Duration = std::max( beat.Duration, PollMonitor.maxTimeOut() );
+    this->beat(socket, beat, std::max( beat.Duration, PollMonitor.maxTimeOut() ));
   }
 
   //----------------------------------------------------------------------------
@@ -85,24 +98,18 @@ public:
     IteratorType iter = (this->HeartBeats.insert(key_value)).first;
     BeatInfo& beat = iter->second;
 
-    beat.LastOccurrence = boost::posix_time::microsec_clock::local_time();
-
     //Now we choose the greatest value between the poller and the sent in duration
     //from the socket.
-    beat.Duration = std::max( dur, PollMonitor.maxTimeOut() );
+    this->beat(socket, beat, std::max( dur, PollMonitor.maxTimeOut() ));
   }
 
   //----------------------------------------------------------------------------
-  boost::int64_t heartbeatInterval(const zmq::SocketIdentity& socket)
+  boost::int64_t heartbeatInterval(const zmq::SocketIdentity& socket) const
   {
-    //insert a new item if it doesn't exist, otherwise get the beatInfo already
-    //in the map
-    if(exists(socket))
+    ConstIteratorType iter = this->HeartBeats.find(socket);
+    if(iter != this->HeartBeats.end())
       {
-      InsertType key_value(socket,BeatInfo());
-      IteratorType iter = (this->HeartBeats.insert(key_value)).first;
-      BeatInfo& beat = iter->second;
-      return beat.Duration;
+      return iter->second.Duration;
       }
     return boost::int64_t(0);
   }
@@ -110,13 +117,18 @@ public:
   //----------------------------------------------------------------------------
   void markAsDead( const zmq::SocketIdentity& socket )
   {
-    this->HeartBeats.erase(socket);
+    if(this->HeartBeats.erase(socket) > 0)
+      {
+      this->Deadlines.cancel(socket);
+      this->NowDead.push_back(socket);
+      }
   }
 
   //----------------------------------------------------------------------------
   bool isMostlyDead( const zmq::SocketIdentity& socket ) const
   {
-    if(this->exists(socket))
+    ConstIteratorType iter = this->HeartBeats.find(socket);
+    if(iter != this->HeartBeats.end())
       {
       //polling has been abnormal give it a pass
       if(PollMonitor.hasAbnormalEvent())
@@ -124,16 +136,75 @@ public:
         return false;
         }
 
-      const BeatInfo& beat = this->HeartBeats.find(socket)->second;
-      const ptime current = boost::posix_time::microsec_clock::local_time();
-      const ptime expectedHB = beat.LastOccurrence +
-                               boost::posix_time::milliseconds(beat.Duration*2);
-      return current > expectedHB;
+      const BeatInfo& beat = iter->second;
+      const boost::int64_t expectedHB = beat.LastOccurrence + (beat.Duration*2);
+      return remus::server::detail::TimerWheel::now() > expectedHB;
       }
 
     //the socket isn't contained here, this socket is dead dead
     return true;
   }
+
+  //----------------------------------------------------------------------------
+  SocketChanges checkHeartbeats()
+  {
+    SocketChanges changes;
+
+    const boost::int64_t now = remus::server::detail::TimerWheel::now();
+    std::vector<zmq::SocketIdentity> expired;
+    this->Deadlines.advance(now, expired);
+
+    typedef std::vector<zmq::SocketIdentity>::const_iterator SIt;
+    for(SIt i = expired.begin(); i != expired.end(); ++i)
+      {
+      if(PollMonitor.hasAbnormalEvent())
+        {
+        //polling has been abnormal give it a pass, and check again
+        //the next time we look at heartbeats
+        this->Deadlines.schedule(*i, now);
+        }
+      else
+        {
+        this->HeartBeats[*i].ReportedUnresponsive = true;
+        changes.Unresponsive.push_back(*i);
+        }
+      }
+
+    //only report sockets that are still in the state they changed to, since
+    //a socket can be marked as dead and than come back before we are called
+    for(SIt i = this->NowResponsive.begin(); i != this->NowResponsive.end(); ++i)
+      {
+      if(this->exists(*i) && !this->HeartBeats[*i].ReportedUnresponsive)
+        { changes.Responsive.push_back(*i); }
+      }
+    for(SIt i = this->NowDead.begin(); i != this->NowDead.end(); ++i)
+      {
+      if(!this->exists(*i))
+        { changes.Dead.push_back(*i); }
+      }
+    this->NowResponsive.clear();
+    this->NowDead.clear();
+
+    return changes;
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  void beat( const zmq::SocketIdentity& socket, BeatInfo& beat,
+             boost::int64_t duration )
+  {
+    beat.LastOccurrence = remus::server::detail::TimerWheel::now();
+    beat.Duration = duration;
+
+    //a socket becomes unresponsive once it has missed two heartbeats
+    this->Deadlines.schedule(socket, beat.LastOccurrence + (beat.Duration*2) + 1);
+
+    if(beat.ReportedUnresponsive)
+      {
+      beat.ReportedUnresponsive = false;
+      this->NowResponsive.push_back(socket);
+      }
+  }
 };
 
 //------------------------------------------------------------------------------
@@ -216,6 +287,12 @@ bool SocketMonitor::isUnresponsive( const zmq::SocketIdentity& socket ) const
   return this->Tracker->isMostlyDead(socket);
 }
 
+//------------------------------------------------------------------------------
+SocketChanges SocketMonitor::checkHeartbeats()
+{
+  return this->Tracker->checkHeartbeats();
+}
+
 }
 }
 }
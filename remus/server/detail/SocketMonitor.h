@@ -20,10 +20,26 @@
 
 #include <remus/common/PollingMonitor.h>
 
+#include <vector>
+
 namespace remus{
 namespace server{
 namespace detail{
 
+//The sockets whose state has changed since the last time the
+//SocketMonitor checked for expired heartbeats
+struct SocketChanges
+{
+  //sockets that have missed their heartbeat
+  std::vector<zmq::SocketIdentity> Unresponsive;
+
+  //sockets that were unresponsive and have sent a heartbeat since
+  std::vector<zmq::SocketIdentity> Responsive;
+
+  //sockets that have been marked as dead
+  std::vector<zmq::SocketIdentity> Dead;
+};
+
 // Provides monitoring that adjusts to the polling frequency of socket ids
 class SocketMonitor
 {
@@ -67,6 +83,13 @@ public:
   //and we should expect sockets to come back.
   bool isUnresponsive( const zmq::SocketIdentity& socket ) const;
 
+  //find all sockets that have missed their heartbeat since the last check,
+  //and return them along with the sockets that have become responsive again
+  //or have been marked as dead. The heartbeat deadlines of sockets are kept
+  //in a timer wheel, so the cost of this is proportional to the number of
+  //sockets that have changed, not the number of sockets being monitored.
+  SocketChanges checkHeartbeats();
+
 private:
   class WorkerTracker;
   boost::shared_ptr<WorkerTracker> Tracker;
@@ -0,0 +1,205 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <remus/server/detail/TimerWheel.h>
+
+//First check if we have a C++11 compiler
+#if defined(REMUS_HAVE_CXX_11)
+  #include <chrono>
+#elif defined(_MSC_VER)
+  # ifndef WIN32_LEAN_AND_MEAN
+  #   define WIN32_LEAN_AND_MEAN
+  # endif
+  #include <windows.h>
+#else
+  #include <time.h>
+#endif
+
+#include <algorithm>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+TimerWheel::TimerWheel(boost::int64_t resolution):
+  Resolution( std::max(resolution, boost::int64_t(1)) ),
+  CurrentTick( TimerWheel::now() / Resolution ),
+  Slots(NumberOfLevels * SlotsPerLevel),
+  Locations()
+{
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t TimerWheel::now()
+{
+#if defined(REMUS_HAVE_CXX_11)
+  //We have detected c++11 support, so use the c++11 steady clock
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#elif defined(_MSC_VER)
+  return static_cast<boost::int64_t>(GetTickCount64());
+#else
+  struct timespec current;
+  clock_gettime(CLOCK_MONOTONIC, &current);
+  return static_cast<boost::int64_t>(current.tv_sec) * 1000 +
+         static_cast<boost::int64_t>(current.tv_nsec / 1000000);
+#endif
+}
+
+//------------------------------------------------------------------------------
+void TimerWheel::schedule(const zmq::SocketIdentity& socket,
+                          boost::int64_t deadline)
+{
+  //round up to the next tick so we never expire a socket early, and
+  //make sure the deadline is after the current tick, as the slot for the
+  //current tick has already been processed
+  boost::int64_t deadlineTick = (deadline + this->Resolution - 1) /
+                                this->Resolution;
+  deadlineTick = std::max(deadlineTick, this->CurrentTick + 1);
+
+  typedef boost::unordered_map<zmq::SocketIdentity,Location>::iterator LocIt;
+  LocIt loc = this->Locations.find(socket);
+  if(loc != this->Locations.end())
+    {
+    loc->second.Position->Deadline = deadlineTick;
+    this->place(this->Slots[loc->second.SlotIndex], loc->second.Position);
+    }
+  else
+    {
+    Slot pending;
+    pending.push_back(Entry(socket,deadlineTick));
+    this->place(pending, pending.begin());
+    }
+}
+
+//------------------------------------------------------------------------------
+bool TimerWheel::cancel(const zmq::SocketIdentity& socket)
+{
+  typedef boost::unordered_map<zmq::SocketIdentity,Location>::iterator LocIt;
+  LocIt loc = this->Locations.find(socket);
+  if(loc == this->Locations.end())
+    {
+    return false;
+    }
+  this->Slots[loc->second.SlotIndex].erase(loc->second.Position);
+  this->Locations.erase(loc);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool TimerWheel::isScheduled(const zmq::SocketIdentity& socket) const
+{
+  return this->Locations.count(socket) > 0;
+}
+
+//------------------------------------------------------------------------------
+void TimerWheel::advance(boost::int64_t time,
+                         std::vector<zmq::SocketIdentity>& expired)
+{
+  const boost::int64_t targetTick = time / this->Resolution;
+  while(this->CurrentTick < targetTick)
+    {
+    if(this->Locations.empty())
+      { //nothing can expire, so skip straight to the target
+      this->CurrentTick = targetTick;
+      break;
+      }
+    this->tick(expired);
+    }
+}
+
+//------------------------------------------------------------------------------
+void TimerWheel::place(Slot& from, Slot::iterator entry)
+{
+  //deadlines further out than the coarsest wheel can represent are placed
+  //at the far end of the coarsest wheel, and placed again when they
+  //cascade down
+  const boost::int64_t maxDelta =
+                  (boost::int64_t(1) << (BitsPerLevel * NumberOfLevels)) - 1;
+  const boost::int64_t delta =
+                  std::min( std::max(entry->Deadline - this->CurrentTick,
+                                     boost::int64_t(0)),
+                            maxDelta );
+  const boost::int64_t placementTick = this->CurrentTick + delta;
+
+  //find the finest wheel whose span covers the deadline
+  int level = 0;
+  while(level < NumberOfLevels-1 &&
+        delta >= (boost::int64_t(1) << (BitsPerLevel * (level+1))))
+    {
+    ++level;
+    }
+
+  const std::size_t index = static_cast<std::size_t>(
+      level * SlotsPerLevel +
+      ((placementTick >> (BitsPerLevel * level)) & (SlotsPerLevel-1)) );
+
+  Slot& to = this->Slots[index];
+  to.splice(to.end(), from, entry);
+
+  Location& loc = this->Locations[entry->Socket];
+  loc.SlotIndex = index;
+  loc.Position = entry;
+}
+
+//------------------------------------------------------------------------------
+void TimerWheel::tick(std::vector<zmq::SocketIdentity>& expired)
+{
+  ++this->CurrentTick;
+
+  //cascade the slots of the coarser wheels that line up with this tick.
+  //We go from the coarsest wheel down so that an entry can cascade through
+  //multiple wheels in a single tick
+  for(int level = NumberOfLevels-1; level > 0; --level)
+    {
+    const boost::int64_t mask =
+                  (boost::int64_t(1) << (BitsPerLevel * level)) - 1;
+    if((this->CurrentTick & mask) == 0)
+      {
+      const std::size_t index = static_cast<std::size_t>(
+          level * SlotsPerLevel +
+          ((this->CurrentTick >> (BitsPerLevel * level)) & (SlotsPerLevel-1)) );
+      Slot pending;
+      pending.swap(this->Slots[index]);
+      while(!pending.empty())
+        {
+        this->place(pending, pending.begin());
+        }
+      }
+    }
+
+  //expire everything in the slot of the finest wheel for this tick. Entries
+  //that were clamped to the far end of the coarsest wheel can land here
+  //before their deadline, and are placed again
+  Slot pending;
+  pending.swap(this->Slots[this->CurrentTick & (SlotsPerLevel-1)]);
+  while(!pending.empty())
+    {
+    Slot::iterator entry = pending.begin();
+    if(entry->Deadline <= this->CurrentTick)
+      {
+      expired.push_back(entry->Socket);
+      this->Locations.erase(entry->Socket);
+      pending.erase(entry);
+      }
+    else
+      {
+      this->place(pending, entry);
+      }
+    }
+}
+
+}
+}
+}
@@ -0,0 +1,109 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#ifndef remus_server_detail_TimerWheel_h
+#define remus_server_detail_TimerWheel_h
+
+#include <remus/proto/zmqSocketIdentity.h>
+
+#include <remus/common/CompilerInformation.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <list>
+#include <vector>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//A hierarchical timer wheel that tracks a deadline for each socket.
+//Deadlines are placed into coarser wheels the further away they are, and
+//cascade down into finer wheels as time advances. Scheduling and
+//cancelling a deadline are constant time, and advancing the wheel only
+//touches the deadlines that are due or that cascade, so finding expired
+//sockets costs O(expired) instead of O(all sockets).
+//
+//All times are in milliseconds of the monotonic clock returned by now().
+class TimerWheel
+{
+public:
+  //construct a wheel whose slots are resolution milliseconds apart.
+  //Deadlines never fire early, but can fire up to one resolution late.
+  explicit TimerWheel(boost::int64_t resolution = 8);
+
+  //returns the current time of the monotonic clock in milliseconds
+  static boost::int64_t now();
+
+  //schedule the socket to expire at the given time, replacing any
+  //existing deadline for the socket
+  void schedule(const zmq::SocketIdentity& socket, boost::int64_t deadline);
+
+  //remove the deadline for the socket. Returns false if the socket
+  //had no deadline
+  bool cancel(const zmq::SocketIdentity& socket);
+
+  //returns true if the socket has a deadline
+  bool isScheduled(const zmq::SocketIdentity& socket) const;
+
+  //returns the number of sockets with a deadline
+  std::size_t size() const { return this->Locations.size(); }
+
+  //advance the wheel to the given time, removing every socket whose
+  //deadline has passed and appending them to expired
+  void advance(boost::int64_t time, std::vector<zmq::SocketIdentity>& expired);
+
+private:
+  enum { BitsPerLevel = 6,
+         SlotsPerLevel = 1 << BitsPerLevel,
+         NumberOfLevels = 4 };
+
+  struct Entry
+  {
+    Entry(const zmq::SocketIdentity& socket, boost::int64_t deadline):
+      Socket(socket),
+      Deadline(deadline)
+      {}
+
+    zmq::SocketIdentity Socket;
+    boost::int64_t Deadline; //in ticks
+  };
+  typedef std::list<Entry> Slot;
+
+  struct Location
+  {
+    std::size_t SlotIndex;
+    Slot::iterator Position;
+  };
+
+  //move the entry from the slot it is in to the slot that matches
+  //its deadline
+  void place(Slot& from, Slot::iterator entry);
+
+  //run a single tick of the wheel
+  void tick(std::vector<zmq::SocketIdentity>& expired);
+
+  boost::int64_t Resolution;
+  boost::int64_t CurrentTick;
+  std::vector<Slot> Slots;
+  boost::unordered_map<zmq::SocketIdentity, Location> Locations;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,225 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <remus/server/detail/Transfers.h>
+
+#include <remus/server/detail/TimerWheel.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/make_shared.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <limits>
+#include <new>
+#include <stdexcept>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+Transfers::State::State(const zmq::SocketIdentity& sender,
+                        boost::uint64_t size,
+                        std::size_t headroom):
+  Sender(sender),
+  Size(size),
+  Headroom(headroom),
+  LastActive(TimerWheel::now()),
+  Data(boost::make_shared<std::string>(headroom, '\0'))
+{
+  //reserve the whole transfer when we know its size, so that the
+  //chunks are copied into the buffer exactly once
+  if(size > 0)
+    {
+    this->Data->reserve(static_cast<std::size_t>(size) + headroom);
+    }
+}
+
+//------------------------------------------------------------------------------
+Transfers::Transfers(boost::uint32_t credits,
+                     boost::int64_t idleTimeout,
+                     boost::uint64_t maxSize):
+  InProgress(),
+  Credits(credits > 0 ? credits : 1),
+  IdleTimeout(idleTimeout),
+  MaxSize(maxSize)
+{
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Transfer Transfers::begin(const zmq::SocketIdentity& sender,
+                                        const remus::proto::Transfer& request,
+                                        std::size_t headroom)
+{
+  if(!request.valid())
+    {
+    return remus::proto::Transfer();
+    }
+
+  TransferMap::iterator i = this->InProgress.find(request.id());
+  if(i == this->InProgress.end())
+    {
+    const bool tooLarge = request.size() > this->MaxSize ||
+        request.size() > std::numeric_limits<std::size_t>::max() - headroom;
+    if(tooLarge)
+      {
+      return remus::proto::Transfer();
+      }
+
+    //the buffer is reserved for the size the sender told us about, which
+    //can still be more than we are able to allocate
+    try
+      {
+      i = this->InProgress.insert(TransferMap::value_type(request.id(),
+                            State(sender, request.size(), headroom))).first;
+      }
+    catch(std::bad_alloc&)
+      {
+      return remus::proto::Transfer();
+      }
+    catch(std::length_error&)
+      {
+      return remus::proto::Transfer();
+      }
+    }
+  else
+    {
+    //the sender may have reconnected with a new identity
+    i->second.Sender = sender;
+    i->second.LastActive = TimerWheel::now();
+    }
+  return this->reply(request.id(), i->second);
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Transfer Transfers::append(const remus::proto::Transfer& chunk,
+                                         const char* data,
+                                         std::size_t size)
+{
+  TransferMap::iterator i = this->InProgress.find(chunk.id());
+  if(!chunk.valid() || i == this->InProgress.end())
+    {
+    return remus::proto::Transfer();
+    }
+
+  State& state = i->second;
+  state.LastActive = TimerWheel::now();
+
+  const bool tooLarge = state.Size > 0 &&
+                        chunk.offset() + size > state.Size;
+  if(tooLarge)
+    {
+    return remus::proto::Transfer();
+    }
+
+  //duplicates and chunks after a gap are dropped, the reply tells the
+  //sender where the data we have ends
+  if(chunk.offset() == state.received() && size > 0)
+    {
+    //transfers that didn't tell us their size grow as chunks arrive
+    if(state.received() + size > this->MaxSize)
+      {
+      this->InProgress.erase(i);
+      return remus::proto::Transfer();
+      }
+    try
+      {
+      state.Data->append(data, size);
+      }
+    catch(std::bad_alloc&)
+      {
+      this->InProgress.erase(i);
+      return remus::proto::Transfer();
+      }
+    catch(std::length_error&)
+      {
+      this->InProgress.erase(i);
+      return remus::proto::Transfer();
+      }
+    }
+  return this->reply(chunk.id(), state);
+}
+
+//------------------------------------------------------------------------------
+bool Transfers::commit(const remus::proto::Transfer& request,
+                       boost::shared_ptr<std::string>& data)
+{
+  TransferMap::iterator i = this->InProgress.find(request.id());
+  if(!request.valid() || i == this->InProgress.end())
+    {
+    return false;
+    }
+
+  //transfers that didn't know their size up front are complete once we
+  //have everything up to the offset of the commit
+  const State& state = i->second;
+  const boost::uint64_t expected = state.Size > 0 ? state.Size
+                                                  : request.offset();
+  if(state.received() != expected)
+    {
+    return false;
+    }
+
+  data = state.Data;
+  this->InProgress.erase(i);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void Transfers::remove(const zmq::SocketIdentity& sender)
+{
+  for(TransferMap::iterator i = this->InProgress.begin();
+      i != this->InProgress.end();)
+    {
+    if(i->second.Sender == sender)
+      {
+      i = this->InProgress.erase(i);
+      }
+    else
+      {
+      ++i;
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+std::size_t Transfers::removeIdle(boost::int64_t now)
+{
+  std::size_t removed = 0;
+  for(TransferMap::iterator i = this->InProgress.begin();
+      i != this->InProgress.end();)
+    {
+    if(now - i->second.LastActive >= this->IdleTimeout)
+      {
+      i = this->InProgress.erase(i);
+      ++removed;
+      }
+    else
+      {
+      ++i;
+      }
+    }
+  return removed;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Transfer Transfers::reply(const boost::uuids::uuid& id,
+                                        const State& state) const
+{
+  return remus::proto::Transfer(id, state.received(), state.Size,
+                                this->Credits);
+}
+
+}
+}
+}
@@ -0,0 +1,135 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#ifndef remus_server_detail_Transfers_h
+#define remus_server_detail_Transfers_h
+
+#include <remus/proto/Transfer.h>
+#include <remus/proto/zmqSocketIdentity.h>
+
+#include <remus/server/detail/uuidHelper.h>
+
+#include <remus/common/CompilerInformation.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/uuid/uuid.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <string>
+#include <vector>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//Assembles the chunked transfers that clients and workers send to the
+//server. Each transfer is collected into a single buffer, which is handed
+//over without another copy once the sender commits the transfer.
+//
+//Chunks must arrive in order. A chunk that doesn't start where the
+//received data ends is ignored, and the reply tells the sender where to
+//resume from. Beginning a transfer that already exists resumes it, which
+//is how a sender that has reconnected continues a transfer.
+//
+//The size a sender declares isn't trusted. Transfers larger than the max
+//size, or that we can't allocate a buffer for, are rejected instead of
+//taking the server down.
+class Transfers
+{
+public:
+  //credits is the number of chunks a sender may have in flight before it
+  //waits for a reply. Transfers that haven't seen a message for
+  //idleTimeout milliseconds are dropped by removeIdle. Transfers can't be
+  //larger than maxSize bytes.
+  explicit Transfers(boost::uint32_t credits = 8,
+                     boost::int64_t idleTimeout = 300000,
+                     boost::uint64_t maxSize = defaultMaxSize());
+
+  //the largest transfer we accept by default, which is 4GB
+  static boost::uint64_t defaultMaxSize()
+    { return boost::uint64_t(4) * 1024 * 1024 * 1024; }
+
+  //the largest transfer in bytes that we accept. Transfers that have
+  //already begun keep going
+  void maxSize(boost::uint64_t bytes) { this->MaxSize = bytes; }
+  boost::uint64_t maxSize() const { return this->MaxSize; }
+
+  //start a transfer, or resume the transfer when we already have one
+  //with the same id. The buffer of a new transfer starts with headroom
+  //bytes that the caller fills in once the transfer is committed.
+  //Returns the reply to send to the sender, which is invalid when the
+  //transfer is larger than the max size or can't be allocated.
+  remus::proto::Transfer begin(const zmq::SocketIdentity& sender,
+                               const remus::proto::Transfer& request,
+                               std::size_t headroom = 0);
+
+  //add a chunk of data to a transfer. Returns the reply to send to the
+  //sender, which is invalid when the transfer is unknown or the chunk
+  //would make it larger than the size given when it began. A transfer
+  //that grows past the max size, or that can't be grown, is dropped
+  remus::proto::Transfer append(const remus::proto::Transfer& chunk,
+                                const char* data,
+                                std::size_t size);
+
+  //finish a transfer, returning its buffer with the headroom at the front.
+  //Returns false and leaves the transfer alone if it is unknown or hasn't
+  //received all of its data.
+  bool commit(const remus::proto::Transfer& request,
+              boost::shared_ptr<std::string>& data);
+
+  //drop every transfer a sender started, used when a worker has died
+  void remove(const zmq::SocketIdentity& sender);
+
+  //drop the transfers that have been idle for too long at the given time
+  //of remus::server::detail::TimerWheel::now(). Returns the number dropped
+  std::size_t removeIdle(boost::int64_t now);
+
+  //the number of transfers in progress
+  std::size_t size() const { return this->InProgress.size(); }
+
+private:
+  struct State
+  {
+    State(const zmq::SocketIdentity& sender,
+          boost::uint64_t size,
+          std::size_t headroom);
+
+    //the number of data bytes we have received
+    boost::uint64_t received() const
+      { return this->Data->size() - this->Headroom; }
+
+    zmq::SocketIdentity Sender;
+    boost::uint64_t Size;
+    std::size_t Headroom;
+    boost::int64_t LastActive;
+    boost::shared_ptr<std::string> Data;
+  };
+
+  remus::proto::Transfer reply(const boost::uuids::uuid& id,
+                               const State& state) const;
+
+  typedef boost::unordered_map<boost::uuids::uuid, State> TransferMap;
+  TransferMap InProgress;
+  boost::uint32_t Credits;
+  boost::int64_t IdleTimeout;
+  boost::uint64_t MaxSize;
+};
+
+}
+}
+}
+
+#endif
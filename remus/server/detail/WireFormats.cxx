@@ -0,0 +1,89 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/WireFormats.h>
+
+#include <remus/server/detail/TimerWheel.h>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+remus::proto::WireFormat::Type WireFormats::negotiate(
+                                    const zmq::SocketIdentity& socket,
+                                    remus::proto::WireFormat::Type requested)
+{
+  //the server understands every format, so we always accept the format
+  //that was asked for. We only store sockets that don't use Text so
+  //that clients who never negotiate cost nothing
+  if(requested == remus::proto::WireFormat::Binary)
+    {
+    State& state = this->Formats[socket];
+    state.Format = requested;
+    state.LastSeen = TimerWheel::now();
+    }
+  else
+    {
+    this->Formats.erase(socket);
+    }
+  return requested;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::WireFormat::Type WireFormats::format(
+                                    const zmq::SocketIdentity& socket) const
+{
+  FormatMap::const_iterator i = this->Formats.find(socket);
+  return (i != this->Formats.end()) ? i->second.Format
+                                    : remus::proto::WireFormat::Text;
+}
+
+//------------------------------------------------------------------------------
+void WireFormats::seen(const zmq::SocketIdentity& socket)
+{
+  FormatMap::iterator i = this->Formats.find(socket);
+  if(i != this->Formats.end())
+    {
+    i->second.LastSeen = TimerWheel::now();
+    }
+}
+
+//------------------------------------------------------------------------------
+void WireFormats::remove(const zmq::SocketIdentity& socket)
+{
+  this->Formats.erase(socket);
+}
+
+//------------------------------------------------------------------------------
+std::size_t WireFormats::removeIdle(boost::int64_t now)
+{
+  std::size_t removed = 0;
+  for(FormatMap::iterator i = this->Formats.begin();
+      i != this->Formats.end();)
+    {
+    if(now - i->second.LastSeen >= this->IdleTimeout)
+      {
+      i = this->Formats.erase(i);
+      ++removed;
+      }
+    else
+      {
+      ++i;
+      }
+    }
+  return removed;
+}
+
+}
+}
+}
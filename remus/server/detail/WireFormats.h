@@ -0,0 +1,81 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_WireFormats_h
+#define remus_server_detail_WireFormats_h
+
+#include <remus/proto/WireFormat.h>
+#include <remus/proto/zmqSocketIdentity.h>
+
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//Tracks the wire format that each client or worker has negotiated with
+//the server. Sockets that have never negotiated use the Text format, which
+//is what every version of remus understands.
+//
+//Clients don't tell the server when they go away, so sockets that haven't
+//been seen for a while can be dropped with removeIdle. A socket that was
+//dropped but is still around gets Text again, which it can always decode.
+class WireFormats
+{
+public:
+  //sockets that haven't been seen for idleTimeout milliseconds are dropped
+  //by removeIdle
+  explicit WireFormats(boost::int64_t idleTimeout = 300000):
+    Formats(),
+    IdleTimeout(idleTimeout)
+  {}
+
+  //record the format a socket asked for, and return the format the server
+  //will use when sending to that socket
+  remus::proto::WireFormat::Type negotiate(const zmq::SocketIdentity& socket,
+                                    remus::proto::WireFormat::Type requested);
+
+  //the format to use when sending to the given socket
+  remus::proto::WireFormat::Type format(const zmq::SocketIdentity& socket) const;
+
+  //note that a message has arrived from the socket, so that it isn't
+  //dropped by removeIdle
+  void seen(const zmq::SocketIdentity& socket);
+
+  //forget the format of a socket, used when a worker has died
+  void remove(const zmq::SocketIdentity& socket);
+
+  //forget the sockets that haven't been seen for too long at the given time
+  //of remus::server::detail::TimerWheel::now(). Returns the number dropped
+  std::size_t removeIdle(boost::int64_t now);
+
+  //the number of sockets that use a format other than Text
+  std::size_t size() const { return this->Formats.size(); }
+
+private:
+  struct State
+  {
+    remus::proto::WireFormat::Type Format;
+    boost::int64_t LastSeen;
+  };
+
+  typedef boost::unordered_map<zmq::SocketIdentity, State> FormatMap;
+  FormatMap Formats;
+  boost::int64_t IdleTimeout;
+};
+
+}
+}
+}
+
+#endif
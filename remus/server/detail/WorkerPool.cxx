@@ -12,6 +12,7 @@
 
 #include <remus/server/detail/WorkerPool.h>
 
+#include <remus/server/detail/TimerWheel.h>
 #include <remus/server/detail/uuidHelper.h>
 #include <remus/proto/zmqSocketIdentity.h>
 
@@ -27,13 +28,23 @@ WorkerPool::WorkerInfo::WorkerInfo(const zmq::SocketIdentity& address,
   NumberOfDesiredJobs(0),
   Reqs(reqs),
   Address(address),
-  IsResponsive(true)
+  IsResponsive(true),
+  IsFull(false),
+  IsIdle(false),
+  IdleHeld(0),
+  IdlePosition()
 {
 }
 
 //------------------------------------------------------------------------------
 WorkerPool::WorkerPool():
-  Pool()
+  Pool(),
+  ByAddress(),
+  Idle(),
+  MaxJobsPerWorker(0),
+  HeldJobs(),
+  HeldCounts(),
+  IdleSince()
 {
 
 }
@@ -44,7 +55,14 @@ bool WorkerPool::addWorker(zmq::SocketIdentity workerIdentity,
 {
   if(!this->haveWorker(workerIdentity,reqs))
     {
-    this->Pool.push_back( WorkerPool::WorkerInfo(workerIdentity,reqs) );
+    if(this->ByAddress.count(workerIdentity) == 0)
+      {
+      this->IdleSince[workerIdentity] = TimerWheel::now();
+      }
+    It worker = this->Pool.insert(this->Pool.end(),
+                                  WorkerPool::WorkerInfo(workerIdentity,reqs));
+    worker->IsFull = this->isFull(workerIdentity);
+    this->ByAddress[workerIdentity].push_back(worker);
     }
   return true;
 }
@@ -65,11 +83,13 @@ remus::common::MeshIOTypeSet WorkerPool::supportedIOTypes() const
 remus::proto::JobRequirementsSet WorkerPool::waitingWorkerRequirements(
                                          remus::common::MeshIOType type) const
 {
+  typedef boost::unordered_map<remus::proto::JobRequirements,
+                               IdleBuckets>::const_iterator IdleIt;
   remus::proto::JobRequirementsSet validWorkers;
-  for(ConstIt i=this->Pool.begin(); i != this->Pool.end(); ++i)
+  for(IdleIt i=this->Idle.begin(); i != this->Idle.end(); ++i)
     {
-    if( i->Reqs.meshTypes() == type && i->isWaitingForWork() )
-      { validWorkers.insert(i->Reqs); }
+    if( i->first.meshTypes() == type && !i->second.empty() )
+      { validWorkers.insert(i->first); }
     }
   return validWorkers;
 }
@@ -78,46 +98,70 @@ remus::proto::JobRequirementsSet WorkerPool::waitingWorkerRequirements(
 bool WorkerPool::haveWaitingWorker(
                            const remus::proto::JobRequirements& reqs) const
 {
-  bool found = false;
-  for(ConstIt i=this->Pool.begin(); !found && i != this->Pool.end(); ++i)
+  typedef boost::unordered_map<remus::proto::JobRequirements,
+                               IdleBuckets>::const_iterator IdleIt;
+  IdleIt idle = this->Idle.find(reqs);
+  return idle != this->Idle.end() && !idle->second.empty();
+}
+
+//------------------------------------------------------------------------------
+std::size_t WorkerPool::waitingWorkerCount(
+                           const remus::proto::JobRequirements& reqs) const
+{
+  typedef boost::unordered_map<remus::proto::JobRequirements,
+                               IdleBuckets>::const_iterator IdleIt;
+  std::size_t count = 0;
+  IdleIt idle = this->Idle.find(reqs);
+  if(idle != this->Idle.end())
     {
-    found = ( i->Reqs == reqs && i->isWaitingForWork() );
+    for(IdleBuckets::const_iterator i = idle->second.begin();
+        i != idle->second.end(); ++i)
+      {
+      count += i->second.size();
+      }
     }
-  return found;
+  return count;
 }
 
 //------------------------------------------------------------------------------
-bool WorkerPool::haveWorker(const zmq::SocketIdentity& address,
-                            const remus::proto::JobRequirements& reqs) const
+std::size_t WorkerPool::busyWorkerCount(
+                           const remus::proto::JobRequirements& reqs) const
 {
-  bool found = false;
-  for(ConstIt i=this->Pool.begin(); !found && i != this->Pool.end(); ++i)
+  std::size_t count = 0;
+  for(ConstIt i=this->Pool.begin(); i != this->Pool.end(); ++i)
     {
-    found = ( i->Address == address && i->Reqs == reqs );
+    if( i->IsResponsive && i->Reqs == reqs &&
+        this->heldJobCount(i->Address) > 0 )
+      { ++count; }
     }
-  return found;
+  return count;
+}
+
+//------------------------------------------------------------------------------
+bool WorkerPool::haveWorker(const zmq::SocketIdentity& address,
+                            const remus::proto::JobRequirements& reqs) const
+{
+  return this->findWorker(address,reqs) != this->Pool.end();
 }
 
 //------------------------------------------------------------------------------
 bool WorkerPool::readyForWork(const zmq::SocketIdentity& address,
                               const remus::proto::JobRequirements& reqs)
 {
-  //a worker can be registered multiple times, we need to iterate
-  //over the entire vector and find the correct address and reqs that match
-  //transform every element that matches the address and reqs to be
-  //waiting for work, If the worker is already waiting for work we increase
-  //the number of jobs it is waiting to take.
-  int count = 0;
-   for(It i=this->Pool.begin(); i != this->Pool.end(); ++i)
+  //a worker can be registered multiple times with different requirements,
+  //so find the registration that matches the address and reqs. If the
+  //worker is already waiting for work we increase the number of jobs it
+  //is waiting to take.
+  It worker = this->findWorker(address,reqs);
+  if(worker == this->Pool.end())
     {
-    if(i->Address == address && i->Reqs == reqs)
-      {
-      i->IsResponsive = true; //mark the worker as responsive
-      i->addJob();
-      ++count;
-      }
+    return false;
     }
-  return (count > 0);
+
+  worker->IsResponsive = true; //mark the worker as responsive
+  worker->addJob();
+  this->updateIdleState(worker);
+  return true;
 }
 
 
@@ -125,50 +169,165 @@ bool WorkerPool::readyForWork(const zmq::SocketIdentity& address,
 zmq::SocketIdentity WorkerPool::takeWorker(
                              const remus::proto::JobRequirements& reqs)
 {
-  bool found = false;
-  It i;
-  for(i=this->Pool.begin(); !found && i != this->Pool.end(); ++i)
-    {
-    found = (i->Reqs == reqs) && (i->isWaitingForWork());
-    }
-
   zmq::SocketIdentity workerIdentity;
 
-  if(found)
+  typedef boost::unordered_map<remus::proto::JobRequirements,
+                               IdleBuckets>::iterator IdleIt;
+  IdleIt idle = this->Idle.find(reqs);
+  if(idle != this->Idle.end())
     {
-    --i; //we have to decrement the iterator, as the forloop increments it one
-    //past the found position.
-
-    //take the worker id as it matches the reqs
-    workerIdentity = zmq::SocketIdentity(i->Address);
-    i->takesJob();
+    //take the first worker of those that hold the fewest jobs, so that
+    //workers which asked for jobs ahead of time only get them once the
+    //other waiting workers have a job as well
+    It worker = idle->second.begin()->second.front();
+    workerIdentity = zmq::SocketIdentity(worker->Address);
+    worker->takesJob();
 
     //now that the worker has taken the job, we move him to the back of
-    //the vector so he is the last worker to take a job of that type again,
+    //the idle list so he is the last worker to take a job of that type again,
     //this allows us to handle multiple workers taking jobs
-    std::rotate(this->Pool.begin(), this->Pool.begin() + 1,this->Pool.end());
+    this->removeIdle(worker);
+    this->updateIdleState(worker);
     }
 
   return workerIdentity;
 }
 
 //------------------------------------------------------------------------------
-void WorkerPool::purgeDeadWorkers(remus::server::detail::SocketMonitor monitor)
+remus::proto::JobRequirementsSet WorkerPool::maxJobsPerWorker(std::size_t count)
 {
+  this->MaxJobsPerWorker = count;
+
+  remus::proto::JobRequirementsSet nowWaiting;
+  typedef boost::unordered_map<zmq::SocketIdentity,
+                               std::vector<It> >::const_iterator AddressIt;
+  for(AddressIt i=this->ByAddress.begin(); i != this->ByAddress.end(); ++i)
+    {
+    this->markFull(i->first, nowWaiting);
+    }
+  return nowWaiting;
+}
+
+//------------------------------------------------------------------------------
+void WorkerPool::holdJob(const zmq::SocketIdentity& address,
+                         const boost::uuids::uuid& id)
+{
+  const bool added = this->HeldJobs.insert(std::make_pair(id,address)).second;
+  if(added)
+    {
+    ++this->HeldCounts[address];
+
+    //holding a job can only fill a worker up, so nothing starts waiting
+    remus::proto::JobRequirementsSet nowWaiting;
+    this->markFull(address, nowWaiting);
+    }
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobRequirementsSet WorkerPool::releaseJob(
+                                                 const boost::uuids::uuid& id)
+{
+  remus::proto::JobRequirementsSet nowWaiting;
+
+  typedef boost::unordered_map<boost::uuids::uuid,
+                               zmq::SocketIdentity>::iterator HeldIt;
+  HeldIt job = this->HeldJobs.find(id);
+  if(job == this->HeldJobs.end())
+    {
+    return nowWaiting;
+    }
+
+  const zmq::SocketIdentity address = job->second;
+  this->HeldJobs.erase(job);
+
+  typedef boost::unordered_map<zmq::SocketIdentity,
+                               std::size_t>::iterator CountIt;
+  CountIt count = this->HeldCounts.find(address);
+  if(count != this->HeldCounts.end() && --count->second == 0)
+    {
+    this->HeldCounts.erase(count);
+    if(this->ByAddress.count(address) > 0)
+      {
+      this->IdleSince[address] = TimerWheel::now();
+      }
+    }
+
+  this->markFull(address, nowWaiting);
+  return nowWaiting;
+}
+
+//------------------------------------------------------------------------------
+std::size_t WorkerPool::heldJobCount(const zmq::SocketIdentity& address) const
+{
+  typedef boost::unordered_map<zmq::SocketIdentity,
+                               std::size_t>::const_iterator CountIt;
+  CountIt count = this->HeldCounts.find(address);
+  return count != this->HeldCounts.end() ? count->second : std::size_t(0);
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobRequirementsSet WorkerPool::purgeDeadWorkers(
+                             const remus::server::detail::SocketChanges& changes)
+{
+  typedef std::vector<zmq::SocketIdentity>::const_iterator SIt;
+
+  remus::proto::JobRequirementsSet nowWaiting;
+  for(SIt i=changes.Unresponsive.begin(); i != changes.Unresponsive.end(); ++i)
+    {
+    this->markResponsive(*i, false, nowWaiting);
+    }
+  for(SIt i=changes.Responsive.begin(); i != changes.Responsive.end(); ++i)
+    {
+    this->markResponsive(*i, true, nowWaiting);
+    }
+
   //Remove all workers that we know are really dead
-  WorkerPool::DeadWorkers dead(monitor);
+  for(SIt i=changes.Dead.begin(); i != changes.Dead.end(); ++i)
+    {
+    this->removeWorker(*i);
+    }
+  return nowWaiting;
+}
 
-  //remove if moves all bad items to end of the vector and returns
-  //an iterator to the new end. Remove if is easiest way to remove from middle
-  It newEnd = std::remove_if(this->Pool.begin(),this->Pool.end(),dead);
+//------------------------------------------------------------------------------
+std::vector<zmq::SocketIdentity> WorkerPool::idleWorkers(
+                              const remus::proto::JobRequirements& reqs,
+                              boost::int64_t idleFor,
+                              boost::int64_t now) const
+{
+  typedef boost::unordered_map<remus::proto::JobRequirements,
+                               IdleBuckets>::const_iterator IdleIt;
+  typedef boost::unordered_map<zmq::SocketIdentity,
+                               boost::int64_t>::const_iterator SinceIt;
 
-  for(It i=this->Pool.begin(); i != newEnd; ++i)
+  //workers waiting for work can still hold jobs they asked for ahead
+  //of time, those aren't idle
+  std::vector< std::pair<boost::int64_t, zmq::SocketIdentity> > idle;
+  IdleIt waiting = this->Idle.find(reqs);
+  IdleBuckets::const_iterator unloaded;
+  if(waiting != this->Idle.end() &&
+     (unloaded = waiting->second.find(0)) != waiting->second.end())
     {
-    i->IsResponsive = !monitor.isUnresponsive(i->Address);
+    for(IdleList::const_iterator i = unloaded->second.begin();
+        i != unloaded->second.end(); ++i)
+      {
+      SinceIt since = this->IdleSince.find((*i)->Address);
+      if(since != this->IdleSince.end() &&
+         now - since->second >= idleFor)
+        {
+        idle.push_back(std::make_pair(since->second, (*i)->Address));
+        }
+      }
     }
+  std::sort(idle.begin(), idle.end());
 
-  //erase all the dead workers to free up space
-  this->Pool.erase(newEnd,this->Pool.end());
+  std::vector<zmq::SocketIdentity> workers;
+  workers.reserve(idle.size());
+  for(std::size_t i=0; i < idle.size(); ++i)
+    {
+    workers.push_back(idle[i].second);
+    }
+  return workers;
 }
 
 //------------------------------------------------------------------------------
@@ -210,8 +369,176 @@ std::set<zmq::SocketIdentity> WorkerPool::allWorkersWantingWork() const
   return workerAddresses;
 }
 
+//------------------------------------------------------------------------------
+WorkerPool::It WorkerPool::findWorker(const zmq::SocketIdentity& address,
+                                      const remus::proto::JobRequirements& reqs)
+{
+  typedef boost::unordered_map<zmq::SocketIdentity,
+                               std::vector<It> >::iterator AddressIt;
+  AddressIt registrations = this->ByAddress.find(address);
+  if(registrations != this->ByAddress.end())
+    {
+    typedef std::vector<It>::const_iterator RegIt;
+    for(RegIt i=registrations->second.begin();
+        i != registrations->second.end(); ++i)
+      {
+      if((*i)->Reqs == reqs)
+        {
+        return *i;
+        }
+      }
+    }
+  return this->Pool.end();
+}
 
+//------------------------------------------------------------------------------
+WorkerPool::ConstIt WorkerPool::findWorker(
+                          const zmq::SocketIdentity& address,
+                          const remus::proto::JobRequirements& reqs) const
+{
+  return const_cast<WorkerPool*>(this)->findWorker(address,reqs);
+}
 
+//------------------------------------------------------------------------------
+void WorkerPool::markResponsive(const zmq::SocketIdentity& address,
+                                bool responsive,
+                                remus::proto::JobRequirementsSet& nowWaiting)
+{
+  typedef boost::unordered_map<zmq::SocketIdentity,
+                               std::vector<It> >::iterator AddressIt;
+  AddressIt registrations = this->ByAddress.find(address);
+  if(registrations == this->ByAddress.end())
+    {
+    return;
+    }
+
+  typedef std::vector<It>::const_iterator RegIt;
+  for(RegIt i=registrations->second.begin();
+      i != registrations->second.end(); ++i)
+    {
+    (*i)->IsResponsive = responsive;
+    if(this->updateIdleState(*i))
+      {
+      nowWaiting.insert((*i)->Reqs);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void WorkerPool::markFull(const zmq::SocketIdentity& address,
+                          remus::proto::JobRequirementsSet& nowWaiting)
+{
+  typedef boost::unordered_map<zmq::SocketIdentity,
+                               std::vector<It> >::iterator AddressIt;
+  AddressIt registrations = this->ByAddress.find(address);
+  if(registrations == this->ByAddress.end())
+    {
+    return;
+    }
+
+  const bool full = this->isFull(address);
+  typedef std::vector<It>::const_iterator RegIt;
+  for(RegIt i=registrations->second.begin();
+      i != registrations->second.end(); ++i)
+    {
+    (*i)->IsFull = full;
+    if(this->updateIdleState(*i))
+      {
+      nowWaiting.insert((*i)->Reqs);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+bool WorkerPool::isFull(const zmq::SocketIdentity& address) const
+{
+  return this->MaxJobsPerWorker > 0 &&
+         this->heldJobCount(address) >= this->MaxJobsPerWorker;
+}
+
+//------------------------------------------------------------------------------
+void WorkerPool::removeWorker(const zmq::SocketIdentity& address)
+{
+  typedef boost::unordered_map<zmq::SocketIdentity,
+                               std::vector<It> >::iterator AddressIt;
+  AddressIt registrations = this->ByAddress.find(address);
+  if(registrations == this->ByAddress.end())
+    {
+    return;
+    }
+
+  typedef std::vector<It>::const_iterator RegIt;
+  for(RegIt i=registrations->second.begin();
+      i != registrations->second.end(); ++i)
+    {
+    (*i)->NumberOfDesiredJobs = 0;
+    this->updateIdleState(*i);
+    this->Pool.erase(*i);
+    }
+  this->ByAddress.erase(registrations);
+
+  //a dead worker doesn't hold its jobs anymore
+  typedef boost::unordered_map<boost::uuids::uuid,
+                               zmq::SocketIdentity>::iterator HeldIt;
+  for(HeldIt i=this->HeldJobs.begin(); i != this->HeldJobs.end();)
+    {
+    if(i->second == address)
+      {
+      i = this->HeldJobs.erase(i);
+      }
+    else
+      {
+      ++i;
+      }
+    }
+  this->HeldCounts.erase(address);
+  this->IdleSince.erase(address);
+}
+
+//------------------------------------------------------------------------------
+bool WorkerPool::updateIdleState(It worker)
+{
+  const bool wasIdle = worker->IsIdle;
+  const bool waiting = worker->isWaitingForWork();
+  const std::size_t held = this->heldJobCount(worker->Address);
+  if(wasIdle && (!waiting || held != worker->IdleHeld))
+    {
+    this->removeIdle(worker);
+    }
+
+  if(waiting && !worker->IsIdle)
+    {
+    IdleList& idle = this->Idle[worker->Reqs][held];
+    worker->IdlePosition = idle.insert(idle.end(), worker);
+    worker->IdleHeld = held;
+    worker->IsIdle = true;
+    }
+  return waiting && !wasIdle;
+}
+
+//------------------------------------------------------------------------------
+void WorkerPool::removeIdle(It worker)
+{
+  if(!worker->IsIdle)
+    {
+    return;
+    }
+
+  typedef boost::unordered_map<remus::proto::JobRequirements,
+                               IdleBuckets>::iterator IdleIt;
+  IdleIt idle = this->Idle.find(worker->Reqs);
+  IdleBuckets::iterator bucket = idle->second.find(worker->IdleHeld);
+  bucket->second.erase(worker->IdlePosition);
+  if(bucket->second.empty())
+    {
+    idle->second.erase(bucket);
+    }
+  if(idle->second.empty())
+    {
+    this->Idle.erase(idle);
+    }
+  worker->IsIdle = false;
+}
 
 }
 }
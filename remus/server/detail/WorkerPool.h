@@ -18,6 +18,12 @@
 
 #include <remus/server/detail/SocketMonitor.h>
 
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <list>
+#include <map>
 #include <set>
 #include <vector>
 
@@ -25,6 +31,17 @@ namespace remus{
 namespace server{
 namespace detail{
 
+//The pool of workers that have registered with the server. Workers are
+//indexed by their socket identity, and the workers that are waiting for
+//work are kept in lists per JobRequirements, one for each number of jobs
+//the workers in it hold. This makes registering, marking ready, and taking
+//a worker cheap operations. Workers are taken round robin for each
+//JobRequirements, preferring the workers that hold the fewest jobs.
+//
+//A worker holds every job it has been sent until the job finishes, fails,
+//is terminated, or expires. Workers that ask for jobs ahead of time hold
+//more than one, and can be limited in how many they hold at once so that
+//a single worker can't take every job that is queued.
 class WorkerPool
 {
 public:
@@ -47,6 +64,15 @@ public:
   //do we have any worker waiting to take this type of job
   bool haveWaitingWorker(const remus::proto::JobRequirements& reqs) const;
 
+  //the number of workers waiting to take this type of job
+  std::size_t waitingWorkerCount(
+                        const remus::proto::JobRequirements& reqs) const;
+
+  //the number of responsive workers registered for this type of job that
+  //hold at least one job
+  std::size_t busyWorkerCount(
+                        const remus::proto::JobRequirements& reqs) const;
+
   //do we have a worker with this address?
   bool haveWorker(const zmq::SocketIdentity& address,
                   const remus::proto::JobRequirements& reqs) const;
@@ -58,12 +84,50 @@ public:
 
   //returns the worker address and marks that the worker has taken a job.
   //this doesn't remove the worker from the worker pool, it just decrements
-  //the number of jobs the worker is allowed to take, and puts in at the worker
-  //queue
+  //the number of jobs the worker is allowed to take, and moves the worker
+  //to the back of the workers waiting for this type of job. Of the workers
+  //waiting for this type of job the one holding the fewest jobs that has
+  //waited the longest with that many jobs is taken
   zmq::SocketIdentity takeWorker(const remus::proto::JobRequirements& reqs);
 
-  //remove all workers that haven't responded based on the passed in monitor
-  void purgeDeadWorkers(remus::server::detail::SocketMonitor monitor);
+  //set the most jobs a worker can hold at once. Workers holding that many
+  //jobs aren't taken until they release one, while the jobs they asked for
+  //stay waiting. Zero, the default, means workers can hold any number
+  //of jobs. Returns the requirements that have waiting workers again
+  //because the limit was raised
+  remus::proto::JobRequirementsSet maxJobsPerWorker(std::size_t count);
+  std::size_t maxJobsPerWorker() const { return MaxJobsPerWorker; }
+
+  //mark that the worker with the given address holds the job
+  void holdJob(const zmq::SocketIdentity& address,
+               const boost::uuids::uuid& id);
+
+  //mark that the worker holding the job doesn't hold it anymore. Releasing
+  //a job that isn't held does nothing. Returns the requirements that have
+  //waiting workers again because the worker dropped below the job limit
+  remus::proto::JobRequirementsSet releaseJob(const boost::uuids::uuid& id);
+
+  //the number of jobs the worker with the given address holds
+  std::size_t heldJobCount(const zmq::SocketIdentity& address) const;
+
+  //remove all workers that the socket monitor has marked as dead,
+  //and update which workers are responsive. Returns the requirements that
+  //have waiting workers again because a worker became responsive
+  remus::proto::JobRequirementsSet purgeDeadWorkers(
+                             const remus::server::detail::SocketChanges& changes);
+
+  //return the workers waiting to take this type of job that haven't held
+  //a job for at least idleFor milliseconds, as of now in milliseconds of
+  //remus::server::detail::TimerWheel::now(). The workers that have been
+  //idle the longest come first
+  std::vector<zmq::SocketIdentity> idleWorkers(
+                        const remus::proto::JobRequirements& reqs,
+                        boost::int64_t idleFor,
+                        boost::int64_t now) const;
+
+  //remove every registration of a worker, such as a worker that has been
+  //told to terminate. The worker doesn't hold its jobs anymore
+  void removeWorker(const zmq::SocketIdentity& address);
 
   //return the socket identity of all workers including workers that are
   //unresponsive
@@ -76,34 +140,82 @@ public:
   std::set<zmq::SocketIdentity> allWorkersWantingWork() const;
 
 private:
+  struct WorkerInfo;
+  typedef std::list<WorkerInfo>::const_iterator ConstIt;
+  typedef std::list<WorkerInfo>::iterator It;
+  typedef std::list<It> IdleList;
+
+  //the workers waiting for a type of job, by the number of jobs they hold
+  typedef std::map<std::size_t, IdleList> IdleBuckets;
+
   struct WorkerInfo
   {
     int NumberOfDesiredJobs;
     remus::proto::JobRequirements Reqs;
     zmq::SocketIdentity Address;
     bool IsResponsive; //as in we are getting heartbeating from the worker
+    bool IsFull; //holds as many jobs as a worker is allowed to
+
+    //location of the worker in the list of workers waiting for Reqs
+    //that hold IdleHeld jobs, only valid when IsIdle is true
+    bool IsIdle;
+    std::size_t IdleHeld;
+    IdleList::iterator IdlePosition;
 
     WorkerInfo(const zmq::SocketIdentity& address,
                const remus::proto::JobRequirements& type);
 
-    bool isWaitingForWork() const { return NumberOfDesiredJobs > 0 && IsResponsive; }
+    bool isWaitingForWork() const
+      { return NumberOfDesiredJobs > 0 && IsResponsive && !IsFull; }
     void addJob() { ++NumberOfDesiredJobs; }
     void takesJob() { --NumberOfDesiredJobs; }
   };
 
-  struct DeadWorkers
-  {
-   remus::server::detail::SocketMonitor Monitor;
-   DeadWorkers(remus::server::detail::SocketMonitor monitor):
-     Monitor(monitor){}
-   inline bool operator()(const WorkerPool::WorkerInfo& worker)
-    { return Monitor.isDead(worker.Address); }
-  };
+  //find the worker with the given address and requirements
+  It findWorker(const zmq::SocketIdentity& address,
+                const remus::proto::JobRequirements& reqs);
+  ConstIt findWorker(const zmq::SocketIdentity& address,
+                     const remus::proto::JobRequirements& reqs) const;
+
+  //update the responsive state of every registration of a worker, adding
+  //the requirements of registrations that are now waiting to nowWaiting
+  void markResponsive(const zmq::SocketIdentity& address, bool responsive,
+                      remus::proto::JobRequirementsSet& nowWaiting);
+
+  //update if every registration of a worker holds as many jobs as it is
+  //allowed to, adding the requirements of registrations that are now
+  //waiting to nowWaiting
+  void markFull(const zmq::SocketIdentity& address,
+                remus::proto::JobRequirementsSet& nowWaiting);
+
+  //is a worker holding as many jobs as it is allowed to
+  bool isFull(const zmq::SocketIdentity& address) const;
+
+  //add or remove the worker from the list of workers waiting for work
+  //based on if it is currently waiting for work, and move it to the list
+  //for the number of jobs it now holds. Returns true when the worker
+  //wasn't waiting for work before
+  bool updateIdleState(It worker);
+
+  //take the worker out of the lists of workers waiting for work
+  void removeIdle(It worker);
+
+  std::list<WorkerInfo> Pool;
+
+  //a worker can be registered multiple times with different requirements
+  boost::unordered_map<zmq::SocketIdentity, std::vector<It> > ByAddress;
+
+  //the workers waiting for work for each requirements, in the order
+  //they will be taken. Requirements without waiting workers aren't kept
+  boost::unordered_map<remus::proto::JobRequirements, IdleBuckets> Idle;
 
+  //the worker holding each job, and the number of jobs each worker holds
+  std::size_t MaxJobsPerWorker;
+  boost::unordered_map<boost::uuids::uuid, zmq::SocketIdentity> HeldJobs;
+  boost::unordered_map<zmq::SocketIdentity, std::size_t> HeldCounts;
 
-  typedef std::vector<WorkerInfo>::const_iterator ConstIt;
-  typedef std::vector<WorkerInfo>::iterator It;
-  std::vector<WorkerInfo> Pool;
+  //when each worker last stopped holding jobs, or registered
+  boost::unordered_map<zmq::SocketIdentity, boost::int64_t> IdleSince;
 };
 
 }
@@ -14,6 +14,8 @@
 #include <remus/common/SleepFor.h>
 #include <remus/testing/Testing.h>
 
+#include <boost/make_shared.hpp>
+
 
 namespace {
 
@@ -271,14 +273,14 @@ void verify_refresh_jobs()
   for(int i=0; i < 5; ++i)
     { REMUS_ASSERT( (jobs.add(socketIds_used[i], uuids_used[i]) == true) ); }
 
-  jobs.markExpiredJobs( monitor );
+  jobs.markExpiredJobs( monitor.checkHeartbeats(), monitor );
   for(int i=0; i < 5; ++i)
     { REMUS_ASSERT( (jobs.status(uuids_used[i]).status() == remus::QUEUED) ); }
 
   remus::common::SleepForMillisec(100);
 
   //even after 100 milliseconds we aren't expired
-  jobs.markExpiredJobs( monitor );
+  jobs.markExpiredJobs( monitor.checkHeartbeats(), monitor );
   for(int i=0; i < 5; ++i)
     { REMUS_ASSERT( (jobs.status(uuids_used[i]).status() == remus::QUEUED) ); }
 
@@ -291,7 +293,7 @@ void verify_refresh_jobs()
 
   //even after 2 more seconds we aren't expired, since we sent
   //refresh / heartbeats
-  jobs.markExpiredJobs( monitor );
+  jobs.markExpiredJobs( monitor.checkHeartbeats(), monitor );
   for(int i=0; i < 5; ++i)
     { REMUS_ASSERT( (jobs.status(uuids_used[i]).status() == remus::QUEUED) ); }
 
@@ -305,7 +307,7 @@ void verify_refresh_jobs()
   jobs.updateResult(result_with_data);
 
   monitor.refresh( finishedJobSocketId );
-  jobs.markExpiredJobs( monitor );
+  jobs.markExpiredJobs( monitor.checkHeartbeats(), monitor );
   REMUS_ASSERT( (jobs.status(finished_job_uuid).status() == remus::FINISHED) );
 }
 
@@ -333,7 +335,7 @@ void verify_expire_jobs()
   for(int i=0; i < 5; ++i)
     { REMUS_ASSERT( (jobs.add(socketIds_used[i], uuids_used[i]) == true) ); }
 
-  jobs.markExpiredJobs( monitor );
+  jobs.markExpiredJobs( monitor.checkHeartbeats(), monitor );
   for(int i=0; i < 5; ++i)
     { REMUS_ASSERT( (jobs.status(uuids_used[i]).status() == remus::QUEUED) ); }
 
@@ -346,7 +348,7 @@ void verify_expire_jobs()
       { monitor.refresh(socketIds_used[j]); }
     }
 
-  jobs.markExpiredJobs( monitor );
+  jobs.markExpiredJobs( monitor.checkHeartbeats(), monitor );
   for(int i=0; i < 3; ++i)
     { REMUS_ASSERT( (jobs.status(uuids_used[i]).status() == remus::QUEUED) ); }
   for(int i=3; i < 5; ++i)
@@ -354,6 +356,108 @@ void verify_expire_jobs()
 
 }
 
+void verify_expire_jobs_of_unresponsive_workers()
+{
+  //a job given to a worker that has already been reported as unresponsive
+  //must still expire
+  typedef remus::server::detail::SocketMonitor MonitorType;
+  MonitorType monitor = make_Monitor( );
+
+  const zmq::SocketIdentity unresponsive = make_socketId();
+  const zmq::SocketIdentity responsive = make_socketId();
+  monitor.refresh(unresponsive);
+  monitor.refresh(responsive);
+
+  remus::server::detail::ActiveJobs jobs;
+  for(int i=0; i < 3; ++i)
+    {
+    remus::common::SleepForMillisec(100);
+    monitor.refresh(responsive);
+    }
+
+  //the worker is reported as unresponsive before it has any jobs
+  remus::server::detail::SocketChanges changes = monitor.checkHeartbeats();
+  REMUS_ASSERT( (changes.Unresponsive.size() == 1) );
+  REMUS_ASSERT( (jobs.markExpiredJobs( changes, monitor ).size() == 0) );
+
+  const boost::uuids::uuid late_job = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid good_job = remus::testing::UUIDGenerator();
+  jobs.add(unresponsive, late_job);
+  jobs.add(responsive, good_job);
+
+  changes = monitor.checkHeartbeats();
+  REMUS_ASSERT( (changes.Unresponsive.size() == 0) );
+  REMUS_ASSERT( (jobs.markExpiredJobs( changes, monitor ).size() == 1) );
+  REMUS_ASSERT( (jobs.status(late_job).status() == remus::EXPIRED) );
+  REMUS_ASSERT( (jobs.status(good_job).status() == remus::QUEUED) );
+}
+
+void verify_fail_jobs()
+{
+  remus::server::detail::ActiveJobs jobs;
+  const zmq::SocketIdentity failed = make_socketId();
+  const zmq::SocketIdentity other = make_socketId();
+
+  std::vector< boost::uuids::uuid > uuids_used;
+  for(int i=0; i < 3; ++i)
+    {
+    uuids_used.push_back( remus::testing::UUIDGenerator() );
+    REMUS_ASSERT( (jobs.add(failed, uuids_used[i]) == true) );
+    }
+  uuids_used.push_back( remus::testing::UUIDGenerator() );
+  REMUS_ASSERT( (jobs.add(other, uuids_used[3]) == true) );
+
+  //finished jobs stay finished
+  jobs.updateResult( remus::proto::make_JobResult(uuids_used[2],"data") );
+
+  std::vector< remus::proto::JobStatus > failedJobs =
+                            jobs.markFailedJobs(failed, "out of memory");
+  REMUS_ASSERT( (failedJobs.size() == 2) );
+  for(int i=0; i < 2; ++i)
+    {
+    REMUS_ASSERT( (jobs.status(uuids_used[i]).failed() == true) );
+    REMUS_ASSERT( (jobs.status(uuids_used[i]).progress().message() == "out of memory") );
+    }
+  REMUS_ASSERT( (jobs.status(uuids_used[2]).finished() == true) );
+  REMUS_ASSERT( (jobs.status(uuids_used[3]).queued() == true) );
+
+  //jobs that have failed aren't failed again
+  REMUS_ASSERT( (jobs.markFailedJobs(failed, "again").size() == 0) );
+  REMUS_ASSERT( (jobs.markFailedJobs(make_socketId(), "none").size() == 0) );
+}
+
+void verify_encoded_results()
+{
+  remus::server::detail::ActiveJobs jobs;
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const zmq::SocketIdentity socketId = make_socketId();
+  jobs.add(socketId, id);
+
+  //results stored without their encoding have an empty encoded result
+  remus::proto::JobResult result = remus::proto::make_JobResult(id,"data");
+  jobs.updateResult(result);
+  REMUS_ASSERT( (jobs.encodedResult(id).empty()) );
+
+  //results stored with their encoding keep the buffer alive, and remember
+  //the wire format it was encoded with
+  boost::shared_ptr<std::string> wire =
+      boost::make_shared<std::string>(remus::proto::to_binary(result));
+  const char* wire_data = wire->data();
+  jobs.updateResult(result,
+      remus::server::detail::EncodedResult(wire->data(),wire->size(),wire));
+  wire.reset();
+
+  const remus::server::detail::EncodedResult& encoded = jobs.encodedResult(id);
+  REMUS_ASSERT( (!encoded.empty()) );
+  REMUS_ASSERT( (encoded.Data == wire_data) );
+  REMUS_ASSERT( (encoded.Format == remus::proto::WireFormat::Binary) );
+
+  remus::proto::JobResult decoded =
+                    remus::proto::to_JobResult(encoded.Data,encoded.Size);
+  REMUS_ASSERT( (decoded.id() == id) );
+  REMUS_ASSERT( (std::string(decoded.data(),decoded.dataSize()) == "data") );
+}
+
 } //namespace
 
 int UnitTestActiveJobs(int, char *[])
@@ -368,5 +472,11 @@ int UnitTestActiveJobs(int, char *[])
 
   verify_expire_jobs();
 
+  verify_expire_jobs_of_unresponsive_workers();
+
+  verify_fail_jobs();
+
+  verify_encoded_results();
+
   return 0;
 }
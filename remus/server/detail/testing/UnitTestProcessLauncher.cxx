@@ -0,0 +1,103 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/ProcessLauncher.h>
+
+#include <remus/testing/Testing.h>
+
+#include <boost/make_shared.hpp>
+
+#include <vector>
+
+namespace {
+
+typedef remus::common::ExecuteProcess ExecuteProcess;
+typedef boost::shared_ptr<ExecuteProcess> ExecuteProcessPtr;
+
+//a process that fails to start, which lets us check that the launcher
+//executes it without depending on any executable being around
+ExecuteProcessPtr make_process()
+{
+  return boost::make_shared<ExecuteProcess>(
+                              "remus_process_launcher_missing_executable");
+}
+
+void verify_launch_on_calling_thread()
+{
+  remus::server::detail::ProcessLauncher launcher(0);
+
+  ExecuteProcessPtr process = make_process();
+  boost::shared_future<void> launched = launcher.launch(process);
+
+  //the process has been executed before launch returns
+  REMUS_ASSERT( launched.is_ready() );
+  REMUS_ASSERT( !launched.has_exception() );
+  REMUS_ASSERT( (launcher.pendingLaunches() == 0) );
+  REMUS_ASSERT( (launcher.threadCount() == 0) );
+  REMUS_ASSERT( !process->isAlive() );
+}
+
+void verify_launch_on_helper_threads()
+{
+  const std::size_t numProcesses = 64;
+  remus::server::detail::ProcessLauncher launcher(4);
+  REMUS_ASSERT( (launcher.maxThreads() == 4) );
+
+  std::vector< ExecuteProcessPtr > processes;
+  std::vector< boost::shared_future<void> > launched;
+  for(std::size_t i=0; i < numProcesses; ++i)
+    {
+    processes.push_back( make_process() );
+    launched.push_back( launcher.launch(processes.back()) );
+    }
+
+  //we never start more threads than we are allowed
+  REMUS_ASSERT( (launcher.threadCount() > 0) );
+  REMUS_ASSERT( (launcher.threadCount() <= 4) );
+
+  launcher.waitForLaunches();
+  REMUS_ASSERT( (launcher.pendingLaunches() == 0) );
+  for(std::size_t i=0; i < numProcesses; ++i)
+    {
+    REMUS_ASSERT( launched[i].is_ready() );
+    REMUS_ASSERT( !launched[i].has_exception() );
+    REMUS_ASSERT( !processes[i]->isAlive() );
+    }
+}
+
+void verify_destruction_waits_for_launches()
+{
+  std::vector< boost::shared_future<void> > launched;
+  {
+  remus::server::detail::ProcessLauncher launcher(2);
+  for(std::size_t i=0; i < 16; ++i)
+    {
+    launched.push_back( launcher.launch(make_process()) );
+    }
+  }
+
+  //every queued process was executed before the launcher went away
+  for(std::size_t i=0; i < launched.size(); ++i)
+    {
+    REMUS_ASSERT( launched[i].is_ready() );
+    }
+}
+
+}
+
+int UnitTestProcessLauncher(int, char *[])
+{
+  verify_launch_on_calling_thread();
+  verify_launch_on_helper_threads();
+  verify_destruction_waits_for_launches();
+  return 0;
+}
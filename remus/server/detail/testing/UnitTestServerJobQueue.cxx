@@ -12,9 +12,16 @@
 #include <remus/server/detail/JobQueue.h>
 
 #include <remus/common/ContentTypes.h>
+#include <remus/common/SleepFor.h>
+#include <remus/proto/zmq.hpp>
+#include <remus/server/detail/TimerWheel.h>
 #include <remus/server/detail/uuidHelper.h>
 #include <remus/testing/Testing.h>
 
+#include <boost/make_shared.hpp>
+
+#include <cstring>
+
 
 namespace {
 
@@ -212,6 +219,195 @@ void verify_dispatch_jobs()
   REMUS_ASSERT( (queue.waitingJobRequirements().count(worker_type3D) == 0) );
 }
 
+void verify_remove_waiting_jobs()
+{
+  remus::server::detail::JobQueue queue;
+
+  const boost::uuids::uuid waiting_id = make_id();
+  const boost::uuids::uuid queued_id = make_id();
+  queue.addJob( waiting_id, make_jobSubmission(Edges(),Mesh2D()) );
+  queue.addJob( queued_id, make_jobSubmission(Edges(),Mesh2D()) );
+
+  REMUS_ASSERT( (queue.workerDispatched(worker_type2D) == true) );
+  REMUS_ASSERT( (queue.numJobsWaitingForWorkers() == 1) );
+  REMUS_ASSERT( (queue.numJobsJustQueued() == 1) );
+
+  //the first job added is the first job dispatched
+  REMUS_ASSERT( (queue.remove(waiting_id) == true) );
+  REMUS_ASSERT( (queue.remove(waiting_id) == false) );
+  REMUS_ASSERT( (queue.numJobsWaitingForWorkers() == 0) );
+  REMUS_ASSERT( (queue.numJobsJustQueued() == 1) );
+  REMUS_ASSERT( (queue.waitingJobRequirements().size() == 0) );
+  REMUS_ASSERT( (queue.queuedJobRequirements().count(worker_type2D) == 1) );
+
+  //verify that clear also removes jobs waiting for workers
+  REMUS_ASSERT( (queue.workerDispatched(worker_type2D) == true) );
+  queue.clear();
+  REMUS_ASSERT( (queue.haveUUID(queued_id) == false) );
+  REMUS_ASSERT( (queue.numJobsWaitingForWorkers() == 0) );
+  REMUS_ASSERT( (queue.numJobsJustQueued() == 0) );
+  REMUS_ASSERT( (queue.takeJob(worker_type2D).valid() == false) );
+}
+
+void verify_requeue_waiting_jobs()
+{
+  remus::server::detail::JobQueue queue;
+
+  const zmq::SocketIdentity client_a("client_a",8);
+  const zmq::SocketIdentity client_b("client_b",8);
+
+  std::vector< boost::uuids::uuid > a_ids;
+  for(int i=0; i < 3; ++i)
+    {
+    a_ids.push_back(make_id());
+    queue.addJob( a_ids.back(), make_jobSubmission(Edges(),Mesh2D()), client_a );
+    }
+
+  //nothing is waiting for a worker yet
+  REMUS_ASSERT( (queue.requeueWaitingJobs(worker_type2D) == 0) );
+  REMUS_ASSERT( (queue.requeueWaitingJobs(worker_type3D) == 0) );
+
+  //dispatch workers for the first two jobs of client a, before client b
+  //submits a job
+  REMUS_ASSERT( (queue.workerDispatched(worker_type2D) == true) );
+  REMUS_ASSERT( (queue.workerDispatched(worker_type2D) == true) );
+  const boost::uuids::uuid b_id = make_id();
+  queue.addJob( b_id, make_jobSubmission(Edges(),Mesh2D()), client_b );
+  REMUS_ASSERT( (queue.numJobsWaitingForWorkers() == 2) );
+  REMUS_ASSERT( (queue.numJobsJustQueued() == 2) );
+
+  //the workers went away, so the jobs are queued again ahead of the
+  //rest of the jobs of their client, in the order they were dispatched
+  REMUS_ASSERT( (queue.requeueWaitingJobs(worker_type2D) == 2) );
+  REMUS_ASSERT( (queue.numJobsWaitingForWorkers() == 0) );
+  REMUS_ASSERT( (queue.numJobsJustQueued() == 4) );
+  REMUS_ASSERT( (queue.waitingJobRequirements().size() == 0) );
+  REMUS_ASSERT( (queue.queuedJobRequirements().count(worker_type2D) == 1) );
+
+  //jobs that were queued again can be removed
+  REMUS_ASSERT( (queue.remove(a_ids[1]) == true) );
+
+  REMUS_ASSERT( (queue.takeJob(worker_type2D).id() == a_ids[0]) );
+  REMUS_ASSERT( (queue.takeJob(worker_type2D).id() == b_id) );
+  REMUS_ASSERT( (queue.takeJob(worker_type2D).id() == a_ids[2]) );
+  REMUS_ASSERT( (queue.takeJob(worker_type2D).valid() == false) );
+
+  //a job of a client that has nothing else queued still gets queued again
+  const boost::uuids::uuid c_id = make_id();
+  queue.addJob( c_id, make_jobSubmission(Edges(),Mesh2D()), client_b );
+  REMUS_ASSERT( (queue.workerDispatched(worker_type2D) == true) );
+  REMUS_ASSERT( (queue.queuedJobRequirements().size() == 0) );
+  REMUS_ASSERT( (queue.requeueWaitingJobs(worker_type2D) == 1) );
+  REMUS_ASSERT( (queue.takeJob(worker_type2D).id() == c_id) );
+  REMUS_ASSERT( (queue.numJobsJustQueued() == 0) );
+}
+
+void verify_round_robin_clients()
+{
+  remus::server::detail::JobQueue queue;
+
+  const zmq::SocketIdentity client_a("client_a",8);
+  const zmq::SocketIdentity client_b("client_b",8);
+
+  //client a submits all of its jobs before client b submits any
+  std::vector< boost::uuids::uuid > a_ids, b_ids;
+  for(int i=0; i < 3; ++i)
+    {
+    a_ids.push_back(make_id());
+    queue.addJob( a_ids.back(), make_jobSubmission(Edges(),Mesh3D()), client_a );
+    }
+  for(int i=0; i < 2; ++i)
+    {
+    b_ids.push_back(make_id());
+    queue.addJob( b_ids.back(), make_jobSubmission(Edges(),Mesh3D()), client_b );
+    }
+
+  //jobs should be handed out alternating between the clients, and in
+  //submission order for each client
+  REMUS_ASSERT( (queue.takeJob(worker_type3D).id() == a_ids[0]) );
+  REMUS_ASSERT( (queue.takeJob(worker_type3D).id() == b_ids[0]) );
+
+  //dispatching a worker also takes its turn in the round robin order
+  REMUS_ASSERT( (queue.workerDispatched(worker_type3D) == true) );
+  REMUS_ASSERT( (queue.remove(b_ids[1]) == true) );
+  REMUS_ASSERT( (queue.takeJob(worker_type3D).id() == a_ids[1]) );
+  REMUS_ASSERT( (queue.takeJob(worker_type3D).id() == a_ids[2]) );
+  REMUS_ASSERT( (queue.takeJob(worker_type3D).valid() == false) );
+}
+
+void verify_job_payloads()
+{
+  remus::server::detail::JobQueue queue;
+
+  //jobs queued with a payload hand back the same payload when taken
+  const std::string contents("opaque submission");
+  boost::shared_ptr<zmq::message_t> payload =
+                  boost::make_shared<zmq::message_t>(contents.size());
+  std::memcpy(payload->data(), contents.data(), contents.size());
+
+  boost::uuids::uuid payload_id = make_id();
+  boost::uuids::uuid plain_id = make_id();
+  queue.addJob( payload_id, make_jobSubmission(Edges(),Mesh2D()),
+                zmq::SocketIdentity(), payload );
+  queue.addJob( plain_id, make_jobSubmission(Edges(),Mesh2D()) );
+
+  boost::shared_ptr<zmq::message_t> taken;
+  remus::worker::Job job = queue.takeJob(worker_type2D, taken);
+  REMUS_ASSERT( (job.id() == payload_id) );
+  REMUS_ASSERT( (taken.get() == payload.get()) );
+
+  //the payload isn't copied or consumed while it is queued
+  const std::string taken_contents(static_cast<const char*>(taken->data()),
+                                   taken->size());
+  REMUS_ASSERT( (taken_contents == contents) );
+
+  job = queue.takeJob(worker_type2D, taken);
+  REMUS_ASSERT( (job.id() == plain_id) );
+  REMUS_ASSERT( (!taken) );
+}
+
+void verify_queued_job_wait()
+{
+  using remus::server::detail::TimerWheel;
+  remus::server::detail::JobQueue queue;
+
+  const zmq::SocketIdentity client_a("client_a",8);
+  const zmq::SocketIdentity client_b("client_b",8);
+
+  //nothing queued has waited
+  REMUS_ASSERT( (queue.numJobsJustQueued(worker_type3D) == 0) );
+  REMUS_ASSERT( (queue.oldestQueuedJobWait(worker_type3D,
+                                           TimerWheel::now()) == 0) );
+
+  boost::uuids::uuid oldest = make_id();
+  queue.addJob( oldest, make_jobSubmission(Edges(),Mesh3D()), client_a );
+  remus::common::SleepForMillisec(50);
+  queue.addJob( make_id(), make_jobSubmission(Edges(),Mesh3D()), client_b );
+  queue.addJob( make_id(), make_jobSubmission(Edges(),Mesh2D()), client_b );
+  REMUS_ASSERT( (queue.numJobsJustQueued(worker_type3D) == 2) );
+  REMUS_ASSERT( (queue.numJobsJustQueued(worker_type2D) == 1) );
+
+  //the wait is of the oldest job of any client
+  const boost::int64_t now = TimerWheel::now();
+  REMUS_ASSERT( (queue.oldestQueuedJobWait(worker_type3D, now) >= 50) );
+  REMUS_ASSERT( (queue.oldestQueuedJobWait(worker_type3D, now) >
+                 queue.oldestQueuedJobWait(worker_type2D, now)) );
+  REMUS_ASSERT( (queue.oldestQueuedJobWait(worker_type3D, now + 100) ==
+                 queue.oldestQueuedJobWait(worker_type3D, now) + 100) );
+
+  //jobs waiting for a worker aren't counted, as a worker is on its way
+  REMUS_ASSERT( (queue.workerDispatched(worker_type3D) == true) );
+  REMUS_ASSERT( (queue.numJobsJustQueued(worker_type3D) == 1) );
+  REMUS_ASSERT( (queue.oldestQueuedJobWait(worker_type3D, now) < 50) );
+
+  //jobs that are queued again keep how long they have waited
+  REMUS_ASSERT( (queue.requeueWaitingJobs(worker_type3D) == 1) );
+  REMUS_ASSERT( (queue.oldestQueuedJobWait(worker_type3D, now) >= 50) );
+
+  REMUS_ASSERT( (queue.remove(oldest) == true) );
+  REMUS_ASSERT( (queue.oldestQueuedJobWait(worker_type3D, now) < 50) );
+}
+
 } //namespace
 
 int UnitTestServerJobQueue(int, char *[])
@@ -221,6 +417,16 @@ int UnitTestServerJobQueue(int, char *[])
 
   verify_dispatch_jobs();
 
+  verify_remove_waiting_jobs();
+
+  verify_requeue_waiting_jobs();
+
+  verify_round_robin_clients();
+
+  verify_job_payloads();
+
+  verify_queued_job_wait();
+
 
   return 0;
 }
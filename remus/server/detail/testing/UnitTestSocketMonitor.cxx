@@ -236,6 +236,44 @@ void verify_responiveness()
 }
 
 
+void verify_check_heartbeats()
+{
+  zmq::SocketIdentity sid = make_socketId();
+  SocketMonitor monitor;
+  monitor.pollingMonitor().changeTimeOutRates(25,25);
+
+  monitor.heartbeat(sid, make_heartbeat(25) );
+  remus::server::detail::SocketChanges changes = monitor.checkHeartbeats();
+  REMUS_ASSERT( (changes.Unresponsive.size() == 0) );
+  REMUS_ASSERT( (changes.Responsive.size() == 0) );
+  REMUS_ASSERT( (changes.Dead.size() == 0) );
+
+  //after twice the interval sid is reported as unresponsive, but only once
+  remus::common::SleepForMillisec(75);
+  changes = monitor.checkHeartbeats();
+  REMUS_ASSERT( (changes.Unresponsive.size() == 1) );
+  REMUS_ASSERT( (changes.Unresponsive[0] == sid) );
+  changes = monitor.checkHeartbeats();
+  REMUS_ASSERT( (changes.Unresponsive.size() == 0) );
+
+  //bring the socket back to being responsive
+  monitor.heartbeat(sid, make_heartbeat(25) );
+  changes = monitor.checkHeartbeats();
+  REMUS_ASSERT( (changes.Unresponsive.size() == 0) );
+  REMUS_ASSERT( (changes.Responsive.size() == 1) );
+  REMUS_ASSERT( (changes.Responsive[0] == sid) );
+
+  //dead sockets are reported, and never become unresponsive
+  monitor.markAsDead(sid);
+  changes = monitor.checkHeartbeats();
+  REMUS_ASSERT( (changes.Dead.size() == 1) );
+  REMUS_ASSERT( (changes.Dead[0] == sid) );
+  remus::common::SleepForMillisec(75);
+  changes = monitor.checkHeartbeats();
+  REMUS_ASSERT( (changes.Unresponsive.size() == 0) );
+  REMUS_ASSERT( (changes.Dead.size() == 0) );
+}
+
 }
 int UnitTestSocketMonitor(int, char *[])
 {
@@ -248,6 +286,7 @@ int UnitTestSocketMonitor(int, char *[])
   verify_resurrection();
   verify_heartbeat_interval();
   verify_responiveness();
+  verify_check_heartbeats();
 
   return 0;
 }
@@ -0,0 +1,129 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <remus/server/detail/TimerWheel.h>
+
+#include <remus/proto/zmqSocketIdentity.h>
+#include <remus/testing/Testing.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <map>
+
+namespace
+{
+typedef remus::server::detail::TimerWheel TimerWheel;
+
+//makes a socket identity from a number
+zmq::SocketIdentity make_socketId(int i)
+{
+  const std::string str_id = boost::lexical_cast<std::string>(i);
+  return zmq::SocketIdentity(str_id.c_str(),str_id.size());
+}
+
+void verify_schedule_and_cancel()
+{
+  TimerWheel wheel;
+  const boost::int64_t base = TimerWheel::now();
+  std::vector<zmq::SocketIdentity> expired;
+
+  zmq::SocketIdentity a = make_socketId(1);
+  zmq::SocketIdentity b = make_socketId(2);
+  zmq::SocketIdentity c = make_socketId(3);
+
+  wheel.schedule(a, base + 10);
+  wheel.schedule(b, base + 100);
+  wheel.schedule(c, base + 10000);
+  REMUS_ASSERT( (wheel.size() == 3) );
+  REMUS_ASSERT( (wheel.isScheduled(a) == true) );
+
+  //nothing expires before its deadline
+  wheel.advance(base + 9, expired);
+  REMUS_ASSERT( (expired.size() == 0) );
+
+  wheel.advance(base + 20, expired);
+  REMUS_ASSERT( (expired.size() == 1) );
+  REMUS_ASSERT( (expired[0] == a) );
+  REMUS_ASSERT( (wheel.isScheduled(a) == false) );
+  expired.clear();
+
+  //moving a deadline replaces the old one
+  wheel.schedule(b, base + 200);
+  REMUS_ASSERT( (wheel.size() == 2) );
+  wheel.advance(base + 150, expired);
+  REMUS_ASSERT( (expired.size() == 0) );
+  wheel.advance(base + 210, expired);
+  REMUS_ASSERT( (expired.size() == 1) );
+  REMUS_ASSERT( (expired[0] == b) );
+  expired.clear();
+
+  //cancelled sockets never expire
+  REMUS_ASSERT( (wheel.cancel(c) == true) );
+  REMUS_ASSERT( (wheel.cancel(c) == false) );
+  REMUS_ASSERT( (wheel.isScheduled(c) == false) );
+  wheel.advance(base + 20000, expired);
+  REMUS_ASSERT( (expired.size() == 0) );
+  REMUS_ASSERT( (wheel.size() == 0) );
+
+  //a deadline in the past expires on the next advance
+  wheel.schedule(a, base);
+  wheel.advance(base + 20010, expired);
+  REMUS_ASSERT( (expired.size() == 1) );
+}
+
+void verify_cascading()
+{
+  //schedule deadlines that span multiple wheels, and verify that every
+  //socket expires after its deadline and no later than one resolution
+  //after it
+  const boost::int64_t resolution = 8;
+  TimerWheel wheel(resolution);
+  const boost::int64_t base = TimerWheel::now();
+
+  std::map<zmq::SocketIdentity, boost::int64_t> deadlines;
+  for(int i=0; i < 8000; ++i)
+    {
+    const boost::int64_t deadline = base + 1 + (i * 37);
+    deadlines[make_socketId(i)] = deadline;
+    wheel.schedule(make_socketId(i), deadline);
+    }
+  REMUS_ASSERT( (wheel.size() == deadlines.size()) );
+
+  std::size_t numExpired = 0;
+  boost::int64_t previous = base;
+  for(boost::int64_t time = base; time <= base + 300000; time += 50)
+    {
+    std::vector<zmq::SocketIdentity> expired;
+    wheel.advance(time, expired);
+    for(std::size_t i=0; i < expired.size(); ++i)
+      {
+      const boost::int64_t deadline = deadlines[expired[i]];
+      REMUS_ASSERT( (deadline <= time) );
+      REMUS_ASSERT( (deadline > previous - resolution) );
+      }
+    numExpired += expired.size();
+    previous = time;
+    }
+  REMUS_ASSERT( (numExpired == deadlines.size()) );
+  REMUS_ASSERT( (wheel.size() == 0) );
+}
+
+}
+
+int UnitTestTimerWheel(int, char *[])
+{
+  verify_schedule_and_cancel();
+  verify_cascading();
+
+  return 0;
+}
@@ -0,0 +1,172 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <remus/server/detail/Transfers.h>
+#include <remus/server/detail/TimerWheel.h>
+
+#include <remus/testing/Testing.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+
+namespace
+{
+typedef remus::proto::Transfer Transfer;
+typedef remus::server::detail::Transfers Transfers;
+
+//makes a socket identity from a number
+zmq::SocketIdentity make_socketId(int i)
+{
+  const std::string str_id = boost::lexical_cast<std::string>(i);
+  return zmq::SocketIdentity(str_id.c_str(),str_id.size());
+}
+
+void verify_in_order()
+{
+  Transfers transfers(4);
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const std::string data = remus::testing::BinaryDataGenerator(1000);
+
+  Transfer reply = transfers.begin(make_socketId(1),
+                                   Transfer(id, 0, data.size()));
+  REMUS_ASSERT( reply.valid() );
+  REMUS_ASSERT( (reply.offset() == 0) );
+  REMUS_ASSERT( (reply.credits() == 4) );
+  REMUS_ASSERT( (transfers.size() == 1) );
+
+  //a commit before all the data has arrived fails
+  boost::shared_ptr<std::string> assembled;
+  for(std::size_t offset = 0; offset < data.size(); offset += 300)
+    {
+    REMUS_ASSERT( !transfers.commit(Transfer(id, offset), assembled) );
+    const std::size_t size = std::min<std::size_t>(300, data.size()-offset);
+    reply = transfers.append(Transfer(id, offset), data.data()+offset, size);
+    REMUS_ASSERT( (reply.offset() == offset + size) );
+    }
+
+  REMUS_ASSERT( transfers.commit(Transfer(id, data.size()), assembled) );
+  REMUS_ASSERT( (*assembled == data) );
+  REMUS_ASSERT( (transfers.size() == 0) );
+
+  //the transfer is gone once committed
+  REMUS_ASSERT( !transfers.append(Transfer(id, 0), data.data(), 1).valid() );
+}
+
+void verify_out_of_order()
+{
+  Transfers transfers;
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const std::string data("0123456789");
+
+  transfers.begin(make_socketId(1), Transfer(id, 0, data.size()));
+  transfers.append(Transfer(id, 0), data.data(), 4);
+
+  //duplicates and gaps are ignored, and we are told where to resume
+  Transfer reply = transfers.append(Transfer(id, 0), data.data(), 4);
+  REMUS_ASSERT( (reply.offset() == 4) );
+  reply = transfers.append(Transfer(id, 8), data.data()+8, 2);
+  REMUS_ASSERT( (reply.offset() == 4) );
+
+  //chunks past the size we were told about are rejected
+  REMUS_ASSERT( !transfers.append(Transfer(id, 4), data.data(), 64).valid() );
+
+  //beginning again from a new socket resumes the transfer
+  reply = transfers.begin(make_socketId(2), Transfer(id, 0, data.size()));
+  REMUS_ASSERT( (reply.offset() == 4) );
+  transfers.append(Transfer(id, 4), data.data()+4, 6);
+
+  //the first socket no longer owns the transfer
+  transfers.remove(make_socketId(1));
+  REMUS_ASSERT( (transfers.size() == 1) );
+
+  boost::shared_ptr<std::string> assembled;
+  REMUS_ASSERT( transfers.commit(Transfer(id, data.size()), assembled) );
+  REMUS_ASSERT( (*assembled == data) );
+}
+
+void verify_headroom()
+{
+  //transfers of an unknown size are complete at the offset of the commit,
+  //and keep the headroom at the front of the buffer
+  Transfers transfers;
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const std::string data("result");
+
+  Transfer reply = transfers.begin(make_socketId(1), Transfer(id, 0), 8);
+  REMUS_ASSERT( (reply.offset() == 0) );
+  transfers.append(Transfer(id, 0), data.data(), data.size());
+
+  boost::shared_ptr<std::string> assembled;
+  REMUS_ASSERT( !transfers.commit(Transfer(id, data.size()+1), assembled) );
+  REMUS_ASSERT( transfers.commit(Transfer(id, data.size()), assembled) );
+  REMUS_ASSERT( (assembled->size() == data.size() + 8) );
+  REMUS_ASSERT( (assembled->substr(8) == data) );
+}
+
+void verify_max_size()
+{
+  Transfers transfers(8, 1000, 100);
+  REMUS_ASSERT( (transfers.maxSize() == 100) );
+
+  //sizes that are too large, or that we could never allocate, are rejected
+  //without keeping the transfer around
+  const boost::uuids::uuid bogus = remus::testing::UUIDGenerator();
+  REMUS_ASSERT( !transfers.begin(make_socketId(1),
+                                 Transfer(bogus, 0, 101)).valid() );
+  REMUS_ASSERT( (transfers.size() == 0) );
+
+  transfers.maxSize(Transfers::defaultMaxSize());
+  const boost::uint64_t huge = ~boost::uint64_t(0);
+  REMUS_ASSERT( !transfers.begin(make_socketId(1),
+                                 Transfer(bogus, 0, huge)).valid() );
+  REMUS_ASSERT( (transfers.size() == 0) );
+
+  //transfers of an unknown size are dropped once they grow too large
+  transfers.maxSize(100);
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const std::string data = remus::testing::BinaryDataGenerator(60);
+  REMUS_ASSERT( transfers.begin(make_socketId(1), Transfer(id, 0)).valid() );
+  REMUS_ASSERT( transfers.append(Transfer(id, 0), data.data(), 60).valid() );
+  REMUS_ASSERT( !transfers.append(Transfer(id, 60), data.data(), 60).valid() );
+  REMUS_ASSERT( (transfers.size() == 0) );
+}
+
+void verify_removal()
+{
+  Transfers transfers(8, 1000);
+  transfers.begin(make_socketId(1), Transfer(remus::testing::UUIDGenerator(), 0));
+  transfers.begin(make_socketId(1), Transfer(remus::testing::UUIDGenerator(), 0));
+  transfers.begin(make_socketId(2), Transfer(remus::testing::UUIDGenerator(), 0));
+  REMUS_ASSERT( (transfers.size() == 3) );
+
+  transfers.remove(make_socketId(1));
+  REMUS_ASSERT( (transfers.size() == 1) );
+
+  const boost::int64_t now = remus::server::detail::TimerWheel::now();
+  REMUS_ASSERT( (transfers.removeIdle(now) == 0) );
+  REMUS_ASSERT( (transfers.removeIdle(now + 5000) == 1) );
+  REMUS_ASSERT( (transfers.size() == 0) );
+}
+
+}
+
+int UnitTestTransfers(int, char *[])
+{
+  verify_in_order();
+  verify_out_of_order();
+  verify_headroom();
+  verify_max_size();
+  verify_removal();
+  return 0;
+}
@@ -0,0 +1,89 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/WireFormats.h>
+#include <remus/server/detail/TimerWheel.h>
+
+#include <remus/testing/Testing.h>
+
+#include <boost/lexical_cast.hpp>
+
+namespace
+{
+typedef remus::proto::WireFormat WireFormat;
+
+//makes a socket identity from a number
+zmq::SocketIdentity make_socketId(int i)
+{
+  const std::string str_id = boost::lexical_cast<std::string>(i);
+  return zmq::SocketIdentity(str_id.c_str(),str_id.size());
+}
+
+void verify_negotiate()
+{
+  remus::server::detail::WireFormats formats;
+  zmq::SocketIdentity a = make_socketId(1);
+  zmq::SocketIdentity b = make_socketId(2);
+
+  //sockets that never negotiated use text
+  REMUS_ASSERT( (formats.format(a) == WireFormat::Text) );
+  REMUS_ASSERT( (formats.size() == 0) );
+
+  REMUS_ASSERT( (formats.negotiate(a,WireFormat::Binary) == WireFormat::Binary) );
+  REMUS_ASSERT( (formats.format(a) == WireFormat::Binary) );
+  REMUS_ASSERT( (formats.format(b) == WireFormat::Text) );
+  REMUS_ASSERT( (formats.size() == 1) );
+
+  //asking for text again goes back to the default
+  REMUS_ASSERT( (formats.negotiate(a,WireFormat::Text) == WireFormat::Text) );
+  REMUS_ASSERT( (formats.format(a) == WireFormat::Text) );
+  REMUS_ASSERT( (formats.size() == 0) );
+
+  formats.negotiate(b,WireFormat::Binary);
+  formats.remove(b);
+  REMUS_ASSERT( (formats.format(b) == WireFormat::Text) );
+  REMUS_ASSERT( (formats.size() == 0) );
+}
+
+void verify_idle()
+{
+  remus::server::detail::WireFormats formats(1000);
+  zmq::SocketIdentity a = make_socketId(1);
+  zmq::SocketIdentity b = make_socketId(2);
+
+  formats.negotiate(a,WireFormat::Binary);
+  formats.negotiate(b,WireFormat::Binary);
+  REMUS_ASSERT( (formats.size() == 2) );
+
+  const boost::int64_t now = remus::server::detail::TimerWheel::now();
+  REMUS_ASSERT( (formats.removeIdle(now) == 0) );
+  REMUS_ASSERT( (formats.size() == 2) );
+
+  //sockets that haven't been seen for the idle timeout are dropped, and
+  //go back to text
+  REMUS_ASSERT( (formats.removeIdle(now + 5000) == 2) );
+  REMUS_ASSERT( (formats.size() == 0) );
+  REMUS_ASSERT( (formats.format(a) == WireFormat::Text) );
+
+  //seeing a socket that doesn't use binary doesn't track it
+  formats.seen(a);
+  REMUS_ASSERT( (formats.size() == 0) );
+}
+
+}
+
+int UnitTestWireFormats(int, char *[])
+{
+  verify_negotiate();
+  verify_idle();
+  return 0;
+}
@@ -13,6 +13,7 @@
 
 #include <remus/common/SleepFor.h>
 #include <remus/proto/zmqSocketIdentity.h>
+#include <remus/server/detail/TimerWheel.h>
 #include <remus/server/detail/uuidHelper.h>
 
 #include <remus/testing/Testing.h>
@@ -148,7 +149,7 @@ void verify_purge_workers()
   monitor.refresh(worker1_id);
 
   //fail to purge by using the time stamp the worker was added with
-  pool.purgeDeadWorkers(monitor);
+  pool.purgeDeadWorkers(monitor.checkHeartbeats());
   REMUS_ASSERT( (pool.haveWaitingWorker(worker_type2D) == true) );
   REMUS_ASSERT( (pool.haveWorker(worker1_id, worker_type2D) == true) );
   REMUS_ASSERT( (pool.haveWorker(worker1_id, worker_type3D) == true) );
@@ -156,7 +157,7 @@ void verify_purge_workers()
   //mark workers as inactive and not ready for jobs by waiting 3 seconds
   remus::common::SleepForMillisec(3000);
 
-  pool.purgeDeadWorkers(monitor);
+  pool.purgeDeadWorkers(monitor.checkHeartbeats());
   REMUS_ASSERT( (pool.haveWaitingWorker(worker_type2D) == false) );
   REMUS_ASSERT( (pool.haveWaitingWorker(worker_type3D) == false) );
   REMUS_ASSERT( (pool.haveWorker(worker1_id, worker_type2D) == true) );
@@ -166,8 +167,9 @@ void verify_purge_workers()
   REMUS_ASSERT( (pool.allResponsiveWorkers().size() == 0) );
 
   //refresh the work will make it active on the next check to purge workers
+  //and both of its requirements have a waiting worker again
   monitor.refresh(worker1_id);
-  pool.purgeDeadWorkers(monitor);
+  REMUS_ASSERT( (pool.purgeDeadWorkers(monitor.checkHeartbeats()).size() == 2) );
   REMUS_ASSERT( (pool.haveWaitingWorker(worker_type2D) == true) );
   REMUS_ASSERT( (pool.haveWaitingWorker(worker_type3D) == true) );
   REMUS_ASSERT( (pool.haveWorker(worker1_id, worker_type2D) == true) );
@@ -261,6 +263,227 @@ void verify_taking_works()
   }
 }
 
+void verify_round_robin_taking()
+{
+  //verify that workers that take a job go to the back of the line for
+  //that type of job, so jobs are spread across all waiting workers
+  remus::server::detail::WorkerPool pool;
+  zmq::SocketIdentity worker1_id = make_socketId();
+  zmq::SocketIdentity worker2_id = make_socketId();
+
+  pool.addWorker(worker1_id, worker_type2D);
+  pool.addWorker(worker2_id, worker_type2D);
+  pool.readyForWork(worker1_id, worker_type2D);
+  pool.readyForWork(worker1_id, worker_type2D);
+  pool.readyForWork(worker2_id, worker_type2D);
+  pool.readyForWork(worker2_id, worker_type2D);
+
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker1_id) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker2_id) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker1_id) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker2_id) );
+  REMUS_ASSERT( (pool.haveWaitingWorker(worker_type2D) == false) );
+  REMUS_ASSERT( (pool.waitingWorkerRequirements(
+                            worker_type2D.meshTypes()).size() == 0) );
+
+  //a worker asking for more work goes to the back of the line
+  pool.readyForWork(worker2_id, worker_type2D);
+  pool.readyForWork(worker1_id, worker_type2D);
+  REMUS_ASSERT( (pool.waitingWorkerRequirements(
+                            worker_type2D.meshTypes()).size() == 1) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker2_id) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker1_id) );
+}
+
+void verify_least_loaded_taking()
+{
+  //verify that the waiting worker holding the fewest jobs is taken, so a
+  //worker that asks for many jobs ahead of time doesn't get them all
+  remus::server::detail::WorkerPool pool;
+  zmq::SocketIdentity greedy_id = make_socketId();
+  zmq::SocketIdentity worker_id = make_socketId();
+
+  pool.addWorker(greedy_id, worker_type2D);
+  pool.addWorker(worker_id, worker_type2D);
+  for(int i=0; i < 4; ++i)
+    {
+    pool.readyForWork(greedy_id, worker_type2D);
+    }
+
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == greedy_id) );
+  pool.holdJob(greedy_id, remus::testing::UUIDGenerator());
+  REMUS_ASSERT( (pool.heldJobCount(greedy_id) == 1) );
+
+  //the other worker asks after the greedy one, but holds no jobs
+  pool.readyForWork(worker_id, worker_type2D);
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker_id) );
+  const boost::uuids::uuid job = remus::testing::UUIDGenerator();
+  pool.holdJob(worker_id, job);
+
+  //holding a job twice doesn't count twice
+  pool.holdJob(worker_id, job);
+  REMUS_ASSERT( (pool.heldJobCount(worker_id) == 1) );
+
+  //once both hold a job, they are taken in the order they asked again
+  pool.readyForWork(worker_id, worker_type2D);
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == greedy_id) );
+  pool.holdJob(greedy_id, remus::testing::UUIDGenerator());
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker_id) );
+
+  //releasing a job, even twice, only releases it once
+  pool.releaseJob(job);
+  pool.releaseJob(job);
+  REMUS_ASSERT( (pool.heldJobCount(worker_id) == 0) );
+  REMUS_ASSERT( (pool.heldJobCount(greedy_id) == 2) );
+
+  //a waiting worker that releases a job is taken ahead of the workers
+  //that now hold more jobs than it does, even if they asked first
+  const boost::uuids::uuid first = remus::testing::UUIDGenerator();
+  pool.holdJob(worker_id, first);
+  pool.holdJob(worker_id, remus::testing::UUIDGenerator());
+  pool.readyForWork(worker_id, worker_type2D);
+  pool.releaseJob(first);
+  REMUS_ASSERT( (pool.waitingWorkerCount(worker_type2D) == 2) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker_id) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == greedy_id) );
+}
+
+void verify_max_jobs_per_worker()
+{
+  //verify that a worker holding as many jobs as it is allowed to isn't
+  //taken until it releases one, and that it keeps the jobs it asked for
+  remus::server::detail::WorkerPool pool;
+  zmq::SocketIdentity worker1_id = make_socketId();
+  REMUS_ASSERT( (pool.maxJobsPerWorker() == 0) );
+  pool.maxJobsPerWorker(2);
+  REMUS_ASSERT( (pool.maxJobsPerWorker() == 2) );
+
+  pool.addWorker(worker1_id, worker_type2D);
+  pool.addWorker(worker1_id, worker_type3D);
+  for(int i=0; i < 4; ++i)
+    {
+    pool.readyForWork(worker1_id, worker_type2D);
+    }
+  pool.readyForWork(worker1_id, worker_type3D);
+
+  std::vector<boost::uuids::uuid> jobs;
+  for(int i=0; i < 2; ++i)
+    {
+    REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker1_id) );
+    jobs.push_back(remus::testing::UUIDGenerator());
+    pool.holdJob(worker1_id, jobs.back());
+    }
+
+  //the limit is for the worker, not for each of its requirements
+  REMUS_ASSERT( (pool.haveWaitingWorker(worker_type2D) == false) );
+  REMUS_ASSERT( (pool.haveWaitingWorker(worker_type3D) == false) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == zmq::SocketIdentity()) );
+  REMUS_ASSERT( (pool.allWorkersWantingWork().size() == 0) );
+
+  //releasing a job makes the worker wait for both requirements again
+  REMUS_ASSERT( (pool.releaseJob(jobs[0]).size() == 2) );
+  REMUS_ASSERT( (pool.haveWaitingWorker(worker_type2D) == true) );
+  REMUS_ASSERT( (pool.haveWaitingWorker(worker_type3D) == true) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker1_id) );
+  pool.holdJob(worker1_id, remus::testing::UUIDGenerator());
+  REMUS_ASSERT( (pool.haveWaitingWorker(worker_type2D) == false) );
+
+  //removing the limit lets the worker take the jobs it asked for
+  REMUS_ASSERT( (pool.maxJobsPerWorker(0).size() == 2) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker1_id) );
+  REMUS_ASSERT( (pool.haveWaitingWorker(worker_type2D) == false) );
+  REMUS_ASSERT( (pool.heldJobCount(worker1_id) == 2) );
+}
+
+void verify_waiting_and_busy_counts()
+{
+  //verify that workers are counted as waiting until they hold a job,
+  //and as busy while they hold one
+  remus::server::detail::WorkerPool pool;
+  zmq::SocketIdentity worker1_id = make_socketId();
+  zmq::SocketIdentity worker2_id = make_socketId();
+  REMUS_ASSERT( (pool.waitingWorkerCount(worker_type2D) == 0) );
+  REMUS_ASSERT( (pool.busyWorkerCount(worker_type2D) == 0) );
+
+  pool.addWorker(worker1_id, worker_type2D);
+  pool.addWorker(worker2_id, worker_type2D);
+  REMUS_ASSERT( (pool.waitingWorkerCount(worker_type2D) == 0) );
+
+  pool.readyForWork(worker1_id, worker_type2D);
+  pool.readyForWork(worker2_id, worker_type2D);
+  REMUS_ASSERT( (pool.waitingWorkerCount(worker_type2D) == 2) );
+  REMUS_ASSERT( (pool.waitingWorkerCount(worker_type3D) == 0) );
+
+  const zmq::SocketIdentity taken = pool.takeWorker(worker_type2D);
+  const boost::uuids::uuid job = remus::testing::UUIDGenerator();
+  pool.holdJob(taken, job);
+  REMUS_ASSERT( (pool.waitingWorkerCount(worker_type2D) == 1) );
+  REMUS_ASSERT( (pool.busyWorkerCount(worker_type2D) == 1) );
+  REMUS_ASSERT( (pool.busyWorkerCount(worker_type3D) == 0) );
+
+  pool.releaseJob(job);
+  REMUS_ASSERT( (pool.busyWorkerCount(worker_type2D) == 0) );
+}
+
+void verify_idle_workers()
+{
+  using remus::server::detail::TimerWheel;
+
+  //verify that workers waiting for work are idle from when they registered
+  //or released their last job, and are found longest idle first
+  remus::server::detail::WorkerPool pool;
+  zmq::SocketIdentity worker1_id = make_socketId();
+  zmq::SocketIdentity worker2_id = make_socketId();
+
+  pool.addWorker(worker1_id, worker_type2D);
+  remus::common::SleepForMillisec(20);
+  pool.addWorker(worker2_id, worker_type2D);
+
+  //workers that aren't waiting for work aren't idle
+  REMUS_ASSERT( (pool.idleWorkers(worker_type2D, 0, TimerWheel::now()).size() == 0) );
+
+  pool.readyForWork(worker2_id, worker_type2D);
+  pool.readyForWork(worker1_id, worker_type2D);
+  std::vector<zmq::SocketIdentity> idle =
+                        pool.idleWorkers(worker_type2D, 0, TimerWheel::now());
+  REMUS_ASSERT( (idle.size() == 2) );
+  REMUS_ASSERT( (idle[0] == worker1_id) );
+  REMUS_ASSERT( (idle[1] == worker2_id) );
+  REMUS_ASSERT( (pool.idleWorkers(worker_type3D, 0, TimerWheel::now()).size() == 0) );
+
+  //only workers idle for long enough are found
+  const boost::int64_t now = TimerWheel::now();
+  REMUS_ASSERT( (pool.idleWorkers(worker_type2D, 60000, now).size() == 0) );
+  REMUS_ASSERT( (pool.idleWorkers(worker_type2D, 0, now + 60000).size() == 2) );
+
+  //a worker holding a job isn't idle, even when it asked for more jobs,
+  //and becomes idle again once it releases the job
+  pool.readyForWork(worker1_id, worker_type2D);
+  pool.readyForWork(worker2_id, worker_type2D);
+  const zmq::SocketIdentity busy_id = pool.takeWorker(worker_type2D);
+  const zmq::SocketIdentity other_id =
+                          (busy_id == worker1_id) ? worker2_id : worker1_id;
+  const boost::uuids::uuid job = remus::testing::UUIDGenerator();
+  pool.holdJob(busy_id, job);
+  REMUS_ASSERT( (pool.waitingWorkerCount(worker_type2D) == 2) );
+  idle = pool.idleWorkers(worker_type2D, 0, TimerWheel::now());
+  REMUS_ASSERT( (idle.size() == 1) );
+  REMUS_ASSERT( (idle[0] == other_id) );
+
+  remus::common::SleepForMillisec(20);
+  pool.releaseJob(job);
+  idle = pool.idleWorkers(worker_type2D, 0, TimerWheel::now());
+  REMUS_ASSERT( (idle.size() == 2) );
+  REMUS_ASSERT( (idle[0] == other_id) );
+  REMUS_ASSERT( (idle[1] == busy_id) );
+
+  //removed workers are gone for good
+  pool.removeWorker(other_id);
+  REMUS_ASSERT( (pool.haveWorker(other_id, worker_type2D) == false) );
+  REMUS_ASSERT( (pool.waitingWorkerCount(worker_type2D) == 1) );
+  REMUS_ASSERT( (pool.idleWorkers(worker_type2D, 0, TimerWheel::now()).size() == 1) );
+}
+
 } //namespace
 
 int UnitTestWorkerPool(int, char *[])
@@ -273,5 +496,15 @@ int UnitTestWorkerPool(int, char *[])
 
   verify_taking_works();
 
+  verify_round_robin_taking();
+
+  verify_least_loaded_taking();
+
+  verify_max_jobs_per_worker();
+
+  verify_waiting_and_busy_counts();
+
+  verify_idle_workers();
+
   return 0;
 }
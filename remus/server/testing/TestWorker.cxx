@@ -17,6 +17,10 @@
 
 #include <stdlib.h>
 
+#if !defined(_WIN32) || defined(__CYGWIN__)
+#include <sys/resource.h>
+#endif
+
 #define REMUS_WORKER_ENV_TEST "REMUS_WORKER_ENV_TEST"
 
 int main(int argc, char** argv)
@@ -35,6 +39,42 @@ int main(int argc, char** argv)
         remus::common::SleepForMillisec(1000);
         }
       }
+    else if( prog_type.find("RESIDENT") == 0)
+      {
+      //resident workers are launched with the limits of their worker file
+      const char* maxJobs = getenv("REMUS_WORKER_MAX_JOBS");
+      const char* idleTimeout = getenv("REMUS_WORKER_IDLE_TIMEOUT");
+      if(!maxJobs || std::string(maxJobs) != "3" ||
+         !idleTimeout || std::string(idleTimeout) != "500")
+        {
+        return 1;
+        }
+      remus::common::SleepForMillisec(1000);
+      }
+    else if( prog_type.find("CHECK_LIMITS") == 0)
+      {
+      //limited workers are launched with the limits of their worker file,
+      //and with the launch id their identities start with
+      if(!getenv("REMUS_WORKER_LAUNCH_ID"))
+        {
+        return 1;
+        }
+#if !defined(_WIN32) || defined(__CYGWIN__)
+      struct rlimit files;
+      if(getrlimit(RLIMIT_NOFILE, &files) != 0 || files.rlim_cur != 64)
+        {
+        return 1;
+        }
+#endif
+      }
+    else if( prog_type.find("CRASH") == 0)
+      {
+      abort();
+      }
+    else if( prog_type.find("EXIT_WITH_ERROR") == 0)
+      {
+      return 3;
+      }
     else
       {
       return 1;
@@ -99,6 +99,72 @@ void test_server_poll_rates()
   REMUS_ASSERT( (server.pollingRates().maxRate() == original_rates.maxRate()) );
 }
 
+void test_server_message_batch_size()
+{
+  //verify that we can get and set the message batch size for a server
+  //verify that a batch size of zero is treated as one
+  remus::server::Server server;
+
+  const std::size_t original_size = server.messageBatchSize();
+  REMUS_ASSERT( (original_size > 0) );
+
+  server.messageBatchSize(1024);
+  REMUS_ASSERT( (server.messageBatchSize() == 1024) );
+
+  server.messageBatchSize(0);
+  REMUS_ASSERT( (server.messageBatchSize() == 1) );
+
+  server.messageBatchSize(original_size);
+  REMUS_ASSERT( (server.messageBatchSize() == original_size) );
+}
+
+void test_server_heartbeat_check_interval()
+{
+  //verify that we can get and set how often the server checks heartbeats
+  //verify that a non positive interval is treated as one millisecond
+  remus::server::Server server;
+  REMUS_ASSERT( (server.heartbeatCheckInterval() == 250) );
+
+  server.heartbeatCheckInterval(50);
+  REMUS_ASSERT( (server.heartbeatCheckInterval() == 50) );
+
+  server.heartbeatCheckInterval(0);
+  REMUS_ASSERT( (server.heartbeatCheckInterval() == 1) );
+
+  server.heartbeatCheckInterval(-10);
+  REMUS_ASSERT( (server.heartbeatCheckInterval() == 1) );
+
+  //verify a server with a short interval can start and stop brokering
+  server.heartbeatCheckInterval(50);
+  server.startBrokering();
+  REMUS_ASSERT( (server.isBrokering() == true) );
+  server.stopBrokering();
+  REMUS_ASSERT( (server.isBrokering() == false) );
+}
+
+void test_server_threading()
+{
+  //verify that we can get and set the broker threading mode, and that
+  //a multi threaded server can start and stop brokering
+  remus::server::Server server;
+  REMUS_ASSERT( (server.brokerThreading() == remus::server::Server::SINGLE_THREADED) );
+
+  server.brokerThreading(remus::server::Server::MULTI_THREADED);
+  REMUS_ASSERT( (server.brokerThreading() == remus::server::Server::MULTI_THREADED) );
+
+  server.startBrokering();
+  REMUS_ASSERT( (server.isBrokering() == true) );
+  server.stopBrokering();
+  REMUS_ASSERT( (server.isBrokering() == false) );
+
+  server.startBrokering();
+  REMUS_ASSERT( (server.isBrokering() == true) );
+  server.stopBrokering();
+
+  server.brokerThreading(remus::server::Server::SINGLE_THREADED);
+  REMUS_ASSERT( (server.brokerThreading() == remus::server::Server::SINGLE_THREADED) );
+}
+
 void test_server_sig_catching()
 {
   void (*prev_sig_func)(int);
@@ -339,6 +405,15 @@ int UnitTestServer(int, char *[])
   //Test server rate changes
   test_server_poll_rates();
 
+  //Test server message batch size changes
+  test_server_message_batch_size();
+
+  //Test server heartbeat check interval changes
+  test_server_heartbeat_check_interval();
+
+  //Test server broker threading changes
+  test_server_threading();
+
   //Test server signal catching
   test_server_sig_catching();
 
@@ -11,6 +11,7 @@
 //=============================================================================
 
 #include <iostream>
+#include <remus/server/FactoryFileParser.h>
 #include <remus/server/WorkerFactory.h>
 #include <remus/testing/Testing.h>
 #include <remus/common/SleepFor.h>
@@ -294,6 +295,274 @@ void test_factory_worker_launching()
     SleepForMillisec(5);
     f_def.updateWorkerCount();
     }
+
+  //workers are launched by helper threads unless told otherwise, when
+  //they are launched before createWorker returns
+  REMUS_ASSERT( (f_def.maxParallelLaunches() == 4) );
+  f_def.setMaxParallelLaunches(0);
+  REMUS_ASSERT( (f_def.maxParallelLaunches() == 0) );
+
+  REMUS_ASSERT( (f_def.createWorker(raw_edges,kill) == true) );
+  REMUS_ASSERT( (f_def.currentWorkerCount() == 1) );
+  while (f_def.currentWorkerCount() == 1)
+    {
+    SleepForMillisec(5);
+    f_def.updateWorkerCount();
+    }
+}
+
+void test_factory_autoscaling()
+{
+  const remus::server::WorkerFactoryBase::FactoryDeletionBehavior kill =
+                remus::server::WorkerFactoryBase::KillOnFactoryDeletion;
+
+  remus::server::WorkerFactory f_def(".tst");
+  f_def.addCommandLineArgument("SLEEP_AND_EXIT");
+  f_def.addWorkerSearchDirectory(
+                  remus::server::testing::worker_factory::locationToSearch() );
+
+  remus::proto::JobRequirements raw_edges = make_Reqs(Edges(),Mesh2D());
+  remus::proto::JobRequirements other = make_Reqs(Edges(),Mesh3D());
+
+  //without a max for the requirements the max of the factory is used, and
+  //a max for the requirements can't go over the max of the factory
+  f_def.setMaxWorkerCount(3);
+  REMUS_ASSERT( (f_def.maxWorkerCount(raw_edges) == 3) );
+  f_def.setMaxWorkerCount(raw_edges, 5);
+  REMUS_ASSERT( (f_def.maxWorkerCount(raw_edges) == 3) );
+  f_def.setMaxWorkerCount(raw_edges, 1);
+  REMUS_ASSERT( (f_def.maxWorkerCount(raw_edges) == 1) );
+  REMUS_ASSERT( (f_def.maxWorkerCount(other) == 3) );
+
+  //the max for the requirements stops workers from being launched while
+  //the factory still has room
+  REMUS_ASSERT( (f_def.haveRoomForWorker(raw_edges) == true) );
+  REMUS_ASSERT( (f_def.createWorker(raw_edges,kill) == true) );
+  REMUS_ASSERT( (f_def.launchedWorkerCount(raw_edges) == 1) );
+  REMUS_ASSERT( (f_def.launchedWorkerCount(other) == 0) );
+  REMUS_ASSERT( (f_def.haveRoomForWorker(raw_edges) == false) );
+  REMUS_ASSERT( (f_def.haveRoomForWorker(other) == true) );
+  REMUS_ASSERT( (f_def.createWorker(raw_edges,kill) == false) );
+  REMUS_ASSERT( (f_def.currentWorkerCount() == 1) );
+
+  //without a target queue wait a single worker is launched at a time, and
+  //none once the requirements have as many workers as they are allowed
+  REMUS_ASSERT( (f_def.targetQueueWait() < 0) );
+  REMUS_ASSERT( (f_def.workersToLaunch(other,4,0) == 1) );
+  REMUS_ASSERT( (f_def.workersToLaunch(other,4,100000) == 1) );
+  REMUS_ASSERT( (f_def.workersToLaunch(other,0,0) == 0) );
+  REMUS_ASSERT( (f_def.workersToLaunch(raw_edges,4,0) == 0) );
+
+  //with a target, a single worker is still launched for jobs that haven't
+  //waited for the target, even when the requirements have no worker
+  f_def.setTargetQueueWait(500);
+  REMUS_ASSERT( (f_def.targetQueueWait() == 500) );
+  REMUS_ASSERT( (f_def.launchedWorkerCount(other) == 0) );
+  REMUS_ASSERT( (f_def.workersToLaunch(other,4,100) == 1) );
+  REMUS_ASSERT( (f_def.workersToLaunch(other,0,1000) == 0) );
+
+  //once the oldest job has waited for the target, a worker is launched for
+  //every queued job that there is room for. The factory has room for two
+  //more workers
+  REMUS_ASSERT( (f_def.workersToLaunch(other,2,500) == 2) );
+  REMUS_ASSERT( (f_def.workersToLaunch(other,4,500) == 2) );
+  REMUS_ASSERT( (f_def.workersToLaunch(raw_edges,4,500) == 0) );
+
+  //idle workers are never terminated by default
+  REMUS_ASSERT( (f_def.idleWorkerTimeout() < 0) );
+  f_def.setIdleWorkerTimeout(60000);
+  REMUS_ASSERT( (f_def.idleWorkerTimeout() == 60000) );
+
+  //wait for the processes to finish
+  while (f_def.currentWorkerCount() > 0)
+    {
+    SleepForMillisec(5);
+    f_def.updateWorkerCount();
+    }
+  REMUS_ASSERT( (f_def.haveRoomForWorker(raw_edges) == true) );
+}
+
+void test_factory_resident_workers()
+{
+  const remus::server::WorkerFactoryBase::FactoryDeletionBehavior kill =
+                remus::server::WorkerFactoryBase::KillOnFactoryDeletion;
+
+  //verify the limits of the worker file are parsed
+  boost::filesystem::path rw_file(
+                  remus::server::testing::worker_factory::locationToSearch() );
+  rw_file /= "TestWorker.rsd";
+  remus::server::FactoryFileParser parser;
+  remus::server::FactoryWorkerSpecification spec = parser(rw_file);
+  REMUS_ASSERT( (spec.isValid) );
+  REMUS_ASSERT( (spec.isResident()) );
+  REMUS_ASSERT( (spec.MaxJobsPerProcess == 3) );
+  REMUS_ASSERT( (spec.IdleTimeout == 500) );
+
+  //workers that don't state limits handle a single job
+  rw_file.replace_extension(".tst");
+  REMUS_ASSERT( (parser(rw_file).isResident() == false) );
+
+  remus::server::WorkerFactory f_def(".rsd");
+  f_def.addWorkerSearchDirectory(
+                  remus::server::testing::worker_factory::locationToSearch() );
+
+  remus::proto::JobRequirements resident =
+                            make_Reqs(Edges(),Mesh2D(),"ResidentWorker");
+  REMUS_ASSERT( (f_def.haveSupport(resident)) );
+  REMUS_ASSERT( (f_def.haveLaunchedWorker(resident) == false) );
+
+  f_def.setMaxWorkerCount(1);
+  REMUS_ASSERT( (f_def.createWorker(resident,kill) == true) );
+  REMUS_ASSERT( (f_def.currentWorkerCount() == 1) );
+  REMUS_ASSERT( (f_def.haveLaunchedWorker(resident) == true) );
+  REMUS_ASSERT( (f_def.haveLaunchedWorker(make_Reqs(Edges(),Mesh2D())) == false) );
+
+  //the running process handles the next two jobs, so no other process
+  //is launched for them
+  REMUS_ASSERT( (f_def.createWorker(resident,kill) == true) );
+  REMUS_ASSERT( (f_def.createWorker(resident,kill) == true) );
+  REMUS_ASSERT( (f_def.currentWorkerCount() == 1) );
+
+  //the process can't handle a fourth job, and there is no room for
+  //another process
+  REMUS_ASSERT( (f_def.createWorker(resident,kill) == false) );
+
+  f_def.setMaxWorkerCount(2);
+  REMUS_ASSERT( (f_def.createWorker(resident,kill) == true) );
+  REMUS_ASSERT( (f_def.currentWorkerCount() == 2) );
+
+  //wait for the processes to finish
+  while (f_def.currentWorkerCount() > 0)
+    {
+    SleepForMillisec(5);
+    f_def.updateWorkerCount();
+    }
+  REMUS_ASSERT( (f_def.haveLaunchedWorker(resident) == false) );
+}
+
+void test_factory_prewarmed_workers()
+{
+  //verify the minimum of the worker file is parsed
+  boost::filesystem::path rw_file(
+                  remus::server::testing::worker_factory::locationToSearch() );
+  rw_file /= "TestWorker.pwm";
+  remus::server::FactoryFileParser parser;
+  REMUS_ASSERT( (parser(rw_file).MinIdleWorkers == 2) );
+
+  rw_file.replace_extension(".tst");
+  REMUS_ASSERT( (parser(rw_file).MinIdleWorkers == 0) );
+
+  remus::server::WorkerFactory f_def(".pwm");
+  f_def.addWorkerSearchDirectory(
+                  remus::server::testing::worker_factory::locationToSearch() );
+
+  remus::proto::JobRequirements prewarmed =
+                            make_Reqs(Edges(),Mesh2D(),"PrewarmedWorker");
+  REMUS_ASSERT( (f_def.minIdleWorkers(prewarmed) == 2) );
+  REMUS_ASSERT( (f_def.prewarmedRequirements().count(prewarmed) == 1) );
+
+  //workers the factory doesn't support are never prewarmed
+  remus::proto::JobRequirements other = make_Reqs(Edges(),Mesh2D());
+  f_def.setMinIdleWorkers(other, 1);
+  REMUS_ASSERT( (f_def.prewarmedRequirements().size() == 1) );
+  REMUS_ASSERT( (f_def.prewarmWorkers(other,0,0) == 0) );
+
+  //launch the minimum, and nothing more once they are starting
+  f_def.setMaxWorkerCount(3);
+  REMUS_ASSERT( (f_def.prewarmWorkers(prewarmed,0,0) == 2) );
+  REMUS_ASSERT( (f_def.currentWorkerCount() == 2) );
+  REMUS_ASSERT( (f_def.prewarmWorkers(prewarmed,2,0) == 0) );
+  REMUS_ASSERT( (f_def.prewarmWorkers(prewarmed,0,0) == 0) );
+
+  //once the workers are busy the factory tops up, but never launches more
+  //workers than the max worker count allows
+  REMUS_ASSERT( (f_def.prewarmWorkers(prewarmed,0,2) == 1) );
+  REMUS_ASSERT( (f_def.currentWorkerCount() == 3) );
+  REMUS_ASSERT( (f_def.prewarmWorkers(prewarmed,0,3) == 0) );
+
+  //the minimum set on the factory overrides the worker file
+  f_def.setMinIdleWorkers(prewarmed, 0);
+  REMUS_ASSERT( (f_def.minIdleWorkers(prewarmed) == 0) );
+  REMUS_ASSERT( (f_def.prewarmedRequirements().size() == 0) );
+  REMUS_ASSERT( (f_def.prewarmWorkers(prewarmed,0,3) == 0) );
+
+  //wait for the processes to finish
+  while (f_def.currentWorkerCount() > 0)
+    {
+    SleepForMillisec(5);
+    f_def.updateWorkerCount();
+    }
+}
+
+void test_factory_limited_workers()
+{
+  //verify the limits of the worker file are parsed
+  boost::filesystem::path rw_file(
+                  remus::server::testing::worker_factory::locationToSearch() );
+  rw_file /= "TestWorker.lim";
+  remus::server::FactoryFileParser parser;
+  const remus::common::ProcessLimits limits = parser(rw_file).Limits;
+  REMUS_ASSERT( (limits.MaxOpenFiles == 64) );
+  REMUS_ASSERT( (limits.MaxMemoryBytes == 1024 * 1024 * 1024) );
+  REMUS_ASSERT( (limits.CpuQuota == 0) );
+  REMUS_ASSERT( limits.limited() );
+
+  rw_file.replace_extension(".tst");
+  REMUS_ASSERT( !parser(rw_file).Limits.limited() );
+
+  const remus::server::WorkerFactoryBase::FactoryDeletionBehavior kill =
+                remus::server::WorkerFactoryBase::KillOnFactoryDeletion;
+
+  //the worker checks that it was launched with its limits, and exits by
+  //itself when it was, so it isn't a failure
+  remus::server::WorkerFactory f_def(".lim");
+  f_def.addWorkerSearchDirectory(
+                  remus::server::testing::worker_factory::locationToSearch() );
+  f_def.setMaxWorkerCount(1);
+  remus::proto::JobRequirements limited =
+                            make_Reqs(Edges(),Mesh2D(),"LimitedWorker");
+  REMUS_ASSERT( (f_def.createWorker(limited,kill) == true) );
+  while (f_def.currentWorkerCount() > 0)
+    {
+    SleepForMillisec(5);
+    f_def.updateWorkerCount();
+    }
+  REMUS_ASSERT( (f_def.takeWorkerFailures().size() == 0) );
+
+  //a worker that crashes is a failure, which is only returned once
+  remus::server::WorkerFactory f_crash(".tst");
+  f_crash.addWorkerSearchDirectory(
+                  remus::server::testing::worker_factory::locationToSearch() );
+  f_crash.setMaxWorkerCount(1);
+  f_crash.addCommandLineArgument("CRASH");
+  REMUS_ASSERT( (f_crash.createWorker(make_Reqs(Edges(),Mesh2D()),kill) == true) );
+  while (f_crash.currentWorkerCount() > 0)
+    {
+    SleepForMillisec(5);
+    f_crash.updateWorkerCount();
+    }
+  std::vector<remus::server::WorkerFailure> failures =
+                                              f_crash.takeWorkerFailures();
+  REMUS_ASSERT( (failures.size() == 1) );
+  REMUS_ASSERT( (!failures[0].LaunchId.empty()) );
+  REMUS_ASSERT( (failures[0].Reason == "worker process ended abnormally") );
+  REMUS_ASSERT( (f_crash.takeWorkerFailures().size() == 0) );
+
+  //a worker that exits with a nonzero code is a failure as well
+  remus::server::WorkerFactory f_exit(".tst");
+  f_exit.addWorkerSearchDirectory(
+                  remus::server::testing::worker_factory::locationToSearch() );
+  f_exit.setMaxWorkerCount(1);
+  f_exit.addCommandLineArgument("EXIT_WITH_ERROR");
+  REMUS_ASSERT( (f_exit.createWorker(make_Reqs(Edges(),Mesh2D()),kill) == true) );
+  while (f_exit.currentWorkerCount() > 0)
+    {
+    SleepForMillisec(5);
+    f_exit.updateWorkerCount();
+    }
+  failures = f_exit.takeWorkerFailures();
+  REMUS_ASSERT( (failures.size() == 1) );
+  REMUS_ASSERT( (failures[0].Reason == "worker process exited with code 3") );
 }
 
 void test_shutdown_with_active_killOnFactoryDel_workers()
@@ -368,6 +637,16 @@ int UnitTestWorkerFactory(int, char *[])
 
   test_factory_worker_launching();
 
+  test_factory_autoscaling();
+
+  test_factory_resident_workers();
+
+  std::cout << __LINE__ << std::endl;
+  test_factory_prewarmed_workers();
+
+  std::cout << __LINE__ << std::endl;
+  test_factory_limited_workers();
+
   std::cout << __LINE__ << std::endl;
   test_shutdown_with_active_killOnFactoryDel_workers();
 
@@ -23,6 +23,9 @@ REMUS_THIRDPARTY_PRE_INCLUDE
 #include <boost/date_time/posix_time/posix_time.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
+#include <algorithm>
+#include <deque>
+
 namespace
 {
 
@@ -99,7 +102,7 @@ void client_query_performance(remus::proto::Job job,
     //ask for the current status of a job
     status = client->jobStatus( job );
     }
-  //Client is REQ/REP so everything has been sent/recv by this line
+  //jobStatus waits for every reply, so everything has been sent/recv by this line
   const ptime endTime = boost::posix_time::microsec_clock::local_time();
   const time_duration dur = endTime - startTime;
 
@@ -158,6 +161,63 @@ void client_query_performance(remus::proto::Job job,
 
 }
 
+
+//------------------------------------------------------------------------------
+//returns the number of status queries per millisecond when we keep depth
+//queries in flight at once
+boost::int64_t pipelined_query_rate(remus::proto::Job job,
+                                    boost::shared_ptr< remus::Client > client,
+                                    std::size_t depth)
+{
+  typedef boost::posix_time::ptime ptime;
+  typedef boost::posix_time::time_duration time_duration;
+  typedef boost::shared_future<remus::proto::JobStatus> StatusFuture;
+
+  std::deque<StatusFuture> inFlight;
+
+  const ptime startTime = boost::posix_time::microsec_clock::local_time();
+  for( std::size_t i=0; i < num_messages; ++i)
+    {
+    if(inFlight.size() == depth)
+      {
+      REMUS_ASSERT( inFlight.front().get().good() )
+      inFlight.pop_front();
+      }
+    inFlight.push_back( client->jobStatusAsync( job ) );
+    }
+  for(; !inFlight.empty(); inFlight.pop_front())
+    {
+    REMUS_ASSERT( inFlight.front().get().good() )
+    }
+  const ptime endTime = boost::posix_time::microsec_clock::local_time();
+  const time_duration dur = endTime - startTime;
+
+  const boost::int64_t millisec = std::max<boost::int64_t>(1,
+                                                  dur.total_milliseconds());
+  const boost::int64_t queries_per_msec = num_messages / millisec;
+  std::cout << "Pipeline depth " << depth << ": " << millisec
+            << " milliseconds, " << queries_per_msec
+            << " queries per millisec" << std::endl;
+  return queries_per_msec;
+}
+
+//------------------------------------------------------------------------------
+void client_pipeline_performance(remus::proto::Job job,
+                                 boost::shared_ptr< remus::Client > client)
+{
+  const std::size_t depths[] = {1, 4, 16, 64};
+  const std::size_t numDepths = sizeof(depths)/sizeof(depths[0]);
+
+  boost::int64_t rates[numDepths];
+  for(std::size_t i=0; i < numDepths; ++i)
+    {
+    rates[i] = pipelined_query_rate(job, client, depths[i]);
+    }
+
+  //keeping queries in flight hides the round trip to the server, so a deep
+  //pipeline has to do better than waiting for every reply
+  REMUS_ASSERT( (rates[numDepths-1] > rates[0]) )
+}
 }
 
 int main(int argc, char* argv[])
@@ -186,6 +246,7 @@ int main(int argc, char* argv[])
   worker->updateStatus( status );
 
   client_query_performance(j, client);
+  client_pipeline_performance(j, client);
 
   return 0;
 }
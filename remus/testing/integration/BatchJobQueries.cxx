@@ -0,0 +1,207 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+
+#include <set>
+#include <vector>
+
+namespace
+{
+
+static const std::size_t num_jobs = 200;
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  remus::server::PollingRates newRates(1500,60000);
+  server->pollingRates(newRates);
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports,
+                                              remus::proto::WireFormat::Type format )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+  conn.wireFormat(format);
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports )
+{
+  using namespace remus::meshtypes;
+
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobRequirements requirements =
+          remus::proto::make_JobRequirements(io_type, "BatchWorker", "");
+  boost::shared_ptr<remus::Worker> w(new remus::Worker(requirements,conn));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+//the server only knows the requirements of a worker once it asks for a job
+remus::proto::JobRequirements ready_worker(boost::shared_ptr<remus::Client> client,
+                                           boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::meshtypes;
+
+  worker->askForJobs(1);
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobRequirementsSet reqs = client->retrieveRequirements(io_type);
+  while(reqs.size() == 0)
+    {
+    remus::common::SleepForMillisec(50);
+    reqs = client->retrieveRequirements(io_type);
+    }
+  return *reqs.begin();
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::JobSubmission>
+make_Submissions(const remus::proto::JobRequirements& reqs, std::size_t count)
+{
+  std::vector<remus::proto::JobSubmission> subs;
+  for(std::size_t i=0; i < count; ++i)
+    {
+    remus::proto::JobSubmission sub(reqs);
+    sub["data"] = remus::proto::make_JobContent(
+                          remus::testing::AsciiStringGenerator(i+1) );
+    subs.push_back(sub);
+    }
+  return subs;
+}
+
+//------------------------------------------------------------------------------
+//returns the index of the job the worker was given
+std::size_t verify_worker_job(boost::shared_ptr<remus::Worker> worker,
+                    const std::vector<remus::proto::Job>& jobs,
+                    const std::vector<remus::proto::JobSubmission>& subs)
+{
+  //wait for the job the worker asked for, getJob would ask for another
+  //when the first hasn't arrived yet
+  remus::worker::Job workerJob = worker->takePendingJob();
+  while(!workerJob.valid())
+    {
+    remus::common::SleepForMillisec(10);
+    workerJob = worker->takePendingJob();
+    }
+
+  std::size_t index = 0;
+  while(index < jobs.size() && jobs[index].id() != workerJob.id())
+    {
+    ++index;
+    }
+  REMUS_ASSERT( (index < jobs.size()) )
+
+  //the worker gets the submission that was batched with the job
+  const remus::proto::JobContent& sent = subs[index].find("data")->second;
+  const remus::proto::JobContent& got =
+                          workerJob.submission().find("data")->second;
+  REMUS_ASSERT( (std::string(got.data(), got.dataSize()) ==
+                 std::string(sent.data(), sent.dataSize())) )
+  return index;
+}
+
+//------------------------------------------------------------------------------
+void verify_batches(const remus::server::ServerPorts& ports,
+                    remus::proto::WireFormat::Type format)
+{
+  using namespace remus::proto;
+
+  boost::shared_ptr<remus::Client> client = make_Client(ports, format);
+  boost::shared_ptr<remus::Worker> worker = make_Worker(ports);
+  const JobRequirements reqs = ready_worker(client,worker);
+
+  //every submission gets its own job, in the order they were submitted
+  const std::vector<JobSubmission> subs = make_Submissions(reqs, num_jobs);
+  const std::vector<Job> jobs = client->submitJobs(subs);
+  REMUS_ASSERT( (jobs.size() == num_jobs) )
+  std::set<boost::uuids::uuid> ids;
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    REMUS_ASSERT( jobs[i].valid() )
+    REMUS_ASSERT( (jobs[i].type() == subs[i].type()) )
+    ids.insert(jobs[i].id());
+    }
+  REMUS_ASSERT( (ids.size() == num_jobs) )
+
+  const std::size_t active = verify_worker_job(worker, jobs, subs);
+
+  //the statuses are in the same order as the jobs
+  std::vector<JobStatus> statuses = client->jobStatus(jobs);
+  REMUS_ASSERT( (statuses.size() == num_jobs) )
+  for(std::size_t i=0; i < statuses.size(); ++i)
+    {
+    REMUS_ASSERT( (statuses[i].id() == jobs[i].id()) )
+    REMUS_ASSERT( statuses[i].good() )
+    REMUS_ASSERT( (i == active || statuses[i].queued()) )
+    }
+
+  //terminating the jobs removes the queued ones from the server
+  statuses = client->terminate(jobs);
+  REMUS_ASSERT( (statuses.size() == num_jobs) )
+  for(std::size_t i=0; i < statuses.size(); ++i)
+    {
+    REMUS_ASSERT( (statuses[i].id() == jobs[i].id()) )
+    REMUS_ASSERT( (statuses[i].status() == remus::FAILED) )
+    }
+
+  statuses = client->jobStatus(jobs);
+  for(std::size_t i=0; i < statuses.size(); ++i)
+    {
+    REMUS_ASSERT( (i == active || statuses[i].invalid()) )
+    }
+
+  //empty batches never reach the server
+  REMUS_ASSERT( client->submitJobs(std::vector<JobSubmission>()).empty() )
+  REMUS_ASSERT( client->jobStatus(std::vector<Job>()).empty() )
+}
+
+}
+
+//Submits, queries and terminates many jobs with a single query each,
+//for clients that use either wire format
+int BatchJobQueries(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  verify_batches(ports, remus::proto::WireFormat::Binary);
+  verify_batches(ports, remus::proto::WireFormat::Text);
+
+  return 0;
+}
@@ -0,0 +1,230 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+
+//suppress warnings inside boost headers for gcc and clang
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+
+static const std::size_t num_jobs = 48;
+static const unsigned int concurrency = 8;
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports )
+{
+  using namespace remus::meshtypes;
+
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+  //stream results in many small chunks, so that the replies to the chunks
+  //of different jobs are interleaved
+  conn.chunkSize(512);
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobRequirements requirements =
+          remus::proto::make_JobRequirements(io_type, "ConcurrentWorker", "");
+  boost::shared_ptr<remus::Worker> w(new remus::Worker(requirements,conn));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+//tracks how many jobs are being handled at the same time
+struct Occupancy
+{
+  Occupancy(): Mutex(), Current(0), Peak(0) {}
+
+  void enter()
+  {
+    boost::lock_guard<boost::mutex> lock(this->Mutex);
+    ++this->Current;
+    this->Peak = std::max(this->Peak, this->Current);
+  }
+
+  void leave()
+  {
+    boost::lock_guard<boost::mutex> lock(this->Mutex);
+    --this->Current;
+  }
+
+  boost::mutex Mutex;
+  unsigned int Current;
+  unsigned int Peak;
+};
+
+//------------------------------------------------------------------------------
+std::string make_ResultData(const std::string& input)
+{
+  std::string result;
+  for(int i=0; i < 10; ++i)
+    {
+    result += input;
+    }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+//echos the data of the job back as its result, alternating between results
+//that are sent in one message and ones that are streamed
+void handle_Job(Occupancy* occupancy,
+                remus::worker::Worker& worker,
+                const remus::worker::Job& job)
+{
+  occupancy->enter();
+
+  const remus::proto::JobContent& content = job.submission().find("data")->second;
+  const std::string data(content.data(), content.dataSize());
+  if(data == "throw")
+    {
+    occupancy->leave();
+    throw std::runtime_error("asked to throw");
+    }
+
+  for(int progress=25; progress < 100; progress += 25)
+    {
+    worker.sendProgress(job, progress, std::string());
+    remus::common::SleepForMillisec(20);
+    }
+
+  const std::string result = make_ResultData(data);
+  if(data.size() % 2 == 0)
+    {
+    std::istringstream stream(result);
+    worker.returnResult(job, remus::common::ContentFormat::User, stream);
+    }
+  else
+    {
+    worker.returnResult( remus::proto::make_JobResult(job.id(), result) );
+    }
+  occupancy->leave();
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::Job> submit_Jobs(boost::shared_ptr<remus::Client> client,
+                                           boost::shared_ptr<remus::Worker> worker,
+                                           std::vector<std::string>& data)
+{
+  using namespace remus::meshtypes;
+
+  //the server only knows the requirements of the worker once it asks
+  //for a job, which the executor will take once it starts
+  worker->askForJobs(1);
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobRequirementsSet reqs = client->retrieveRequirements(io_type);
+  while(reqs.size() == 0)
+    {
+    remus::common::SleepForMillisec(50);
+    reqs = client->retrieveRequirements(io_type);
+    }
+
+  std::vector<remus::proto::JobSubmission> subs;
+  for(std::size_t i=0; i < num_jobs; ++i)
+    {
+    data.push_back( (i == 5) ? std::string("throw") :
+                    remus::testing::AsciiStringGenerator(1000 + i) );
+    remus::proto::JobSubmission sub(*reqs.begin());
+    sub["data"] = remus::proto::make_JobContent(data.back());
+    subs.push_back(sub);
+    }
+  return client->submitJobs(subs);
+}
+
+}
+
+//Executes many jobs at once on a single worker, whose results are sent
+//from many threads at the same time
+int ConcurrentWorkerJobs(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client(ports);
+  boost::shared_ptr<remus::Worker> worker = make_Worker(ports);
+
+  std::vector<std::string> data;
+  const std::vector<remus::proto::Job> jobs = submit_Jobs(client, worker, data);
+  REMUS_ASSERT( (jobs.size() == num_jobs) )
+
+  Occupancy occupancy;
+  const std::size_t handled =
+    worker->execute(boost::bind(handle_Job, &occupancy, _1, _2),
+                    concurrency, num_jobs);
+  REMUS_ASSERT( (handled == num_jobs) )
+
+  //the jobs were handled at the same time, but never by more threads
+  //than we asked for
+  REMUS_ASSERT( (occupancy.Peak > 1) )
+  REMUS_ASSERT( (occupancy.Peak <= concurrency) )
+  REMUS_ASSERT( (occupancy.Current == 0) )
+
+  //every job has the result its own thread sent
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    remus::proto::JobStatus status = client->jobStatus(jobs[i]);
+    if(data[i] == "throw")
+      {
+      REMUS_ASSERT( (status.status() == remus::FAILED) )
+      continue;
+      }
+
+    REMUS_ASSERT( status.finished() )
+    const remus::proto::JobResult result = client->retrieveResults(jobs[i]);
+    REMUS_ASSERT( result.valid() )
+    REMUS_ASSERT( (std::string(result.data(), result.dataSize()) ==
+                   make_ResultData(data[i])) )
+    }
+
+  return 0;
+}
@@ -0,0 +1,42 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/worker/Worker.h>
+
+#include <stdlib.h>
+
+//A worker launched by a worker factory, that takes a job and crashes
+//before finishing it
+int main(int argc, char** argv)
+{
+  if(argc < 2)
+    {
+    return 1;
+    }
+
+  using namespace remus::meshtypes;
+  remus::common::MeshIOType io_type =
+                        remus::common::make_MeshIOType(Edges(),Mesh2D());
+  remus::proto::JobRequirements requirements =
+          remus::proto::make_JobRequirements(io_type, "CrashingWorker", "");
+
+  remus::worker::ServerConnection conn =
+                          remus::worker::make_ServerConnection(argv[1]);
+  remus::worker::Worker worker(requirements, conn);
+
+  remus::worker::Job job = worker.getJob();
+  if(job.valid())
+    {
+    abort();
+    }
+  return 0;
+}
@@ -0,0 +1,87 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+
+#include "FailedWorkerProcessPaths.h"
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+//the factory launches the crashing worker, whose process takes a job
+//and aborts
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  boost::shared_ptr<remus::server::WorkerFactory> factory(
+                              new remus::server::WorkerFactory(".crw"));
+  factory->addWorkerSearchDirectory(
+                  remus::testing::failed_worker_process::locationToSearch() );
+  factory->setMaxWorkerCount(1);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+}
+
+//The server fails the job of a worker whose process crashed while holding
+//it, with the reason the factory gives, instead of waiting for the worker
+//to miss its heartbeats
+int FailedWorkerProcess(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  using namespace remus::meshtypes;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  boost::shared_ptr<remus::Client> client = make_Client( server->serverPortInfo() );
+
+  remus::common::MeshIOType io_type =
+                        remus::common::make_MeshIOType(Edges(),Mesh2D());
+  remus::proto::JobRequirementsSet reqs = client->retrieveRequirements(io_type);
+  REMUS_ASSERT( (reqs.size() == 1) );
+
+  remus::proto::JobSubmission sub(*reqs.begin());
+  sub["data"] = remus::proto::make_JobContent("crash");
+  remus::proto::Job job = client->submitJob(sub);
+  REMUS_ASSERT( job.valid() );
+
+  remus::proto::JobStatus status = client->jobStatus(job);
+  while(status.good())
+    {
+    remus::common::SleepForMillisec(50);
+    status = client->jobStatus(job);
+    }
+
+  REMUS_ASSERT( (status.status() == remus::FAILED) );
+  REMUS_ASSERT( (status.progress().message() ==
+                 "worker process ended abnormally") );
+  return 0;
+}
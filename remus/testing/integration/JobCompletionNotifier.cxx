@@ -0,0 +1,269 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+
+#include <remus/client/Client.h>
+#include <remus/client/JobNotifier.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/common/Timer.h>
+#include <remus/testing/Testing.h>
+
+//suppress warnings inside boost headers for gcc and clang
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <vector>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  remus::server::PollingRates newRates(1500,60000);
+  server->pollingRates(newRates);
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports )
+{
+  using namespace remus::meshtypes;
+
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobRequirements requirements =
+          remus::proto::make_JobRequirements(io_type, "NotifiedWorker", "");
+  boost::shared_ptr<remus::Worker> w(new remus::Worker(requirements,conn));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+//the worker asks for a single job, which is also how the server learns the
+//requirements the jobs are submitted with
+std::vector<remus::proto::Job> submit_Jobs(boost::shared_ptr<remus::Client> client,
+                                           boost::shared_ptr<remus::Worker> worker,
+                                           std::size_t count)
+{
+  using namespace remus::meshtypes;
+
+  worker->askForJobs(1);
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobRequirementsSet reqs = client->retrieveRequirements(io_type);
+  while(reqs.size() == 0)
+    {
+    remus::common::SleepForMillisec(50);
+    reqs = client->retrieveRequirements(io_type);
+    }
+
+  std::vector<remus::proto::JobSubmission> subs(count,
+                                remus::proto::JobSubmission(*reqs.begin()));
+  return client->submitJobs(subs);
+}
+
+//------------------------------------------------------------------------------
+//wait for the job the worker asked for to arrive
+remus::worker::Job take_Job(boost::shared_ptr<remus::Worker> worker)
+{
+  remus::worker::Job job = worker->takePendingJob();
+  while(!job.valid())
+    {
+    remus::common::SleepForMillisec(10);
+    job = worker->takePendingJob();
+    }
+  return job;
+}
+
+//------------------------------------------------------------------------------
+void finish_Job(boost::shared_ptr<remus::Worker> worker,
+                remus::worker::Job job,
+                int delayMillisec)
+{
+  remus::common::SleepForMillisec(delayMillisec);
+  worker->returnResult( remus::proto::make_JobResult(job.id(), "done") );
+}
+
+//------------------------------------------------------------------------------
+void record_Status(std::vector<remus::proto::JobStatus>* statuses,
+                   const remus::proto::JobStatus& status)
+{
+  statuses->push_back(status);
+}
+
+//------------------------------------------------------------------------------
+void poll_Callbacks(remus::client::JobNotifier& notifier)
+{
+  remus::common::Timer timer;
+  while(notifier.pendingCallbacks() > 0 && timer.elapsed() < 20000)
+    {
+    notifier.poll(100);
+    }
+  REMUS_ASSERT( (notifier.pendingCallbacks() == 0) )
+}
+
+//------------------------------------------------------------------------------
+void verify_blocking_wait(boost::shared_ptr<remus::Client> client,
+                          boost::shared_ptr<remus::Worker> worker,
+                          remus::client::JobNotifier& notifier)
+{
+  using namespace remus::proto;
+
+  //only an event can complete the waits before the fallback query
+  notifier.fallbackInterval(60000);
+
+  const Job job = submit_Jobs(client, worker, 1).front();
+  const remus::worker::Job workerJob = take_Job(worker);
+  REMUS_ASSERT( (workerJob.id() == job.id()) )
+
+  //the wait times out while the job is still running
+  JobStatus status = notifier.waitForCompletion(job, 100);
+  REMUS_ASSERT( status.good() )
+
+  //the job finishes while we are waiting on it, once our subscription
+  //has had time to reach the server
+  boost::thread finisher( boost::bind(finish_Job, worker, workerJob, 1000) );
+  remus::common::Timer timer;
+  status = notifier.waitForCompletion(job);
+  finisher.join();
+  REMUS_ASSERT( status.finished() )
+  REMUS_ASSERT( (status.id() == job.id()) )
+  REMUS_ASSERT( (timer.elapsed() < 30000) )
+
+  //a job that completed before we wait is found by the first status query
+  status = notifier.waitForCompletion(job, 0);
+  REMUS_ASSERT( status.finished() )
+  client->retrieveResults(job);
+}
+
+//------------------------------------------------------------------------------
+void verify_callbacks(boost::shared_ptr<remus::Client> client,
+                      boost::shared_ptr<remus::Worker> worker,
+                      remus::client::JobNotifier& notifier)
+{
+  using namespace remus::proto;
+
+  //the worker can fail its job before our subscription reaches the server,
+  //in which case the fallback query finds it
+  notifier.fallbackInterval(1000);
+
+  const std::vector<Job> jobs = submit_Jobs(client, worker, 3);
+  REMUS_ASSERT( (jobs.size() == 3) )
+
+  std::vector<JobStatus> anyStatus;
+  std::vector<JobStatus> lastStatus;
+  notifier.waitForAny(jobs, boost::bind(record_Status, &anyStatus, _1));
+  notifier.waitForCompletion(jobs.back(),
+                             boost::bind(record_Status, &lastStatus, _1));
+  REMUS_ASSERT( (notifier.pendingCallbacks() == 2) )
+
+  //the worker failing the job it was given completes the first wait
+  const remus::worker::Job workerJob = take_Job(worker);
+  worker->sendJobFailure(workerJob, "failed on purpose");
+  remus::common::Timer timer;
+  while(anyStatus.empty() && timer.elapsed() < 20000)
+    {
+    notifier.poll(100);
+    }
+  REMUS_ASSERT( (anyStatus.size() == 1) )
+  REMUS_ASSERT( (anyStatus.front().id() == workerJob.id()) )
+  REMUS_ASSERT( (anyStatus.front().status() == remus::FAILED) )
+
+  //terminating the queued jobs completes the other wait
+  client->terminate(jobs);
+  poll_Callbacks(notifier);
+  REMUS_ASSERT( (anyStatus.size() == 1) )
+  REMUS_ASSERT( (lastStatus.size() == 1) )
+  REMUS_ASSERT( (lastStatus.front().id() == jobs.back().id()) )
+  REMUS_ASSERT( (!lastStatus.front().good()) )
+}
+
+//------------------------------------------------------------------------------
+void verify_missed_events(boost::shared_ptr<remus::Client> client,
+                          boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::proto;
+
+  //a notifier that never hears an event, so it has to fall back to asking
+  //the server for the status of the job
+  remus::client::JobNotifier deaf(*client,
+            remus::client::make_ServerConnection("tcp://127.0.0.1:1"));
+  deaf.fallbackInterval(100);
+
+  const Job job = submit_Jobs(client, worker, 1).front();
+  std::vector<JobStatus> statuses;
+  deaf.waitForCompletion(job, boost::bind(record_Status, &statuses, _1));
+
+  const remus::worker::Job workerJob = take_Job(worker);
+  finish_Job(worker, workerJob, 0);
+  poll_Callbacks(deaf);
+  REMUS_ASSERT( (statuses.size() == 1) )
+  REMUS_ASSERT( statuses.front().finished() )
+
+  //the wait keeps asking while the job runs
+  const Job other = submit_Jobs(client, worker, 1).front();
+  boost::thread finisher( boost::bind(finish_Job, worker, take_Job(worker), 250) );
+  const JobStatus status = deaf.waitForCompletion(other, 20000);
+  finisher.join();
+  REMUS_ASSERT( status.finished() )
+}
+
+}
+
+//Waits on jobs to complete by listening to the events the server publishes,
+//instead of asking the server for their status over and over
+int JobCompletionNotifier(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client(ports);
+  boost::shared_ptr<remus::Worker> worker = make_Worker(ports);
+
+  remus::client::JobNotifier notifier(*client,
+            remus::client::make_ServerConnection(ports.status().endpoint()));
+
+  verify_blocking_wait(client, worker, notifier);
+  verify_callbacks(client, worker, notifier);
+  verify_missed_events(client, worker);
+
+  return 0;
+}
@@ -0,0 +1,229 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+
+#include <set>
+#include <vector>
+
+namespace
+{
+
+static const std::size_t num_jobs = 16;
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  remus::server::PollingRates newRates(1500,60000);
+  server->pollingRates(newRates);
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports )
+{
+  using namespace remus::meshtypes;
+
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobRequirements requirements =
+          remus::proto::make_JobRequirements(io_type, "PipelinedWorker", "");
+  boost::shared_ptr<remus::Worker> w(new remus::Worker(requirements,conn));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+//the server only knows the requirements of a worker once it asks for a job
+remus::proto::JobRequirements ready_worker(boost::shared_ptr<remus::Client> client,
+                                           boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::meshtypes;
+
+  worker->askForJobs(1);
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobRequirementsSet reqs = client->retrieveRequirements(io_type);
+  while(reqs.size() == 0)
+    {
+    remus::common::SleepForMillisec(50);
+    reqs = client->retrieveRequirements(io_type);
+    }
+  return *reqs.begin();
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::Job>
+verify_pipelined_submissions(boost::shared_ptr<remus::Client> client,
+                             const remus::proto::JobRequirements& reqs)
+{
+  using namespace remus::proto;
+
+  std::vector< boost::shared_future<Job> > futures;
+  for(std::size_t i=0; i < num_jobs; ++i)
+    {
+    JobSubmission sub(reqs);
+    sub["index"] = make_JobContent( remus::testing::AsciiStringGenerator(i+1) );
+    futures.push_back( client->submitJobAsync(sub) );
+    }
+  REMUS_ASSERT( (client->pendingResponses() == num_jobs) )
+
+  //a blocking query that is made while others are in flight gets the
+  //reply to it, and not one of theirs
+  remus::common::MeshIOTypeSet types = client->supportedIOTypes();
+  REMUS_ASSERT( (types.size() == 1) )
+
+  //every job is its own, even though we wait on them in reverse order
+  std::set<boost::uuids::uuid> ids;
+  for(std::size_t i=num_jobs; i > 0; --i)
+    {
+    const Job job = futures[i-1].get();
+    REMUS_ASSERT( job.valid() )
+    ids.insert(job.id());
+    }
+  REMUS_ASSERT( (ids.size() == num_jobs) )
+  REMUS_ASSERT( (client->pendingResponses() == 0) )
+
+  std::vector<Job> jobs;
+  for(std::size_t i=0; i < num_jobs; ++i)
+    {
+    jobs.push_back( futures[i].get() );
+    }
+  return jobs;
+}
+
+//------------------------------------------------------------------------------
+void verify_polled_status(boost::shared_ptr<remus::Client> client,
+                          const std::vector<remus::proto::Job>& jobs)
+{
+  using namespace remus::proto;
+
+  std::vector< boost::shared_future<JobStatus> > futures;
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    futures.push_back( client->jobStatusAsync(jobs[i]) );
+    }
+
+  //polling makes the futures ready without blocking on any of them
+  std::size_t ready = 0;
+  for(int tries=0; tries < 100 && client->pendingResponses() > 0; ++tries)
+    {
+    ready += client->pollResponses(50);
+    }
+  REMUS_ASSERT( (ready == jobs.size()) )
+  REMUS_ASSERT( (client->pollResponses() == 0) )
+
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    REMUS_ASSERT( futures[i].is_ready() )
+    const JobStatus status = futures[i].get();
+    REMUS_ASSERT( (status.id() == jobs[i].id()) )
+    REMUS_ASSERT( status.good() )
+    }
+}
+
+//------------------------------------------------------------------------------
+void verify_async_result(boost::shared_ptr<remus::Client> client,
+                         boost::shared_ptr<remus::Worker> worker,
+                         const std::vector<remus::proto::Job>& jobs)
+{
+  using namespace remus::proto;
+
+  remus::worker::Job workerJob = worker->getJob();
+  REMUS_ASSERT( workerJob.valid() )
+
+  const std::string output = remus::testing::BinaryDataGenerator(4096);
+  worker->returnResult( make_JobResult(workerJob.id(), output) );
+
+  std::size_t index = 0;
+  while(index < jobs.size() && jobs[index].id() != workerJob.id())
+    {
+    ++index;
+    }
+  REMUS_ASSERT( (index < jobs.size()) )
+  const remus::proto::Job& job = jobs[index];
+
+  JobStatus status = client->jobStatusAsync(job).get();
+  while(!status.finished())
+    {
+    remus::common::SleepForMillisec(50);
+    status = client->jobStatusAsync(job).get();
+    }
+
+  boost::shared_future<JobResult> result = client->retrieveResultsAsync(job);
+  const Job& otherJob = (jobs[0].id() == job.id()) ? jobs[1] : jobs[0];
+  boost::shared_future<JobStatus> other = client->jobStatusAsync(otherJob);
+  const JobResult r = result.get();
+  REMUS_ASSERT( (r.id() == job.id()) )
+  REMUS_ASSERT( (std::string(r.data(), r.dataSize()) == output) )
+  REMUS_ASSERT( other.get().good() )
+}
+
+//------------------------------------------------------------------------------
+void verify_broken_on_destruction(const remus::server::ServerPorts& ports,
+                                  const remus::proto::Job& job)
+{
+  boost::shared_future<remus::proto::JobStatus> status;
+  {
+  boost::shared_ptr<remus::Client> client = make_Client( ports );
+  status = client->jobStatusAsync(job);
+  }
+  REMUS_ASSERT( status.is_ready() )
+  REMUS_ASSERT( status.has_exception() )
+}
+
+}
+
+//Keeps many queries in flight on a single client connection, and checks
+//that every reply is matched to the query it answers
+int PipelinedClientQueries(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client( ports );
+  boost::shared_ptr<remus::Worker> worker = make_Worker( ports );
+
+  const remus::proto::JobRequirements reqs = ready_worker(client,worker);
+  std::vector<remus::proto::Job> jobs = verify_pipelined_submissions(client,reqs);
+  verify_polled_status(client,jobs);
+  verify_async_result(client,worker,jobs);
+  verify_broken_on_destruction(ports,jobs[0]);
+
+  return 0;
+}
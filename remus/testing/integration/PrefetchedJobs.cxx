@@ -0,0 +1,209 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/common/Timer.h>
+#include <remus/testing/Testing.h>
+
+#include <vector>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports,
+                                              std::size_t maxJobsPerWorker )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->maxJobsPerWorker(maxJobsPerWorker);
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports )
+{
+  using namespace remus::meshtypes;
+
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobRequirements requirements =
+          remus::proto::make_JobRequirements(io_type, "PrefetchWorker", "");
+  boost::shared_ptr<remus::Worker> w(new remus::Worker(requirements,conn));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::Job> submit_Jobs(boost::shared_ptr<remus::Client> client,
+                                           std::size_t count)
+{
+  using namespace remus::meshtypes;
+
+  //the server only knows the requirements of a worker once it asks
+  //for a job
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobRequirementsSet reqs = client->retrieveRequirements(io_type);
+  while(reqs.size() == 0)
+    {
+    remus::common::SleepForMillisec(50);
+    reqs = client->retrieveRequirements(io_type);
+    }
+
+  std::vector<remus::proto::JobSubmission> subs;
+  for(std::size_t i=0; i < count; ++i)
+    {
+    remus::proto::JobSubmission sub(*reqs.begin());
+    sub["data"] = remus::proto::make_JobContent(
+                                remus::testing::AsciiStringGenerator(100 + i));
+    subs.push_back(sub);
+    }
+  return client->submitJobs(subs);
+}
+
+//------------------------------------------------------------------------------
+//wait for the worker to have count jobs pending
+bool wait_for_pending(boost::shared_ptr<remus::Worker> worker, std::size_t count)
+{
+  remus::common::Timer timer;
+  while(worker->pendingJobCount() != count && timer.elapsed() < 10000)
+    {
+    remus::common::SleepForMillisec(10);
+    }
+  return worker->pendingJobCount() == count;
+}
+
+//------------------------------------------------------------------------------
+void finish_Job(boost::shared_ptr<remus::Worker> worker,
+                const remus::worker::Job& job)
+{
+  const remus::proto::JobContent& content = job.submission().find("data")->second;
+  const std::string data(content.data(), content.dataSize());
+  worker->returnResult( remus::proto::make_JobResult(job.id(), data) );
+}
+
+//------------------------------------------------------------------------------
+void verify_prefetch()
+{
+  boost::shared_ptr<remus::Server> server =
+                          make_Server( remus::server::ServerPorts(), 0 );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client(ports);
+  boost::shared_ptr<remus::Worker> worker = make_Worker(ports);
+
+  REMUS_ASSERT( (worker->prefetch() == 0) );
+  worker->prefetch(2);
+  REMUS_ASSERT( (worker->prefetch() == 2) );
+
+  const std::size_t num_jobs = 6;
+  const std::vector<remus::proto::Job> jobs = submit_Jobs(client, num_jobs);
+  REMUS_ASSERT( (jobs.size() == num_jobs) )
+
+  //the jobs we asked for ahead of time are sent to us before we take any
+  REMUS_ASSERT( wait_for_pending(worker, 2) );
+
+  for(std::size_t i=0; i < num_jobs; ++i)
+    {
+    remus::worker::Job job = worker->getJob();
+    REMUS_ASSERT( job.valid() );
+
+    //while we process a job the next ones are sent to us, until the
+    //server runs out of jobs
+    const std::size_t remaining = num_jobs - i - 1;
+    REMUS_ASSERT( wait_for_pending(worker, std::min<std::size_t>(remaining,2)) );
+    finish_Job(worker, job);
+    }
+
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    remus::common::Timer timer;
+    remus::proto::JobStatus status = client->jobStatus(jobs[i]);
+    while(!status.finished() && timer.elapsed() < 10000)
+      {
+      remus::common::SleepForMillisec(10);
+      status = client->jobStatus(jobs[i]);
+      }
+    REMUS_ASSERT( status.finished() )
+    }
+}
+
+//------------------------------------------------------------------------------
+void verify_fairness()
+{
+  //a server that limits workers to holding two jobs at once
+  boost::shared_ptr<remus::Server> server =
+                          make_Server( remus::server::ServerPorts(), 2 );
+  REMUS_ASSERT( (server->maxJobsPerWorker() == 2) );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client(ports);
+  boost::shared_ptr<remus::Worker> greedy = make_Worker(ports);
+  boost::shared_ptr<remus::Worker> worker = make_Worker(ports);
+
+  //the greedy worker asks for more jobs than the server lets it hold
+  greedy->prefetch(5);
+  const std::vector<remus::proto::Job> jobs = submit_Jobs(client, 4);
+  REMUS_ASSERT( (jobs.size() == 4) )
+  REMUS_ASSERT( wait_for_pending(greedy, 2) );
+  remus::common::SleepForMillisec(250);
+  REMUS_ASSERT( (greedy->pendingJobCount() == 2) );
+
+  //so the other worker still gets a job when it asks for one
+  worker->askForJobs(1);
+  REMUS_ASSERT( wait_for_pending(worker, 1) );
+
+  //once the greedy worker finishes a job it can take the last one
+  remus::worker::Job job = greedy->takePendingJob();
+  REMUS_ASSERT( job.valid() );
+  finish_Job(greedy, job);
+  REMUS_ASSERT( wait_for_pending(greedy, 2) );
+}
+
+}
+
+//Workers that prefetch jobs have the next jobs sent to them while they
+//are processing the current one, without taking jobs from other workers
+int PrefetchedJobs(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  verify_prefetch();
+
+  verify_fairness();
+
+  return 0;
+}
@@ -0,0 +1,186 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/common/Timer.h>
+#include <remus/testing/Testing.h>
+
+//suppress warnings inside boost headers for gcc and clang
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <vector>
+
+namespace
+{
+
+static const boost::int64_t idle_timeout = 300;
+static const boost::int64_t long_job = 2 * idle_timeout;
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports )
+{
+  using namespace remus::meshtypes;
+
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobRequirements requirements =
+          remus::proto::make_JobRequirements(io_type, "ResidentWorker", "");
+  boost::shared_ptr<remus::Worker> w(new remus::Worker(requirements,conn));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+//the first job takes longer than the idle timeout of the worker
+void handle_Job(remus::worker::Worker& worker,
+                const remus::worker::Job& job)
+{
+  const std::string data = job.details("data");
+  if(data == "slow")
+    {
+    remus::common::SleepForMillisec(long_job);
+    }
+  worker.returnResult( remus::proto::make_JobResult(job.id(), data) );
+}
+
+//------------------------------------------------------------------------------
+//submits count jobs once the server knows the requirements of a worker,
+//which is once the worker has asked for a job
+void submit_Jobs(boost::shared_ptr<remus::Client> client,
+                 std::size_t count,
+                 std::vector<remus::proto::Job>* jobs)
+{
+  using namespace remus::meshtypes;
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobRequirementsSet reqs = client->retrieveRequirements(io_type);
+  while(reqs.size() == 0)
+    {
+    remus::common::SleepForMillisec(50);
+    reqs = client->retrieveRequirements(io_type);
+    }
+
+  std::vector<remus::proto::JobSubmission> subs;
+  for(std::size_t i=0; i < count; ++i)
+    {
+    remus::proto::JobSubmission sub(*reqs.begin());
+    sub["data"] = remus::proto::make_JobContent( (i == 0) ? "slow" : "fast" );
+    subs.push_back(sub);
+    }
+  *jobs = client->submitJobs(subs);
+}
+
+//------------------------------------------------------------------------------
+void verify_idle_timeout(boost::shared_ptr<remus::Client> client,
+                         boost::shared_ptr<remus::Worker> worker)
+{
+  std::vector<remus::proto::Job> jobs;
+  worker->askForJobs(1);
+  submit_Jobs(client, 4, &jobs);
+
+  //the worker keeps handling jobs while they come in, and isn't idle while
+  //it handles a job that takes longer than the idle timeout
+  remus::common::Timer timer;
+  const std::size_t handled =
+    worker->execute(boost::bind(handle_Job, _1, _2), 1,
+                    remus::worker::ResidentLimits(0, idle_timeout));
+  const boost::int64_t elapsed = timer.elapsed();
+  REMUS_ASSERT( (handled == jobs.size()) )
+
+  //once the jobs are handled the worker gives up after the idle timeout
+  REMUS_ASSERT( (elapsed >= long_job + idle_timeout) )
+  REMUS_ASSERT( (elapsed < long_job + 10 * idle_timeout) )
+
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    REMUS_ASSERT( client->jobStatus(jobs[i]).finished() )
+    }
+}
+
+//------------------------------------------------------------------------------
+void verify_max_jobs(boost::shared_ptr<remus::Client> client,
+                     boost::shared_ptr<remus::Worker> worker)
+{
+  //the jobs are submitted once the worker asks for its first job, so
+  //that the worker never asks for more jobs than it may handle
+  std::vector<remus::proto::Job> jobs;
+  boost::thread submitter(boost::bind(submit_Jobs, client, 3, &jobs));
+
+  //a worker that may handle two jobs leaves the third queued
+  const std::size_t handled =
+    worker->execute(boost::bind(handle_Job, _1, _2), 1,
+                    remus::worker::ResidentLimits(2, -1));
+  submitter.join();
+  REMUS_ASSERT( (handled == 2) )
+  REMUS_ASSERT( client->jobStatus(jobs[0]).finished() )
+  REMUS_ASSERT( client->jobStatus(jobs[1]).finished() )
+  REMUS_ASSERT( (client->jobStatus(jobs[2]).status() == remus::QUEUED) )
+}
+
+}
+
+//Handles many jobs with a single resident worker, which gives up once it
+//has been idle for too long or has handled as many jobs as it may
+int ResidentWorkerJobs(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client(ports);
+
+  verify_idle_timeout(client, make_Worker(ports));
+  verify_max_jobs(client, make_Worker(ports));
+
+  //the limits a worker is launched with default to a single job
+  remus::worker::ResidentLimits limits =
+                          remus::worker::ResidentLimits::fromEnvironment();
+  REMUS_ASSERT( (limits.maxJobs() == 1) )
+  REMUS_ASSERT( (limits.isResident() == false) )
+
+  return 0;
+}
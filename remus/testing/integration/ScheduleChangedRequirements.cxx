@@ -0,0 +1,164 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+#include <remus/testing/integration/detail/Factories.h>
+
+#include <map>
+
+namespace
+{
+  namespace workdetail
+  {
+  using namespace remus::testing::integration::detail;
+  }
+
+//------------------------------------------------------------------------------
+//a factory that never launches a worker, but counts how often the server
+//asks it to for each requirement. The server only asks about requirements
+//that have changed since it last matched jobs to workers
+class CountingFactory : public workdetail::AlwaysSupportFactory
+{
+public:
+  CountingFactory():
+    workdetail::AlwaysSupportFactory("ScheduledWorker"),
+    Mutex(),
+    Asked()
+  {
+  }
+
+  unsigned int workersToLaunch(const remus::proto::JobRequirements& reqs,
+                               std::size_t queuedJobs,
+                               boost::int64_t oldestJobWait) const
+  {
+    (void) queuedJobs;
+    (void) oldestJobWait;
+    boost::lock_guard<boost::mutex> lock(this->Mutex);
+    ++this->Asked[reqs];
+    return 0;
+  }
+
+  int timesAsked(const remus::proto::JobRequirements& reqs) const
+  {
+    boost::lock_guard<boost::mutex> lock(this->Mutex);
+    std::map<remus::proto::JobRequirements, int>::const_iterator i =
+                                                      this->Asked.find(reqs);
+    return (i != this->Asked.end()) ? i->second : 0;
+  }
+
+private:
+  mutable boost::mutex Mutex;
+  mutable std::map<remus::proto::JobRequirements, int> Asked;
+};
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Job submit_Job(boost::shared_ptr<remus::Client> client,
+                             const remus::common::MeshIOType& io_type,
+                             remus::proto::JobRequirements& reqs)
+{
+  remus::proto::JobRequirementsSet reqsFromServer =
+                                        client->retrieveRequirements(io_type);
+  REMUS_ASSERT( (reqsFromServer.size() == 1) );
+  reqs = *reqsFromServer.begin();
+
+  remus::proto::JobSubmission sub(reqs);
+  remus::proto::Job job = client->submitJob(sub);
+  REMUS_ASSERT( job.valid() );
+  return job;
+}
+
+//------------------------------------------------------------------------------
+void wait_until_asked(const CountingFactory& factory,
+                      const remus::proto::JobRequirements& reqs)
+{
+  while(factory.timesAsked(reqs) == 0)
+    {
+    remus::common::SleepForMillisec(25);
+    }
+}
+
+}
+
+//Verify that the server only matches requirements whose jobs or workers
+//have changed, and that a job queued before any worker could take it is
+//given to a worker that registers later
+int ScheduleChangedRequirements(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  using namespace remus::meshtypes;
+
+  boost::shared_ptr<CountingFactory> factory(new CountingFactory());
+  boost::shared_ptr<remus::Server> server(
+        new remus::Server(remus::server::ServerPorts(), factory) );
+
+  //every requirement is rescheduled when we check on the workers, so check
+  //rarely enough that it doesn't happen during the test
+  server->heartbeatCheckInterval(60000);
+  server->startBrokering();
+
+  boost::shared_ptr<remus::Client> client =
+                                      make_Client( server->serverPortInfo() );
+
+  //queueing a job changes its requirements, so the server asks the
+  //factory for a worker for them
+  remus::proto::JobRequirements edgesReqs;
+  remus::proto::Job edgesJob =
+    submit_Job(client, remus::common::make_MeshIOType(Edges(),Mesh2D()),
+               edgesReqs);
+  wait_until_asked(*factory, edgesReqs);
+  REMUS_ASSERT( (factory->timesAsked(edgesReqs) == 1) );
+
+  //queueing a job with other requirements doesn't look at the requirements
+  //of the first job again, since nothing about them changed
+  remus::proto::JobRequirements meshReqs;
+  remus::proto::Job meshJob =
+    submit_Job(client, remus::common::make_MeshIOType(Mesh2D(),Mesh3D()),
+               meshReqs);
+  wait_until_asked(*factory, meshReqs);
+  REMUS_ASSERT( (factory->timesAsked(edgesReqs) == 1) );
+  REMUS_ASSERT( (factory->timesAsked(meshReqs) == 1) );
+
+  //a worker that registers later changes the requirements of the first
+  //job again, so it is given that job
+  remus::worker::ServerConnection conn =
+     remus::worker::make_ServerConnection(
+                            server->serverPortInfo().worker().endpoint());
+  remus::worker::Worker worker(edgesReqs, conn);
+  remus::worker::Job workerJob = worker.getJob();
+  REMUS_ASSERT( workerJob.valid() );
+  REMUS_ASSERT( (workerJob.id() == edgesJob.id()) );
+
+  //give the server time to finish matching before we look at what it asked
+  remus::common::SleepForMillisec(250);
+  REMUS_ASSERT( (client->jobStatus(meshJob).status() == remus::QUEUED) );
+
+  //matching the worker only looked at the requirements it changed
+  REMUS_ASSERT( (factory->timesAsked(meshReqs) == 1) );
+  return 0;
+}
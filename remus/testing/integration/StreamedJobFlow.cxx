@@ -0,0 +1,290 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+
+#include <boost/uuid/random_generator.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <streambuf>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+//a stream of data that can only be read up to a point, like a file on a
+//connection that went away part way through
+class TruncatedBuffer : public std::streambuf
+{
+public:
+  TruncatedBuffer(const std::string& data, std::size_t readable):
+    Data(data),
+    Readable(static_cast<off_type>(std::min(readable, data.size())))
+  {
+    this->seekpos(0, std::ios_base::in);
+  }
+
+protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                   std::ios_base::openmode which)
+  {
+    const off_type base = (dir == std::ios_base::beg) ? 0 :
+                          (dir == std::ios_base::cur) ? this->gptr() - this->eback() :
+                          static_cast<off_type>(this->Data.size());
+    return this->seekpos(base + off, which);
+  }
+
+  pos_type seekpos(pos_type pos, std::ios_base::openmode)
+  {
+    const off_type p = pos;
+    if(p < 0 || p > static_cast<off_type>(this->Data.size()))
+      {
+      return pos_type(off_type(-1));
+      }
+    char* begin = &this->Data[0];
+    this->setg(begin, begin + p, begin + std::max(p, this->Readable));
+    return pos;
+  }
+
+private:
+  std::string Data;
+  off_type Readable;
+};
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  remus::server::PollingRates newRates(1500,60000);
+  server->pollingRates(newRates);
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+//use small chunks so that every transfer is made of many of them
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports,
+                                              remus::proto::WireFormat::Type format )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+  conn.wireFormat(format);
+  conn.chunkSize(4096);
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports,
+                                              remus::proto::WireFormat::Type format )
+{
+  using namespace remus::meshtypes;
+
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+  conn.wireFormat(format);
+  conn.chunkSize(4096);
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobRequirements requirements =
+          remus::proto::make_JobRequirements(io_type, "StreamingWorker", "");
+  boost::shared_ptr<remus::Worker> w(new remus::Worker(requirements,conn));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+//the server only knows the requirements of a worker once it asks for a job
+remus::proto::JobRequirements ready_worker(boost::shared_ptr<remus::Client> client,
+                                           boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::meshtypes;
+
+  worker->askForJobs(1);
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobRequirementsSet reqs = client->retrieveRequirements(io_type);
+  while(reqs.size() == 0)
+    {
+    remus::common::SleepForMillisec(50);
+    reqs = client->retrieveRequirements(io_type);
+    }
+  return *reqs.begin();
+}
+
+//------------------------------------------------------------------------------
+void wait_for_finished(const remus::proto::Job& job,
+                       boost::shared_ptr<remus::Client> client)
+{
+  remus::proto::JobStatus status = client->jobStatus(job);
+  while(!status.finished())
+    {
+    REMUS_ASSERT( status.good() )
+    remus::common::SleepForMillisec(50);
+    status = client->jobStatus(job);
+    }
+}
+
+//------------------------------------------------------------------------------
+void verify_streamed_job(boost::shared_ptr<remus::Client> client,
+                         boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::proto;
+
+  //stream a content that doesn't fill its last chunk, next to content
+  //that is sent like any other
+  const std::string input = remus::testing::BinaryDataGenerator(100000);
+  JobSubmission sub(ready_worker(client,worker));
+  sub["mesh"] = make_JobContent(std::string(), remus::common::ContentFormat::BSON);
+  sub["mesh"].tag("streamed");
+  sub["settings"] = make_JobContent("settings");
+
+  std::istringstream inputStream(input);
+  Job clientJob = client->submitJob(sub, "mesh", inputStream);
+  REMUS_ASSERT( clientJob.valid() )
+
+  remus::worker::Job workerJob = worker->getJob();
+  REMUS_ASSERT( (workerJob.id() == clientJob.id()) )
+
+  const JobContent& mesh = workerJob.submission().find("mesh")->second;
+  REMUS_ASSERT( (mesh.formatType() == remus::common::ContentFormat::BSON) )
+  REMUS_ASSERT( (mesh.tag() == "streamed") )
+  REMUS_ASSERT( (std::string(mesh.data(), mesh.dataSize()) == input) )
+  const JobContent& settings = workerJob.submission().find("settings")->second;
+  REMUS_ASSERT( (std::string(settings.data(), settings.dataSize()) == "settings") )
+
+  //stream the result back with writes that don't line up with chunks
+  const std::string output = remus::testing::BinaryDataGenerator(70001);
+  remus::worker::ResultStream result =
+      worker->streamResult(workerJob, remus::common::ContentFormat::XML);
+  for(std::size_t offset = 0; offset < output.size(); offset += 3000)
+    {
+    const std::size_t size = std::min<std::size_t>(3000, output.size()-offset);
+    REMUS_ASSERT( result.write(output.data()+offset, size) )
+    }
+  REMUS_ASSERT( (result.size() == output.size()) )
+  REMUS_ASSERT( result.commit() )
+
+  wait_for_finished(clientJob, client);
+  JobResult clientResult = client->retrieveResults(clientJob);
+  REMUS_ASSERT( (clientResult.formatType() == remus::common::ContentFormat::XML) )
+  REMUS_ASSERT( (std::string(clientResult.data(), clientResult.dataSize()) == output) )
+}
+
+//------------------------------------------------------------------------------
+void verify_resumed_submission(const remus::server::ServerPorts& ports,
+                               boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::proto;
+
+  boost::shared_ptr<remus::Client> client =
+        make_Client( ports, remus::proto::WireFormat::Binary );
+  JobSubmission sub(ready_worker(client,worker));
+  sub["mesh"] = make_JobContent(std::string());
+
+  //the first client can only read half of the content, so the server is
+  //left holding half of the transfer
+  const std::string input = remus::testing::BinaryDataGenerator(100000);
+  const boost::uuids::uuid transferId = boost::uuids::random_generator()();
+  TruncatedBuffer truncated(input, input.size() / 2);
+  std::istream truncatedStream(&truncated);
+  REMUS_ASSERT( !client->submitJob(sub, "mesh", truncatedStream,
+                                   transferId).valid() )
+  client.reset();
+
+  //another client resumes the transfer with the same id
+  boost::shared_ptr<remus::Client> resumer =
+        make_Client( ports, remus::proto::WireFormat::Binary );
+  std::istringstream inputStream(input);
+  Job clientJob = resumer->submitJob(sub, "mesh", inputStream, transferId);
+  REMUS_ASSERT( clientJob.valid() )
+
+  remus::worker::Job workerJob = worker->getJob();
+  REMUS_ASSERT( (workerJob.id() == clientJob.id()) )
+  const JobContent& mesh = workerJob.submission().find("mesh")->second;
+  REMUS_ASSERT( (std::string(mesh.data(), mesh.dataSize()) == input) )
+  worker->returnResult( make_JobResult(workerJob.id(), "done") );
+  wait_for_finished(clientJob, resumer);
+}
+
+//------------------------------------------------------------------------------
+void verify_returned_stream(boost::shared_ptr<remus::Client> client,
+                            boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::proto;
+
+  JobSubmission sub(ready_worker(client,worker));
+  sub["data"] = make_JobContent(std::string());
+
+  const std::string input = remus::testing::AsciiStringGenerator(20000);
+  std::istringstream inputStream(input);
+  Job clientJob = client->submitJob(sub, "data", inputStream);
+  REMUS_ASSERT( clientJob.valid() )
+
+  remus::worker::Job workerJob = worker->getJob();
+  const JobContent& data = workerJob.submission().find("data")->second;
+  REMUS_ASSERT( (std::string(data.data(), data.dataSize()) == input) )
+
+  const std::string output = remus::testing::AsciiStringGenerator(50000);
+  std::istringstream outputStream(output);
+  REMUS_ASSERT( worker->returnResult(workerJob,
+                                     remus::common::ContentFormat::User,
+                                     outputStream) )
+
+  wait_for_finished(clientJob, client);
+  JobResult clientResult = client->retrieveResults(clientJob);
+  REMUS_ASSERT( (std::string(clientResult.data(), clientResult.dataSize()) == output) )
+}
+
+}
+
+//Streams large submissions and results in chunks, for peers that use the
+//binary wire format, and for peers that fall back to single messages
+int StreamedJobFlow(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  {
+  boost::shared_ptr<remus::Client> client =
+        make_Client( ports, remus::proto::WireFormat::Binary );
+  boost::shared_ptr<remus::Worker> worker =
+        make_Worker( ports, remus::proto::WireFormat::Binary );
+  verify_streamed_job(client,worker);
+  verify_returned_stream(client,worker);
+  verify_resumed_submission(ports,worker);
+  }
+
+  {
+  boost::shared_ptr<remus::Client> client =
+        make_Client( ports, remus::proto::WireFormat::Text );
+  boost::shared_ptr<remus::Worker> worker =
+        make_Worker( ports, remus::proto::WireFormat::Text );
+  verify_returned_stream(client,worker);
+  }
+
+  return 0;
+}
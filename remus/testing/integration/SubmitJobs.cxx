@@ -72,7 +72,8 @@ namespace
   };
 
 //------------------------------------------------------------------------------
-boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports,
+                                              remus::Server::BrokerThreading threading )
 {
   //create the server and start brokering, with a factory that can launch
   //no workers, so we have to use workers that connect in only
@@ -80,6 +81,7 @@ boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
   factory->setMaxWorkerCount(0);
 
   boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->brokerThreading(threading);
   server->startBrokering();
   return server;
 }
@@ -201,16 +203,20 @@ int main(int argc, char* argv[])
   zmq::socketInfo<zmq::proto::tcp> si(ci.host(), remus::server::STATUS_PORT);
   zmq::socketInfo<zmq::proto::inproc> wi("worker_channel");
 
-  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts(ci,si,wi) );
-  const remus::server::ServerPorts& ports = server->serverPortInfo();
-
-  boost::shared_ptr<remus::Client> client = make_Client( ports );
-
   //if no parameters just run with a single worker and single job
   std::size_t num_workers = 1;
   std::size_t num_jobs = 1;
   std::string data_size_flag = "small";
-  if( argc == 4)
+
+  //an optional fifth parameter of 'threaded' runs the server with the
+  //multi threaded broker
+  remus::Server::BrokerThreading threading = remus::Server::SINGLE_THREADED;
+  if( argc == 5 && std::string(argv[4]) == "threaded")
+    {
+    threading = remus::Server::MULTI_THREADED;
+    }
+
+  if( argc >= 4)
     {
     std::stringstream buffer;
     buffer << argv[1] << std::endl;
@@ -227,6 +233,12 @@ int main(int argc, char* argv[])
     binary_data_size = large_size;
     }
 
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts(ci,si,wi),
+                                                         threading );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client( ports );
+
   std::cout << "verifying " << num_workers << " workers "
             << num_jobs << " jobs" << std::endl;
 
@@ -0,0 +1,148 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/common/Timer.h>
+#include <remus/testing/Testing.h>
+
+//suppress warnings inside boost headers for gcc and clang
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <vector>
+
+namespace
+{
+
+static const boost::int64_t idle_timeout = 1000;
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only. Workers
+  //that go without a job for too long are told to terminate
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+  factory->setIdleWorkerTimeout(idle_timeout);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports )
+{
+  using namespace remus::meshtypes;
+
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobRequirements requirements =
+          remus::proto::make_JobRequirements(io_type, "IdleWorker", "");
+  boost::shared_ptr<remus::Worker> w(new remus::Worker(requirements,conn));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+void handle_Job(remus::worker::Worker& worker,
+                const remus::worker::Job& job)
+{
+  worker.returnResult( remus::proto::make_JobResult(job.id(), "done") );
+}
+
+//------------------------------------------------------------------------------
+//submits a job once the server knows the requirements of a worker,
+//which is once the worker has asked for a job
+void submit_Job(boost::shared_ptr<remus::Client> client,
+                std::vector<remus::proto::Job>* jobs)
+{
+  using namespace remus::meshtypes;
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobRequirementsSet reqs = client->retrieveRequirements(io_type);
+  while(reqs.size() == 0)
+    {
+    remus::common::SleepForMillisec(50);
+    reqs = client->retrieveRequirements(io_type);
+    }
+
+  remus::proto::JobSubmission sub(*reqs.begin());
+  sub["data"] = remus::proto::make_JobContent("data");
+  jobs->push_back(client->submitJob(sub));
+}
+
+//------------------------------------------------------------------------------
+void verify_idle_worker_terminated(boost::shared_ptr<remus::Client> client,
+                                   boost::shared_ptr<remus::Worker> worker)
+{
+  std::vector<remus::proto::Job> jobs;
+  boost::thread submitter(boost::bind(submit_Job, client, &jobs));
+
+  //the worker would wait for jobs forever, but is told to terminate by
+  //the server once it has gone without a job for the idle timeout
+  remus::common::Timer timer;
+  const std::size_t handled =
+    worker->execute(boost::bind(handle_Job, _1, _2), 1,
+                    remus::worker::ResidentLimits(0, -1));
+  const boost::int64_t elapsed = timer.elapsed();
+  submitter.join();
+
+  REMUS_ASSERT( (handled == 1) )
+  REMUS_ASSERT( client->jobStatus(jobs[0]).finished() )
+  REMUS_ASSERT( (elapsed >= idle_timeout) )
+  REMUS_ASSERT( (elapsed < 10 * idle_timeout) )
+
+  //the server has no workers left for the requirements
+  using namespace remus::meshtypes;
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  REMUS_ASSERT( (client->retrieveRequirements(io_type).size() == 0) )
+}
+
+}
+
+//Terminates a worker that connected to the server once it has gone
+//without a job for longer than the idle worker timeout of the factory
+int TerminateIdleWorkers(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client(ports);
+
+  verify_idle_worker_terminated(client, make_Worker(ports));
+
+  return 0;
+}
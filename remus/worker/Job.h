@@ -122,26 +122,44 @@ inline std::string to_string(const remus::worker::Job& job)
 
 
 //------------------------------------------------------------------------------
-inline remus::worker::Job to_Job(const std::string& msg)
+inline std::string to_binary(const remus::worker::Job& job)
 {
-  //convert a job detail from a string, used as a hack to serialize
-  std::istringstream buffer(msg);
+  //convert a job to the binary wire format, which is the job id followed
+  //by the submission
+  return remus::proto::to_binary(job.id(), job.submission());
+}
 
+//------------------------------------------------------------------------------
+//decode a job. When the job is binary encoded and the owner of data is given
+//the contents of the job point into data instead of being copied
+inline remus::worker::Job to_Job(const char* data, std::size_t size,
+                                 const boost::shared_ptr<const void>& owner)
+{
+  //jobs encoded with the binary wire format can be decoded in place
   boost::uuids::uuid id;
   remus::proto::JobSubmission submission;
+  if(remus::proto::to_JobSubmission(data, size, owner, id, submission))
+    {
+    return remus::worker::Job(id,submission);
+    }
 
+  //convert a job detail from a string, used as a hack to serialize
+  std::istringstream buffer(std::string(data,size));
   buffer >> id;
   buffer >> submission;
   return remus::worker::Job(id,submission);
 }
 
+//------------------------------------------------------------------------------
+inline remus::worker::Job to_Job(const char* data, std::size_t size)
+{
+  return to_Job(data, size, boost::shared_ptr<const void>());
+}
 
 //------------------------------------------------------------------------------
-inline remus::worker::Job to_Job(const char* data, int size)
+inline remus::worker::Job to_Job(const std::string& msg)
 {
-  //convert a job from a string, used as a hack to serialize
-  const std::string temp(data,size);
-  return to_Job( temp );
+  return to_Job(msg.c_str(), msg.size());
 }
 
 }
@@ -0,0 +1,108 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_worker_ResidentLimits_h
+#define remus_worker_ResidentLimits_h
+
+#include <cstddef>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+#include <remus/common/CompilerInformation.h>
+
+//suppress warnings inside boost headers for gcc and clang
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/cstdint.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+//The remus::worker::ResidentLimits class.
+// A resident worker is a worker process that handles many jobs before it
+// exits, so that the cost of starting the process is only paid once. The
+// limits state how many jobs the process handles, and how long it waits
+// for a job before it gives up and exits.
+//
+// The worker factory launches the processes of resident workers with the
+// limits declared in their worker file, which it passes to the process
+// through the environment. Workers read them with fromEnvironment.
+namespace remus{
+namespace worker{
+class ResidentLimits
+{
+public:
+  //the limits of a worker that isn't resident, which handles a single job
+  //and waits for it forever
+  ResidentLimits():
+    MaxJobs(1),
+    IdleTimeoutMillisec(-1)
+  {
+  }
+
+  //a maxJobs of 0 handles jobs until the worker is terminated, and a
+  //negative idle timeout waits for jobs forever
+  ResidentLimits(std::size_t maxJobs, boost::int64_t idleTimeoutMillisec):
+    MaxJobs(maxJobs),
+    IdleTimeoutMillisec(idleTimeoutMillisec)
+  {
+  }
+
+  //the number of jobs to handle before exiting, 0 means there is no limit
+  std::size_t maxJobs() const { return MaxJobs; }
+
+  //how long in milliseconds to wait without handling a job before exiting,
+  //a negative timeout means the worker never gives up
+  boost::int64_t idleTimeout() const { return IdleTimeoutMillisec; }
+
+  //does the worker handle more than a single job
+  bool isResident() const { return MaxJobs != 1; }
+
+  //the environment variables the worker factory passes the limits with
+  static const char* maxJobsVariable()
+    { return "REMUS_WORKER_MAX_JOBS"; }
+  static const char* idleTimeoutVariable()
+    { return "REMUS_WORKER_IDLE_TIMEOUT"; }
+
+  //the limits the process was launched with. Any limit that isn't set in
+  //the environment is taken from defaults
+  static ResidentLimits fromEnvironment(
+                      const ResidentLimits& defaults = ResidentLimits())
+  {
+    ResidentLimits limits(defaults);
+    read_variable(maxJobsVariable(), limits.MaxJobs);
+    read_variable(idleTimeoutVariable(), limits.IdleTimeoutMillisec);
+    return limits;
+  }
+
+private:
+  template<typename T>
+  static void read_variable(const char* name, T& value)
+  {
+    const char* env = std::getenv(name);
+    if(env && env[0])
+      {
+      std::istringstream buffer(env);
+      T parsed;
+      if(buffer >> parsed)
+        {
+        value = parsed;
+        }
+      }
+  }
+
+  std::size_t MaxJobs;
+  boost::int64_t IdleTimeoutMillisec;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,291 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <remus/worker/ResultStream.h>
+
+#include <remus/worker/Worker.h>
+
+#include <remus/proto/JobResult.h>
+#include <remus/proto/Transfer.h>
+
+//suppress warnings inside boost headers for gcc and clang
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/make_shared.hpp>
+#include <boost/uuid/random_generator.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <utility>
+
+namespace remus{
+namespace worker{
+
+struct ResultStream::InternalImpl
+{
+  InternalImpl(remus::worker::Worker& worker,
+               const remus::worker::Job& job,
+               remus::common::ContentFormat::Type format):
+    Owner(&worker),
+    JobId(job.id()),
+    Format(format),
+    Id(boost::uuids::random_generator()()),
+    Streaming(false),
+    Good(true),
+    Committed(false),
+    ChunkSize(worker.connection().chunkSize()),
+    Credits(1),
+    Pending(),
+    Unacked(),
+    Expected(),
+    ServerOffset(0),
+    Rewind(false),
+    Sent(0),
+    Written(0)
+  {
+  }
+
+  remus::worker::Worker* Owner;
+  boost::uuids::uuid JobId;
+  remus::common::ContentFormat::Type Format;
+
+  //the id of the transfer the result is streamed with
+  boost::uuids::uuid Id;
+
+  bool Streaming;
+  bool Good;
+  bool Committed;
+  std::size_t ChunkSize;
+  boost::uint32_t Credits;
+
+  //data that doesn't fill a chunk yet, or all the data when we can't stream
+  std::string Pending;
+
+  //the chunks the server hasn't acknowledged, by the offset they start at
+  std::deque< std::pair<boost::uint64_t, std::string> > Unacked;
+
+  //the offset the server should reply with for each chunk in flight
+  std::deque<boost::uint64_t> Expected;
+
+  //where the data the server has ends, according to its last reply
+  boost::uint64_t ServerOffset;
+
+  //set when the server didn't keep a chunk we sent
+  bool Rewind;
+
+  //the offset that the next new chunk starts at
+  boost::uint64_t Sent;
+  std::size_t Written;
+};
+
+//-----------------------------------------------------------------------------
+ResultStream::ResultStream(remus::worker::Worker& worker,
+                           const remus::worker::Job& job,
+                           remus::common::ContentFormat::Type format):
+  Implementation( boost::make_shared<InternalImpl>(worker,job,format) )
+{
+  InternalImpl& impl = *this->Implementation;
+  impl.Streaming = worker.canStreamResults();
+  if(impl.Streaming)
+    {
+    //we don't know how large the result will be, so the server finds
+    //out the size when we commit
+    worker.sendTransfer(impl.Id, remus::TRANSFER_BEGIN,
+                        remus::proto::to_binary(
+                              remus::proto::Transfer(impl.Id, 0)),
+                        std::string());
+    const remus::proto::Transfer reply = worker.receiveTransfer(impl.Id);
+    impl.Good = reply.valid();
+    impl.Credits = std::max<boost::uint32_t>(reply.credits(), 1);
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool ResultStream::write(const char* data, std::size_t size)
+{
+  InternalImpl& impl = *this->Implementation;
+  if(!impl.Good || impl.Committed)
+    {
+    return false;
+    }
+
+  impl.Written += size;
+  if(!impl.Streaming)
+    {
+    impl.Pending.append(data, size);
+    return true;
+    }
+
+  //top up the partial chunk first, and then send full chunks straight
+  //from the data we were given
+  if(!impl.Pending.empty())
+    {
+    const std::size_t n = std::min(size, impl.ChunkSize - impl.Pending.size());
+    impl.Pending.append(data, n);
+    data += n;
+    size -= n;
+    if(impl.Pending.size() == impl.ChunkSize)
+      {
+      this->sendChunk(impl.Pending.data(), impl.Pending.size());
+      impl.Pending.clear();
+      }
+    }
+  while(impl.Good && size >= impl.ChunkSize)
+    {
+    this->sendChunk(data, impl.ChunkSize);
+    data += impl.ChunkSize;
+    size -= impl.ChunkSize;
+    }
+  if(impl.Good && size > 0)
+    {
+    impl.Pending.append(data, size);
+    }
+  return impl.Good;
+}
+
+//-----------------------------------------------------------------------------
+bool ResultStream::commit()
+{
+  InternalImpl& impl = *this->Implementation;
+  if(!impl.Good || impl.Committed)
+    {
+    return false;
+    }
+  impl.Committed = true;
+
+  if(!impl.Streaming)
+    {
+    impl.Owner->returnResult(remus::proto::JobResult(impl.JobId, impl.Format,
+                                                     impl.Pending));
+    impl.Pending.clear();
+    return true;
+    }
+
+  if(!impl.Pending.empty())
+    {
+    this->sendChunk(impl.Pending.data(), impl.Pending.size());
+    impl.Pending.clear();
+    }
+  while(impl.Good && !impl.Expected.empty())
+    {
+    this->receiveReply();
+    }
+  if(!impl.Good)
+    {
+    return false;
+    }
+
+  //the server builds the result from the data we streamed and the result
+  //without any data that we send with the commit
+  impl.Owner->sendTransfer(impl.Id, remus::TRANSFER_COMMIT,
+                           remus::proto::to_binary(
+                              remus::proto::Transfer(impl.Id, impl.Sent)),
+                           remus::proto::to_binary(
+                              remus::proto::JobResult(impl.JobId, impl.Format,
+                                                      std::string())));
+  impl.Good = impl.Owner->receiveTransfer(impl.Id).valid();
+  return impl.Good;
+}
+
+//-----------------------------------------------------------------------------
+bool ResultStream::good() const
+{
+  return this->Implementation->Good;
+}
+
+//-----------------------------------------------------------------------------
+std::size_t ResultStream::size() const
+{
+  return this->Implementation->Written;
+}
+
+//-----------------------------------------------------------------------------
+bool ResultStream::sendChunk(const char* data, std::size_t size)
+{
+  InternalImpl& impl = *this->Implementation;
+  while(impl.Good && impl.Expected.size() >= impl.Credits)
+    {
+    this->receiveReply();
+    }
+  if(!impl.Good)
+    {
+    return false;
+    }
+
+  std::string chunk(data, size);
+  impl.Owner->sendTransfer(impl.Id, remus::TRANSFER_CHUNK,
+                           remus::proto::to_binary(
+                              remus::proto::Transfer(impl.Id, impl.Sent)),
+                           chunk);
+
+  //keep the chunk until the server has it, so we can send it again
+  impl.Unacked.push_back(std::make_pair(impl.Sent, std::string()));
+  impl.Unacked.back().second.swap(chunk);
+  impl.Sent += size;
+  impl.Expected.push_back(impl.Sent);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool ResultStream::receiveReply()
+{
+  InternalImpl& impl = *this->Implementation;
+  const remus::proto::Transfer reply = impl.Owner->receiveTransfer(impl.Id);
+  const boost::uint64_t expected = impl.Expected.front();
+  impl.Expected.pop_front();
+  if(!reply.valid())
+    {
+    impl.Good = false;
+    return false;
+    }
+
+  //forget the chunks the server has
+  impl.ServerOffset = reply.offset();
+  while(!impl.Unacked.empty() &&
+        impl.Unacked.front().first + impl.Unacked.front().second.size() <=
+        impl.ServerOffset)
+    {
+    impl.Unacked.pop_front();
+    }
+  impl.Rewind = impl.Rewind || reply.offset() < expected;
+
+  //once every chunk in flight has been answered, send everything the
+  //server didn't keep again. We can only do that if we still hold the
+  //chunk that starts where the server's data ends
+  if(impl.Rewind && impl.Expected.empty())
+    {
+    impl.Rewind = false;
+    const bool canResume = !impl.Unacked.empty() &&
+                           impl.Unacked.front().first == impl.ServerOffset;
+    if(!canResume)
+      {
+      impl.Good = false;
+      return false;
+      }
+
+    typedef std::deque< std::pair<boost::uint64_t, std::string> >::const_iterator It;
+    for(It i = impl.Unacked.begin(); i != impl.Unacked.end(); ++i)
+      {
+      impl.Owner->sendTransfer(impl.Id, remus::TRANSFER_CHUNK,
+                               remus::proto::to_binary(
+                                  remus::proto::Transfer(impl.Id, i->first)),
+                               i->second);
+      impl.Expected.push_back(i->first + i->second.size());
+      }
+    }
+  return true;
+}
+
+}
+}
@@ -0,0 +1,80 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#ifndef remus_worker_ResultStream_h
+#define remus_worker_ResultStream_h
+
+#include <remus/common/ContentTypes.h>
+#include <remus/worker/Job.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <cstddef>
+
+//included for export symbols
+#include <remus/worker/WorkerExports.h>
+
+namespace remus{
+namespace worker{
+
+class Worker;
+
+//Sends the data of a job's result to the server in chunks as it is
+//written, so that large results never need to be held in memory as a whole.
+//Only the chunks the server hasn't acknowledged yet are kept, and the server
+//states how many of those we are allowed to have before we wait for it.
+//
+//Servers that can't accept streamed results are sent the result as a single
+//message when the stream is committed, in which case all the data is kept
+//until then. A ResultStream is created by Worker::streamResult and must not
+//outlive the worker that created it.
+class REMUSWORKER_EXPORT ResultStream
+{
+public:
+  //add data to the end of the result. Returns false if the server stopped
+  //accepting the result, after which nothing else will be sent
+  bool write(const char* data, std::size_t size);
+
+  //send whatever data hasn't been sent and wait for the server to have the
+  //whole result. Returns false if the server didn't accept the result
+  bool commit();
+
+  //returns false once the server has stopped accepting the result
+  bool good() const;
+
+  //the number of bytes written to the stream
+  std::size_t size() const;
+
+private:
+  friend class Worker;
+  ResultStream(remus::worker::Worker& worker,
+               const remus::worker::Job& job,
+               remus::common::ContentFormat::Type format);
+
+  //send a chunk of the result, waiting for the server first when we
+  //have used up our credits
+  bool sendChunk(const char* data, std::size_t size);
+
+  //wait for the server's reply to the oldest chunk we have sent. When the
+  //server didn't keep a chunk, every chunk from where its data ends is
+  //sent again
+  bool receiveReply();
+
+  struct InternalImpl;
+  boost::shared_ptr<InternalImpl> Implementation;
+};
+
+}
+}
+
+#endif
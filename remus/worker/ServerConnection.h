@@ -14,6 +14,7 @@
 #define remus_worker_ServerConnection_h
 
 #include <remus/proto/zmqSocketInfo.h>
+#include <remus/proto/WireFormat.h>
 
 #include <boost/shared_ptr.hpp>
 
@@ -62,10 +63,23 @@ public:
   //Not Thread Safe
   void context(boost::shared_ptr<zmq::context_t> c) { this->Context = c; }
 
+  //the wire format that we ask the server to use when sending proto objects
+  //over this connection. The server and worker fall back to the Text format
+  //when the server doesn't support the requested format. Defaults to Binary
+  remus::proto::WireFormat::Type wireFormat() const { return this->Format; }
+  void wireFormat(remus::proto::WireFormat::Type f) { this->Format = f; }
+
+  //the largest chunk that streamed results are sent to the server in.
+  //Streaming needs the Binary wire format, and defaults to 1MB chunks
+  std::size_t chunkSize() const { return this->ChunkSize; }
+  void chunkSize(std::size_t size) { this->ChunkSize = (size > 0) ? size : 1; }
+
 private:
   mutable boost::shared_ptr<zmq::context_t> Context;
   std::string Endpoint;
   bool IsLocalEndpoint;
+  remus::proto::WireFormat::Type Format;
+  std::size_t ChunkSize;
 };
 
 //convert a string in the form of proto://hostname:port where :port
@@ -84,7 +98,9 @@ template<typename T>
 ServerConnection::ServerConnection(zmq::socketInfo<T> const& socket):
   Context( ),
   Endpoint(socket.endpoint()),
-  IsLocalEndpoint( zmq::isLocalEndpoint(socket) )
+  IsLocalEndpoint( zmq::isLocalEndpoint(socket) ),
+  Format( remus::proto::WireFormat::Binary ),
+  ChunkSize(1024*1024)
 {
 }
 
@@ -14,14 +14,23 @@
 
 #include <remus/proto/Message.h>
 #include <remus/proto/Response.h>
+#include <remus/proto/Transfer.h>
 #include <remus/proto/zmqHelper.h>
 #include <remus/worker/detail/JobQueue.h>
 #include <remus/worker/detail/MessageRouter.h>
 
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <fstream>
 #include <string>
+#include <vector>
 
 //suppress warnings inside boost headers for gcc and clang
 REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/uuid/random_generator.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
@@ -35,31 +44,320 @@ namespace worker{
 namespace detail{
 struct ZmqManagement
 {
+  typedef boost::unordered_map< boost::uuids::uuid,
+                    std::deque<remus::proto::Response> > ReplyMap;
+
   //use auto generated channel names, this allows multiple workers to share
   //the same context.
   boost::shared_ptr<zmq::context_t> InterWorkerContext;
   zmq::socket_t Server;
+  zmq::socket_t Replies;
   std::string WorkerChannelUUID;
-  std::string JobChannelUUID;
+
+  //guards every use of the Server socket, so that many threads can report
+  //on their jobs at the same time
+  boost::mutex Lock;
+
+  //guards who is waiting on replies. The server's replies arrive on their
+  //own socket, so a thread waiting for a reply doesn't stop other threads
+  //from sending. Only one thread at a time receives from the Replies
+  //socket, and hands replies other threads are waiting on over to them
+  boost::mutex ReplyLock;
+  boost::condition_variable ReplyArrived;
+  bool Receiving;
+
+  //who is waiting on each reply, in the order the messages were sent. The
+  //server replies in that order, so a thread that receives a reply some
+  //other thread is waiting on hands it over instead
+  std::deque<boost::uuids::uuid> Awaiting;
+  ReplyMap Received;
+
+  //the number of jobs we have asked the server for, and how many jobs
+  //to keep asked for or pending
+  std::size_t JobsRequested;
+  unsigned int Prefetch;
+
   ZmqManagement( remus::worker::ServerConnection const& conn ):
     InterWorkerContext( conn.context() ),
     Server( *InterWorkerContext, ZMQ_PAIR),
+    Replies( *InterWorkerContext, ZMQ_PAIR),
     WorkerChannelUUID(),
-    JobChannelUUID()
+    Lock(),
+    ReplyLock(),
+    ReplyArrived(),
+    Receiving(false),
+    Awaiting(),
+    Received(),
+    JobsRequested(0),
+    Prefetch(0)
   {
   boost::uuids::random_generator generator;
 
   //the goal here is to produce unique socket names. The current solution
   //is to use uuids for the channel names
   WorkerChannelUUID = boost::uuids::to_string(generator());
-  JobChannelUUID = boost::uuids::to_string(generator());
 
-  //We have to bind to the inproc socket before the MessageRouter class does
+  //We have to bind to the inproc sockets before the MessageRouter class does
   zmq::socketInfo<zmq::proto::inproc> sInfo( this->WorkerChannelUUID );
   zmq::bindToAddress(this->Server, sInfo);
+  zmq::bindToAddress(this->Replies,
+        remus::worker::detail::MessageRouter::replyChannel(sInfo));
+  }
+
+  //ask the server for count jobs, the caller must hold the lock
+  void requestJobs(const remus::common::MeshIOType& mtype,
+                   const std::string& request,
+                   std::size_t count)
+  {
+    for(std::size_t i=0; i < count; ++i)
+      {
+      remus::proto::send_Message(mtype, remus::MAKE_MESH, request,
+                                 &this->Server);
+      }
+    this->JobsRequested += count;
+  }
+
+  //send a message that the server replies to, on behalf of replyTo
+  void sendAwaitingReply(const boost::uuids::uuid& replyTo,
+                         const remus::common::MeshIOType& mtype,
+                         remus::SERVICE_TYPE service,
+                         const std::string& data,
+                         const std::string& payload)
+  {
+    boost::lock_guard<boost::mutex> lock(this->Lock);
+    remus::proto::send_Message(mtype, service, data, payload, &this->Server);
+
+    //we still hold the send lock, so the order of Awaiting is the order
+    //the messages were sent in
+    boost::lock_guard<boost::mutex> replyLock(this->ReplyLock);
+    this->Awaiting.push_back(replyTo);
+  }
+
+  //wait for the oldest reply to a message sent on behalf of replyTo. The
+  //send lock isn't held while we wait
+  remus::proto::Response receiveReply(const boost::uuids::uuid& replyTo)
+  {
+    boost::unique_lock<boost::mutex> lock(this->ReplyLock);
+    while(true)
+      {
+      ReplyMap::iterator r = this->Received.find(replyTo);
+      if(r != this->Received.end())
+        {
+        remus::proto::Response response = r->second.front();
+        r->second.pop_front();
+        if(r->second.empty())
+          {
+          this->Received.erase(r);
+          }
+        return response;
+        }
+
+      if(this->Receiving)
+        { //another thread is receiving, and will hand us our reply
+        this->ReplyArrived.wait(lock);
+        continue;
+        }
+
+      this->Receiving = true;
+      lock.unlock();
+      try
+        {
+        remus::proto::Response response =
+            remus::proto::receive_Response(&this->Replies);
+        lock.lock();
+        this->Receiving = false;
+
+        //wake the waiting threads, both so they can look for their reply
+        //and so one of them takes over receiving
+        this->ReplyArrived.notify_all();
+        if(this->Awaiting.empty())
+          { //nobody else could be waiting on this reply
+          return response;
+          }
+        const boost::uuids::uuid repliedTo = this->Awaiting.front();
+        this->Awaiting.pop_front();
+        if(repliedTo == replyTo)
+          {
+          return response;
+          }
+        this->Received[repliedTo].push_back(response);
+        }
+      catch(...)
+        {
+        if(!lock.owns_lock())
+          {
+          lock.lock();
+          }
+        this->Receiving = false;
+        this->ReplyArrived.notify_all();
+        throw;
+        }
+      }
   }
 };
 
+//-----------------------------------------------------------------------------
+//Runs jobs on a pool of threads for Worker::execute. Every thread has a job
+//in flight, and asks the server for another once it has handled it
+class JobExecutor
+{
+public:
+  JobExecutor(remus::worker::Worker& worker,
+              const remus::worker::Worker::JobHandler& handler,
+              unsigned int concurrency,
+              std::size_t maxJobs):
+    Owner(worker),
+    Handler(handler),
+    MaxJobs(maxJobs),
+    Mutex(),
+    JobsChanged(),
+    Jobs(),
+    Stopping(false),
+    Requested(0),
+    Handled(0),
+    Active(0),
+    IdleSince(boost::get_system_time()),
+    Threads()
+  {
+    for(unsigned int i=0; i < concurrency; ++i)
+      {
+      this->Threads.create_thread( boost::bind(&JobExecutor::run, this) );
+      }
+  }
+
+  ~JobExecutor()
+  {
+    this->stop();
+  }
+
+  //reserve up to count more jobs to ask the server for, returning how many
+  //we should ask for
+  unsigned int request(unsigned int count)
+  {
+    boost::lock_guard<boost::mutex> lock(this->Mutex);
+    if(this->MaxJobs > 0)
+      {
+      const std::size_t left = this->MaxJobs - this->Requested;
+      count = static_cast<unsigned int>(std::min<std::size_t>(count, left));
+      }
+    this->Requested += count;
+    return count;
+  }
+
+  void post(const remus::worker::Job& job)
+  {
+    boost::lock_guard<boost::mutex> lock(this->Mutex);
+    this->Jobs.push_back(job);
+    ++this->Active;
+    this->JobsChanged.notify_one();
+  }
+
+  //the number of milliseconds since the last job was handled, or -1 when
+  //jobs are being handled
+  boost::int64_t idleTime()
+  {
+    boost::lock_guard<boost::mutex> lock(this->Mutex);
+    if(this->Active > 0)
+      {
+      return -1;
+      }
+    return (boost::get_system_time() - this->IdleSince).total_milliseconds();
+  }
+
+  //wait for the threads to handle the jobs they have been given
+  std::size_t stop()
+  {
+      {
+      boost::lock_guard<boost::mutex> lock(this->Mutex);
+      this->Stopping = true;
+      this->JobsChanged.notify_all();
+      }
+    this->Threads.join_all();
+    return this->Handled;
+  }
+
+private:
+  void run()
+  {
+    while(true)
+      {
+      remus::worker::Job job;
+        {
+        boost::unique_lock<boost::mutex> lock(this->Mutex);
+        while(this->Jobs.empty() && !this->Stopping)
+          {
+          this->JobsChanged.wait(lock);
+          }
+        if(this->Jobs.empty())
+          {
+          return;
+          }
+        job = this->Jobs.front();
+        this->Jobs.pop_front();
+        }
+
+      //jobs that are waiting when the server terminates us are dropped
+      if(this->Owner.workerShouldTerminate())
+        {
+        this->finished(false);
+        continue;
+        }
+      this->handle(job);
+      this->finished(true);
+      if(!this->Owner.workerShouldTerminate() && this->request(1) > 0)
+        {
+        this->Owner.askForJobs(1);
+        }
+      }
+  }
+
+  void finished(bool handled)
+  {
+    boost::lock_guard<boost::mutex> lock(this->Mutex);
+    if(handled)
+      {
+      ++this->Handled;
+      }
+    if(--this->Active == 0)
+      {
+      this->IdleSince = boost::get_system_time();
+      }
+  }
+
+  void handle(const remus::worker::Job& job)
+  {
+    try
+      {
+      this->Handler(this->Owner, job);
+      }
+    catch(std::exception& e)
+      {
+      this->Owner.sendJobFailure(job, e.what());
+      }
+    catch(...)
+      {
+      this->Owner.sendJobFailure(job, "job handler threw an exception");
+      }
+  }
+
+  remus::worker::Worker& Owner;
+  remus::worker::Worker::JobHandler Handler;
+  const std::size_t MaxJobs;
+
+  boost::mutex Mutex;
+  boost::condition_variable JobsChanged;
+  std::deque<remus::worker::Job> Jobs;
+  bool Stopping;
+  std::size_t Requested;
+  std::size_t Handled;
+
+  //jobs that have been posted and not finished, and when the last of
+  //them finished
+  std::size_t Active;
+  boost::system_time IdleSince;
+
+  boost::thread_group Threads;
+};
 
 }
 
@@ -70,20 +368,13 @@ Worker::Worker(remus::common::MeshIOType mtype,
   MeshRequirements( remus::proto::make_JobRequirements(mtype,"","") ),
   ConnectionInfo(conn),
   Zmq( new detail::ZmqManagement( conn ) ),
+  JobQueue( new remus::worker::detail::JobQueue() ),
   MessageRouter( new remus::worker::detail::MessageRouter(
                     zmq::socketInfo<zmq::proto::inproc>(Zmq->WorkerChannelUUID),
-                    zmq::socketInfo<zmq::proto::inproc>(Zmq->JobChannelUUID))),
-  JobQueue( new remus::worker::detail::JobQueue( *Zmq->InterWorkerContext,
-                    zmq::socketInfo<zmq::proto::inproc>(Zmq->JobChannelUUID)))
+                    *JobQueue) )
 {
   this->MessageRouter->start(conn, *Zmq->InterWorkerContext);
-
-  std::ostringstream input_buffer;
-  input_buffer << this->MeshRequirements;
-  remus::proto::send_Message(this->MeshRequirements.meshTypes(),
-                            remus::CAN_MESH_REQUIREMENTS,
-                            input_buffer.str(),
-                            &this->Zmq->Server);
+  this->registerWithServer();
 }
 
 //-----------------------------------------------------------------------------
@@ -92,13 +383,31 @@ Worker::Worker(const remus::proto::JobRequirements& requirements,
   MeshRequirements(requirements),
   ConnectionInfo(conn),
   Zmq( new detail::ZmqManagement( conn ) ),
+  JobQueue( new remus::worker::detail::JobQueue() ),
   MessageRouter( new remus::worker::detail::MessageRouter(
                     zmq::socketInfo<zmq::proto::inproc>(Zmq->WorkerChannelUUID),
-                    zmq::socketInfo<zmq::proto::inproc>(Zmq->JobChannelUUID)) ),
-  JobQueue( new remus::worker::detail::JobQueue( *Zmq->InterWorkerContext,
-                    zmq::socketInfo<zmq::proto::inproc>(Zmq->JobChannelUUID)) )
+                    *JobQueue) )
 {
   this->MessageRouter->start(conn, *Zmq->InterWorkerContext);
+  this->registerWithServer();
+}
+
+
+//-----------------------------------------------------------------------------
+void Worker::registerWithServer()
+{
+  //ask the server to use our wire format before registering, so that the
+  //jobs it sends us are already in that format. Servers that don't know
+  //about wire formats ignore the request, and we keep sending text
+  boost::lock_guard<boost::mutex> lock(this->Zmq->Lock);
+  if(this->ConnectionInfo.wireFormat() != remus::proto::WireFormat::Text)
+    {
+    remus::proto::send_Message(this->MeshRequirements.meshTypes(),
+                               remus::WIRE_FORMAT,
+                               remus::proto::to_string(
+                                        this->ConnectionInfo.wireFormat()),
+                               &this->Zmq->Server);
+    }
 
   std::ostringstream input_buffer;
   input_buffer << this->MeshRequirements;
@@ -108,7 +417,6 @@ Worker::Worker(const remus::proto::JobRequirements& requirements,
                             &this->Zmq->Server);
 }
 
-
 //-----------------------------------------------------------------------------
 Worker::~Worker()
 {
@@ -116,6 +424,7 @@ Worker::~Worker()
     {
     //send message that we are shutting down communication, and we can stop
     //polling the server
+    boost::lock_guard<boost::mutex> lock(this->Zmq->Lock);
     remus::proto::send_Message(this->MeshRequirements.meshTypes(),
                                remus::TERMINATE_WORKER,
                                &this->Zmq->Server);
@@ -149,11 +458,39 @@ remus::worker::PollingRates Worker::pollingRates() const
   return remus::worker::PollingRates(low,high);
 }
 
+//------------------------------------------------------------------------------
+void Worker::statusInterval( boost::int64_t millisec )
+{
+  this->MessageRouter->statusInterval(millisec);
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t Worker::statusInterval() const
+{
+  return this->MessageRouter->statusInterval();
+}
+
 //-----------------------------------------------------------------------------
-void Worker::askForJobs( unsigned int numberOfJobs )
+void Worker::prefetch( unsigned int count )
+{
+    {
+    boost::lock_guard<boost::mutex> lock(this->Zmq->Lock);
+    this->Zmq->Prefetch = count;
+    }
+  this->fillJobWindow(count);
+}
+
+//-----------------------------------------------------------------------------
+unsigned int Worker::prefetch() const
 {
+  boost::lock_guard<boost::mutex> lock(this->Zmq->Lock);
+  return this->Zmq->Prefetch;
+}
 
-  //next we send the MAKE_MESH call with the shorter version of the reqs,
+//-----------------------------------------------------------------------------
+std::string Worker::jobRequest() const
+{
+  //we send the MAKE_MESH call with the shorter version of the reqs,
   //which have none of the heavy data.
   proto::JobRequirements lightReqs(this->MeshRequirements.formatType(),
                                    this->MeshRequirements.meshTypes(),
@@ -163,18 +500,44 @@ void Worker::askForJobs( unsigned int numberOfJobs )
   lightReqs.SourceType = this->MeshRequirements.sourceType();
   lightReqs.Tag = this->MeshRequirements.tag();
 
-  std::ostringstream input_buffer;
-  input_buffer << lightReqs;
+  return remus::proto::to_string(lightReqs,
+                                 this->MessageRouter->wireFormat());
+}
 
-  for(unsigned int i=0; i < numberOfJobs; ++i)
+//-----------------------------------------------------------------------------
+void Worker::fillJobWindow(std::size_t count)
+{
+  if(count == 0)
     {
-    proto::send_Message(this->MeshRequirements.meshTypes(),
-                        remus::MAKE_MESH,
-                        input_buffer.str(),
-                        &this->Zmq->Server);
+    return;
+    }
+
+  const std::string msg = this->jobRequest();
+
+  boost::lock_guard<boost::mutex> lock(this->Zmq->Lock);
+
+  //jobs we asked for that haven't arrived, plus the jobs that are pending
+  const std::size_t received = this->JobQueue->jobsReceived();
+  const std::size_t held = this->JobQueue->size() +
+      (this->Zmq->JobsRequested > received ?
+       this->Zmq->JobsRequested - received : 0);
+  if(held < count)
+    {
+    this->Zmq->requestJobs(this->MeshRequirements.meshTypes(), msg,
+                           count - held);
     }
 }
 
+//-----------------------------------------------------------------------------
+void Worker::askForJobs( unsigned int numberOfJobs )
+{
+  const std::string msg = this->jobRequest();
+
+  boost::lock_guard<boost::mutex> lock(this->Zmq->Lock);
+  this->Zmq->requestJobs(this->MeshRequirements.meshTypes(), msg,
+                         numberOfJobs);
+}
+
 //-----------------------------------------------------------------------------
 std::size_t Worker::pendingJobCount() const
 {
@@ -184,24 +547,104 @@ std::size_t Worker::pendingJobCount() const
 //-----------------------------------------------------------------------------
 remus::worker::Job Worker::takePendingJob()
 {
-  return this->JobQueue->take();
+  remus::worker::Job job = this->JobQueue->take();
+  if(job.valid())
+    {
+    this->fillJobWindow(this->prefetch());
+    }
+  return job;
 }
 
 //-----------------------------------------------------------------------------
 remus::worker::Job Worker::getJob()
 {
-  if(this->pendingJobCount() == 0)
+  return this->getJob(-1);
+}
+
+//-----------------------------------------------------------------------------
+remus::worker::Job Worker::getJob(boost::int64_t timeoutMillisec)
+{
+  //make sure a job is on its way, without asking again for a job that
+  //hasn't arrived yet
+  const unsigned int window = this->prefetch();
+  this->fillJobWindow(std::max(window, 1u));
+
+  remus::worker::Job job = (timeoutMillisec < 0) ?
+            this->JobQueue->waitAndTakeJob() :
+            this->JobQueue->waitAndTakeJob(timeoutMillisec);
+
+  //ask for the jobs that will follow this one before handing it out, so
+  //they are sent to us while this job is processed
+  if(job.valid())
     {
-    this->askForJobs(1);
+    this->fillJobWindow(window);
     }
-  return this->JobQueue->waitAndTakeJob();
+  return job;
+}
+
+//-----------------------------------------------------------------------------
+std::size_t Worker::execute(const JobHandler& handler,
+                            unsigned int concurrency,
+                            std::size_t maxJobs)
+{
+  return this->execute(handler, concurrency,
+                       remus::worker::ResidentLimits(maxJobs, -1));
+}
+
+//-----------------------------------------------------------------------------
+std::size_t Worker::execute(const JobHandler& handler,
+                            unsigned int concurrency,
+                            const remus::worker::ResidentLimits& limits)
+{
+  const std::size_t maxJobs = limits.maxJobs();
+  const boost::int64_t idleTimeout = limits.idleTimeout();
+
+  //every thread asks for a job once it has handled one, so asking for the
+  //prefetched jobs up front keeps them pending for the whole execution
+  detail::JobExecutor executor(*this, handler, std::max(concurrency, 1u),
+                               maxJobs);
+  this->askForJobs( executor.request(std::max(concurrency, 1u) +
+                                     this->prefetch()) );
+
+  std::size_t taken = 0;
+  while(maxJobs == 0 || taken < maxJobs)
+    {
+    //only wait for the part of the idle timeout that hasn't passed yet,
+    //the timeout doesn't run while jobs are being handled
+    boost::int64_t wait = idleTimeout;
+    if(idleTimeout >= 0)
+      {
+      const boost::int64_t idle = executor.idleTime();
+      if(idle >= idleTimeout)
+        {
+        break;
+        }
+      wait = (idle > 0) ? idleTimeout - idle : idleTimeout;
+      }
+
+    remus::worker::Job job = (wait < 0) ?
+              this->JobQueue->waitAndTakeJob() :
+              this->JobQueue->waitAndTakeJob(wait);
+    if(job.validityReason() == remus::worker::Job::TERMINATE_WORKER)
+      {
+      break;
+      }
+    if(job.valid())
+      {
+      executor.post(job);
+      ++taken;
+      }
+    }
+  return executor.stop();
 }
 
 //-----------------------------------------------------------------------------
 void Worker::updateStatus(const remus::proto::JobStatus& info)
 {
   //send a message that contains, the status
-  std::string msg = remus::proto::to_string(info);
+  std::string msg = remus::proto::to_string(info,
+                                        this->MessageRouter->wireFormat());
+  boost::lock_guard<boost::mutex> lock(this->Zmq->Lock);
   remus::proto::send_Message(this->MeshRequirements.meshTypes(),
                              remus::MESH_STATUS,
                              msg,
@@ -233,21 +676,99 @@ void Worker::sendJobFailure(const remus::worker::Job& j,
 void Worker::returnResult(const remus::proto::JobResult& result)
 {
   //send a message that contains, the path to the resulting file
-  std::string msg = remus::proto::to_string(result);
-  remus::proto::send_Message(this->MeshRequirements.meshTypes(),
-                             remus::RETRIEVE_RESULT,
-                             msg,
-                             &this->Zmq->Server);
+  std::string msg = remus::proto::to_string(result,
+                                        this->MessageRouter->wireFormat());
+  this->Zmq->sendAwaitingReply(result.id(),
+                               this->MeshRequirements.meshTypes(),
+                               remus::RETRIEVE_RESULT,
+                               msg,
+                               std::string());
 
   //we need to block on waiting for the server to notify it has our result.
   //Otherwise it is possible to delete a worker before it is done transimiting
   //really large results to the server. Don't worry if the server terminates
   //the worker before this is over the MessageRouter spoofs the response.
-  remus::proto::Response response =
-      remus::proto::receive_Response(&this->Zmq->Server);
+  remus::proto::Response response = this->Zmq->receiveReply(result.id());
   (void) response;
 }
 
+//-----------------------------------------------------------------------------
+remus::worker::ResultStream Worker::streamResult(const remus::worker::Job& job,
+                                remus::common::ContentFormat::Type format)
+{
+  return remus::worker::ResultStream(*this, job, format);
+}
+
+//-----------------------------------------------------------------------------
+bool Worker::returnResult(const remus::worker::Job& job,
+                          remus::common::ContentFormat::Type format,
+                          std::istream& data)
+{
+  remus::worker::ResultStream stream = this->streamResult(job, format);
+
+  std::vector<char> buffer(this->ConnectionInfo.chunkSize());
+  while(stream.good() && data)
+    {
+    data.read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
+    const std::size_t count = static_cast<std::size_t>(data.gcount());
+    if(count > 0)
+      {
+      stream.write(&buffer[0], count);
+      }
+    }
+  return stream.commit();
+}
+
+//-----------------------------------------------------------------------------
+bool Worker::returnResultFromFile(const remus::worker::Job& job,
+                                  remus::common::ContentFormat::Type format,
+                                  const std::string& path)
+{
+  std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+  if(!file)
+    {
+    return false;
+    }
+  return this->returnResult(job, format, file);
+}
+
+//-----------------------------------------------------------------------------
+bool Worker::canStreamResults() const
+{
+  return this->MessageRouter->wireFormat() == remus::proto::WireFormat::Binary;
+}
+
+//-----------------------------------------------------------------------------
+void Worker::sendTransfer(const boost::uuids::uuid& transferId,
+                          remus::SERVICE_TYPE service,
+                          const std::string& header,
+                          const std::string& payload)
+{
+  this->Zmq->sendAwaitingReply(transferId,
+                               this->MeshRequirements.meshTypes(),
+                               service,
+                               header,
+                               payload);
+}
+
+//-----------------------------------------------------------------------------
+remus::proto::Transfer
+Worker::receiveTransfer(const boost::uuids::uuid& transferId)
+{
+  //the MessageRouter spoofs a RETRIEVE_RESULT reply to everything we are
+  //waiting on when the server terminates us, so anything that isn't a
+  //transfer reply means the result won't get to the server
+  remus::proto::Response response = this->Zmq->receiveReply(transferId);
+  const remus::SERVICE_TYPE service = response.serviceType();
+  if(service != remus::TRANSFER_BEGIN &&
+     service != remus::TRANSFER_CHUNK &&
+     service != remus::TRANSFER_COMMIT)
+    {
+    return remus::proto::Transfer();
+    }
+  return remus::proto::to_Transfer(response.data(), response.dataSize());
+}
+
 //-----------------------------------------------------------------------------
 bool Worker::workerShouldTerminate() const
 {
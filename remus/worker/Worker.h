@@ -14,6 +14,7 @@
 #define remus_worker_h
 
 #include <remus/common/MeshIOType.h>
+#include <remus/common/ServiceTypes.h>
 
 //Workers include everything from proto, so that
 //users don't need as many includes
@@ -22,14 +23,30 @@
 #include <remus/proto/JobStatus.h>
 
 #include <remus/worker/Job.h>
+#include <remus/worker/ResidentLimits.h>
+#include <remus/worker/ResultStream.h>
 #include <remus/worker/ServerConnection.h>
 
 #include <boost/scoped_ptr.hpp>
 
+//suppress warnings inside boost headers for gcc and clang
+#include <remus/common/CompilerInformation.h>
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/function.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <iosfwd>
+
 //included for export symbols
 #include <remus/worker/WorkerExports.h>
 
 namespace remus{
+  namespace proto
+  {
+  //forward declaration of classes only the implementation needs
+  class Transfer;
+  }
+
 namespace worker{
   namespace detail
   {
@@ -63,9 +80,19 @@ private:
 // remus server. Once you get a job from the server you process the given
 // job reporting back the status of the job, and than once finished the
 // results of the job.
+//
+// The status and results of jobs can be sent from many threads at once,
+// so a worker can process many jobs at the same time. The simplest way to
+// do that is to have the worker execute the jobs with a handler.
 class REMUSWORKER_EXPORT Worker
 {
 public:
+  //processes a single job when the worker executes jobs. It is called from
+  //the threads of the worker, and reports the status and result of the job
+  //through the worker it is given
+  typedef boost::function<void (remus::worker::Worker&,
+                                const remus::worker::Job&)> JobHandler;
+
   //construct a worker that can mesh a single type
   //it uses the server connection object to determine what server
   //to connect too. The requirements of this worker are extremely simple
@@ -97,6 +124,31 @@ public:
   void pollingRates( const remus::worker::PollingRates& rates );
   remus::worker::PollingRates pollingRates() const;
 
+  //Set the minimum time between status updates of a job that are sent to
+  //the server. Workers that report progress very often, like every line of
+  //output of a mesher, can use this to keep from flooding the server. Only
+  //the latest progress of a job is sent once the interval has passed,
+  //while changes in the state of a job and failures are always sent
+  //right away.
+  //
+  //Note: the interval is in milliseconds, and 0 (the default) sends
+  //every update
+  void statusInterval( boost::int64_t millisec );
+  boost::int64_t statusInterval() const;
+
+  //Set the number of jobs the worker keeps asked for or pending at all
+  //times. Once a job is taken the worker asks the server for another, so
+  //that the next job has already been sent to the worker by the time the
+  //current one is finished. The server gives queued jobs to the waiting
+  //workers holding the fewest jobs first, and can limit how many jobs a
+  //worker holds, so prefetching doesn't take jobs away from idle workers.
+  //
+  //Note: the default of 0 only asks for a job when getJob is called and
+  //no job is pending. Workers that execute jobs keep this many jobs
+  //pending on top of the jobs their threads are handling
+  void prefetch( unsigned int count );
+  unsigned int prefetch() const;
+
   //send a message to the server stating how many jobs
   //that we want to be sent to process
   void askForJobs( unsigned int numberOfJobs = 1 );
@@ -112,6 +164,33 @@ public:
   //Blocking fetch a pending job and return it
   remus::worker::Job getJob();
 
+  //Blocking fetch a pending job, waiting at most timeoutMillisec for it.
+  //Returns an invalid job if no job arrived in time. The job that was
+  //asked for is still sent to the worker, and taken by the next fetch
+  remus::worker::Job getJob(boost::int64_t timeoutMillisec);
+
+  //Process jobs with the handler on a pool of concurrency threads, keeping
+  //a job in flight for each of them. Blocks until the server tells the
+  //worker to terminate, or until maxJobs jobs have been handled when maxJobs
+  //isn't zero. Returns the number of jobs that were handled.
+  //
+  //Handlers that throw fail the job they were given, and handlers should
+  //check jobShouldBeTerminated and workerShouldTerminate like any other
+  //code that processes jobs
+  std::size_t execute(const JobHandler& handler,
+                      unsigned int concurrency,
+                      std::size_t maxJobs = 0);
+
+  //Process jobs like execute does, as a resident worker that handles at
+  //most limits.maxJobs() jobs, and stops once no job has been handled for
+  //limits.idleTimeout() milliseconds. Workers launched by the worker factory
+  //as resident workers are given their limits through the environment:
+  //
+  //  w.execute(handler, 1, remus::worker::ResidentLimits::fromEnvironment());
+  std::size_t execute(const JobHandler& handler,
+                      unsigned int concurrency,
+                      const remus::worker::ResidentLimits& limits);
+
   //update the status of the worker
   void updateStatus(const remus::proto::JobStatus& info);
 
@@ -128,6 +207,27 @@ public:
   //send to the server the mesh results.
   void returnResult(const remus::proto::JobResult& result);
 
+  //start sending the results of a job to the server, as the data is
+  //written to the returned stream. The data is sent in chunks of the
+  //connection's chunkSize, so large results never need to be held in
+  //memory. The result is finished once the stream is committed.
+  remus::worker::ResultStream streamResult(const remus::worker::Job& job,
+                             remus::common::ContentFormat::Type format);
+
+  //send to the server the results of a job, whose data is read from the
+  //given stream in chunks. Returns false if the server didn't accept
+  //the result
+  bool returnResult(const remus::worker::Job& job,
+                    remus::common::ContentFormat::Type format,
+                    std::istream& data);
+
+  //send to the server the results of a job, whose data is read from the
+  //given file in chunks. Returns false if the file can't be read or the
+  //server didn't accept the result
+  bool returnResultFromFile(const remus::worker::Job& job,
+                            remus::common::ContentFormat::Type format,
+                            const std::string& path);
+
   //ask the worker API if the server has told us we should shutdown.
   //This means that the server has shutdown and all jobs the worker
   //has are invalid and can be terminated.
@@ -139,14 +239,44 @@ public:
   bool jobShouldBeTerminated( const remus::worker::Job& job ) const;
 
 private:
+  friend class ResultStream;
+
+  //negotiate the wire format with the server and register the
+  //requirements that we support
+  void registerWithServer();
+
+  //the message that asks the server for a job
+  std::string jobRequest() const;
+
+  //ask for enough jobs that count jobs are asked for or pending
+  void fillJobWindow(std::size_t count);
+
+  //returns true when the server accepts results that are streamed to it
+  bool canStreamResults() const;
+
+  //send one message of a streamed result to the server. The server replies
+  //to every message, and the replies of a transfer are read with
+  //receiveTransfer in the order its messages were sent
+  void sendTransfer(const boost::uuids::uuid& transferId,
+                    remus::SERVICE_TYPE service,
+                    const std::string& header,
+                    const std::string& payload);
+
+  //wait for the reply to the oldest message of a streamed result that
+  //hasn't been replied to. Returns an invalid transfer if the server
+  //rejected the message, or the worker is being terminated
+  remus::proto::Transfer receiveTransfer(const boost::uuids::uuid& transferId);
+
   //holds the type of mesh we support
   const remus::proto::JobRequirements MeshRequirements;
 
   remus::worker::ServerConnection ConnectionInfo;
 
+  //the message router hands jobs to the job queue, so the queue is
+  //constructed before the router and destroyed after it
   boost::scoped_ptr<detail::ZmqManagement> Zmq;
-  boost::scoped_ptr<remus::worker::detail::MessageRouter> MessageRouter;
   boost::scoped_ptr<remus::worker::detail::JobQueue> JobQueue;
+  boost::scoped_ptr<remus::worker::detail::MessageRouter> MessageRouter;
 
   //explicitly state the worker doesn't support copy or move semantics
   Worker(const Worker&);
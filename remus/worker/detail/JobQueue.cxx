@@ -12,15 +12,15 @@
 
 #include <remus/worker/detail/JobQueue.h>
 
-#include <remus/proto/Response.h>
-#include <remus/proto/JobSubmission.h>
-
 //suppress warnings inside boost headers for gcc and clang
+#include <remus/common/CompilerInformation.h>
 REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/thread.hpp>
 #include <boost/thread/locks.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
+#include <algorithm>
 #include <deque>
 #include <set>
 
@@ -45,144 +45,42 @@ namespace detail{
 //-----------------------------------------------------------------------------
 class JobQueue::JobQueueImplementation
 {
-  //thread our polling method
-  boost::scoped_ptr<boost::thread> PollingThread;
-
   //used to keep the queue from breaking with threads
-  boost::mutex QueueMutex;
+  mutable boost::mutex QueueMutex;
   boost::condition_variable QueueChanged;
   std::deque< remus::worker::Job > Queue;
+  std::size_t JobsReceived;
 
   //a set of jobs that the JobQueue has been told should be terminated
   std::set< boost::uuids::uuid > TerminatedJobs;
 
-  //need to store our endpoint so we can pass it to the worker
-  std::string EndPoint;
-
-  //state to tell when we should stop polling
-  bool ContinuePolling;
-
-  //states that we have finished setting up and are ready to accept messages
-  bool PollingStarted;
-
-  //states that we have been told to stop polling and should be ready
-  //to be destroyed. Is not the same as NOT ContinuePolling and PollingStarted.
-  //as that logic returns false while the polling thread is being constructed
-  bool PollingFinished;
+  //states that we have been told to terminate the worker, and won't
+  //accept any more jobs
+  bool Shutdown;
 
 public:
 //-----------------------------------------------------------------------------
-JobQueueImplementation(zmq::context_t& context,
-                       const zmq::socketInfo<zmq::proto::inproc>& queue_info):
-  PollingThread(new boost::thread()),
+JobQueueImplementation():
   QueueMutex(),
   QueueChanged(),
   Queue(),
+  JobsReceived(0),
   TerminatedJobs(),
-  EndPoint(),
-  ContinuePolling(true),
-  PollingStarted(false),
-  PollingFinished(false)
-{
-  //start up our thread
-  boost::scoped_ptr<boost::thread> pollingThread(
-      new boost::thread( &JobQueueImplementation::pollForJobs,
-                         this,
-                         &context,
-                         queue_info) );
-
-  //transfer ownership of the polling thread to our scoped_ptr
-  this->PollingThread.swap(pollingThread);
-}
-
-//------------------------------------------------------------------------------
-~JobQueueImplementation()
-{
-  //stop the thread
-  this->PollingThread->join();
-}
-
-//------------------------------------------------------------------------------
-const std::string& endpoint() const
-{
-  return this->EndPoint;
-}
-
-//------------------------------------------------------------------------------
-void stop()
+  Shutdown(false)
 {
-  this->ContinuePolling = false;
-  this->PollingStarted = false;
-  this->PollingFinished = true;
 }
 
 //------------------------------------------------------------------------------
-void pollForJobs(zmq::context_t* context,
-                 zmq::socketInfo<zmq::proto::inproc> queue_info)
-{
-  //we pass the context by pointer since it can't be copied.
-  //we pass the queue_info by value since it is light weight
-
-  //since this is threaded, this we need to make sure that zmq_socket and
-  //zmq_close will execute from inside the thread address space so that
-  //when the thread is joined everything cleans up in the correct order,
-  //otherwise we can get segment-faults when trying to use multiple workers in
-  //the same process.
-  zmq::socket_t serverComm(*context,ZMQ_PAIR);
-
-  //bind to the work_jobs communication channel first
-  this->EndPoint = zmq::bindToAddress(serverComm, queue_info).endpoint();
-
-  //now that we have finished binding we are ready to accept jobs
-  this->PollingStarted = true;
-
-  zmq::pollitem_t item  = { serverComm,  0, ZMQ_POLLIN, 0 };
-  while( this->ContinuePolling )
-    {
-    zmq::poll_safely(&item,1,250);
-    if(item.revents & ZMQ_POLLIN)
-      {
-      remus::proto::Response response =
-          remus::proto::receive_Response(&serverComm);
-      if(!response.isValid())
-        { //ignore this response if it isn't valid
-        continue;
-        }
-
-      switch(response.serviceType())
-        {
-        case remus::TERMINATE_WORKER:
-          this->clearJobs();
-          this->stop();
-          break;
-        case remus::MAKE_MESH:
-          this->addItem(response);
-          break;
-        case remus::TERMINATE_JOB:
-          this->terminateJob(response);
-        default:
-          //ignore other service types as we shouldn't be sent those
-          break;
-        }
-      }
-    }
-}
-
-//------------------------------------------------------------------------------
-void terminateJob(remus::proto::Response& response)
+void terminateJob(const boost::uuids::uuid& id)
 {
   boost::lock_guard<boost::mutex> lock(this->QueueMutex);
 
-  const std::string data(response.data(), response.dataSize());
-  remus::worker::Job tj = remus::worker::to_Job(data);
-
   //first thing is we add the job id to the list of terminated job ids
-  this->TerminatedJobs.insert( tj.id() );
+  this->TerminatedJobs.insert( id );
 
   //next we go through the deque and remove any job with that id
-
   typedef std::deque< remus::worker::Job >::iterator iter;
-  JobIdMatches pred( tj.id() );
+  JobIdMatches pred( id );
 
   iter new_end = std::remove_if(this->Queue.begin(),
                                 this->Queue.end(),
@@ -193,7 +91,7 @@ void terminateJob(remus::proto::Response& response)
 }
 
 //------------------------------------------------------------------------------
-void clearJobs()
+void terminateWorker()
 {
   boost::lock_guard<boost::mutex> lock(this->QueueMutex);
   this->Queue.clear();
@@ -201,20 +99,22 @@ void clearJobs()
   remus::worker::Job j;
   j.updateValidityReason(remus::worker::Job::TERMINATE_WORKER);
   this->Queue.push_back(j);
+  this->Shutdown = true;
 
   this->QueueChanged.notify_all();
 }
 
 //------------------------------------------------------------------------------
-void addItem(remus::proto::Response& response )
+void addJob(const remus::worker::Job& job)
 {
   boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  if(this->Shutdown)
+    { //the only job left should be the one terminating the worker
+    return;
+    }
 
-  //required to use the char*, len constructor as response's data can
-  //be binary data with lots of null terminators.
-  const std::string data(response.data(), response.dataSize());
-  remus::worker::Job j = remus::worker::to_Job(data);
-  this->Queue.push_back( j );
+  this->Queue.push_back( job );
+  ++this->JobsReceived;
 
   this->QueueChanged.notify_all();
 }
@@ -222,75 +122,112 @@ void addItem(remus::proto::Response& response )
 //------------------------------------------------------------------------------
 bool isATerminatedJob(const remus::worker::Job& job) const
 {
+  //workers that execute many jobs at once ask from many threads
+  boost::lock_guard<boost::mutex> lock(this->QueueMutex);
   return this->TerminatedJobs.count( job.id() ) == 1;
 }
 
 //------------------------------------------------------------------------------
 remus::worker::Job take()
 {
-  //the only jobs on the queue should be valid jobs or kill the worker
-  remus::worker::Job job;
-  if(this->size() > 0)
-    {
-    boost::unique_lock<boost::mutex> lock(this->QueueMutex);
-    job = this->Queue[0];
-    this->Queue.pop_front();
+  boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  return this->takeLocked();
+}
 
-    //notify everyone that a job was taken from the queue
-    this->QueueChanged.notify_all();
+//------------------------------------------------------------------------------
+remus::worker::Job waitAndTakeJob()
+{
+  boost::unique_lock<boost::mutex> lock(this->QueueMutex);
+  while(this->Queue.empty())
+    {
+    this->QueueChanged.wait(lock);
     }
-  return job;
+  return this->takeLocked();
 }
 
 //------------------------------------------------------------------------------
-remus::worker::Job waitAndTakeJob()
+remus::worker::Job waitAndTakeJob(boost::int64_t timeoutMillisec)
 {
+  const boost::system_time deadline = boost::get_system_time() +
+              boost::posix_time::milliseconds(std::max(boost::int64_t(0),
+                                                       timeoutMillisec));
+
   boost::unique_lock<boost::mutex> lock(this->QueueMutex);
-  while(this->Queue.size() == 0)
+  while(this->Queue.empty())
     {
-    QueueChanged.wait(lock);
+    if(!this->QueueChanged.timed_wait(lock, deadline))
+      {
+      break;
+      }
     }
-  lock.unlock();
-  return take();
+  return this->takeLocked();
 }
 
 //------------------------------------------------------------------------------
-std::size_t size()
+std::size_t size() const
 {
   boost::lock_guard<boost::mutex> lock(this->QueueMutex);
   return this->Queue.size();
 }
 
 //------------------------------------------------------------------------------
-bool isReady() const
+std::size_t jobsReceived() const
 {
-  return this->PollingStarted && this->ContinuePolling;
+  boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  return this->JobsReceived;
 }
 
 //------------------------------------------------------------------------------
 bool isShutdown() const
 {
-  return this->PollingFinished;
+  boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  return this->Shutdown;
+}
+
+private:
+//------------------------------------------------------------------------------
+//takes the first job off the queue, the caller must hold the lock
+remus::worker::Job takeLocked()
+{
+  //the only jobs on the queue should be valid jobs or kill the worker
+  remus::worker::Job job;
+  if(!this->Queue.empty())
+    {
+    job = this->Queue.front();
+    this->Queue.pop_front();
+    }
+  return job;
 }
 
 };
 
 //------------------------------------------------------------------------------
-JobQueue::JobQueue(zmq::context_t& context,
-                   const zmq::socketInfo<zmq::proto::inproc>& queue_info):
-  Implementation( new JobQueueImplementation(context,queue_info) )
+JobQueue::JobQueue():
+  Implementation( new JobQueueImplementation() )
 {
 }
 
+//------------------------------------------------------------------------------
 JobQueue::~JobQueue()
 {
-  this->Implementation->stop();
 }
 
 //------------------------------------------------------------------------------
-std::string JobQueue::endpoint() const
+void JobQueue::addJob(const remus::worker::Job& job)
+{
+  this->Implementation->addJob(job);
+}
+
+//------------------------------------------------------------------------------
+void JobQueue::terminateJob(const boost::uuids::uuid& id)
 {
-  return this->Implementation->endpoint();
+  this->Implementation->terminateJob(id);
+}
+
+//------------------------------------------------------------------------------
+void JobQueue::terminateWorker()
+{
+  this->Implementation->terminateWorker();
 }
 
 //------------------------------------------------------------------------------
@@ -311,16 +248,28 @@ remus::worker::Job JobQueue::waitAndTakeJob()
   return this->Implementation->waitAndTakeJob();
 }
 
+//------------------------------------------------------------------------------
+remus::worker::Job JobQueue::waitAndTakeJob(boost::int64_t timeoutMillisec)
+{
+  return this->Implementation->waitAndTakeJob(timeoutMillisec);
+}
+
 //------------------------------------------------------------------------------
 std::size_t JobQueue::size() const
 {
   return this->Implementation->size();
 }
 
+//------------------------------------------------------------------------------
+std::size_t JobQueue::jobsReceived() const
+{
+  return this->Implementation->jobsReceived();
+}
+
 //------------------------------------------------------------------------------
 bool JobQueue::isReady() const
 {
-  return this->Implementation->isReady();
+  return !this->Implementation->isShutdown();
 }
 
 //------------------------------------------------------------------------------
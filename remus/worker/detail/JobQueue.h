@@ -13,10 +13,11 @@
 #ifndef remus_worker_detail_JobQueue_h
 #define remus_worker_detail_JobQueue_h
 
-#include <remus/proto/zmqHelper.h>
 #include <remus/worker/Job.h>
 
+#include <boost/cstdint.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/uuid/uuid.hpp>
 
 namespace remus{
 namespace worker{
@@ -28,14 +29,27 @@ namespace detail{
 //
 //Once a JobQueue is sent a TerminateWorker, it will not accept any new jobs
 //and will refuse to start back up looking for jobs
+//
+//Jobs are added by the thread of the MessageRouter as it receives them from
+//the server, and taken by the threads of the worker. Every call takes the
+//lock of the queue once, so adding a job never waits on more than a single
+//take of a job.
 class JobQueue
 {
 public:
-  JobQueue(zmq::context_t& context,
-           const zmq::socketInfo<zmq::proto::inproc>& queue_info);
+  JobQueue();
   ~JobQueue();
 
-  std::string endpoint() const;
+  //add a job that the server has sent us to the end of the queue. Jobs
+  //added after the queue has been told to terminate the worker are dropped
+  void addJob(const remus::worker::Job& job);
+
+  //remove a job from the queue, and remember that it has been terminated
+  //so that the worker processing it can find out
+  void terminateJob(const boost::uuids::uuid& id);
+
+  //clear the queue, leaving only a job that tells the worker to terminate
+  void terminateWorker();
 
   //Returns true if the job is part of the queue and job status
   //has been marked as terminate. This is allows people to peek at the queue
@@ -50,15 +64,23 @@ public:
   //job is present, it waits for a job to enter the queue
   remus::worker::Job waitAndTakeJob();
 
+  //Removes the first job from the queue, If no job is present, it waits
+  //up to timeoutMillisec for a job to enter the queue, returning an
+  //invalid job when none does
+  remus::worker::Job waitAndTakeJob(boost::int64_t timeoutMillisec);
+
   //return the number of jobs waiting for work
   std::size_t size() const;
 
-  //has finished setting up and is ready for jobs
+  //return the number of jobs the server has sent to the queue, including
+  //the jobs that have already been taken or terminated
+  std::size_t jobsReceived() const;
+
+  //is ready for jobs, which is true until the queue has been told
+  //to terminate the worker
   bool isReady() const;
 
-  //has job queue been told to shutdown and terminate this is only true
-  //if the job queue has been started and than has been stopped. If the
-  //job queue is still launching this will return false
+  //has job queue been told to shutdown and terminate the worker
   bool isShutdown() const;
 
 private:
@@ -12,20 +12,30 @@
 
 #include <remus/worker/detail/MessageRouter.h>
 
+#include <remus/proto/JobStatus.h>
+#include <remus/proto/JobSubmission.h>
 #include <remus/proto/Message.h>
 #include <remus/proto/Response.h>
 #include <remus/proto/zmqHelper.h>
 
 #include <remus/common/CompilerInformation.h>
 #include <remus/common/PollingMonitor.h>
+#include <remus/common/Timer.h>
 #include <remus/worker/Job.h>
+#include <remus/worker/detail/JobQueue.h>
 
 REMUS_THIRDPARTY_PRE_INCLUDE
 #include <boost/thread.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/thread/locks.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_generators.hpp>
+#include <boost/uuid/uuid_io.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
+#include <algorithm>
+
 namespace remus{
 namespace worker{
 namespace detail{
@@ -34,7 +44,8 @@ namespace detail{
 class MessageRouter::MessageRouterImplementation
 {
   std::string WorkerEndpoint;
-  std::string QueueEndpoint;
+  std::string ReplyEndpoint;
+  remus::worker::detail::JobQueue& Queue;
   std::size_t OutstandingResults;
 
   //kept as a member variable so that we can allow the user to specify
@@ -56,13 +67,38 @@ class MessageRouter::MessageRouterImplementation
   //Should we continue to forward messages from the server to the worker
   bool ContinueForwardingToWorker;
 
+  //the wire format the server has agreed to accept from us
+  remus::proto::WireFormat::Type Format;
+
+  //the minimum time in milliseconds between status updates of a job that
+  //are sent to the server, zero sends every update
+  boost::int64_t StatusInterval;
+
+  //the status updates that we have sent for each job, and the latest
+  //update that is waiting for the status interval of the job to pass
+  struct StatusState
+  {
+    StatusState(): LastSentStatus(remus::INVALID_STATUS), LastSentTime(0),
+                   Pending() {}
+
+    remus::STATUS_TYPE LastSentStatus;
+    boost::int64_t LastSentTime;
+    boost::shared_ptr<remus::proto::Message> Pending;
+  };
+  typedef boost::unordered_map<boost::uuids::uuid, StatusState> StatusMap;
+  StatusMap Statuses;
+
+  //the clock that status updates are timed with
+  remus::common::Timer Clock;
+
 public:
 //-----------------------------------------------------------------------------
 MessageRouterImplementation(
                       const zmq::socketInfo<zmq::proto::inproc>& worker_info,
-                      const zmq::socketInfo<zmq::proto::inproc>& queue_info):
+                      remus::worker::detail::JobQueue& queue):
   WorkerEndpoint(worker_info.endpoint()),
-  QueueEndpoint(queue_info.endpoint()),
+  ReplyEndpoint(MessageRouter::replyChannel(worker_info).endpoint()),
+  Queue(queue),
   OutstandingResults(0),
   PollMonitor(boost::int64_t(250), boost::int64_t(60000)), //assign a low floor for faster testing
   ThreadMutex(),
@@ -70,7 +106,11 @@ MessageRouterImplementation(
   PollingThread(new boost::thread()),
   ContinuePolling(false),
   ContinueForwardingToServer(true),
-  ContinueForwardingToWorker(true)
+  ContinueForwardingToWorker(true),
+  Format(remus::proto::WireFormat::Text),
+  StatusInterval(0),
+  Statuses(),
+  Clock()
 {
   //we don't connect the sockets until the polling thread starts up
 }
@@ -102,6 +142,27 @@ bool isForwardingToServer() const
   return this->ContinueForwardingToServer;
 }
 
+//-----------------------------------------------------------------------------
+remus::proto::WireFormat::Type wireFormat() const
+{
+  boost::lock_guard<boost::mutex> lock(ThreadMutex);
+  return this->Format;
+}
+
+//-----------------------------------------------------------------------------
+boost::int64_t statusInterval() const
+{
+  boost::lock_guard<boost::mutex> lock(ThreadMutex);
+  return this->StatusInterval;
+}
+
+//-----------------------------------------------------------------------------
+void statusInterval(boost::int64_t millisec)
+{
+  boost::lock_guard<boost::mutex> lock(ThreadMutex);
+  this->StatusInterval = std::max(boost::int64_t(0), millisec);
+}
+
 //------------------------------------------------------------------------------
 bool startTalking(const remus::worker::ServerConnection& server_info,
                   zmq::context_t& internal_inproc_context)
@@ -165,15 +226,33 @@ void poll(remus::worker::ServerConnection server_info,
   //we pass the context by pointer since it can't be copied.
   //we pass the ServerConnection by value since it is light weight
 
+  //we talk to the server over two connections. The data lane carries jobs
+  //and results, while the control lane carries heartbeats and status so
+  //that they keep reaching the server while a large result is being sent.
+  //We pick the identities so that the server can tell which worker the
+  //control lane belongs to, and which process launched by a worker
+  //factory the worker belongs to
+  const std::string name =
+                boost::uuids::to_string(boost::uuids::random_generator()());
+  const zmq::SocketIdentity dataIdentity = zmq::make_WorkerIdentity(name);
+  const zmq::SocketIdentity controlIdentity =
+                                      zmq::make_ControlIdentity(dataIdentity);
+
   zmq::socket_t serverComm(*(server_info.context()),ZMQ_DEALER);
+  serverComm.setsockopt(ZMQ_IDENTITY, dataIdentity.data(), dataIdentity.size());
   zmq::connectToAddress(serverComm, server_info.endpoint());
 
-  zmq::socket_t queueComm(*internal_inproc_context,ZMQ_PAIR);
-  zmq::connectToAddress(queueComm,  this->QueueEndpoint);
+  zmq::socket_t controlComm(*(server_info.context()),ZMQ_DEALER);
+  controlComm.setsockopt(ZMQ_IDENTITY, controlIdentity.data(),
+                         controlIdentity.size());
+  zmq::connectToAddress(controlComm, server_info.endpoint());
 
   zmq::socket_t workerComm(*internal_inproc_context,ZMQ_PAIR);
   zmq::connectToAddress(workerComm, this->WorkerEndpoint);
 
+  zmq::socket_t replyComm(*internal_inproc_context,ZMQ_PAIR);
+  zmq::connectToAddress(replyComm, this->ReplyEndpoint);
+
   zmq::pollitem_t items[2]  = {
                                 { workerComm,  0, ZMQ_POLLIN, 0 },
                                 { serverComm,  0, ZMQ_POLLIN, 0 }
@@ -185,27 +264,45 @@ void poll(remus::worker::ServerConnection server_info,
   //notification, and will also allow threads that have been holding on
   //waitForThreadToStart to resume
   this->setIsTalking(true);
+
+  //any message we send shows the server we are alive, so we only send
+  //heartbeats once we have gone a heartbeat interval without sending
+  //anything. The first heartbeat is sent right away so the server knows
+  //about us as soon as we connect
+  remus::common::Timer sinceLastSent;
+  bool sentToServer = false;
   while( this->isTalking() )
     {
-    zmq::poll_safely(&items[0],2,this->PollMonitor.current());
+    //wake up in time to send the next heartbeat or held back status
+    //update, even when the polling monitor wants to sleep longer
+    const boost::int64_t untilHeartbeat =
+          std::max( boost::int64_t(1),
+                    this->heartbeatInterval() - sinceLastSent.elapsed() );
+    const boost::int64_t untilWakeUp =
+          std::min( untilHeartbeat, this->untilPendingStatus() );
+    zmq::poll_safely(&items[0],2,
+                     std::min(this->PollMonitor.current(), untilWakeUp));
     this->PollMonitor.pollOccurred();
 
     //handle taking
-    bool notSentToServer = true;
     if(items[1].revents & ZMQ_POLLIN)
         {
         //handle accepting message from the server and forwarding
         //them to the server. Handle server messages before worker
         //messages so that we don't send messages to a server
         //that is now telling us to shut down
-        this->handleServerMessage(workerComm, serverComm, queueComm);
+        this->handleServerMessage(replyComm, serverComm);
         }
     if(items[0].revents & ZMQ_POLLIN)
         {
-        notSentToServer = false;
         //handle accepting messages from the worker and forwarding
         //them to the server
-        this->handleWorkerMessage(workerComm, serverComm, queueComm);
+        if(this->handleWorkerMessage(workerComm, replyComm, serverComm,
+                                     controlComm))
+          {
+          sentToServer = true;
+          sinceLastSent.reset();
+          }
         if(!ContinueForwardingToWorker)
           {
           //we are shutting down so we mark that we will not accept any
@@ -214,25 +311,173 @@ void poll(remus::worker::ServerConnection server_info,
           }
         }
 
-     if(notSentToServer)
+     //status updates share a lane with heartbeats, so sending one that
+     //was held back also shows the server we are alive
+     if(this->sendPendingStatus(this->laneFor(remus::MESH_STATUS, serverComm,
+                                              controlComm), false))
+        {
+        sentToServer = true;
+        sinceLastSent.reset();
+        }
+
+     if(!sentToServer ||
+        sinceLastSent.elapsed() >= this->heartbeatInterval())
         {
         //we are going to send a heartbeat now since we have gone long enough
         //without sending a message to the server
-        this->sendHeartBeat(serverComm, this->PollMonitor);
+        this->sendHeartBeat(this->laneFor(remus::HEARTBEAT, serverComm,
+                                          controlComm),
+                            this->PollMonitor);
+        sentToServer = true;
+        sinceLastSent.reset();
         }
     }
 }
 
 //------------------------------------------------------------------------------
-//handles taking messages from the worker
-void handleWorkerMessage(zmq::socket_t& workerComm,
+//how long we can go without sending the server a message. We advertise
+//the max poll time out as the interval the server should expect a heartbeat
+//in, and beat twice as often so a single late heartbeat doesn't make the
+//server think we are unresponsive
+boost::int64_t heartbeatInterval() const
+{
+  return std::max( boost::int64_t(1), this->PollMonitor.maxTimeOut() / 2 );
+}
+
+//------------------------------------------------------------------------------
+//returns true when a status update should be sent to the server now.
+//Changes in the state of a job and failures are always sent, while
+//progress is only sent once the status interval of the job has passed.
+//Progress that arrives sooner is held back, replacing the progress that
+//is already waiting, so that only the latest update is sent
+bool shouldSendStatus(const remus::proto::Message& message)
+{
+  const boost::int64_t interval = this->statusInterval();
+  if(interval == 0)
+    {
+    return true;
+    }
+
+  const remus::proto::JobStatus status =
+        remus::proto::to_JobStatus(message.data(), message.dataSize());
+  const boost::int64_t now = this->Clock.elapsed();
+  StatusState& state = this->Statuses[status.id()];
+  if(status.failed() ||
+     status.status() != state.LastSentStatus ||
+     now - state.LastSentTime >= interval)
+    {
+    state.LastSentStatus = status.status();
+    state.LastSentTime = now;
+    state.Pending.reset();
+    return true;
+    }
+
+  state.Pending = boost::make_shared<remus::proto::Message>(message);
+  return false;
+}
+
+//------------------------------------------------------------------------------
+//sends the held back status updates whose status interval has passed, or
+//all of them when flushing. Returns true when anything was sent
+bool sendPendingStatus(zmq::socket_t& lane, bool flush)
+{
+  if(this->Statuses.empty())
+    {
+    return false;
+    }
+
+  const boost::int64_t interval = this->statusInterval();
+  const boost::int64_t now = this->Clock.elapsed();
+  bool sent = false;
+  for(StatusMap::iterator i = this->Statuses.begin();
+      i != this->Statuses.end(); )
+    {
+    StatusState& state = i->second;
+    const bool due = (now - state.LastSentTime) >= interval;
+    if(state.Pending && (flush || due))
+      {
+      if(this->ContinueForwardingToServer)
+        {
+        remus::proto::forward_Message(*state.Pending,&lane);
+        sent = true;
+        }
+      state.Pending.reset();
+      state.LastSentTime = now;
+      ++i;
+      }
+    else if(!state.Pending && due)
+      {
+      //the next update of this job will be sent right away, so we
+      //don't need to remember anything about it
+      i = this->Statuses.erase(i);
+      }
+    else
+      {
+      ++i;
+      }
+    }
+  return sent;
+}
+
+//------------------------------------------------------------------------------
+//the time in milliseconds until a held back status update needs to be sent
+boost::int64_t untilPendingStatus() const
+{
+  const boost::int64_t interval = this->statusInterval();
+  const boost::int64_t now = this->Clock.elapsed();
+  boost::int64_t until = this->PollMonitor.maxTimeOut();
+  for(StatusMap::const_iterator i = this->Statuses.begin();
+      i != this->Statuses.end(); ++i)
+    {
+    if(i->second.Pending)
+      {
+      until = std::min(until, i->second.LastSentTime + interval - now);
+      }
+    }
+  return std::max(boost::int64_t(1), until);
+}
+
+//------------------------------------------------------------------------------
+//returns true for the messages that stream a result to the server
+static bool is_transfer(remus::SERVICE_TYPE service)
+{
+  return service == remus::TRANSFER_BEGIN ||
+         service == remus::TRANSFER_CHUNK ||
+         service == remus::TRANSFER_COMMIT;
+}
+
+//------------------------------------------------------------------------------
+//returns the connection a message should be sent to the server on.
+//Heartbeats and status only use the control lane once the server has
+//answered our WIRE_FORMAT request, as servers that negotiate wire formats
+//also understand control lanes. Older servers would think the control
+//lane is a worker of its own
+zmq::socket_t& laneFor(remus::SERVICE_TYPE service,
+                       zmq::socket_t& serverComm,
+                       zmq::socket_t& controlComm) const
+{
+  //Format is only changed by the polling thread, which is who calls us
+  const bool isControl = service == remus::HEARTBEAT ||
+                         service == remus::MESH_STATUS;
+  return (isControl && this->Format == remus::proto::WireFormat::Binary) ?
+                                                    controlComm : serverComm;
+}
+
+//------------------------------------------------------------------------------
+//handles taking messages from the worker. Returns true when the message
+//was sent on the same lane as heartbeats, as only then does it show the
+//server we are alive. A large result on the data lane can take longer to
+//arrive than the server is willing to wait for a heartbeat
+bool handleWorkerMessage(zmq::socket_t& workerComm,
+                         zmq::socket_t& replyComm,
                          zmq::socket_t& serverComm,
-                         zmq::socket_t& queueComm)
+                         zmq::socket_t& controlComm)
 {
   //first we take the message from the worker socket so it
   //doesn't hang around, and makes the worker think it
   //always is connected to a server
   remus::proto::Message message = remus::proto::receive_Message(&workerComm);
+  bool sentOnHeartbeatLane = false;
 
   //next we check if we are forwarding messages to the server,
   //if we aren't doing that there is no point to send the message
@@ -240,45 +485,73 @@ void handleWorkerMessage(zmq::socket_t& workerComm,
   //use block on destruction of the socket
   if( this->ContinueForwardingToServer )
     {
+    //progress that arrives faster than the status interval is held back,
+    //and only the latest progress of a job is sent
+    if(message.serviceType() == remus::MESH_STATUS &&
+       !this->shouldSendStatus(message))
+      {
+      return false;
+      }
+
+    //make sure the server has the latest progress of our jobs before it
+    //gets their results, or we go away
+    if(message.serviceType() == remus::RETRIEVE_RESULT ||
+       message.serviceType() == remus::TRANSFER_COMMIT ||
+       message.serviceType() == remus::TERMINATE_WORKER)
+      {
+      this->sendPendingStatus(this->laneFor(remus::MESH_STATUS, serverComm,
+                                            controlComm), true);
+      }
+
     //first we need to forward all message to the server
-    remus::proto::forward_Message(message,&serverComm);
+    zmq::socket_t& lane = this->laneFor(message.serviceType(),
+                                        serverComm, controlComm);
+    remus::proto::forward_Message(message,&lane);
+    sentOnHeartbeatLane =
+          (&lane == &this->laneFor(remus::HEARTBEAT, serverComm, controlComm));
 
     //if the worker is telling use to submit a TERMINATE_WORKER
     //job that means it is in the process of shutting down.
     //so we need to prepare for that
     if(message.serviceType()==remus::TERMINATE_WORKER)
       {
-      //send the terminate worker message to the job queue so it
-      //shuts down. This has to be blocking so we know that it has
-      //received the message.
-      remus::worker::Job terminateJob;
-      remus::proto::send_Response(remus::TERMINATE_WORKER,
-                                  remus::worker::to_string(terminateJob),
-                                  &queueComm,
-                                  (zmq::SocketIdentity()) );
+      //tell the job queue to shut down
+      this->Queue.terminateWorker();
 
       //we are in the process of cleaning up we need to stop everything.
       //we first check if we have any outstanding job results that
       //are waiting around to be sent
       this->ContinueForwardingToWorker = false;
       }
-    else if(message.serviceType()==remus::RETRIEVE_RESULT)
+    else if(message.serviceType()==remus::RETRIEVE_RESULT ||
+            is_transfer(message.serviceType()))
       {
       //Mark that we need a response from the server, this is required so that
       //we can send back really large result data. When we don't wait for the
       //server to get our data, we will drop the results as the socket linger
       //time is less than the amount of time it takes to transmit the results
-      //to the server.
+      //to the server. Every message of a streamed result is answered by
+      //the server, and the worker waits on those answers for flow control
       ++this->OutstandingResults;
       }
     }
+  else if(is_transfer(message.serviceType()))
+    {
+    //nothing is going to answer a streamed result, so fail it right away
+    //instead of leaving the worker waiting
+    remus::proto::send_NonBlockingResponse(message.serviceType(),
+                                           remus::INVALID_MSG,
+                                           &replyComm,
+                                           (zmq::SocketIdentity()));
+    }
+  return sentOnHeartbeatLane;
 }
 
 //------------------------------------------------------------------------------
-//handles taking messages from the server
-void handleServerMessage( zmq::socket_t& workerComm,
-                          zmq::socket_t& serverComm,
-                          zmq::socket_t& queueComm)
+//handles taking messages from the server, handing the replies the worker
+//is waiting on to the reply channel
+void handleServerMessage( zmq::socket_t& replyComm,
+                          zmq::socket_t& serverComm)
 {
   remus::proto::Response response = remus::proto::receive_Response(&serverComm);
   const bool goodToForward = response.isValid();
@@ -298,38 +571,69 @@ void handleServerMessage( zmq::socket_t& workerComm,
         {
         remus::proto::send_NonBlockingResponse(remus::RETRIEVE_RESULT,
                                                remus::INVALID_MSG,
-                                               &workerComm,
+                                               &replyComm,
                                                (zmq::SocketIdentity()));
         --this->OutstandingResults;
         }
-      remus::proto::forward_Response(response,
-                                     &queueComm,
-                                     zmq::SocketIdentity());
+      this->Queue.terminateWorker();
 
       //the server has told us to terminate, which means that the server
       //might not exist so don't continue trying to send it messages
       this->ContinueForwardingToServer = false;
       }
     else if(goodToForwardToQueue &&
-            ( response.serviceType() == remus::TERMINATE_JOB ||
-              response.serviceType() == remus::MAKE_MESH ) )
+            response.serviceType() == remus::MAKE_MESH)
       {
-      remus::proto::forward_Response(response,
-                                     &queueComm,
-                                     zmq::SocketIdentity());
+      this->Queue.addJob( to_Job(response) );
       }
-    else if ( response.serviceType() == remus::RETRIEVE_RESULT)
+    else if(goodToForwardToQueue &&
+            response.serviceType() == remus::TERMINATE_JOB)
+      {
+      this->Queue.terminateJob(
+            remus::worker::to_Job(response.data(),response.dataSize()).id());
+      }
+    else if ( response.serviceType() == remus::RETRIEVE_RESULT ||
+              is_transfer(response.serviceType()) )
       { //the worker is notifying us that it recieved our results, so decrement
         //our outstanding results, and forward the message to the worker so
         //it can stop blocking
       remus::proto::forward_Response(response,
-                                     &workerComm,
+                                     &replyComm,
                                      zmq::SocketIdentity());
         --this->OutstandingResults;
       }
+    else if ( response.serviceType() == remus::WIRE_FORMAT)
+      { //the server is telling us what wire format it will accept
+      boost::lock_guard<boost::mutex> lock(ThreadMutex);
+      this->Format = remus::proto::to_WireFormat(response.data(),
+                                                 response.dataSize());
+      }
       // do nothing if it isn't terminate_job, terminate_worker,
-      // make_mesh or retrieve result
+      // make_mesh, retrieve result or wire format
+    }
+}
+
+//------------------------------------------------------------------------------
+//decodes the job the server has sent us
+static remus::worker::Job to_Job(const remus::proto::Response& response)
+{
+  //required to use the char*, len constructor as response's data can
+  //be binary data with lots of null terminators. The job shares the
+  //response's storage so large submissions are never copied
+  remus::worker::Job j = remus::worker::to_Job(response.data(),
+                                               response.dataSize(),
+                                               response.storage());
+
+  //jobs that come with a payload only have the requirements in the
+  //header, the submission itself is the payload the client sent
+  if(response.payloadSize() > 0)
+    {
+    j = remus::worker::Job(j.id(),
+                  remus::proto::to_JobSubmission(response.payload(),
+                                                 response.payloadSize(),
+                                                 response.payloadStorage()));
     }
+  return j;
 }
 
 //------------------------------------------------------------------------------
@@ -361,8 +665,8 @@ void sendHeartBeat(zmq::socket_t& serverComm,
 //-----------------------------------------------------------------------------
 MessageRouter::MessageRouter(
                 const zmq::socketInfo<zmq::proto::inproc>& worker_info,
-                const zmq::socketInfo<zmq::proto::inproc>& queue_info):
-Implementation( new MessageRouterImplementation(worker_info, queue_info) )
+                remus::worker::detail::JobQueue& queue):
+Implementation( new MessageRouterImplementation(worker_info, queue) )
 {
 
 }
@@ -372,6 +676,13 @@ MessageRouter::~MessageRouter()
 {
 }
 
+//-----------------------------------------------------------------------------
+zmq::socketInfo<zmq::proto::inproc> MessageRouter::replyChannel(
+                  const zmq::socketInfo<zmq::proto::inproc>& worker_info)
+{
+  return zmq::socketInfo<zmq::proto::inproc>(worker_info.host() + "-replies");
+}
+
 //-----------------------------------------------------------------------------
 bool MessageRouter::valid() const
 {
@@ -398,6 +709,24 @@ remus::common::PollingMonitor MessageRouter::pollingMonitor() const
   return this->Implementation->monitor();
 }
 
+//-----------------------------------------------------------------------------
+remus::proto::WireFormat::Type MessageRouter::wireFormat() const
+{
+  return this->Implementation->wireFormat();
+}
+
+//-----------------------------------------------------------------------------
+boost::int64_t MessageRouter::statusInterval() const
+{
+  return this->Implementation->statusInterval();
+}
+
+//-----------------------------------------------------------------------------
+void MessageRouter::statusInterval(boost::int64_t millisec)
+{
+  this->Implementation->statusInterval(millisec);
+}
+
 }
 }
 }
@@ -25,9 +25,15 @@ namespace remus{
 namespace worker{
 namespace detail{
 
+class JobQueue;
+
 //Routes messages from the server to the worker class or the job queue,
 //based on the message type. The message router also handles send heartbeat
 //message back to the server
+//
+//All the communication with the server happens on the single thread of
+//the message router, which hands the jobs it receives straight to the
+//job queue.
 
 //Once a MessageRouter is sent a TerminateWorker message,it will not accept any
 //new messages from the Server and trying to start back up the server. Also
@@ -35,11 +41,18 @@ namespace detail{
 class MessageRouter
 {
 public:
+  //the job queue must outlive the message router
   MessageRouter(const zmq::socketInfo<zmq::proto::inproc>& worker_info,
-                const zmq::socketInfo<zmq::proto::inproc>& queue_info);
+                remus::worker::detail::JobQueue& queue);
 
   ~MessageRouter();
 
+  //the channel the server's replies to results and transfers are handed to
+  //the worker on. It is kept apart from the channel the worker sends on, so
+  //that a worker thread can wait for a reply while other threads send
+  static zmq::socketInfo<zmq::proto::inproc> replyChannel(
+                const zmq::socketInfo<zmq::proto::inproc>& worker_info);
+
   //Returns true when the MessageRouter running and sending messages from
   //the worker to server or server to worker.
   //Only returns false if we are sending no messages in both directions
@@ -60,6 +73,17 @@ public:
   //modify the message router instance.
   remus::common::PollingMonitor pollingMonitor() const;
 
+  //Returns the wire format that the server has agreed to accept from
+  //this worker. Is Text until the server responds to a WIRE_FORMAT message
+  remus::proto::WireFormat::Type wireFormat() const;
+
+  //The minimum time in milliseconds between status updates of a job that
+  //are sent to the server. Progress that arrives sooner is coalesced so
+  //that only the latest is sent, while changes in state and failures are
+  //always sent right away. Zero, the default, sends every update
+  boost::int64_t statusInterval() const;
+  void statusInterval(boost::int64_t millisec);
+
 private:
   class MessageRouterImplementation;
   boost::scoped_ptr<MessageRouterImplementation> Implementation;
@@ -165,7 +165,6 @@ void test_polling_rates(MessageRouter& mr)
 int UnitTestMessageRouterBasics(int, char *[])
 {
   zmq::socketInfo<zmq::proto::inproc> worker_channel(remus::testing::UniqueString());
-  zmq::socketInfo<zmq::proto::inproc> queue_channel(remus::testing::UniqueString());
 
   //bind the serverSocket
   boost::shared_ptr<zmq::context_t> context = remus::worker::make_ServerContext();
@@ -180,12 +179,12 @@ int UnitTestMessageRouterBasics(int, char *[])
   zmq::socket_t worker_socket(*context, ZMQ_PAIR);
   zmq::bindToAddress(worker_socket, worker_channel);
 
-  JobQueue jq(*context,queue_channel); //bind the jobqueue to the worker channel
+  JobQueue jq; //the message router hands the jobs it receives to the queue
 
   //now we can construct the message router, and verify that it can
   //be destroyed before starting
   {
-  MessageRouter mr(worker_channel, queue_channel);
+  MessageRouter mr(worker_channel, jq);
   REMUS_ASSERT( (!mr.valid()) )
   }
 
@@ -193,7 +192,7 @@ int UnitTestMessageRouterBasics(int, char *[])
   //noted that since MessageRouter uses ZMQ_PAIR connections we can't have
   //multiple MessageRouters connecting to the same socket, you have to bind
   //and unbind those socket classes.
-  MessageRouter mr(worker_channel, queue_channel);
+  MessageRouter mr(worker_channel, jq);
   {
   REMUS_ASSERT( (!mr.valid()) )
   mr.start( serverConn, *(serverConn.context()) );
@@ -209,7 +208,7 @@ int UnitTestMessageRouterBasics(int, char *[])
 
   //verify that we can change the polling rages of the Message Router
   {
-  MessageRouter invalid_mr(worker_channel, queue_channel);
+  MessageRouter invalid_mr(worker_channel, jq);
   test_polling_rates(invalid_mr);
 
   test_polling_rates(mr);
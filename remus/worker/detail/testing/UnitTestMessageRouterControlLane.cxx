@@ -0,0 +1,276 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+
+#include <remus/worker/detail/MessageRouter.h>
+
+#include <remus/server/PortNumbers.h>
+#include <remus/common/SleepFor.h>
+
+#include <remus/proto/JobStatus.h>
+#include <remus/proto/Message.h>
+#include <remus/proto/Response.h>
+#include <remus/proto/zmqHelper.h>
+
+#include <remus/worker/detail/JobQueue.h>
+
+#include <remus/testing/Testing.h>
+
+#include <vector>
+
+using namespace remus::worker::detail;
+
+namespace {
+
+//------------------------------------------------------------------------------
+remus::worker::ServerConnection bindToTCPSocket(zmq::socket_t &socket)
+{
+  //try a new port each time we are called this is to help speed up the test
+  int port_offset = 82;
+  zmq::socketInfo<zmq::proto::tcp> socketInfo("127.0.0.1",
+                              remus::server::WORKER_PORT + port_offset);
+  socketInfo = zmq::bindToAddress(socket,socketInfo);
+
+  return remus::worker::ServerConnection(socketInfo);
+}
+
+//------------------------------------------------------------------------------
+//receive the next message of the given type, skipping heartbeats that
+//arrive before it
+remus::proto::Message receive_service(zmq::socket_t& serverSocket,
+                                      remus::SERVICE_TYPE service,
+                                      zmq::SocketIdentity& sender)
+{
+  sender = zmq::address_recv(serverSocket);
+  remus::proto::Message msg = remus::proto::receive_Message(&serverSocket);
+  while(msg.serviceType() != service)
+    {
+    sender = zmq::address_recv(serverSocket);
+    msg = remus::proto::receive_Message(&serverSocket);
+    }
+  return msg;
+}
+
+//------------------------------------------------------------------------------
+//count the messages of the given type that have arrived, consuming
+//everything that has arrived
+int count_service(zmq::socket_t& serverSocket, remus::SERVICE_TYPE service)
+{
+  int count = 0;
+  zmq::SocketIdentity sender;
+  while(zmq::address_recv_nonblocking(serverSocket, sender))
+    {
+    remus::proto::Message msg = remus::proto::receive_Message(&serverSocket);
+    if(msg.serviceType() == service)
+      {
+      ++count;
+      }
+    }
+  return count;
+}
+
+//------------------------------------------------------------------------------
+//returns the status updates that have arrived, consuming everything that
+//has arrived
+std::vector<remus::proto::JobStatus> received_status(zmq::socket_t& serverSocket)
+{
+  std::vector<remus::proto::JobStatus> statuses;
+  zmq::SocketIdentity sender;
+  while(zmq::address_recv_nonblocking(serverSocket, sender))
+    {
+    remus::proto::Message msg = remus::proto::receive_Message(&serverSocket);
+    if(msg.serviceType() == remus::MESH_STATUS)
+      {
+      statuses.push_back(remus::proto::to_JobStatus(msg.data(),msg.dataSize()));
+      }
+    }
+  return statuses;
+}
+
+//------------------------------------------------------------------------------
+void send_status(zmq::socket_t& workerSocket,
+                 const remus::proto::JobStatus& status)
+{
+  remus::proto::send_Message(remus::common::MeshIOType(),
+                             remus::MESH_STATUS,
+                             remus::proto::to_string(status),
+                             &workerSocket);
+}
+
+//------------------------------------------------------------------------------
+void send_status(zmq::socket_t& workerSocket)
+{
+  remus::proto::send_Message(remus::common::MeshIOType(),
+                             remus::MESH_STATUS,
+                             "status",
+                             &workerSocket);
+}
+
+//------------------------------------------------------------------------------
+void test_control_lane(MessageRouter& mr,
+                       remus::worker::ServerConnection serverConn,
+                       zmq::socket_t& serverSocket,
+                       zmq::socket_t& workerSocket)
+{
+  //heartbeat often so we don't wait long for them
+  mr.pollingMonitor().changeTimeOutRates(50,400);
+  mr.start( serverConn, *(serverConn.context()) );
+  REMUS_ASSERT( (mr.valid()) )
+
+  //until the server agrees on a wire format heartbeats use the same
+  //connection as everything else, as older servers don't know about
+  //control lanes
+  zmq::SocketIdentity sid;
+  receive_service(serverSocket, remus::HEARTBEAT, sid);
+  REMUS_ASSERT( (!zmq::is_ControlIdentity(sid)) )
+
+  remus::proto::send_NonBlockingResponse(remus::WIRE_FORMAT,
+                  remus::proto::to_string(remus::proto::WireFormat::Binary),
+                  &serverSocket,
+                  sid);
+  for(int i=0; i < 10 && mr.wireFormat() != remus::proto::WireFormat::Binary; ++i)
+    {
+    remus::common::SleepForMillisec(100);
+    }
+  REMUS_ASSERT( (mr.wireFormat() == remus::proto::WireFormat::Binary) )
+
+  //now heartbeats and status come over the control lane of the worker
+  zmq::SocketIdentity sender;
+  receive_service(serverSocket, remus::HEARTBEAT, sender);
+  while(!zmq::is_ControlIdentity(sender))
+    { //skip heartbeats that were sent before the wire format arrived
+    receive_service(serverSocket, remus::HEARTBEAT, sender);
+    }
+  REMUS_ASSERT( (zmq::to_OwningIdentity(sender) == sid) )
+
+  send_status(workerSocket);
+  remus::proto::Message status =
+          receive_service(serverSocket, remus::MESH_STATUS, sender);
+  REMUS_ASSERT( (zmq::is_ControlIdentity(sender)) )
+  REMUS_ASSERT( (zmq::to_OwningIdentity(sender) == sid) )
+  REMUS_ASSERT( (std::string(status.data(),status.dataSize()) == "status") )
+
+  //while everything else stays on the data lane
+  remus::proto::send_Message(remus::common::MeshIOType(),
+                             remus::RETRIEVE_RESULT,
+                             "result",
+                             &workerSocket);
+  remus::proto::Message result =
+          receive_service(serverSocket, remus::RETRIEVE_RESULT, sender);
+  REMUS_ASSERT( (sender == sid) )
+  REMUS_ASSERT( (std::string(result.data(),result.dataSize()) == "result") )
+}
+
+//------------------------------------------------------------------------------
+void test_coalesced_heartbeats(MessageRouter& mr,
+                               zmq::socket_t& serverSocket,
+                               zmq::socket_t& workerSocket)
+{
+  //heartbeats are sent every half of the max poll time out, so this
+  //gives us a heartbeat every second
+  mr.pollingMonitor().changeTimeOutRates(50,2000);
+  send_status(workerSocket);
+  remus::common::SleepForMillisec(50);
+  count_service(serverSocket, remus::HEARTBEAT);
+
+  //status on the control lane shows the server we are alive, so while
+  //the worker keeps sending it no heartbeats are needed
+  for(int i=0; i < 15; ++i)
+    {
+    send_status(workerSocket);
+    remus::common::SleepForMillisec(100);
+    }
+  REMUS_ASSERT( (count_service(serverSocket, remus::HEARTBEAT) == 0) )
+
+  //once the worker goes quiet heartbeats are sent on a fixed schedule,
+  //and not every time the router wakes up
+  remus::common::SleepForMillisec(2500);
+  const int heartbeats = count_service(serverSocket, remus::HEARTBEAT);
+  REMUS_ASSERT( (heartbeats >= 1 && heartbeats <= 3) )
+}
+
+//------------------------------------------------------------------------------
+void test_coalesced_status(MessageRouter& mr,
+                           zmq::socket_t& serverSocket,
+                           zmq::socket_t& workerSocket)
+{
+  using namespace remus::proto;
+
+  mr.statusInterval(300);
+  REMUS_ASSERT( (mr.statusInterval() == 300) )
+
+  //the first status of a job is sent right away, while progress that
+  //follows it quickly is held back with only the latest being kept
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  for(int i=1; i <= 20; ++i)
+    {
+    send_status(workerSocket, JobStatus(id, JobProgress(i)));
+    }
+  remus::common::SleepForMillisec(100);
+  std::vector<JobStatus> statuses = received_status(serverSocket);
+  REMUS_ASSERT( (statuses.size() == 1) )
+  REMUS_ASSERT( (statuses[0].progress().value() == 1) )
+
+  //once the interval has passed the latest progress is sent
+  remus::common::SleepForMillisec(400);
+  statuses = received_status(serverSocket);
+  REMUS_ASSERT( (statuses.size() == 1) )
+  REMUS_ASSERT( (statuses[0].progress().value() == 20) )
+
+  //failures are never held back
+  send_status(workerSocket, JobStatus(id, JobProgress(21)));
+  JobStatus failed(id, JobProgress("failed"));
+  failed.markAsFailed();
+  send_status(workerSocket, failed);
+  remus::common::SleepForMillisec(100);
+  statuses = received_status(serverSocket);
+  REMUS_ASSERT( (statuses.size() == 1) )
+  REMUS_ASSERT( (statuses[0].failed()) )
+
+  mr.statusInterval(0);
+}
+
+}
+
+int UnitTestMessageRouterControlLane(int, char *[])
+{
+  zmq::socketInfo<zmq::proto::inproc> worker_channel(remus::testing::UniqueString());
+
+  //bind the serverSocket
+  boost::shared_ptr<zmq::context_t> context = remus::worker::make_ServerContext();
+  zmq::socket_t serverSocket(*context, ZMQ_ROUTER);
+  remus::worker::ServerConnection serverConn = bindToTCPSocket(serverSocket);
+  //set the context on the server connection to the one we just created
+  serverConn.context(context);
+
+  //we need to bind to the inproc sockets before constructing the MessageRouter
+  //this is a required implementation detail caused by zmq design, also we have
+  //to share the same zmq context with the inproc protocol
+  zmq::socket_t worker_socket(*context, ZMQ_PAIR);
+  zmq::bindToAddress(worker_socket, worker_channel);
+
+  JobQueue jq; //the message router hands the jobs it receives to the queue
+
+  //verify that heartbeats and status move to the control lane once the
+  //server has agreed to a wire format
+  MessageRouter mr(worker_channel, jq);
+  test_control_lane(mr, serverConn, serverSocket, worker_socket);
+
+  //verify that heartbeats are only sent when nothing else has shown the
+  //server that we are alive
+  test_coalesced_heartbeats(mr, serverSocket, worker_socket);
+
+  //verify that progress is coalesced when asked to
+  test_coalesced_status(mr, serverSocket, worker_socket);
+
+  return 0;
+}
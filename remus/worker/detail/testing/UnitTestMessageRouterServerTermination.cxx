@@ -89,7 +89,6 @@ void test_server_terminate_routing_call(MessageRouter& mr,
 int UnitTestMessageRouterServerTermination(int, char *[])
 {
   zmq::socketInfo<zmq::proto::inproc> worker_channel(remus::testing::UniqueString());
-  zmq::socketInfo<zmq::proto::inproc> queue_channel(remus::testing::UniqueString());
 
   //bind the serverSocket
   boost::shared_ptr<zmq::context_t> context = remus::worker::make_ServerContext();
@@ -104,13 +103,13 @@ int UnitTestMessageRouterServerTermination(int, char *[])
   zmq::socket_t worker_socket(*context, ZMQ_PAIR);
   zmq::bindToAddress(worker_socket, worker_channel);
 
-  JobQueue jq(*context,queue_channel); //bind the jobqueue to the worker channel
+  JobQueue jq; //the message router hands the jobs it receives to the queue
 
   //It should be noted that once you send a terminate call to a JobQueue
   //or MessageRouter it can't be started again
 
   //verify that we can send a TERMINATE_WORKER call from the server properly
-  MessageRouter mr(worker_channel, queue_channel);
+  MessageRouter mr(worker_channel, jq);
   test_server_terminate_routing_call(mr, serverConn, serverSocket,jq);
 
   return 0;
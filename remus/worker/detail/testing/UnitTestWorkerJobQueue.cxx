@@ -10,17 +10,20 @@
 //
 //=============================================================================
 
-#include <remus/worker/detail/MessageRouter.h>
-
-#include <remus/common/SleepFor.h>
-#include <remus/proto/Message.h>
-#include <remus/proto/Response.h>
 #include <remus/worker/detail/JobQueue.h>
 
-#include <remus/proto/zmq.hpp>
+#include <remus/common/SleepFor.h>
+#include <remus/common/Timer.h>
 
 #include <remus/testing/Testing.h>
 
+//suppress warnings inside boost headers for gcc and clang
+#include <remus/common/CompilerInformation.h>
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
 #include <boost/uuid/uuid.hpp>
 
 using namespace remus::worker::detail;
@@ -28,146 +31,121 @@ using namespace remus::worker::detail;
 namespace {
 
 //------------------------------------------------------------------------------
-void verify_basic_comms(zmq::context_t& context)
+remus::proto::JobSubmission make_Submission()
 {
-  zmq::socketInfo<zmq::proto::inproc> queue_channel(
-                                                remus::testing::UniqueString());
-  JobQueue jq(context,queue_channel); //bind the jobqueue to the worker channel
-
-  //we need to pause for some time to all the JobQueue
-  //to properly bind to the socket before we connect
-  while(!jq.isReady())
-    { remus::common::SleepForMillisec(10); }
-
-  //create the socket to send info to the job queue
-  zmq::socket_t jobSocket(context,ZMQ_PAIR);
-  jobSocket.connect(queue_channel.endpoint().c_str());
+  remus::proto::JobRequirements reqs(
+          remus::common::ContentFormat::User,
+          remus::common::MeshIOType( (remus::meshtypes::Mesh2D()),
+                                     (remus::meshtypes::Mesh2D()) ),
+          std::string(),
+          std::string()
+          );
+  return remus::proto::JobSubmission(reqs);
+}
 
-  zmq::SocketIdentity sid;
+//------------------------------------------------------------------------------
+void add_JobLater(JobQueue* jq, remus::worker::Job job)
+{
+  remus::common::SleepForMillisec(100);
+  jq->addJob(job);
+}
 
+//------------------------------------------------------------------------------
+void verify_basic_comms()
+{
+  JobQueue jq;
+  REMUS_ASSERT( (jq.isReady()) );
+  REMUS_ASSERT( (jq.size() == 0) );
 
   boost::uuids::uuid jobId = remus::testing::UUIDGenerator();
   remus::worker::Job fakeJob(jobId,
                              remus::proto::JobSubmission());
-
-  {
-  remus::proto::Response r =
-      remus::proto::send_NonBlockingResponse(remus::MAKE_MESH,
-                                             remus::worker::to_string(fakeJob),
-                                             &jobSocket,
-                                             sid);
-  REMUS_ASSERT( (r.isValid()) );
-  }
-
-  while(jq.size()<1){}
-  REMUS_ASSERT( (jq.size()>0) );
+  jq.addJob(fakeJob);
   REMUS_ASSERT( (jq.size()==1) );
+  REMUS_ASSERT( (jq.jobsReceived()==1) );
 
   //now add multiple more jobs to the queue
-  remus::proto::JobRequirements reqs(
-          remus::common::ContentFormat::User,
-          remus::common::MeshIOType( (remus::meshtypes::Mesh2D()),
-                                     (remus::meshtypes::Mesh2D()) ),
-          std::string(),
-          std::string()
-          );
-  remus::proto::JobSubmission sub(reqs);
-
+  remus::proto::JobSubmission sub = make_Submission();
   remus::worker::Job fakeJob2(remus::testing::UUIDGenerator(), sub);
   remus::worker::Job fakeJob3(remus::testing::UUIDGenerator(), sub);
+  jq.addJob(fakeJob2);
+  jq.addJob(fakeJob3);
 
-  {
-  remus::proto::Response r =
-      remus::proto::send_NonBlockingResponse(remus::MAKE_MESH,
-                                             remus::worker::to_string(fakeJob2),
-                                             &jobSocket,
-                                             sid);
-  REMUS_ASSERT( (r.isValid()) );
-  }
-
-  {
-  remus::proto::Response r =
-      remus::proto::send_NonBlockingResponse(remus::MAKE_MESH,
-                                            remus::worker::to_string(fakeJob3),
-                                            &jobSocket,
-                                            sid);
-  REMUS_ASSERT( (r.isValid()) );
-  }
-
-  //now send a terminate job command for the first job
-  //and verify that the correct job was terminated by pulling
-  //all the jobs off the stack
-  {
-  remus::worker::Job terminateJob(jobId,
-                                  remus::proto::JobSubmission());
-  remus::proto::Response r =
-      remus::proto::send_NonBlockingResponse(remus::TERMINATE_JOB,
-                                             remus::worker::to_string(terminateJob),
-                                             &jobSocket,
-                                             sid);
-  REMUS_ASSERT( (r.isValid()) );
-  }
-
-  //gotta wait for all three messages to come in
-  remus::common::SleepForMillisec(2000);
+  //now terminate the first job and verify that the correct job was
+  //terminated by pulling all the jobs off the stack
+  jq.terminateJob(jobId);
 
   REMUS_ASSERT( (jq.isATerminatedJob( fakeJob ) ==true ))
   REMUS_ASSERT( (jq.isATerminatedJob( fakeJob2 ) ==false ))
   REMUS_ASSERT( (jq.isATerminatedJob( fakeJob3) ==false ))
 
-  while(jq.size()>0)
-    {
-    remus::worker::Job j = jq.take();
-    REMUS_ASSERT( (j.valid() == true) )
-    }
+  //terminated jobs are still counted as received
+  REMUS_ASSERT( (jq.size()==2) );
+  REMUS_ASSERT( (jq.jobsReceived()==3) );
+  REMUS_ASSERT( (jq.take().id() == fakeJob2.id()) )
+  REMUS_ASSERT( (jq.take().id() == fakeJob3.id()) )
+  REMUS_ASSERT( (!jq.take().valid()) )
 }
 
 //------------------------------------------------------------------------------
-void verify_term(zmq::context_t& context)
+void verify_waiting()
 {
-  zmq::socketInfo<zmq::proto::inproc> queue_channel(
-                                                remus::testing::UniqueString());
-  JobQueue jq(context,queue_channel); //bind the jobqueue to the worker channel
-
-  //we need to pause for some time to all the JobQueue
-  //to properly bind to the socket before we connect
-  while(!jq.isReady())
-    { remus::common::SleepForMillisec(10); }
-
-  //create the socket to send info to the job queue
-  zmq::socket_t jobSocket(context,ZMQ_PAIR);
-  jobSocket.connect(queue_channel.endpoint().c_str());
+  JobQueue jq;
+
+  //waiting on an empty queue gives up once the timeout has passed
+  remus::common::Timer timer;
+  remus::worker::Job none = jq.waitAndTakeJob(100);
+  REMUS_ASSERT( (!none.valid()) )
+  REMUS_ASSERT( (none.validityReason() == remus::worker::Job::INVALID) )
+  REMUS_ASSERT( (timer.elapsed() >= 90) )
+
+  //a job added from another thread wakes up whoever is waiting
+  remus::worker::Job fakeJob(remus::testing::UUIDGenerator(),
+                             make_Submission());
+  boost::thread delayed( boost::bind(add_JobLater, &jq, fakeJob) );
+  remus::worker::Job taken = jq.waitAndTakeJob(10000);
+  delayed.join();
+  REMUS_ASSERT( (taken.valid()) )
+  REMUS_ASSERT( (taken.id() == fakeJob.id()) )
+
+  boost::thread later( boost::bind(add_JobLater, &jq, fakeJob) );
+  taken = jq.waitAndTakeJob();
+  later.join();
+  REMUS_ASSERT( (taken.id() == fakeJob.id()) )
+}
 
-  REMUS_ASSERT( (jq.size() == 0) );
+//------------------------------------------------------------------------------
+void verify_term()
+{
+  JobQueue jq;
+  jq.addJob( remus::worker::Job(remus::testing::UUIDGenerator(),
+                                make_Submission()) );
+  REMUS_ASSERT( (jq.size() == 1) );
 
-  //now send it a terminate message over the worker channel
-  remus::worker::Job terminateJob;
-  remus::proto::Response r=
-      remus::proto::send_NonBlockingResponse(remus::TERMINATE_WORKER,
-                                             remus::worker::to_string(terminateJob),
-                                             &jobSocket,
-                                             (zmq::SocketIdentity()));
-  REMUS_ASSERT( (r.isValid()) );
+  //terminating the worker clears the queue
+  jq.terminateWorker();
+  REMUS_ASSERT( (jq.isShutdown()) )
+  REMUS_ASSERT( (!jq.isReady()) )
 
-  //cheap block while we wait for the router thread to get the message
-  while(jq.size()<1){}
+  //and no more jobs are accepted
+  jq.addJob( remus::worker::Job(remus::testing::UUIDGenerator(),
+                                make_Submission()) );
 
   REMUS_ASSERT( (jq.size() == 1) )
   remus::worker::Job invalid_job = jq.take();
   REMUS_ASSERT( (!invalid_job.valid()) )
   REMUS_ASSERT( (invalid_job.validityReason() ==
                  remus::worker::Job::TERMINATE_WORKER) )
-
+  REMUS_ASSERT( (jq.size() == 0) )
 }
 
 }
 
 int UnitTestWorkerJobQueue(int, char *[])
 {
-  zmq::context_t context(1);
-
-  verify_basic_comms(context);
-  verify_term(context);
+  verify_basic_comms();
+  verify_waiting();
+  verify_term();
 
   return 0;
 }
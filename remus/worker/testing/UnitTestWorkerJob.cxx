@@ -181,6 +181,23 @@ void verify_submission()
 
 }
 
+void verify_serialization()
+{ //verify that jobs survive both wire formats
+  remus::proto::JobSubmission sub = make_empty_sub();
+  sub["non_default_key"] = remus::proto::make_JobContent("content");
+  Job job(make_id(),sub);
+
+  Job from_text = remus::worker::to_Job(remus::worker::to_string(job));
+  REMUS_ASSERT( (from_text.id() == job.id()) );
+  REMUS_ASSERT( (from_text.submission() == job.submission()) );
+
+  const std::string binary = remus::worker::to_binary(job);
+  Job from_binary = remus::worker::to_Job(binary.c_str(),binary.size());
+  REMUS_ASSERT( (from_binary.id() == job.id()) );
+  REMUS_ASSERT( (from_binary.submission() == job.submission()) );
+  REMUS_ASSERT( (from_binary.details("non_default_key") == "content") );
+}
+
 } //namespace
 
 
@@ -190,5 +207,6 @@ int UnitTestWorkerJob(int, char *[])
   verify_validity();
   verify_meshTypes();
   verify_submission();
+  verify_serialization();
   return 0;
 }